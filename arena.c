@@ -0,0 +1,251 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "arena.h"
+#include "user_config.h"
+
+#define HEADER_SIZE         sizeof(uint32_t)
+#define ALIGN(n)            (((n) + 3) & ~3)
+#define IN_ARENA(p)         ((uint8_t*)(p) >= m_Arena && (uint8_t*)(p) < m_Arena + ARENA_SIZE)
+#define BLOCK_SIZE(p)       (*(uint32_t*)((uint8_t*)(p) - HEADER_SIZE))
+
+/******************************************************************************************************************
+ * the real allocator, see LD_WRAP in the Makefile
+ *
+ */
+void* __real_pvPortMalloc(size_t sz, const char* file, unsigned line);
+void* __real_pvPortZalloc(size_t sz, const char* file, unsigned line);
+void* __real_pvPortCalloc(size_t count, size_t sz, const char* file, unsigned line);
+void* __real_pvPortRealloc(void* p, size_t sz, const char* file, unsigned line);
+void  __real_vPortFree(void* p, const char* file, unsigned line);
+
+void* __wrap_pvPortMalloc(size_t sz, const char* file, unsigned line);
+void* __wrap_pvPortZalloc(size_t sz, const char* file, unsigned line);
+void* __wrap_pvPortCalloc(size_t count, size_t sz, const char* file, unsigned line);
+void* __wrap_pvPortRealloc(void* p, size_t sz, const char* file, unsigned line);
+void  __wrap_vPortFree(void* p, const char* file, unsigned line);
+
+/******************************************************************************************************************
+ * local variables
+ *
+ */
+
+static uint8_t      m_Arena[ARENA_SIZE] __attribute__((aligned(4)));
+static ARENA_STATS  m_Stats = { ARENA_SIZE, 0, 0, 0, 0, 0 };
+static uint8_t      m_Capture = 0;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void* Arena_Alloc(size_t sz);
+static void  Arena_Release(void* p);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ */
+void ICACHE_FLASH_ATTR Arena_Begin(void)
+{
+    m_Capture = 1;
+}
+/**
+ * 
+ */
+void ICACHE_FLASH_ATTR Arena_End(void)
+{
+    m_Capture = 0;
+}
+/**
+ * 
+ * @return 
+ */
+const ARENA_STATS* ICACHE_FLASH_ATTR Arena_GetStats(void)
+{
+    return &m_Stats;
+}
+/**
+ * 
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* __wrap_pvPortMalloc(size_t sz, const char* file, unsigned line)
+{
+    void* p;
+    
+    if(m_Capture && (p = Arena_Alloc(sz)) != NULL) {
+        return p;
+    }
+    
+    return __real_pvPortMalloc(sz, file, line);
+}
+/**
+ * 
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* __wrap_pvPortZalloc(size_t sz, const char* file, unsigned line)
+{
+    void* p;
+    
+    if(m_Capture && (p = Arena_Alloc(sz)) != NULL) {
+        os_memset(p, 0, sz);
+        return p;
+    }
+    
+    return __real_pvPortZalloc(sz, file, line);
+}
+/**
+ * 
+ * @param count
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* __wrap_pvPortCalloc(size_t count, size_t sz, const char* file, unsigned line)
+{
+    void* p;
+    
+    if(m_Capture && (sz == 0 || count <= ARENA_SIZE / sz) && (p = Arena_Alloc(count * sz)) != NULL) {
+        os_memset(p, 0, count * sz);
+        return p;
+    }
+    
+    return __real_pvPortCalloc(count, sz, file, line);
+}
+/**
+ * 
+ * @param p
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* __wrap_pvPortRealloc(void* p, size_t sz, const char* file, unsigned line)
+{
+    void*    n;
+    uint32_t old;
+    
+    if(p == NULL) {
+        return __wrap_pvPortMalloc(sz, file, line);
+    }
+    
+    if(!IN_ARENA(p)) {
+        return __real_pvPortRealloc(p, sz, file, line);
+    }
+    
+    old = BLOCK_SIZE(p);
+    
+    if(sz <= old) {
+        return p;
+    }
+    
+    // the top block can grow in place
+    if(m_Capture && (uint8_t*)p + old == m_Arena + m_Stats.used && (uint8_t*)p + ALIGN(sz) <= m_Arena + ARENA_SIZE) {
+        m_Stats.used = (uint8_t*)p + ALIGN(sz) - m_Arena;
+        BLOCK_SIZE(p) = ALIGN(sz);
+        
+        if(m_Stats.used > m_Stats.highWater) {
+            m_Stats.highWater = m_Stats.used;
+        }
+        
+        return p;
+    }
+    
+    if((n = __wrap_pvPortMalloc(sz, file, line)) != NULL) {
+        os_memcpy(n, p, old);
+        Arena_Release(p);
+    }
+    
+    return n;
+}
+/**
+ * 
+ * @param p
+ * @param file
+ * @param line
+ */
+void __wrap_vPortFree(void* p, const char* file, unsigned line)
+{
+    if(IN_ARENA(p)) {
+        Arena_Release(p);
+    } else {
+        __real_vPortFree(p, file, line);
+    }
+}
+/**
+ * 
+ * @param sz
+ * @return NULL if it doesn't fit
+ */
+static void* Arena_Alloc(size_t sz)
+{
+    uint32_t need = HEADER_SIZE + ALIGN(sz);
+    uint8_t* p;
+    
+    if(m_Stats.used + need > ARENA_SIZE) {
+        m_Stats.fallbacks++;
+        return NULL;
+    }
+    
+    p = m_Arena + m_Stats.used + HEADER_SIZE;
+    
+    BLOCK_SIZE(p) = ALIGN(sz);
+    
+    m_Stats.used += need;
+    m_Stats.allocs++;
+    
+    if(m_Stats.used > m_Stats.highWater) {
+        m_Stats.highWater = m_Stats.used;
+    }
+    
+    return p;
+}
+/**
+ * 
+ * @param p
+ */
+static void Arena_Release(void* p)
+{
+    uint32_t size = BLOCK_SIZE(p);
+    
+    if((uint8_t*)p + size == m_Arena + m_Stats.used) {
+        m_Stats.used -= size + HEADER_SIZE;                     // top block; give it back
+    } else {
+        m_Stats.holes += size + HEADER_SIZE;
+    }
+}
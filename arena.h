@@ -0,0 +1,75 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * static arena for objects that live as long as the firmware
+ *
+ * The firmware is linked with --wrap for the SDK allocator (see LD_WRAP in the Makefile). Between Arena_Begin()
+ * and Arena_End() every allocation - including those made inside the libraries, e.g. by NewContainer() and
+ * NewAccThermostat() - is carved from a build-time sized static buffer instead of the heap. These objects are
+ * never freed, so keeping them out of the heap removes them as a source of fragmentation.
+ *
+ * Allocations that don't fit fall back to the heap and are counted. Blocks freed below the top of the arena are
+ * counted as holes; they are never reused.
+ */
+typedef struct {
+    uint32_t                size;
+    uint32_t                used;
+    uint32_t                highWater;
+    uint32_t                holes;                                  // bytes freed below the top
+    uint32_t                allocs;
+    uint32_t                fallbacks;                              // allocations that went to the heap instead
+} ARENA_STATS;
+
+/**
+ * route allocations to the arena
+ */
+void Arena_Begin(void);
+/**
+ * route allocations to the heap again
+ */
+void Arena_End(void);
+/**
+ * 
+ * @return 
+ */
+const ARENA_STATS* Arena_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ARENA_H */
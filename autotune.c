@@ -0,0 +1,233 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "autotune.h"
+
+static uint32_t isqrt(uint32_t v);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param at
+ */
+void ICACHE_FLASH_ATTR Autotune_Initialize(AUTOTUNE* at)
+{
+    os_memset(at, 0, sizeof(AUTOTUNE));
+}
+/**
+ * 
+ * @param at
+ * @param setpoint
+ * @param hysteresis
+ * @param cycles
+ * @param timeout
+ * @param temp
+ * @param now
+ */
+void ICACHE_FLASH_ATTR Autotune_Start(AUTOTUNE* at, int16_t setpoint, int16_t hysteresis, int cycles, uint32_t timeout, int16_t temp, uint32_t now)
+{
+    os_memset(at, 0, sizeof(AUTOTUNE));
+    
+    at->state      = AUTOTUNE_RUNNING;
+    at->relay      = (temp < setpoint) ? 1 : 0;
+    at->cycles     = cycles;
+    at->setpoint   = setpoint;
+    at->hysteresis = hysteresis;
+    at->high       = temp;
+    at->low        = temp;
+    at->start      = now;
+    at->timeout    = timeout;
+}
+/**
+ * 
+ * @param at
+ * @param temp
+ * @param now
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Autotune_Run(AUTOTUNE* at, int16_t temp, uint32_t now)
+{
+    if(at->state != AUTOTUNE_RUNNING) {
+        return 0;
+    }
+    
+    if(now - at->start > at->timeout) {
+        at->state = AUTOTUNE_FAILED;
+        at->relay = 0;
+        return 0;
+    }
+    
+    if(temp > at->high) {
+        at->high = temp;
+    }
+    if(temp < at->low) {
+        at->low = temp;
+    }
+    
+    if(at->relay == 1 && temp > at->setpoint + at->hysteresis) {
+        at->relay = 0;
+    } else if(at->relay == 0 && temp < at->setpoint - at->hysteresis) {
+        at->relay = 1;
+        
+        // a cycle runs from one switch on to the next
+        if(at->switches >= 2) {
+            at->periodSum += now - at->cycleStart;
+            at->swingSum  += at->high - at->low;
+            at->measured++;
+        }
+        
+        at->switches++;
+        at->cycleStart = now;
+        at->high       = temp;
+        at->low        = temp;
+        
+        if(at->measured == at->cycles) {
+            at->period    = at->periodSum / at->cycles;
+            at->amplitude = (at->swingSum * 10) / (2 * at->cycles);
+            at->state     = AUTOTUNE_DONE;
+            at->relay     = 0;
+        }
+    }
+    
+    return at->relay;
+}
+/**
+ * 
+ * @param at
+ * @param span
+ * @param kp
+ * @param ki
+ * @param kd
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Autotune_Gains(AUTOTUNE* at, double span, double* kp, double* ki, double* kd)
+{
+    uint32_t a = at->amplitude;                                     // 0.01 C
+    uint32_t e = at->hysteresis * 10;
+    double   ku;
+    
+    if(at->state != AUTOTUNE_DONE || a <= e || at->period == 0) {
+        return 0;
+    }
+    
+    // relay amplitude is half the span; 355/113 is pi to 7 digits
+    ku = (4.0 * (span / 2) * 113 * 100) / (355.0 * isqrt(a * a - e * e));
+    
+    // Tyreus-Luyben: Kp = Ku/2.2, Ti = 2.2 Pu, Td = Pu/6.3 - less overshoot than Ziegler-Nichols on a slow plant
+    *kp = ku / 2.2;
+    *ki = *kp / (2.2 * at->period);
+    *kd = *kp * at->period / 6.3;
+    
+    return 1;
+}
+/**
+ * 
+ * @param at
+ * @param now
+ */
+void ICACHE_FLASH_ATTR Autotune_Handover(AUTOTUNE* at, uint32_t now)
+{
+    at->state     = AUTOTUNE_OBSERVE;
+    at->start     = now;
+    at->overshoot = 0;
+    at->settling  = 0;
+}
+/**
+ * 
+ * @param at
+ * @param temp
+ * @param now
+ * @param window
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Autotune_Observe(AUTOTUNE* at, int16_t temp, uint32_t now, uint32_t window)
+{
+    if(at->state != AUTOTUNE_OBSERVE) {
+        return 0;
+    }
+    
+    if(temp - at->setpoint > at->overshoot) {
+        at->overshoot = temp - at->setpoint;
+    }
+    
+    if(temp > at->setpoint + at->hysteresis || temp < at->setpoint - at->hysteresis) {
+        at->settling = now - at->start;                             // not settled yet
+    }
+    
+    if(now - at->start >= window) {
+        at->state = AUTOTUNE_IDLE;
+        return 1;
+    }
+    
+    return 0;
+}
+/**
+ * 
+ * @param at
+ */
+void ICACHE_FLASH_ATTR Autotune_Stop(AUTOTUNE* at)
+{
+    at->state = AUTOTUNE_IDLE;
+    at->relay = 0;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param v
+ * @return floor(sqrt(v))
+ */
+static uint32_t ICACHE_FLASH_ATTR isqrt(uint32_t v)
+{
+    uint32_t root = 0;
+    uint32_t bit  = 1UL << 30;
+    
+    while(bit > v) {
+        bit >>= 2;
+    }
+    
+    while(bit != 0) {
+        if(v >= root + bit) {
+            v    -= root + bit;
+            root  = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        
+        bit >>= 2;
+    }
+    
+    return root;
+}
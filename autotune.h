@@ -0,0 +1,138 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * relay feedback autotuning (Åström-Hägglund)
+ *
+ * The heaters are switched on below setpoint - hysteresis and off above setpoint + hysteresis. The plant settles in a
+ * limit cycle whose period Pu and amplitude a give the ultimate gain Ku = 4d / (pi * sqrt(a^2 - hysteresis^2)) for a
+ * relay of amplitude d. The first cycle is not used; it depends on where we started.
+ *
+ * After the experiment the new controller is watched for a while to report its overshoot and settling time.
+ */
+#define AUTOTUNE_IDLE               0
+#define AUTOTUNE_RUNNING            1
+#define AUTOTUNE_DONE               2                               // gains can be computed
+#define AUTOTUNE_OBSERVE            3
+#define AUTOTUNE_FAILED             4
+
+typedef struct {
+    uint8_t                 state;
+    uint8_t                 relay;                                  // 1: heat
+    uint8_t                 cycles;                                 // to measure
+    uint8_t                 measured;
+    uint32_t                switches;
+    int16_t                 setpoint;                               // 0.1 C
+    int16_t                 hysteresis;                             // 0.1 C
+    int16_t                 high;                                   // extremes of the current cycle, 0.1 C
+    int16_t                 low;
+    uint32_t                start;                                  // seconds
+    uint32_t                timeout;                                // seconds
+    uint32_t                cycleStart;                             // seconds
+    uint32_t                periodSum;                              // seconds
+    uint32_t                swingSum;                               // 0.1 C, peak to peak
+    
+    // results
+    uint32_t                period;                                 // seconds
+    uint32_t                amplitude;                              // 0.01 C, half peak to peak
+    int16_t                 overshoot;                              // 0.1 C above setpoint
+    uint32_t                settling;                               // seconds until within the hysteresis for good
+} AUTOTUNE;
+
+/**
+ * 
+ * @param at
+ */
+void Autotune_Initialize(AUTOTUNE* at);
+/**
+ * 
+ * @param at
+ * @param setpoint      0.1 C
+ * @param hysteresis    0.1 C
+ * @param cycles
+ * @param timeout       seconds
+ * @param temp          0.1 C
+ * @param now           seconds
+ */
+void Autotune_Start(AUTOTUNE* at, int16_t setpoint, int16_t hysteresis, int cycles, uint32_t timeout, int16_t temp, uint32_t now);
+/**
+ * call on every new reading while AUTOTUNE_RUNNING
+ * 
+ * @param at
+ * @param temp          0.1 C
+ * @param now           seconds
+ * @return 1 to heat, 0 not to
+ */
+int Autotune_Run(AUTOTUNE* at, int16_t temp, uint32_t now);
+/**
+ * Tyreus-Luyben PID gains from the experiment; per second, same as PID::SetTunings()
+ * 
+ * @param at
+ * @param span          controller output range the relay stands for
+ * @param kp
+ * @param ki
+ * @param kd
+ * @return 0 if the experiment did not give usable numbers
+ */
+int Autotune_Gains(AUTOTUNE* at, double span, double* kp, double* ki, double* kd);
+/**
+ * start watching the tuned controller
+ * 
+ * @param at
+ * @param now           seconds
+ */
+void Autotune_Handover(AUTOTUNE* at, uint32_t now);
+/**
+ * call on every new reading while AUTOTUNE_OBSERVE
+ * 
+ * @param at
+ * @param temp          0.1 C
+ * @param now           seconds
+ * @param window        seconds to watch
+ * @return 1 when done and overshoot/settling can be reported
+ */
+int Autotune_Observe(AUTOTUNE* at, int16_t temp, uint32_t now, uint32_t window);
+/**
+ * 
+ * @param at
+ */
+void Autotune_Stop(AUTOTUNE* at);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUTOTUNE_H */
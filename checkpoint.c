@@ -0,0 +1,269 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "checkpoint.h"
+#include <spi_flash.h>
+
+/******************************************************************************************************************
+ * flash log
+ *
+ */
+#define MAGIC                   0x4350                              // "CP"
+#define ERASED                  0xffffffff
+
+#define RECORD_SIZE             sizeof(CHECKPOINT_RECORD)
+#define SLOTS_PER_SECTOR        (SPI_FLASH_SEC_SIZE / RECORD_SIZE)
+#define SLOTS                   (2 * SLOTS_PER_SECTOR)
+
+static CHECKPOINT_RECORD m_Record;
+
+static uint32_t  crc(const CHECKPOINT_RECORD* r);
+static int       isValid(CHECKPOINT* cp, const CHECKPOINT_RECORD* r);
+static int       isErased(const CHECKPOINT_RECORD* r);
+static int       readSlot(CHECKPOINT* cp, uint32_t slot, CHECKPOINT_RECORD* r);
+static uint32_t  slotAddress(CHECKPOINT* cp, uint32_t slot);
+
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param cp
+ * @param rtcBlock
+ * @param flashSector
+ * @param size
+ * @param version
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Checkpoint_Initialize(CHECKPOINT* cp, uint16_t rtcBlock, uint16_t flashSector, uint16_t size,
+                                            uint8_t version)
+{
+    uint32_t slot;
+    uint32_t newest = ERASED;
+    
+    os_memset(cp, 0, sizeof(CHECKPOINT));
+    
+    cp->rtcBlock    = rtcBlock;
+    cp->flashSector = flashSector;
+    cp->version     = version;
+    
+    if(size > CHECKPOINT_MAX_DATA) {
+        return 0;                                                   // a cut record would restore garbage
+    }
+    
+    cp->size = size;
+    
+    // find the end of the flash log, whatever the version - records of another one are not overwritten any sooner
+    for(slot = 0; slot < SLOTS; slot++) {
+        if(readSlot(cp, slot, &m_Record) && isValid(cp, &m_Record) && (newest == ERASED || m_Record.seq > cp->seq)) {
+            newest   = slot;
+            cp->seq  = m_Record.seq;
+        }
+    }
+    
+    if(newest != ERASED) {
+        cp->slot = (newest + 1) % SLOTS;
+        
+        // a failed write may have left the slot half programmed; move on to a fresh sector
+        if(cp->slot % SLOTS_PER_SECTOR != 0) {
+            if(!readSlot(cp, cp->slot, &m_Record) || !isErased(&m_Record)) {
+                cp->slot = ((cp->slot / SLOTS_PER_SECTOR + 1) % 2) * SLOTS_PER_SECTOR;
+            }
+        }
+    }
+    
+    return 1;
+}
+/**
+ * 
+ * @param cp
+ * @param data
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Checkpoint_Load(CHECKPOINT* cp, void* data)
+{
+    uint32_t slot;
+    
+    if(cp->size == 0) {
+        return CHECKPOINT_NONE;
+    }
+    
+    // RTC memory first; it is the most recent
+    if(system_rtc_mem_read(cp->rtcBlock, &m_Record, RECORD_SIZE) && isValid(cp, &m_Record) &&
+       m_Record.version == cp->version) {
+        if(m_Record.seq > cp->seq) {
+            cp->seq = m_Record.seq;
+        }
+        
+        os_memcpy(data, m_Record.data, cp->size);
+        
+        return CHECKPOINT_RTC;
+    }
+    
+    // newest record in the flash log; not an older one when the newest is of another version
+    if(cp->seq > 0) {
+        for(slot = 0; slot < SLOTS; slot++) {
+            if(readSlot(cp, slot, &m_Record) && isValid(cp, &m_Record) && m_Record.seq == cp->seq) {
+                if(m_Record.version != cp->version) {
+                    return CHECKPOINT_NONE;
+                }
+                
+                os_memcpy(data, m_Record.data, cp->size);
+                
+                return CHECKPOINT_FLASH;
+            }
+        }
+    }
+    
+    return CHECKPOINT_NONE;
+}
+/**
+ * 
+ * @param cp
+ * @param data
+ * @param flash
+ */
+void ICACHE_FLASH_ATTR Checkpoint_Save(CHECKPOINT* cp, const void* data, int flash)
+{
+    if(cp->size == 0) {
+        return;
+    }
+    
+    os_memset(&m_Record, 0, RECORD_SIZE);
+    os_memcpy(m_Record.data, data, cp->size);
+    
+    m_Record.magic   = MAGIC;
+    m_Record.version = cp->version;
+    m_Record.seq     = ++cp->seq;
+    m_Record.crc     = crc(&m_Record);
+    
+    if(!system_rtc_mem_write(cp->rtcBlock, &m_Record, RECORD_SIZE)) {
+        cp->errors++;
+    }
+    
+    if(!flash) {
+        return;
+    }
+    
+    if(cp->slot % SLOTS_PER_SECTOR == 0) {
+        cp->flashErases++;
+        
+        if(spi_flash_erase_sector(cp->flashSector + cp->slot / SLOTS_PER_SECTOR) != SPI_FLASH_RESULT_OK) {
+            cp->errors++;
+        }
+    }
+    
+    cp->flashWrites++;
+    
+    if(spi_flash_write(slotAddress(cp, cp->slot), (uint32_t*) &m_Record, RECORD_SIZE) != SPI_FLASH_RESULT_OK) {
+        cp->errors++;
+    }
+    
+    cp->slot = (cp->slot + 1) % SLOTS;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * FNV-1a over everything but the crc itself
+ * 
+ * @param r
+ * @return 
+ */
+static uint32_t ICACHE_FLASH_ATTR crc(const CHECKPOINT_RECORD* r)
+{
+    const uint8_t* p    = (const uint8_t*) r;
+    uint32_t       hash = 2166136261UL;
+    uint32_t       i;
+    
+    for(i = 0; i < RECORD_SIZE - sizeof(r->crc); i++) {
+        hash = (hash ^ p[i]) * 16777619UL;
+    }
+    
+    return hash;
+}
+/**
+ * 
+ * @param cp
+ * @param r
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR isValid(CHECKPOINT* cp, const CHECKPOINT_RECORD* r)
+{
+    return r->magic == MAGIC && r->seq != ERASED && r->crc == crc(r);
+}
+/**
+ * 
+ * @param r
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR isErased(const CHECKPOINT_RECORD* r)
+{
+    const uint32_t* p = (const uint32_t*) r;
+    uint32_t        i;
+    
+    for(i = 0; i < RECORD_SIZE / 4; i++) {
+        if(p[i] != ERASED) {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+/**
+ * 
+ * @param cp
+ * @param slot
+ * @param r
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR readSlot(CHECKPOINT* cp, uint32_t slot, CHECKPOINT_RECORD* r)
+{
+    if(spi_flash_read(slotAddress(cp, slot), (uint32_t*) r, RECORD_SIZE) != SPI_FLASH_RESULT_OK) {
+        cp->errors++;
+        return 0;
+    }
+    
+    return 1;
+}
+/**
+ * 
+ * @param cp
+ * @param slot
+ * @return 
+ */
+static uint32_t ICACHE_FLASH_ATTR slotAddress(CHECKPOINT* cp, uint32_t slot)
+{
+    return (cp->flashSector + slot / SLOTS_PER_SECTOR) * SPI_FLASH_SEC_SIZE + (slot % SLOTS_PER_SECTOR) * RECORD_SIZE;
+}
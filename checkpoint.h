@@ -0,0 +1,106 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * checkpoint
+ *
+ * A small block of application state kept in RTC memory, which survives resets, watchdogs and rBoot ROM swaps, and
+ * in a log in two flash sectors for when power was lost. Each flash save appends a record; a sector is only erased
+ * when the log wraps into it, so the newest record in the other sector is always there.
+ *
+ * Records carry the layout version of the data; one of another version - saved by an older or newer firmware - is
+ * not loaded.
+ */
+#define CHECKPOINT_MAX_DATA         36                              // bytes, multiple of 4
+
+#define CHECKPOINT_NONE             0                               // Checkpoint_Load() return codes
+#define CHECKPOINT_RTC              1
+#define CHECKPOINT_FLASH            2
+
+typedef struct {
+    uint16_t                magic;
+    uint8_t                 version;                                // of the data layout
+    uint8_t                 reserved;
+    uint32_t                seq;
+    uint8_t                 data[CHECKPOINT_MAX_DATA];
+    uint32_t                crc;
+} CHECKPOINT_RECORD;
+
+typedef struct {
+    uint16_t                rtcBlock;
+    uint16_t                flashSector;                            // this one and the next
+    uint16_t                size;                                   // 0: too large, nothing is loaded or saved
+    uint8_t                 version;
+    uint32_t                seq;
+    uint32_t                slot;                                   // next free flash slot
+    
+    // statistics
+    uint32_t                flashWrites;
+    uint32_t                flashErases;
+    uint32_t                errors;
+} CHECKPOINT;
+
+/**
+ * 
+ * @param cp
+ * @param rtcBlock      first RTC memory block (4 bytes each) to use
+ * @param flashSector   first of two flash sectors to use
+ * @param size          of application data
+ * @param version       of the application data layout; change it whenever the layout changes
+ * @return 0 if 'size' is more than CHECKPOINT_MAX_DATA; the checkpoint is not used then
+ */
+int Checkpoint_Initialize(CHECKPOINT* cp, uint16_t rtcBlock, uint16_t flashSector, uint16_t size, uint8_t version);
+/**
+ * 
+ * @param cp
+ * @param data
+ * @return where the data came from; CHECKPOINT_NONE leaves 'data' untouched, also when the only records there are
+ *         of another version
+ */
+int Checkpoint_Load(CHECKPOINT* cp, void* data);
+/**
+ * 
+ * @param cp
+ * @param data
+ * @param flash     also append to the flash log
+ */
+void Checkpoint_Save(CHECKPOINT* cp, const void* data, int flash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHECKPOINT_H */
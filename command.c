@@ -0,0 +1,167 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "command.h"
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param c
+ * @param nodename
+ * @param platformId
+ */
+void ICACHE_FLASH_ATTR Command_Initialize(COMMANDS* c, const char* nodename, const char* platformId)
+{
+    os_memset(c, 0, sizeof(COMMANDS));
+    
+    c->nodename   = nodename;
+    c->platformId = platformId;
+}
+/**
+ * 
+ * @param c
+ * @param name
+ * @param handler
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Command_Add(COMMANDS* c, const char* name, COMMAND_HANDLER handler)
+{
+    uint32_t length;
+    uint32_t hash = Command_Hash(name, &length);
+    uint32_t i, s;
+    
+    if(length > COMMAND_NAME_MAX) {
+        return 0;
+    }
+    
+    for(i = 0; i < COMMAND_SLOTS; i++) {
+        s = (hash + i) & (COMMAND_SLOTS - 1);
+        
+        if(c->slot[s].name == NULL) {
+            c->slot[s].hash    = hash;
+            c->slot[s].name    = name;
+            c->slot[s].handler = handler;
+            return 1;
+        } else if(c->slot[s].hash == hash && os_strcmp(c->slot[s].name, name) == 0) {
+            return 0;
+        }
+    }
+    
+    return 0;
+}
+/**
+ * 
+ * @param c
+ * @param nodename
+ * @param platformId
+ * @param feedId
+ * @param payload
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Command_Dispatch(COMMANDS* c, const char* nodename, const char* platformId, const char* feedId, const char* payload)
+{
+    uint32_t    length;
+    uint32_t    hash;
+    COMMAND*    cmd  = NULL;
+    uint32_t    i, s;
+    int         n, arg;
+    
+    if(nodename == NULL || platformId == NULL || os_strcmp(nodename, c->nodename) != 0 || os_strcmp(platformId, c->platformId) != 0) {
+        c->passed++;
+        return 0;
+    }
+    
+    hash = Command_Hash(feedId, &length);
+    
+    if(length <= COMMAND_NAME_MAX) {
+        for(i = 0; i < COMMAND_SLOTS; i++) {
+            s = (hash + i) & (COMMAND_SLOTS - 1);
+            
+            if(c->slot[s].name == NULL) {
+                break;
+            } else if(c->slot[s].hash == hash && os_strcmp(c->slot[s].name, feedId) == 0) {
+                cmd = &c->slot[s];
+                break;
+            }
+        }
+    }
+    
+    if(cmd == NULL) {
+        c->passed++;
+        return 0;
+    }
+    
+    for(length = 0; length <= JSON_MAX_LENGTH && payload[length] != '\0'; length++) {
+    }
+    
+    n = Json_Parse(&c->json, payload, length, c->token, COMMAND_TOKENS);
+    
+    if(n == JSON_ERROR_SYNTAX) {
+        // plain text
+        c->json.count            = 1;
+        c->token[0].type         = JSON_PRIMITIVE;
+        c->token[0].size         = 0;
+        c->token[0].start        = 0;
+        c->token[0].length       = length;
+        c->token[0].next         = 1;
+    } else if(n < 0) {
+        c->rejected++;
+        return -1;
+    }
+    
+    arg = (c->token[0].type == JSON_OBJECT) ? Json_Find(&c->json, 0, "value") : 0;
+    
+    c->handled++;
+    
+    cmd->handler(&c->json, arg);
+    
+    return 1;
+}
+/**
+ * 
+ * @param s
+ * @param length
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Command_Hash(const char* s, uint32_t* length)
+{
+    uint32_t hash = 2166136261UL;
+    uint32_t i;
+    
+    for(i = 0; i <= COMMAND_NAME_MAX && s[i] != '\0'; i++) {
+        hash = (hash ^ (uint8_t) s[i]) * 16777619UL;
+    }
+    
+    *length = i;
+    
+    return hash;
+}
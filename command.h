@@ -0,0 +1,115 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+#include "json.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * command dispatch
+ *
+ * Only messages addressed to this node and platform are looked at; a message for someone else costs a string
+ * compare and is passed on. Commands are looked up by the FNV-1a hash of the feed id, in an open addressed table
+ * filled at boot; a hit is confirmed with one string compare. The payload is parsed in place into the table's
+ * tokens, and the handler is given the argument: the payload itself when it is a single value, or its "value"
+ * member when it is an object.
+ * A payload that is not JSON at all - a schedule - is handed over as one primitive token covering all of it.
+ *
+ * Feed ids longer than COMMAND_NAME_MAX and payloads longer than JSON_MAX_LENGTH are not looked at any further, so
+ * a message costs at most one pass over each.
+ */
+#define COMMAND_SLOTS               16                              // power of 2
+#define COMMAND_NAME_MAX            24
+#define COMMAND_TOKENS              32
+
+typedef void (*COMMAND_HANDLER)(const JSON* json, int arg);
+
+typedef struct {
+    uint32_t                hash;
+    const char*             name;                                   // NULL: free slot
+    COMMAND_HANDLER         handler;
+} COMMAND;
+
+typedef struct {
+    const char*             nodename;                               // must outlive the table
+    const char*             platformId;
+    COMMAND                 slot[COMMAND_SLOTS];
+    JSON                    json;
+    JSON_TOKEN              token[COMMAND_TOKENS];
+    
+    // statistics
+    uint32_t                handled;
+    uint32_t                rejected;                               // ours, but the payload would not parse
+    uint32_t                passed;                                 // not ours, or not for us
+} COMMANDS;
+
+/**
+ * 
+ * @param c
+ * @param nodename      this node, as the connector was told
+ * @param platformId
+ */
+void Command_Initialize(COMMANDS* c, const char* nodename, const char* platformId);
+/**
+ * 
+ * @param c
+ * @param name          must stay put
+ * @param handler
+ * @return 1 if added, 0 if the table is full or has it already
+ */
+int Command_Add(COMMANDS* c, const char* name, COMMAND_HANDLER handler);
+/**
+ * 
+ * @param c
+ * @param nodename
+ * @param platformId
+ * @param feedId
+ * @param payload
+ * @return 1 if handled, 0 if not ours, -1 if ours but the payload was rejected
+ */
+int Command_Dispatch(COMMANDS* c, const char* nodename, const char* platformId, const char* feedId, const char* payload);
+/**
+ * FNV-1a
+ * 
+ * @param s
+ * @param length        out, capped at COMMAND_NAME_MAX + 1
+ * @return 
+ */
+uint32_t Command_Hash(const char* s, uint32_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMMAND_H */
@@ -0,0 +1,86 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "deadband.h"
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param db
+ * @param threshold
+ * @param minInterval
+ * @param maxSilence
+ */
+void ICACHE_FLASH_ATTR Deadband_Initialize(DEADBAND* db, int32_t threshold, uint32_t minInterval, uint32_t maxSilence)
+{
+    os_memset(db, 0, sizeof(DEADBAND));
+    
+    db->threshold   = threshold;
+    db->minInterval = minInterval;
+    db->maxSilence  = maxSilence;
+}
+/**
+ * 
+ * @param db
+ * @param value
+ * @param now
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Deadband_Check(DEADBAND* db, int32_t value, uint32_t now)
+{
+    uint32_t elapsed = now - db->lastTime;
+    int32_t  delta   = value - db->last;
+    
+    if(db->valid) {
+        if(elapsed < db->maxSilence) {
+            if(elapsed < db->minInterval || (delta < db->threshold && -delta < db->threshold)) {
+                db->suppressed++;
+                return 0;
+            }
+        }
+    }
+    
+    db->last     = value;
+    db->lastTime = now;
+    db->valid    = 1;
+    
+    db->published++;
+    
+    return 1;
+}
+/**
+ * 
+ * @param db
+ */
+void ICACHE_FLASH_ATTR Deadband_Reset(DEADBAND* db)
+{
+    db->valid = 0;
+}
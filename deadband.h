@@ -0,0 +1,83 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * deadband and rate limit for publishing a value
+ *
+ * A new value is published when it has moved at least 'threshold' since the last published value, but never more
+ * often than every 'minInterval' seconds. After 'maxSilence' seconds it is published anyway.
+ */
+typedef struct {
+    int32_t                 threshold;
+    uint32_t                minInterval;                            // seconds
+    uint32_t                maxSilence;                             // seconds
+    int32_t                 last;
+    uint32_t                lastTime;
+    uint8_t                 valid;
+    
+    // statistics
+    uint32_t                published;
+    uint32_t                suppressed;
+} DEADBAND;
+
+/**
+ * 
+ * @param db
+ * @param threshold
+ * @param minInterval
+ * @param maxSilence
+ */
+void Deadband_Initialize(DEADBAND* db, int32_t threshold, uint32_t minInterval, uint32_t maxSilence);
+/**
+ * 
+ * @param db
+ * @param value
+ * @param now       seconds
+ * @return 1 if 'value' should be published, 0 if not
+ */
+int Deadband_Check(DEADBAND* db, int32_t value, uint32_t now);
+/**
+ * force next value to be published
+ * 
+ * @param db
+ */
+void Deadband_Reset(DEADBAND* db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEADBAND_H */
@@ -0,0 +1,491 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "delta.h"
+#include <spi_flash.h>
+
+/******************************************************************************************************************
+ * patch format
+ *
+ */
+#define MAGIC                   0x31544c44                          // "DLT1"
+
+#define OP_END                  0x00
+#define OP_COPY                 0x01
+#define OP_ADD                  0x02
+#define OP_PATCH                0x03
+
+#define ST_HEADER               0
+#define ST_OP                   1
+#define ST_ARGS                 2
+#define ST_ADD                  3
+#define ST_GAP                  4
+#define ST_BYTE                 5
+#define ST_DONE                 6
+
+#define WORK_NONE               0
+#define WORK_SOURCE             1                                   // CRC of the running image
+#define WORK_COPY               2                                   // from the running image
+#define WORK_TARGET             3                                   // CRC of the result
+
+static void     header(DELTA* d);
+static void     execute(DELTA* d);
+static int      varint(DELTA* d, uint8_t b, uint32_t* v);
+static void     queue(DELTA* d, uint8_t work, uint32_t addr, uint32_t len);
+static void     emit(DELTA* d, uint8_t b);
+static void     flush(DELTA* d);
+static void     copySource(DELTA* d, uint32_t offset, uint32_t len);
+static int      readFlash(DELTA* d, uint32_t addr, uint8_t* p, uint32_t len);
+static uint32_t crcFlash(DELTA* d, uint32_t crc, uint32_t addr, uint32_t len);
+static uint32_t get32(const uint8_t* p);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param d
+ * @param srcAddr
+ * @param dstAddr
+ */
+void ICACHE_FLASH_ATTR Delta_Begin(DELTA* d, uint32_t srcAddr, uint32_t dstAddr)
+{
+    os_memset(d, 0, sizeof(DELTA));
+    
+    d->srcAddr = srcAddr;
+    d->dstAddr = dstAddr;
+    d->state   = ST_HEADER;
+}
+/**
+ * 
+ * @param d
+ * @param data
+ * @param len
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Delta_Write(DELTA* d, const uint8_t* data, uint32_t len)
+{
+    uint32_t i;
+    uint8_t  b;
+    
+    for(i = 0; i < len && d->error == DELTA_OK && d->work == WORK_NONE; i++) {
+        b = data[i];
+        
+        switch(d->state) {
+            case ST_HEADER:
+                d->header[d->headerLen++] = b;
+                
+                if(d->headerLen == sizeof(d->header)) {
+                    header(d);
+                }
+                break;
+                
+            case ST_OP:
+                d->op       = b;
+                d->argIndex = 0;
+                d->state    = ST_ARGS;
+                
+                switch(b) {
+                    case OP_END:    d->state    = ST_DONE;  break;
+                    case OP_COPY:   d->argCount = 2;        break;
+                    case OP_ADD:    d->argCount = 1;        break;
+                    case OP_PATCH:  d->argCount = 3;        break;
+                    default:        d->error    = DELTA_ERROR_FORMAT;
+                }
+                break;
+                
+            case ST_ARGS:
+                if(varint(d, b, &d->arg[d->argIndex]) && ++d->argIndex == d->argCount) {
+                    execute(d);
+                }
+                break;
+                
+            case ST_ADD:
+                emit(d, b);
+                
+                if(--d->arg[0] == 0) {
+                    d->state = ST_OP;
+                }
+                break;
+                
+            case ST_GAP:
+                if(varint(d, b, &d->gap)) {
+                    if(d->cursor + d->gap >= d->arg[1]) {
+                        d->error = DELTA_ERROR_FORMAT;
+                    } else {
+                        queue(d, WORK_COPY, d->arg[0] + d->cursor, d->gap);
+                        d->state = ST_BYTE;
+                    }
+                }
+                break;
+                
+            case ST_BYTE:
+                emit(d, b);
+                
+                d->cursor += d->gap + 1;
+                
+                if(--d->arg[2] > 0) {
+                    d->state = ST_GAP;
+                } else {
+                    queue(d, WORK_COPY, d->arg[0] + d->cursor, d->arg[1] - d->cursor);
+                    d->state = ST_OP;
+                }
+                break;
+                
+            case ST_DONE:
+                d->error = DELTA_ERROR_FORMAT;                      // nothing may follow END
+                break;
+        }
+    }
+    
+    return (d->error != DELTA_OK) ? d->error : (int) i;
+}
+/**
+ * 
+ * @param d
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Delta_Run(DELTA* d)
+{
+    uint32_t n = (d->workLeft > DELTA_STEP) ? DELTA_STEP : d->workLeft;
+    
+    if(d->error != DELTA_OK || d->work == WORK_NONE) {
+        return d->error;
+    }
+    
+    if(d->work == WORK_COPY) {
+        copySource(d, d->workAddr, n);
+    } else {
+        d->crc = crcFlash(d, d->crc, d->workAddr, n);
+    }
+    
+    d->workAddr += n;
+    d->workLeft -= n;
+    
+    if(d->error != DELTA_OK) {
+        return d->error;
+    }
+    
+    if(d->workLeft > 0) {
+        return DELTA_BUSY;
+    }
+    
+    if(d->work == WORK_SOURCE && ~d->crc != get32(d->header + 8)) {
+        d->error = DELTA_ERROR_SOURCE;
+    } else if(d->work == WORK_TARGET && ~d->crc != get32(d->header + 16)) {
+        d->error = DELTA_ERROR_CRC;
+    }
+    
+    d->work = WORK_NONE;
+    
+    return d->error;
+}
+/**
+ * 
+ * @param d
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Delta_End(DELTA* d)
+{
+    if(d->error != DELTA_OK) {
+        return d->error;
+    }
+    
+    if(d->state != ST_DONE || d->written != d->dstSize || d->work != WORK_NONE) {
+        return d->error = DELTA_ERROR_FORMAT;
+    }
+    
+    flush(d);
+    
+    // check what actually ended up in flash
+    queue(d, WORK_TARGET, d->dstAddr, d->dstSize);
+    
+    return (d->error != DELTA_OK) ? d->error : DELTA_BUSY;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param d
+ */
+static void ICACHE_FLASH_ATTR header(DELTA* d)
+{
+    if(get32(d->header) != MAGIC) {
+        d->error = DELTA_ERROR_MAGIC;
+        return;
+    }
+    
+    d->srcSize = get32(d->header + 4);
+    d->dstSize = get32(d->header + 12);
+    d->state   = ST_OP;
+    
+    queue(d, WORK_SOURCE, d->srcAddr, d->srcSize);                  // nothing is written before this checks out
+}
+/**
+ * all arguments of an operation are in
+ * 
+ * @param d
+ */
+static void ICACHE_FLASH_ATTR execute(DELTA* d)
+{
+    uint32_t length = (d->op == OP_ADD) ? d->arg[0] : d->arg[1];
+    
+    if(d->written + length > d->dstSize || length > d->dstSize) {
+        d->error = DELTA_ERROR_FORMAT;
+        return;
+    }
+    
+    if(d->op != OP_ADD && (d->arg[0] + length > d->srcSize || length > d->srcSize)) {
+        d->error = DELTA_ERROR_FORMAT;
+        return;
+    }
+    
+    d->state = ST_OP;
+    
+    switch(d->op) {
+        case OP_COPY:
+            queue(d, WORK_COPY, d->arg[0], length);
+            break;
+            
+        case OP_ADD:
+            if(length > 0) {
+                d->state = ST_ADD;
+            }
+            break;
+            
+        case OP_PATCH:
+            d->cursor = 0;
+            
+            if(d->arg[2] == 0) {
+                queue(d, WORK_COPY, d->arg[0], length);
+            } else {
+                d->state = ST_GAP;
+            }
+            break;
+    }
+}
+/**
+ * 
+ * @param d
+ * @param b
+ * @param v
+ * @return 1 when the varint is complete
+ */
+static int ICACHE_FLASH_ATTR varint(DELTA* d, uint8_t b, uint32_t* v)
+{
+    if(d->shift == 0) {
+        *v = 0;
+    }
+    
+    *v |= (uint32_t) (b & 0x7f) << d->shift;
+    
+    if((b & 0x80) == 0) {
+        d->shift = 0;
+        return 1;
+    }
+    
+    d->shift += 7;
+    
+    if(d->shift > 28) {
+        d->error = DELTA_ERROR_FORMAT;
+    }
+    
+    return 0;
+}
+/**
+ * 
+ * @param d
+ * @param work
+ * @param addr      flash address, or source offset for WORK_COPY
+ * @param len
+ */
+static void ICACHE_FLASH_ATTR queue(DELTA* d, uint8_t work, uint32_t addr, uint32_t len)
+{
+    if(len == 0 && work == WORK_COPY) {
+        return;
+    }
+    
+    d->work     = work;
+    d->workAddr = addr;
+    d->workLeft = len;
+    d->crc      = 0xffffffff;
+}
+/**
+ * 
+ * @param d
+ * @param b
+ */
+static void ICACHE_FLASH_ATTR emit(DELTA* d, uint8_t b)
+{
+    d->buffer[d->bufferLen++] = b;
+    d->written++;
+    
+    if(d->bufferLen == DELTA_BUFFER) {
+        flush(d);
+    }
+}
+/**
+ * write the buffer; a sector is erased when the first buffer in it is written
+ * 
+ * @param d
+ */
+static void ICACHE_FLASH_ATTR flush(DELTA* d)
+{
+    uint32_t addr = d->dstAddr + d->written - d->bufferLen;
+    
+    if(d->bufferLen == 0) {
+        return;
+    }
+    
+    while(d->bufferLen % 4 != 0) {
+        d->buffer[d->bufferLen++] = 0xff;                           // only the last one
+    }
+    
+    if(addr % SPI_FLASH_SEC_SIZE == 0) {
+        if(spi_flash_erase_sector(addr / SPI_FLASH_SEC_SIZE) != SPI_FLASH_RESULT_OK) {
+            d->error = DELTA_ERROR_FLASH;
+        }
+    }
+    
+    if(spi_flash_write(addr, (uint32_t*) d->buffer, d->bufferLen) != SPI_FLASH_RESULT_OK) {
+        d->error = DELTA_ERROR_FLASH;
+    }
+    
+    d->bufferLen = 0;
+}
+/**
+ * 
+ * @param d
+ * @param offset
+ * @param len
+ */
+static void ICACHE_FLASH_ATTR copySource(DELTA* d, uint32_t offset, uint32_t len)
+{
+    uint8_t  chunk[32];
+    uint32_t n, i;
+    
+    while(len > 0 && d->error == DELTA_OK) {
+        n = (len > sizeof(chunk)) ? sizeof(chunk) : len;
+        
+        if(readFlash(d, d->srcAddr + offset, chunk, n)) {
+            for(i = 0; i < n; i++) {
+                emit(d, chunk[i]);
+            }
+        }
+        
+        offset += n;
+        len    -= n;
+    }
+}
+/**
+ * spi_flash_read() wants aligned addresses and sizes
+ * 
+ * @param d
+ * @param addr
+ * @param p
+ * @param len
+ * @return 1 on success
+ */
+static int ICACHE_FLASH_ATTR readFlash(DELTA* d, uint32_t addr, uint8_t* p, uint32_t len)
+{
+    uint32_t word[8];
+    uint32_t skip, n;
+    
+    while(len > 0) {
+        skip = addr & 3;
+        n    = sizeof(word) - skip;
+        
+        if(n > len) {
+            n = len;
+        }
+        
+        if(spi_flash_read(addr - skip, word, sizeof(word)) != SPI_FLASH_RESULT_OK) {
+            d->error = DELTA_ERROR_FLASH;
+            return 0;
+        }
+        
+        os_memcpy(p, (uint8_t*) word + skip, n);
+        
+        p    += n;
+        addr += n;
+        len  -= n;
+    }
+    
+    return 1;
+}
+/**
+ * CRC-32 (IEEE 802.3) of a flash area, continued
+ * 
+ * @param d
+ * @param crc       0xffffffff to start with; the result is the complement of what this returns at the end
+ * @param addr
+ * @param len
+ * @return 
+ */
+static uint32_t ICACHE_FLASH_ATTR crcFlash(DELTA* d, uint32_t crc, uint32_t addr, uint32_t len)
+{
+    uint8_t  chunk[32];
+    uint32_t n, i;
+    int      bit;
+    
+    while(len > 0) {
+        n = (len > sizeof(chunk)) ? sizeof(chunk) : len;
+        
+        if(!readFlash(d, addr, chunk, n)) {
+            return 0;
+        }
+        
+        for(i = 0; i < n; i++) {
+            crc ^= chunk[i];
+            
+            for(bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+            }
+        }
+        
+        addr += n;
+        len  -= n;
+    }
+    
+    return crc;
+}
+/**
+ * 
+ * @param p
+ * @return 
+ */
+static uint32_t ICACHE_FLASH_ATTR get32(const uint8_t* p)
+{
+    return p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
@@ -0,0 +1,135 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * delta firmware images
+ *
+ * Applies a patch made by mkdelta.py while it streams in. The new image is built in the other rBoot slot from the
+ * image we run (read straight from flash) and the patch. RAM use is this struct, whatever chunk size is fed.
+ *
+ * Nothing here runs long: the CRC of the running image, copies from it and the CRC of the result are queued as
+ * work, and Delta_Run() does at most DELTA_STEP bytes of it per call. Delta_Write() takes no more of the patch
+ * while there is work queued, so the caller runs that first and then offers the rest again.
+ *
+ * Patch format, all numbers little endian, varints 7 bits per byte, low bits first:
+ *
+ *      header  "DLT1", source size, source CRC-32, target size, target CRC-32     (5 x uint32)
+ *      0x01    COPY    offset, length                  copy from source
+ *      0x02    ADD     length, bytes                   new bytes
+ *      0x03    PATCH   offset, length, count,          copy from source, with 'count' bytes replaced; each is a
+ *                      count x (gap, byte)             gap in bytes from the previous one followed by the new byte
+ *      0x00    END
+ */
+#define DELTA_BUFFER                256                             // write buffer; must divide the sector size
+#define DELTA_STEP                  4096                            // flash work per Delta_Run(), about 4 ms to read
+
+#define DELTA_BUSY                  1                               // Delta_Run() has more to do
+#define DELTA_OK                    0
+#define DELTA_ERROR_MAGIC           -1
+#define DELTA_ERROR_SOURCE          -2                              // patch is for another image
+#define DELTA_ERROR_FORMAT          -3
+#define DELTA_ERROR_FLASH           -4
+#define DELTA_ERROR_CRC             -5                              // result is not what the patch says
+
+typedef struct {
+    uint32_t                srcAddr;                                // flash address of running image
+    uint32_t                dstAddr;                                // flash address of target slot
+    uint32_t                srcSize;
+    uint32_t                dstSize;
+    uint32_t                dstCrc;
+    uint32_t                written;
+    int                     error;
+    
+    // queued flash work
+    uint8_t                 work;
+    uint32_t                workAddr;
+    uint32_t                workLeft;
+    uint32_t                crc;
+    
+    // parser
+    uint8_t                 state;
+    uint8_t                 op;
+    uint8_t                 argIndex;
+    uint8_t                 argCount;
+    uint8_t                 shift;
+    uint32_t                arg[3];
+    uint32_t                gap;
+    uint32_t                cursor;                                 // PATCH: source bytes done
+    uint8_t                 header[20];
+    uint8_t                 headerLen;
+    
+    uint8_t                 buffer[DELTA_BUFFER];
+    uint16_t                bufferLen;
+} DELTA;
+
+/**
+ * 
+ * @param d
+ * @param srcAddr   flash address of the image we run
+ * @param dstAddr   flash address of the slot to write; sector aligned
+ */
+void Delta_Begin(DELTA* d, uint32_t srcAddr, uint32_t dstAddr);
+/**
+ * feed the next part of the patch
+ * 
+ * @param d
+ * @param data
+ * @param len
+ * @return bytes taken, less than 'len' when work was queued; or an error, and once an error is returned all 
+ *         further calls return it
+ */
+int Delta_Write(DELTA* d, const uint8_t* data, uint32_t len);
+/**
+ * do some of the queued work
+ * 
+ * @param d
+ * @return DELTA_BUSY while there is more, DELTA_OK when there is none, or an error
+ */
+int Delta_Run(DELTA* d);
+/**
+ * the whole patch is in; queues the check of the result
+ * 
+ * @param d
+ * @return DELTA_BUSY, or an error; when Delta_Run() then returns DELTA_OK the target slot holds the complete,
+ *         verified image
+ */
+int Delta_End(DELTA* d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DELTA_H */
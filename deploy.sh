@@ -43,9 +43,11 @@ OBJECTFILES=`get_make_var OBJECTFILES nbproject/Makefile-Release.mk`
 LIB_DIR=`get_make_var LIB_DIR nbproject/Makefile-Release.mk`
 LD_SCRIPT2=`get_make_var LD_SCRIPT2 nbproject/Makefile-Release.mk`
 ENTRY_SYMBOL=`get_make_var ENTRY_SYMBOL nbproject/Makefile-Release.mk`
+LD_WRAP=`get_make_var LD_WRAP nbproject/Makefile-Release.mk`
 LIBS=`get_make_var LIBS nbproject/Makefile-Release.mk`
 LIB_GROUP=`get_make_var LIB_GROUP nbproject/Makefile-Release.mk`
 CND_ARTIFACT_DIR_Release=`get_make_var CND_ARTIFACT_DIR_Release nbproject/Makefile-Release.mk`
+MAP_FILE1=$CND_ARTIFACT_DIR_Release/rom1.elf.map
 
 ESPTOOL=`get_make_var ESPTOOL nbproject/Makefile-Release.mk`
 ESPTOOL2=`get_make_var ESPTOOL2 nbproject/Makefile-Release.mk`
@@ -65,28 +67,66 @@ UPGRADER_CLIENT=`get_make_var UPGRADER_CLIENT nbproject/Makefile-Release.mk`
 UPGRADER_SERVER=`get_make_var UPGRADER_SERVER nbproject/Makefile-Release.mk`
 UPGRADER_URL=`get_make_var UPGRADER_URL nbproject/Makefile-Release.mk`
 
+DELTA_PORT=8000
+
+# where the slots start and where the history sectors begin (HISTORY_FLASH_SECTOR in user_config.h)
+ROM0_ADDR=0x02000
+ROM1_ADDR=0x82000
+HISTORY_ADDR=$(( `awk '/#define HISTORY_FLASH_SECTOR /{ print $3 }' user_config.h` * 4096 ))
+
 #echo "OBJECTFILES: $OBJECTFILES"
 #echo "LIB_DIR: $LIB_DIR"
 #echo "LD_SCRIPT2: $LD_SCRIPT2"
 #echo "ENTRY_SYMBOL: $ENTRY_SYMBOL"
 #echo "CND_ARTIFACT_DIR_Release: $CND_ARTIFACT_DIR_Release"
 
-echo "$LD -o $CND_ARTIFACT_DIR_Release/rom1.elf $OBJECTFILES -Wl,--no-check-sections -L$LIB_DIR -nostdlib -fno-rtti -T$LD_SCRIPT2 -u $ENTRY_SYMBOL -Wl,-static -Wl,--start-group $LIB_GROUP -Wl,--end-group"
+echo "$LD -o $CND_ARTIFACT_DIR_Release/rom1.elf $OBJECTFILES -Wl,--no-check-sections -L$LIB_DIR -nostdlib -fno-rtti -T$LD_SCRIPT2 -u $ENTRY_SYMBOL $LD_WRAP -Wl,-Map=$MAP_FILE1 -Wl,-static -Wl,--start-group $LIB_GROUP -Wl,--end-group"
 
 # run linker for ROM slot 1 (NetBeans takes care of ROM slot 0)
-$LD -o $CND_ARTIFACT_DIR_Release/rom1.elf $OBJECTFILES -Wl,--no-check-sections -L$LIB_DIR -nostdlib -fno-rtti -T$LD_SCRIPT2 -u $ENTRY_SYMBOL -Wl,-static -Wl,--start-group $LIB_GROUP -Wl,--end-group
+$LD -o $CND_ARTIFACT_DIR_Release/rom1.elf $OBJECTFILES -Wl,--no-check-sections -L$LIB_DIR -nostdlib -fno-rtti -T$LD_SCRIPT2 -u $ENTRY_SYMBOL $LD_WRAP -Wl,-Map=$MAP_FILE1 -Wl,-static -Wl,--start-group $LIB_GROUP -Wl,--end-group
+
+# DRAM use of slot 1; the build reports slot 0
+python3 dram.py $MAP_FILE1 $MAP_FILE1.last && cp $MAP_FILE1 $MAP_FILE1.last
 
 #
 echo Running $ESPTOOL2 ...
 $ESPTOOL2 $FW_USER_ARGS $CND_ARTIFACT_DIR_Release/rom1.elf $CND_ARTIFACT_DIR_Release/rom1.bin $FW_SECTS
 
+# neither image may run into the next slot or the history sectors
+ROM0_END=$(( ROM0_ADDR + `stat -c %s $CND_ARTIFACT_DIR_Release/rom0.bin` ))
+ROM1_END=$(( ROM1_ADDR + `stat -c %s $CND_ARTIFACT_DIR_Release/rom1.bin` ))
+
+if [ $ROM0_END -gt $(( ROM1_ADDR )) ]; then
+	printf "rom0.bin ends at 0x%x, past slot 1 at 0x%x\n" $ROM0_END $ROM1_ADDR
+	exit 1
+fi
+if [ $ROM1_END -gt $HISTORY_ADDR ]; then
+	printf "rom1.bin ends at 0x%x, past the history sectors at 0x%x\n" $ROM1_END $HISTORY_ADDR
+	exit 1
+fi
+
 if [ ! $# == 2 ]; then
 	echo Running $ESPTOOL ...
         $ESPTOOL -p $ESPPORT read_mac
-	$ESPTOOL -p $ESPPORT write_flash -fs $FLASH_SIZE 0x00000 $RBOOT 0x02000 $CND_ARTIFACT_DIR_Release/rom0.bin 0x82000 $CND_ARTIFACT_DIR_Release/rom1.bin 0xfc000 $BLANK4
-#	$ESPTOOL -p $ESPPORT --baud $ESPBAUD write_flash -fs $FLASH_SIZE 0x00000 $RBOOT 0x02000 $CND_ARTIFACT_DIR_Release/rom0.bin 0x82000 $CND_ARTIFACT_DIR_Release/rom1.bin 0xfc000 $BLANK4
+	$ESPTOOL -p $ESPPORT write_flash -fs $FLASH_SIZE 0x00000 $RBOOT $ROM0_ADDR $CND_ARTIFACT_DIR_Release/rom0.bin $ROM1_ADDR $CND_ARTIFACT_DIR_Release/rom1.bin 0xfc000 $BLANK4
+#	$ESPTOOL -p $ESPPORT --baud $ESPBAUD write_flash -fs $FLASH_SIZE 0x00000 $RBOOT $ROM0_ADDR $CND_ARTIFACT_DIR_Release/rom0.bin $ROM1_ADDR $CND_ARTIFACT_DIR_Release/rom1.bin 0xfc000 $BLANK4
 elif [[ "$1" == "ota" ]]; then
         echo Running OTA tool ...
 	$UPGRADER_CLIENT --ip=$UPGRADER_SERVER update pkgid $UPGRADER_PKGID version $2 server $UPGRADER_URL bin0 $CND_ARTIFACT_DIR_Release/rom0.bin bin1 $CND_ARTIFACT_DIR_Release/rom1.bin
+
+	# what the units run now; base for the next delta images
+	mkdir -p $CND_ARTIFACT_DIR_Release/deployed
+	cp $CND_ARTIFACT_DIR_Release/rom0.bin $CND_ARTIFACT_DIR_Release/rom1.bin $CND_ARTIFACT_DIR_Release/deployed/
+elif [[ "$1" == "delta" ]]; then
+        echo Running delta tool ...
+	# a unit running slot 1 is upgraded to slot 0 and vice versa
+	python3 mkdelta.py diff $CND_ARTIFACT_DIR_Release/deployed/rom1.bin $CND_ARTIFACT_DIR_Release/rom0.bin $CND_ARTIFACT_DIR_Release/rom0.dlt
+	python3 mkdelta.py diff $CND_ARTIFACT_DIR_Release/deployed/rom0.bin $CND_ARTIFACT_DIR_Release/rom1.bin $CND_ARTIFACT_DIR_Release/rom1.dlt
+
+	# units fetch rom<slot>.dlt from here when sent "delta" with http://<this host>:$DELTA_PORT/
+	echo Serving patches on port $DELTA_PORT, Ctrl-C when all units are done ...
+	(cd $CND_ARTIFACT_DIR_Release && python3 -m http.server $DELTA_PORT)
+
+	cp $CND_ARTIFACT_DIR_Release/rom0.bin $CND_ARTIFACT_DIR_Release/rom1.bin $CND_ARTIFACT_DIR_Release/deployed/
 fi
 
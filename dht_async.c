@@ -0,0 +1,254 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <ets_sys.h>
+#include <gpio.h>
+#include "dht_async.h"
+
+#define EDGE_MASK           (DHT_ASYNC_EDGES - 1)
+#define FRAME_BITS          40
+
+/******************************************************************************************************************
+ * local variables
+ *
+ */
+
+static DHT_ASYNC*   m_Sensors[DHT_ASYNC_MAX_SENSORS];
+static uint8_t      m_Count = 0;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void DhtAsync_Release(void* arg);
+static void DhtAsync_Isr(void* arg);
+static void DhtAsync_SetInterrupt(DHT_ASYNC* dht, GPIO_INT_TYPE type);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param dht
+ * @param gpio
+ * @return 
+ */
+int ICACHE_FLASH_ATTR DhtAsync_Initialize(DHT_ASYNC* dht, uint8_t gpio)
+{
+    if(m_Count >= DHT_ASYNC_MAX_SENSORS) {
+        return -1;
+    }
+    
+    os_memset(dht, 0, sizeof(DHT_ASYNC));
+    
+    dht->gpio  = gpio;
+    dht->state = DhtAsyncIdle;
+    
+    os_timer_disarm(&dht->timer);
+    os_timer_setfn(&dht->timer, DhtAsync_Release, dht);
+
+    GPIO_DIS_OUTPUT(gpio);
+    DhtAsync_SetInterrupt(dht, GPIO_PIN_INTR_DISABLE);
+    
+    if(m_Count == 0) {
+        ETS_GPIO_INTR_ATTACH(DhtAsync_Isr, NULL);
+        ETS_GPIO_INTR_ENABLE();
+    }
+    
+    m_Sensors[m_Count++] = dht;
+    
+    return 0;
+}
+/**
+ * 
+ * @param dht
+ */
+void ICACHE_FLASH_ATTR DhtAsync_Start(DHT_ASYNC* dht)
+{
+    DhtAsync_SetInterrupt(dht, GPIO_PIN_INTR_DISABLE);
+    
+    dht->head  = 0;
+    dht->state = DhtAsyncStart;
+
+    // start signal; DhtAsync_Release() lets go of the line again
+    GPIO_OUTPUT_SET(dht->gpio, 0);
+    
+    os_timer_disarm(&dht->timer);
+    os_timer_arm(&dht->timer, DHT_ASYNC_START_MS, 0);
+}
+/**
+ * 
+ * @param dht
+ * @param temperature
+ * @param humidity
+ * @return 
+ */
+int ICACHE_FLASH_ATTR DhtAsync_Decode(DHT_ASYNC* dht, int16_t* temperature, int16_t* humidity)
+{
+    uint16_t highs[DHT_ASYNC_EDGES / 2];
+    uint8_t  data[FRAME_BITS / 8];
+    uint16_t count = 0;
+    uint16_t first = 0;
+    uint16_t head;
+    uint16_t i;
+    int16_t  t;
+    
+    if(dht->state == DhtAsyncStart) {
+        return DHT_ASYNC_BUSY;
+    }
+    
+    DhtAsync_SetInterrupt(dht, GPIO_PIN_INTR_DISABLE);
+    
+    if(dht->state != DhtAsyncCapture) {
+        return DHT_ASYNC_TIMEOUT;                               // never started
+    }
+    
+    dht->state = DhtAsyncIdle;
+    head       = dht->head;
+    
+    if(head > DHT_ASYNC_EDGES) {
+        dht->overruns++;                                        // noise; only the newest edges are left
+        first = head - DHT_ASYNC_EDGES;
+    }
+    
+    //
+    // measure the length of every high pulse
+    //
+    for(i = first; i + 1 < head; i++) {
+        uint16_t a = dht->edges[i & EDGE_MASK];
+        uint16_t b = dht->edges[(i + 1) & EDGE_MASK];
+        
+        if((a & 1) == 1 && (b & 1) == 0) {
+            highs[count++] = (uint16_t)((b & 0xfffe) - (a & 0xfffe));
+        }
+    }
+    
+    //
+    // the frame is the sensor's 80 us response followed by 40 data bits - anything before that is our own start
+    // signal being released
+    //
+    if(count < FRAME_BITS + 1) {
+        dht->timeouts++;
+        return DHT_ASYNC_TIMEOUT;
+    }
+    
+    first = count - FRAME_BITS;
+    
+    if(highs[first - 1] < DHT_ASYNC_RESPONSE_MIN || highs[first - 1] > DHT_ASYNC_RESPONSE_MAX) {
+        dht->frameErrors++;
+        return DHT_ASYNC_FRAME;
+    }
+    
+    os_memset(data, 0, sizeof(data));
+    
+    for(i = 0; i < FRAME_BITS; i++) {
+        uint16_t len = highs[first + i];
+        
+        if(len > DHT_ASYNC_BIT_MAX) {
+            dht->frameErrors++;
+            return DHT_ASYNC_FRAME;
+        }
+        
+        data[i / 8] <<= 1;
+        
+        if(len > DHT_ASYNC_BIT_THRESHOLD) {
+            data[i / 8] |= 1;
+        }
+    }
+    
+    if(((data[0] + data[1] + data[2] + data[3]) & 0xff) != data[4]) {
+        dht->checksumErrors++;
+        return DHT_ASYNC_CHECKSUM;
+    }
+    
+    t = ((data[2] & 0x7f) << 8) | data[3];
+    
+    if(data[2] & 0x80) {
+        t = -t;
+    }
+    
+    *temperature = t;
+    *humidity    = (data[0] << 8) | data[1];
+    
+    dht->frames++;
+    
+    return DHT_ASYNC_OK;
+}
+/**
+ * end of start signal - listen for the reply
+ * 
+ * @param arg
+ */
+static void ICACHE_FLASH_ATTR DhtAsync_Release(void* arg)
+{
+    DHT_ASYNC* dht = (DHT_ASYNC*)arg;
+    
+    dht->state = DhtAsyncCapture;
+    
+    DhtAsync_SetInterrupt(dht, GPIO_PIN_INTR_ANYEDGE);
+    GPIO_DIS_OUTPUT(dht->gpio);
+}
+/**
+ * 
+ * @param dht
+ * @param type
+ */
+static void ICACHE_FLASH_ATTR DhtAsync_SetInterrupt(DHT_ASYNC* dht, GPIO_INT_TYPE type)
+{
+    ETS_GPIO_INTR_DISABLE();
+    
+    GPIO_REG_WRITE(GPIO_STATUS_W1TC_ADDRESS, BIT(dht->gpio));
+    gpio_pin_intr_state_set(GPIO_ID_PIN(dht->gpio), type);
+    
+    ETS_GPIO_INTR_ENABLE();
+}
+/**
+ * runs from IRAM - keep it short
+ * 
+ * @param arg
+ */
+static void DhtAsync_Isr(void* arg)
+{
+    uint32_t status = GPIO_REG_READ(GPIO_STATUS_ADDRESS);
+    uint32_t level  = GPIO_REG_READ(GPIO_IN_ADDRESS);
+    uint16_t now    = (uint16_t)system_get_time();
+    uint8_t  n;
+    
+    GPIO_REG_WRITE(GPIO_STATUS_W1TC_ADDRESS, status);
+    
+    for(n = 0; n < m_Count; n++) {
+        DHT_ASYNC* dht = m_Sensors[n];
+        
+        if((status & BIT(dht->gpio)) && dht->state == DhtAsyncCapture) {
+            dht->edges[dht->head & EDGE_MASK] = (now & 0xfffe) | ((level >> dht->gpio) & 1);
+            dht->head++;
+        }
+    }
+}
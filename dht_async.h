@@ -0,0 +1,109 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef DHT_ASYNC_H
+#define DHT_ASYNC_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * non-blocking DHT22 reader
+ *
+ * DhtAsync_Start() pulls the line low and returns. An os_timer releases it again and the GPIO edge interrupt
+ * records a timestamp for every edge of the sensor's reply into a ring. DhtAsync_Decode(), called from the task
+ * once DHT_ASYNC_FRAME_MS has passed, turns the edges into temperature and humidity. Any number of sensors can
+ * be sampled at the same time.
+ */
+#define DHT_ASYNC_MAX_SENSORS       4
+#define DHT_ASYNC_EDGES             128                             // must be a power of 2; a frame has ~86 edges
+#define DHT_ASYNC_START_MS          2                               // host start signal
+#define DHT_ASYNC_FRAME_MS          10                              // start signal + reply (~5 ms)
+
+#define DHT_ASYNC_BIT_THRESHOLD     48                              // us; '0' is 26-28 us high, '1' is 70 us high
+#define DHT_ASYNC_BIT_MAX           100                             // us
+#define DHT_ASYNC_RESPONSE_MIN      50                              // us; sensor response is 80 us high
+#define DHT_ASYNC_RESPONSE_MAX      120                             // us
+
+#define DHT_ASYNC_OK                0
+#define DHT_ASYNC_BUSY              -1                              // conversion still running
+#define DHT_ASYNC_TIMEOUT           -2                              // too few edges - no sensor or truncated frame
+#define DHT_ASYNC_FRAME             -3                              // pulse timing out of spec
+#define DHT_ASYNC_CHECKSUM          -4
+
+typedef enum {
+    DhtAsyncIdle = 0,
+    DhtAsyncStart,
+    DhtAsyncCapture
+} DhtAsyncState;
+
+typedef struct {
+    uint8_t                 gpio;
+    volatile uint8_t        state;
+    volatile uint16_t       head;                                   // written by the ISR
+    volatile uint16_t       edges[DHT_ASYNC_EDGES];                 // timestamp in us, line level in bit 0
+    os_timer_t              timer;
+    
+    // statistics
+    uint32_t                frames;
+    uint32_t                timeouts;
+    uint32_t                frameErrors;
+    uint32_t                checksumErrors;
+    uint32_t                overruns;
+} DHT_ASYNC;
+
+/**
+ * the pin must already be configured as a GPIO input
+ * 
+ * @param dht
+ * @param gpio
+ * @return 0 on success
+ */
+int DhtAsync_Initialize(DHT_ASYNC* dht, uint8_t gpio);
+/**
+ * begin a conversion
+ * 
+ * @param dht
+ */
+void DhtAsync_Start(DHT_ASYNC* dht);
+/**
+ * 
+ * @param dht
+ * @param temperature   0.1 degree Celsius
+ * @param humidity      0.1 %RH
+ * @return DHT_ASYNC_OK or one of the negative error codes
+ */
+int DhtAsync_Decode(DHT_ASYNC* dht, int16_t* temperature, int16_t* humidity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DHT_ASYNC_H */
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# ESP8266 Non-OS Firmware
+# Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+#
+
+#
+# where the data RAM goes, from the linker map
+#
+#   dram.py <rom0.elf.map | rom1.elf.map> [<baseline.map>]
+#
+# .data, .rodata and .bss all live in the 80 KB of data RAM. Lists the objects and symbols that take the most of it
+# and, given the map of an earlier build, what each object gained or gave back since.
+#
+
+import os
+import re
+import sys
+
+DRAM     = ('.data', '.rodata', '.bss')
+FLASH    = ('.irom0.text',)
+TOP      = 20       # lines per list
+
+HEX      = re.compile(r'^0x[0-9a-fA-F]+$')
+
+
+def objname(path):
+    """libc.a(lib_a-memcpy.o) -> libc.a(memcpy.o), /x/y/main.o -> main.o"""
+    m = re.match(r'^(.*\.a)\((.*)\)$', path)
+    if m:
+        return '%s(%s)' % (os.path.basename(m.group(1)), m.group(2))
+    return os.path.basename(path)
+
+
+def parse(path):
+    """{output section: [(input section, address, size, object, [(address, symbol)])]}"""
+    sections = {}
+    current = None
+    pending = None      # input section name that wrapped onto the next line
+    inputs = None
+    for line in open(path, errors='replace'):
+        line = line.rstrip('\n')
+        if not line.strip():
+            continue
+        if line.startswith('Linker script and memory map'):
+            sections = {}
+            continue
+        fields = line.split()
+        # output section
+        if not line[0].isspace():
+            current = None
+            pending = None
+            if fields[0] in DRAM + FLASH:
+                current = fields[0]
+                inputs = sections.setdefault(current, [])
+            continue
+        if current is None:
+            continue
+        if line.startswith(' ') and not line.startswith('  ') and not fields[0].startswith('*'):
+            # input section, maybe with its address on the next line
+            if len(fields) == 1:
+                pending = fields[0]
+                continue
+            if len(fields) >= 4 and HEX.match(fields[1]) and HEX.match(fields[2]):
+                inputs.append((fields[0], int(fields[1], 16), int(fields[2], 16), objname(' '.join(fields[3:])), []))
+            pending = None
+            continue
+        if pending is not None:
+            if len(fields) >= 3 and HEX.match(fields[0]) and HEX.match(fields[1]):
+                inputs.append((pending, int(fields[0], 16), int(fields[1], 16), objname(' '.join(fields[2:])), []))
+            pending = None
+            continue
+        # symbol in the last input section
+        if len(fields) == 2 and HEX.match(fields[0]) and not HEX.match(fields[1]) and '=' not in line and inputs:
+            inputs[-1][4].append((int(fields[0], 16), fields[1]))
+    return sections
+
+
+def summary(sections):
+    """totals per output section, bytes per object and per symbol"""
+    totals = {}
+    objects = {}
+    symbols = {}
+    for name in DRAM + FLASH:
+        totals[name] = 0
+        for sect, addr, size, obj, syms in sections.get(name, []):
+            if size == 0:
+                continue
+            totals[name] += size
+            if name in FLASH:
+                continue
+            objects[obj] = objects.get(obj, 0) + size
+            # a symbol runs to the next one or to the end of its input section
+            syms = sorted(s for s in syms if addr <= s[0] < addr + size)
+            named = 0
+            for i, (a, sym) in enumerate(syms):
+                end = syms[i + 1][0] if i + 1 < len(syms) else addr + size
+                symbols[(sym, obj, name)] = symbols.get((sym, obj, name), 0) + end - a
+                named += end - a
+            # string literals and other unnamed data
+            if size - named > 0:
+                key = (sect if sect != 'COMMON' else name, obj, name)
+                symbols[key] = symbols.get(key, 0) + size - named
+    return totals, objects, symbols
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write('usage: dram.py <map> [<baseline map>]\n')
+        return 2
+    totals, objects, symbols = summary(parse(argv[1]))
+    dram = sum(totals[n] for n in DRAM)
+
+    print('data RAM: %d bytes' % dram)
+    for name in DRAM + FLASH:
+        print('  %-12s %7d' % (name, totals[name]))
+
+    print('\nobjects')
+    for obj, size in sorted(objects.items(), key=lambda o: -o[1])[:TOP]:
+        print('  %7d  %s' % (size, obj))
+
+    print('\nsymbols')
+    for (sym, obj, name), size in sorted(symbols.items(), key=lambda s: -s[1])[:TOP]:
+        print('  %7d  %-8s %-32s %s' % (size, name, sym, obj))
+
+    if len(argv) == 3 and os.path.exists(argv[2]):
+        before, objects_before, _ = summary(parse(argv[2]))
+        print('\nsince %s' % argv[2])
+        for name in DRAM + FLASH:
+            print('  %-12s %+7d' % (name, totals[name] - before[name]))
+        changed = []
+        for obj in set(objects) | set(objects_before):
+            d = objects.get(obj, 0) - objects_before.get(obj, 0)
+            if d != 0:
+                changed.append((d, obj))
+        for d, obj in sorted(changed)[:TOP]:
+            print('  %+7d  %s' % (d, obj))
+        reclaimed = sum(before[n] for n in DRAM) - dram
+        print('data RAM %s: %d bytes' % ('reclaimed' if reclaimed >= 0 else 'added', abs(reclaimed)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
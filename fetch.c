@@ -0,0 +1,317 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "fetch.h"
+#include "flash_str.h"
+
+#define ST_IDLE                 0
+#define ST_CONNECTING           1
+#define ST_HEADER               2
+#define ST_BODY                 3
+#define ST_CLOSED               4                                   // no more callbacks
+
+static void onConnect(void* arg);
+static void onError(void* arg, sint8 err);
+static void onDisconnect(void* arg);
+static void onReceive(void* arg, char* data, unsigned short len);
+static void header(FETCH* f, char c);
+static int  number(const char** p, uint32_t max, uint32_t* value);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param f
+ * @param url
+ * @param file
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Fetch_Start(FETCH* f, const char* url, const char* file)
+{
+    const char* p    = url;
+    const char* path;
+    uint32_t    port = 80;
+    uint32_t    v;
+    int         i;
+    
+    os_memset(f, 0, sizeof(FETCH));
+    
+    f->status = FETCH_ERROR_URL;
+    
+    if(os_strncmp(p, "http://", 7) != 0) {
+        return f->status;
+    }
+    
+    p += 7;
+    
+    for(i = 0; i < 4; i++) {
+        if(!number(&p, 255, &v) || (i < 3 && *p++ != '.')) {
+            return f->status;
+        }
+        
+        f->tcp.remote_ip[i] = v;
+    }
+    
+    if(*p == ':') {
+        p++;
+        
+        if(!number(&p, 65535, &port)) {
+            return f->status;
+        }
+    }
+    
+    if(*p != '\0' && *p != '/') {
+        return f->status;
+    }
+    
+    path = (*p == '\0') ? "/" : p;
+    
+    if(os_strlen(path) + os_strlen(file) + 48 > FETCH_REQUEST) {
+        return f->status;
+    }
+    
+    FlashStr_Sprintf(f->request, FLASH_STR("GET %s%s%s HTTP/1.0\r\nHost: %d.%d.%d.%d\r\n\r\n"), 
+                        path, (path[os_strlen(path) - 1] == '/') ? "" : "/", file,
+                        f->tcp.remote_ip[0], f->tcp.remote_ip[1], f->tcp.remote_ip[2], f->tcp.remote_ip[3]);
+    
+    f->tcp.remote_port  = port;
+    f->tcp.local_port   = espconn_port();
+    f->conn.type        = ESPCONN_TCP;
+    f->conn.state       = ESPCONN_NONE;
+    f->conn.proto.tcp   = &f->tcp;
+    f->conn.reverse     = f;
+    
+    espconn_regist_connectcb(&f->conn, onConnect);
+    espconn_regist_reconcb(&f->conn, onError);
+    espconn_regist_disconcb(&f->conn, onDisconnect);
+    espconn_regist_recvcb(&f->conn, onReceive);
+    
+    if(espconn_connect(&f->conn) != ESPCONN_OK) {
+        return f->status = FETCH_ERROR_CONNECT;
+    }
+    
+    f->state  = ST_CONNECTING;
+    f->status = FETCH_BUSY;
+    
+    return f->status;
+}
+/**
+ * 
+ * @param f
+ * @param data
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Fetch_Read(FETCH* f, const uint8_t** data)
+{
+    *data = f->buffer + f->pos;
+    
+    return f->length - f->pos;
+}
+/**
+ * 
+ * @param f
+ * @param len
+ */
+void ICACHE_FLASH_ATTR Fetch_Release(FETCH* f, uint32_t len)
+{
+    f->pos += len;
+    
+    if(f->pos >= f->length) {
+        f->pos    = 0;
+        f->length = 0;
+        
+        if(f->state == ST_BODY) {
+            espconn_recv_unhold(&f->conn);
+        }
+    }
+}
+/**
+ * 
+ * @param f
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Fetch_Status(FETCH* f)
+{
+    if(f->state != ST_IDLE && f->state != ST_CLOSED) {
+        return FETCH_BUSY;
+    }
+    
+    if(f->status == FETCH_BUSY && f->length == 0) {
+        return FETCH_OK;                                            // closed after the body, and all of it read
+    }
+    
+    return f->status;
+}
+/**
+ * 
+ * @param f
+ */
+void ICACHE_FLASH_ATTR Fetch_Stop(FETCH* f)
+{
+    if(f->state == ST_IDLE || f->state == ST_CLOSED) {
+        return;
+    }
+    
+    if(f->status == FETCH_BUSY) {
+        f->status = FETCH_ERROR_CLOSED;
+    }
+    
+    Fetch_Release(f, f->length);
+    
+    espconn_disconnect(&f->conn);
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param arg
+ */
+static void ICACHE_FLASH_ATTR onConnect(void* arg)
+{
+    FETCH* f = (FETCH*) ((struct espconn*) arg)->reverse;
+    
+    f->state = ST_HEADER;
+    
+    espconn_send(&f->conn, (uint8_t*) f->request, os_strlen(f->request));
+}
+/**
+ * 
+ * @param arg
+ * @param err
+ */
+static void ICACHE_FLASH_ATTR onError(void* arg, sint8 err)
+{
+    FETCH* f = (FETCH*) ((struct espconn*) arg)->reverse;
+    
+    if(f->status == FETCH_BUSY) {
+        f->status = (f->state == ST_CONNECTING) ? FETCH_ERROR_CONNECT : FETCH_ERROR_CLOSED;
+    }
+    
+    f->state = ST_CLOSED;
+}
+/**
+ * 
+ * @param arg
+ */
+static void ICACHE_FLASH_ATTR onDisconnect(void* arg)
+{
+    FETCH* f = (FETCH*) ((struct espconn*) arg)->reverse;
+    
+    if(f->status == FETCH_BUSY && f->state != ST_BODY) {
+        f->status = FETCH_ERROR_CLOSED;
+    }
+    
+    f->state = ST_CLOSED;
+}
+/**
+ * 
+ * @param arg
+ * @param data
+ * @param len
+ */
+static void ICACHE_FLASH_ATTR onReceive(void* arg, char* data, unsigned short len)
+{
+    FETCH*   f = (FETCH*) ((struct espconn*) arg)->reverse;
+    uint32_t i = 0;
+    
+    while(i < len && f->state == ST_HEADER) {
+        header(f, data[i++]);
+    }
+    
+    if(i == len || f->state != ST_BODY || f->status != FETCH_BUSY) {
+        return;
+    }
+    
+    // more may be in flight after the hold
+    if(f->pos > 0) {
+        os_memmove(f->buffer, f->buffer + f->pos, f->length - f->pos);
+        
+        f->length -= f->pos;
+        f->pos     = 0;
+    }
+    
+    if(f->length + (len - i) > FETCH_BUFFER) {
+        f->status = FETCH_ERROR_SIZE;
+        return;
+    }
+    
+    os_memcpy(f->buffer + f->length, data + i, len - i);
+    
+    f->length   += len - i;
+    f->received += len - i;
+    
+    espconn_recv_hold(&f->conn);                                    // until it is all read
+}
+/**
+ * one character of the response header; "HTTP/1.x 200 ..." and on to an empty line
+ * 
+ * @param f
+ * @param c
+ */
+static void ICACHE_FLASH_ATTR header(FETCH* f, char c)
+{
+    uint16_t n = f->headerLen++;
+    
+    if(n >= 9 && n < 12 && c != "200"[n - 9]) {
+        f->status = FETCH_ERROR_HTTP;                               // the server closes after the body anyway
+    }
+    
+    if(c == "\r\n\r\n"[f->match]) {
+        if(++f->match == 4) {
+            f->state = ST_BODY;
+        }
+    } else {
+        f->match = (c == '\r') ? 1 : 0;
+    }
+}
+/**
+ * 
+ * @param p
+ * @param max
+ * @param value
+ * @return 1 if there was a number no larger than 'max'
+ */
+static int ICACHE_FLASH_ATTR number(const char** p, uint32_t max, uint32_t* value)
+{
+    const char* s = *p;
+    
+    *value = 0;
+    
+    while(**p >= '0' && **p <= '9' && *value <= max) {
+        *value = *value * 10 + (*(*p)++ - '0');
+    }
+    
+    return *p != s && *value <= max;
+}
@@ -0,0 +1,114 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#ifndef FETCH_H
+#define FETCH_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+#include <ip_addr.h>
+#include <espconn.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * HTTP download
+ *
+ * A plain HTTP/1.0 GET from a numeric address; the server closes the connection when the body is complete. The
+ * body is read from the connection's buffer at the caller's pace: while there is something in it, receiving is
+ * held, so nothing has to be done in the network callbacks and a slow reader just slows the transfer down.
+ * A body cut short looks complete here; what is fetched has to tell by itself, as a delta patch does.
+ *
+ * The network stack may call back until the connection is gone, so a FETCH must stay put until Fetch_Status()
+ * returns something other than FETCH_BUSY, also after Fetch_Stop().
+ */
+#define FETCH_BUFFER                1460                            // one TCP segment
+#define FETCH_REQUEST               128
+
+#define FETCH_BUSY                  1
+#define FETCH_OK                    0                               // all of the body is read
+#define FETCH_ERROR_URL             -1
+#define FETCH_ERROR_CONNECT         -2
+#define FETCH_ERROR_HTTP            -3                              // not 200 OK
+#define FETCH_ERROR_CLOSED          -4                              // before the body, or by Fetch_Stop()
+#define FETCH_ERROR_SIZE            -5                              // more than FETCH_BUFFER at once
+
+typedef struct {
+    struct espconn          conn;
+    esp_tcp                 tcp;
+    char                    request[FETCH_REQUEST];
+    int8_t                  status;
+    uint8_t                 state;
+    uint8_t                 match;                                  // header: characters of status or end seen
+    uint16_t                headerLen;
+    uint16_t                length;                                 // in buffer
+    uint16_t                pos;                                    // read from buffer
+    uint32_t                received;                               // body bytes so far
+    uint8_t                 buffer[FETCH_BUFFER];
+} FETCH;
+
+/**
+ * 
+ * @param f
+ * @param url           http://a.b.c.d[:port][/path/]
+ * @param file          appended to the path
+ * @return FETCH_BUSY, or an error
+ */
+int Fetch_Start(FETCH* f, const char* url, const char* file);
+/**
+ * 
+ * @param f
+ * @param data          out
+ * @return body bytes ready; 0 if none yet
+ */
+uint32_t Fetch_Read(FETCH* f, const uint8_t** data);
+/**
+ * the caller is done with some of what Fetch_Read() gave
+ * 
+ * @param f
+ * @param len
+ */
+void Fetch_Release(FETCH* f, uint32_t len);
+/**
+ * 
+ * @param f
+ * @return FETCH_BUSY while connected or there is still something to read, FETCH_OK or an error
+ */
+int Fetch_Status(FETCH* f);
+/**
+ * 
+ * @param f
+ */
+void Fetch_Stop(FETCH* f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FETCH_H */
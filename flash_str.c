@@ -0,0 +1,157 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "flash_str.h"
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param dst
+ * @param src
+ * @param len
+ */
+void ICACHE_FLASH_ATTR FlashStr_Read(void* dst, const void* src, uint32_t len)
+{
+    const uint32_t* p     = (const uint32_t*) ((uintptr_t) src & ~3);
+    uint32_t        shift = ((uintptr_t) src & 3) * 8;
+    uint8_t*        d     = (uint8_t*) dst;
+    uint32_t        word  = *p++;
+    
+    while(len-- > 0) {
+        *d++ = (uint8_t) (word >> shift);                           // little endian
+        
+        shift += 8;
+        
+        if(shift == 32 && len > 0) {
+            word  = *p++;
+            shift = 0;
+        }
+    }
+}
+/**
+ * 
+ * @param s
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR FlashStr_Length(const char* s)
+{
+    const uint32_t* p     = (const uint32_t*) ((uintptr_t) s & ~3);
+    uint32_t        shift = ((uintptr_t) s & 3) * 8;
+    uint32_t        len   = 0;
+    uint32_t        word  = *p++;
+    
+    while(((word >> shift) & 0xff) != 0) {
+        len++;
+        shift += 8;
+        
+        if(shift == 32) {
+            word  = *p++;
+            shift = 0;
+        }
+    }
+    
+    return len;
+}
+/**
+ * 
+ * @param dst
+ * @param src
+ * @param size
+ * @return 
+ */
+char* ICACHE_FLASH_ATTR FlashStr_Copy(char* dst, const char* src, uint32_t size)
+{
+    uint32_t len = FlashStr_Length(src);
+    
+    if(len >= size) {
+        len = size - 1;
+    }
+    
+    FlashStr_Read(dst, src, len);
+    dst[len] = '\0';
+    
+    return dst;
+}
+/**
+ * 
+ * @param buffer
+ * @param format
+ * @return 
+ */
+int ICACHE_FLASH_ATTR FlashStr_Sprintf(char* buffer, const char* format, ...)
+{
+    va_list args;
+    int     n;
+    
+    va_start(args, format);
+    n = FlashStr_Vsnprintf(buffer, 0x7fffffff, format, args);          // as unbounded as os_sprintf()
+    va_end(args);
+    
+    return n;
+}
+/**
+ * 
+ * @param buffer
+ * @param size
+ * @param format
+ * @return 
+ */
+int ICACHE_FLASH_ATTR FlashStr_Snprintf(char* buffer, uint32_t size, const char* format, ...)
+{
+    va_list args;
+    int     n;
+    
+    va_start(args, format);
+    n = FlashStr_Vsnprintf(buffer, size, format, args);
+    va_end(args);
+    
+    return n;
+}
+/**
+ * 
+ * @param buffer
+ * @param size
+ * @param format
+ * @param args
+ * @return 
+ */
+int ICACHE_FLASH_ATTR FlashStr_Vsnprintf(char* buffer, uint32_t size, const char* format, va_list args)
+{
+    char    fmt[FLASH_STR_FORMAT_MAX];
+    int     n;
+    
+    FlashStr_Copy(fmt, format, sizeof(fmt));
+    
+    n = ets_vsnprintf(buffer, size, fmt, args);
+    
+    // ets_vsnprintf() returns what it would have written
+    return (n < (int) size) ? n : (int) size - 1;
+}
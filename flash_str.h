@@ -0,0 +1,110 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef FLASH_STR_H
+#define FLASH_STR_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * strings in flash
+ *
+ * String literals end up in .rodata, which the ESP8266 keeps in data RAM. FLASH_STR("...") puts one in flash instead
+ * and gives a pointer to it:
+ *
+ *      FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Heap %lu"), heap);
+ *
+ * The LOG_* macros in log.h do the same for their format.
+ *
+ * Flash can only be read 32 bits at a time from aligned addresses, so such a pointer must never be handed to code
+ * that reads it byte by byte - os_printf(), os_strcpy() and the like, or a library that keeps it. Use the functions
+ * below, or copy it to RAM first with FlashStr_Copy(). The same goes for %s arguments.
+ */
+#ifndef STORE_ATTR
+#define STORE_ATTR                  __attribute__((aligned(4)))
+#endif
+
+#define FLASH_STR(s)                (__extension__({ static const char __s[] ICACHE_RODATA_ATTR STORE_ATTR = (s); &__s[0]; }))
+
+#define FLASH_STR_FORMAT_MAX        160                             // longer formats are cut
+
+/**
+ * 
+ * @param dst
+ * @param src       in flash
+ * @param len
+ */
+void FlashStr_Read(void* dst, const void* src, uint32_t len);
+/**
+ * 
+ * @param s         in flash
+ * @return 
+ */
+uint32_t FlashStr_Length(const char* s);
+/**
+ * 
+ * @param dst
+ * @param src       in flash
+ * @param size      of dst, including the terminating 0
+ * @return dst
+ */
+char* FlashStr_Copy(char* dst, const char* src, uint32_t size);
+/**
+ * os_sprintf() with the format in flash
+ * 
+ * @param buffer
+ * @param format    in flash
+ * @return number of characters written, not counting the terminating 0
+ */
+int FlashStr_Sprintf(char* buffer, const char* format, ...);
+/**
+ * 
+ * @param buffer
+ * @param size
+ * @param format    in flash
+ * @return number of characters written, not counting the terminating 0
+ */
+int FlashStr_Snprintf(char* buffer, uint32_t size, const char* format, ...);
+/**
+ * 
+ * @param buffer
+ * @param size
+ * @param format    in flash
+ * @param args
+ * @return number of characters written, not counting the terminating 0
+ */
+int FlashStr_Vsnprintf(char* buffer, uint32_t size, const char* format, va_list args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_STR_H */
@@ -0,0 +1,145 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "forward.h"
+#include "flash_str.h"
+
+// room left for the end of the message
+#define TAIL_SIZE                   48
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param f
+ * @param policy
+ */
+void ICACHE_FLASH_ATTR Forward_Initialize(FORWARD* f, int policy)
+{
+    os_memset(f, 0, sizeof(FORWARD));
+    
+    f->policy = policy;
+}
+/**
+ * 
+ * @param f
+ * @param type
+ * @param value
+ * @param time
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Forward_Add(FORWARD* f, uint8_t type, int16_t value, uint32_t time)
+{
+    FORWARD_EVENT* e;
+    
+    if(f->count == FORWARD_EVENTS) {
+        f->dropped++;
+        
+        if(f->policy == FORWARD_DROP_NEWEST) {
+            return 0;
+        }
+        
+        // make room by losing the oldest
+        f->head = (f->head + 1) % FORWARD_EVENTS;
+        f->count--;
+    }
+    
+    e = &f->events[(f->head + f->count) % FORWARD_EVENTS];
+    
+    e->time  = time;
+    e->value = value;
+    e->type  = type;
+    
+    f->count++;
+    
+    return 1;
+}
+/**
+ * 
+ * @param f
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Forward_Count(FORWARD* f)
+{
+    return f->count;
+}
+/**
+ * 
+ * @param f
+ * @param buffer
+ * @param size
+ * @param max
+ * @param now
+ * @param wall
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Forward_Format(FORWARD* f, char* buffer, uint32_t size, int max, uint32_t now, uint32_t wall)
+{
+    char            item[32];
+    char*           p   = buffer;
+    char*           end = buffer + size - TAIL_SIZE;
+    FORWARD_EVENT*  e;
+    uint32_t        time;
+    int             n, len;
+    
+    p += FlashStr_Sprintf(p, FLASH_STR("{\"clock\":\"%s\",\"forward\":["), (wall != 0) ? "utc" : "uptime");
+    
+    for(n = 0; n < max && n < f->count; n++) {
+        e    = &f->events[(f->head + n) % FORWARD_EVENTS];
+        time = (wall != 0) ? wall - (now - e->time) : e->time;
+        len  = FlashStr_Sprintf(item, FLASH_STR("%s[%lu,%u,%d]"), (n > 0) ? "," : "", time, e->type, e->value);
+        
+        if(p + len > end) {
+            break;
+        }
+        
+        os_memcpy(p, item, len);
+        p += len;
+    }
+    
+    FlashStr_Sprintf(p, FLASH_STR("],\"dropped\":%lu,\"left\":%u}"), f->dropped, f->count - n);
+    
+    return n;
+}
+/**
+ * 
+ * @param f
+ * @param n
+ */
+void ICACHE_FLASH_ATTR Forward_Commit(FORWARD* f, int n)
+{
+    if(n > f->count) {
+        n = f->count;
+    }
+    
+    f->head       = (f->head + n) % FORWARD_EVENTS;
+    f->count     -= n;
+    f->forwarded += n;
+}
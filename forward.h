@@ -0,0 +1,113 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef FORWARD_H
+#define FORWARD_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * store and forward
+ *
+ * Events that could not be published while offline are kept in a fixed ring and sent in batches when we are back.
+ * Events are stamped with uptime; Forward_Format() turns that into wall clock time if the clock is synced by then.
+ * When the ring is full the policy decides what is lost - either way it is counted.
+ */
+#define FORWARD_EVENTS              128
+
+#define FORWARD_DROP_OLDEST         0       // keep the latest events
+#define FORWARD_DROP_NEWEST         1       // keep the start of the outage
+
+typedef struct {
+    uint32_t                time;                                   // uptime, seconds
+    int16_t                 value;
+    uint8_t                 type;
+    uint8_t                 reserved;
+} FORWARD_EVENT;
+
+typedef struct {
+    FORWARD_EVENT           events[FORWARD_EVENTS];
+    uint16_t                head;                                   // oldest event
+    uint16_t                count;
+    uint8_t                 policy;
+    
+    // statistics
+    uint32_t                dropped;
+    uint32_t                forwarded;
+} FORWARD;
+
+/**
+ * 
+ * @param f
+ * @param policy
+ */
+void Forward_Initialize(FORWARD* f, int policy);
+/**
+ * 
+ * @param f
+ * @param type
+ * @param value
+ * @param time      uptime, seconds
+ * @return 1 if stored, 0 if dropped
+ */
+int Forward_Add(FORWARD* f, uint8_t type, int16_t value, uint32_t time);
+/**
+ * 
+ * @param f
+ * @return number of events waiting
+ */
+uint32_t Forward_Count(FORWARD* f);
+/**
+ * format up to 'max' of the oldest events as JSON - as many as fit in 'size' bytes, which must be at least 96. The 
+ * events stay in the ring until Forward_Commit()
+ * 
+ * @param f
+ * @param buffer
+ * @param size
+ * @param max
+ * @param now       uptime, seconds
+ * @param wall      wall clock time now, 0 if not known
+ * @return number of events formatted
+ */
+int Forward_Format(FORWARD* f, char* buffer, uint32_t size, int max, uint32_t now, uint32_t wall);
+/**
+ * remove the 'n' oldest events once they are sent
+ * 
+ * @param f
+ * @param n
+ */
+void Forward_Commit(FORWARD* f, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FORWARD_H */
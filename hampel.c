@@ -0,0 +1,133 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "hampel.h"
+
+static int16_t median(const int16_t* values, int n);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param f
+ * @param minDeviation
+ */
+void ICACHE_FLASH_ATTR Hampel_Initialize(HAMPEL* f, int16_t minDeviation)
+{
+    os_memset(f, 0, sizeof(HAMPEL));
+    
+    f->minDeviation = minDeviation;
+}
+/**
+ * 
+ * @param f
+ * @param value
+ * @return 
+ */
+int16_t ICACHE_FLASH_ATTR Hampel_Filter(HAMPEL* f, int16_t value)
+{
+    int16_t  deviation[HAMPEL_WINDOW];
+    int16_t  med;
+    int32_t  limit;
+    int      i;
+    
+    // the window keeps the raw readings, so a real step change gets through after a few readings
+    f->window[f->head] = value;
+    f->head            = (f->head + 1) % HAMPEL_WINDOW;
+    
+    if(f->count < HAMPEL_WINDOW) {
+        f->count++;
+    }
+    
+    if(f->count < 3) {
+        return value;
+    }
+    
+    med = median(f->window, f->count);
+    
+    for(i = 0; i < f->count; i++) {
+        deviation[i] = (f->window[i] > med) ? f->window[i] - med : med - f->window[i];
+    }
+    
+    // 3 * 1.4826 * MAD
+    limit = (9 * (int32_t) median(deviation, f->count)) / 2;
+    
+    if(limit < f->minDeviation) {
+        limit = f->minDeviation;
+    }
+    
+    if(value - med > limit || med - value > limit) {
+        f->rejected++;
+        return med;
+    }
+    
+    return value;
+}
+/**
+ * 
+ * @param f
+ */
+void ICACHE_FLASH_ATTR Hampel_Reset(HAMPEL* f)
+{
+    f->head  = 0;
+    f->count = 0;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * insertion sort of a copy; n is at most HAMPEL_WINDOW
+ * 
+ * @param values
+ * @param n
+ * @return 
+ */
+static int16_t ICACHE_FLASH_ATTR median(const int16_t* values, int n)
+{
+    int16_t sorted[HAMPEL_WINDOW];
+    int16_t v;
+    int     i, j;
+    
+    for(i = 0; i < n; i++) {
+        v = values[i];
+        
+        for(j = i; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        
+        sorted[j] = v;
+    }
+    
+    return sorted[n / 2];
+}
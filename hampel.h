@@ -0,0 +1,79 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef HAMPEL_H
+#define HAMPEL_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * Hampel filter
+ *
+ * A reading further from the median of the last HAMPEL_WINDOW readings than 3 scaled median absolute deviations
+ * (but at least 'minDeviation') is an outlier and is replaced by the median. Fixed window, so constant time per
+ * reading. Until the window holds 3 readings everything is passed through.
+ */
+#define HAMPEL_WINDOW               5
+
+typedef struct {
+    int16_t                 window[HAMPEL_WINDOW];
+    uint8_t                 head;
+    uint8_t                 count;
+    int16_t                 minDeviation;
+    
+    // statistics
+    uint32_t                rejected;
+} HAMPEL;
+
+/**
+ * 
+ * @param f
+ * @param minDeviation
+ */
+void Hampel_Initialize(HAMPEL* f, int16_t minDeviation);
+/**
+ * 
+ * @param f
+ * @param value
+ * @return filtered value
+ */
+int16_t Hampel_Filter(HAMPEL* f, int16_t value);
+/**
+ * 
+ * @param f
+ */
+void Hampel_Reset(HAMPEL* f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAMPEL_H */
@@ -0,0 +1,143 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "health.h"
+
+static uint32_t* m_StackTop;                                        // painted area; m_StackBottom .. m_StackTop
+static uint32_t* m_StackBottom;
+
+static void     paintStack(void);
+static uint32_t stackUsed(void);
+static uint32_t largestBlock(uint32_t limit);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param h
+ */
+void ICACHE_FLASH_ATTR Health_Initialize(HEALTH* h)
+{
+    os_memset(h, 0, sizeof(HEALTH));
+    
+    paintStack();
+    
+    h->heapLow = 0xffffffff;
+    
+    Health_Sample(h);
+}
+/**
+ * 
+ * @param h
+ */
+void ICACHE_FLASH_ATTR Health_Sample(HEALTH* h)
+{
+    h->heapFree = system_get_free_heap_size();
+    
+    if(h->heapFree < h->heapLow) {
+        h->heapLow = h->heapFree;
+    }
+    
+    h->samples++;
+}
+/**
+ * 
+ * @param h
+ */
+void ICACHE_FLASH_ATTR Health_Update(HEALTH* h)
+{
+    Health_Sample(h);
+    
+    h->heapLargest = largestBlock(h->heapFree);
+    h->stackUsed   = stackUsed();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * fill HEALTH_STACK_PAINT bytes below our own frame with the canary
+ */
+static void ICACHE_FLASH_ATTR paintStack(void)
+{
+    volatile uint32_t marker;
+    uint32_t*         p;
+    
+    m_StackTop    = (uint32_t*) &marker - 32;                       // leave room for our own frame
+    m_StackBottom = m_StackTop - HEALTH_STACK_PAINT / 4;
+    
+    for(p = m_StackBottom; p < m_StackTop; p++) {
+        *p = HEALTH_CANARY;
+    }
+}
+/**
+ * 
+ * @return bytes of the painted area that have been overwritten
+ */
+static uint32_t ICACHE_FLASH_ATTR stackUsed(void)
+{
+    uint32_t* p = m_StackBottom;
+    
+    while(p < m_StackTop && *p == HEALTH_CANARY) {
+        p++;
+    }
+    
+    return (m_StackTop - p) * 4;
+}
+/**
+ * binary search for the largest block the allocator will hand out
+ * 
+ * @param limit
+ * @return 
+ */
+static uint32_t ICACHE_FLASH_ATTR largestBlock(uint32_t limit)
+{
+    uint32_t low  = 0;
+    uint32_t high = limit;
+    uint32_t size;
+    void*    p;
+    
+    while(high - low > 16) {
+        size = (low + high) / 2;
+        
+        if((p = os_malloc(size)) != 0) {
+            os_free(p);
+            low = size;
+        }
+        else {
+            high = size;
+        }
+    }
+    
+    return low;
+}
@@ -0,0 +1,76 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * heap and stack health
+ *
+ * Health_Sample() is cheap enough to call on every pass; it only tracks the heap low-water mark. The largest free
+ * block (found by probing the allocator) and the stack high-water mark (found by scanning a painted canary area
+ * below the stack pointer at Health_Initialize()) are only computed by Health_Update().
+ */
+#define HEALTH_STACK_PAINT          3072                            // bytes of stack watched
+#define HEALTH_CANARY               0xa5a5a5a5
+
+typedef struct {
+    uint32_t                heapFree;
+    uint32_t                heapLow;                                // low-water mark
+    uint32_t                heapLargest;                            // largest block that could be allocated
+    uint32_t                stackUsed;                              // bytes of the painted area used
+    uint32_t                samples;
+} HEALTH;
+
+/**
+ * call from user_init() - the stack is painted from there
+ * 
+ * @param h
+ */
+void Health_Initialize(HEALTH* h);
+/**
+ * 
+ * @param h
+ */
+void Health_Sample(HEALTH* h);
+/**
+ * 
+ * @param h
+ */
+void Health_Update(HEALTH* h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEALTH_H */
@@ -0,0 +1,505 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "history.h"
+#include <spi_flash.h>
+
+/******************************************************************************************************************
+ * encoding
+ *
+ */
+#define HDR_DT                  0x10                                // time step differs from interval
+#define HDR_STATE               0x20                                // state byte follows
+#define HDR_SMALL               0x40                                // value deltas packed in nibbles
+#define HDR_VALUES              0x0f                                // one bit per changed value
+
+#define MAX_SAMPLE_SIZE         20
+
+#define BLOCKS_PER_SECTOR       (SPI_FLASH_SEC_SIZE / HISTORY_BLOCK_SIZE)
+#define ERASED                  0xffffffff
+
+static HISTORY_BLOCK m_Scratch;                                     // block read from flash
+
+static uint8_t*  putVarint(uint8_t* p, uint32_t v);
+static uint8_t*  getVarint(uint8_t* p, uint32_t* v);
+static int       encodeKey(uint8_t* p, const HISTORY_SAMPLE* s);
+static int       encodeDelta(HISTORY* h, uint8_t* p, const HISTORY_SAMPLE* s);
+static int       decode(HISTORY* h, HISTORY_BLOCK* b, uint32_t clock, uint32_t first, HISTORY_SAMPLE* s, int max);
+static void      closeBlock(HISTORY* h);
+static uint32_t  oldestSeq(HISTORY* h);
+static HISTORY_BLOCK* getBlock(HISTORY* h, uint32_t seq);
+
+#define ZIGZAG(v)               ((((uint32_t) (v)) << 1) ^ (uint32_t) ((v) >> 31))
+#define UNZIGZAG(u)             ((int32_t) ((u) >> 1) ^ -((int32_t) ((u) & 1)))
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param h
+ * @param interval
+ * @param flashSector
+ * @param flashSectors
+ */
+void ICACHE_FLASH_ATTR History_Initialize(HISTORY* h, uint32_t interval, uint16_t flashSector, uint16_t flashSectors)
+{
+    uint32_t newest = ERASED;
+    uint32_t seq;
+    uint32_t i;
+    
+    os_memset(h, 0, sizeof(HISTORY));
+    
+    h->interval     = interval;
+    h->flashSector  = flashSector;
+    h->flashSectors = flashSectors;
+    
+    m_Scratch.seq   = ERASED;
+    
+    if(flashSectors > 0) {
+        // continue numbering after the newest block in flash
+        for(i = 0; i < (uint32_t) flashSectors * BLOCKS_PER_SECTOR; i++) {
+            if(spi_flash_read(flashSector * SPI_FLASH_SEC_SIZE + i * HISTORY_BLOCK_SIZE, &seq, sizeof(seq)) != SPI_FLASH_RESULT_OK) {
+                h->flashErrors++;
+            }
+            else if(seq != ERASED && (newest == ERASED || seq > newest)) {
+                newest = seq;
+            }
+        }
+        
+        if(newest != ERASED) {
+            // the rest of the newest sector is not erased; start on a fresh one and leave the written ones for History_Read()
+            h->seq = (newest / BLOCKS_PER_SECTOR + 1) * BLOCKS_PER_SECTOR;
+        }
+    }
+    
+    h->firstSeq = h->seq;
+    
+    h->block[h->seq % HISTORY_BLOCKS].seq = h->seq;
+}
+/**
+ * 
+ * @param h
+ * @param s
+ */
+void ICACHE_FLASH_ATTR History_Add(HISTORY* h, const HISTORY_SAMPLE* s)
+{
+    HISTORY_BLOCK* b = &h->block[h->seq % HISTORY_BLOCKS];
+    uint8_t        buf[MAX_SAMPLE_SIZE];
+    int            n;
+    
+    n = (b->count == 0) ? encodeKey(buf, s) : encodeDelta(h, buf, s);
+    
+    if(b->used + n > sizeof(b->data)) {
+        closeBlock(h);
+        
+        b = &h->block[h->seq % HISTORY_BLOCKS];
+        n = encodeKey(buf, s);
+    }
+    
+    os_memcpy(b->data + b->used, buf, n);
+    
+    b->used += n;
+    b->count++;
+    
+    h->last = *s;
+    
+    h->samples++;
+    h->bytes += n;
+}
+/**
+ * 
+ * @param h
+ * @param clock
+ */
+void ICACHE_FLASH_ATTR History_SetClock(HISTORY* h, uint32_t clock)
+{
+    if(h->clock == 0) {
+        h->clock = clock;
+    }
+}
+/**
+ * 
+ * @param h
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR History_Count(HISTORY* h)
+{
+    uint32_t       count = 0;
+    uint32_t       seq;
+    HISTORY_BLOCK* b;
+    
+    for(seq = oldestSeq(h); seq <= h->seq; seq++) {
+        if((b = getBlock(h, seq)) != 0) {
+            count += b->count;
+        }
+    }
+    
+    return count;
+}
+/**
+ * 
+ * @param h
+ * @param first
+ * @param s
+ * @param max
+ * @return 
+ */
+int ICACHE_FLASH_ATTR History_Read(HISTORY* h, uint32_t first, HISTORY_SAMPLE* s, int max)
+{
+    int            n = 0;
+    uint32_t       seq;
+    HISTORY_BLOCK* b;
+    
+    for(seq = oldestSeq(h); seq <= h->seq && n < max; seq++) {
+        if((b = getBlock(h, seq)) == 0) {
+            continue;
+        }
+        
+        if(first >= b->count) {
+            first -= b->count;
+            continue;
+        }
+        
+        // blocks of this boot may have gone to flash before the clock was known
+        n    += decode(h, b, (seq >= h->firstSeq) ? h->clock : b->clock, first, s + n, max - n);
+        first = 0;
+    }
+    
+    return n;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param p
+ * @param v
+ * @return 
+ */
+static uint8_t* ICACHE_FLASH_ATTR putVarint(uint8_t* p, uint32_t v)
+{
+    while(v >= 0x80) {
+        *p++ = (uint8_t) (v | 0x80);
+        v >>= 7;
+    }
+    
+    *p++ = (uint8_t) v;
+    
+    return p;
+}
+/**
+ * 
+ * @param p
+ * @param v
+ * @return 
+ */
+static uint8_t* ICACHE_FLASH_ATTR getVarint(uint8_t* p, uint32_t* v)
+{
+    int shift = 0;
+    
+    *v = 0;
+    
+    do {
+        *v    |= (uint32_t) (*p & 0x7f) << shift;
+        shift += 7;
+    } while((*p++ & 0x80) && shift < 35);
+    
+    return p;
+}
+/**
+ * 
+ * @param p
+ * @param s
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR encodeKey(uint8_t* p, const HISTORY_SAMPLE* s)
+{
+    uint8_t* start = p;
+    int      i;
+    
+    p = putVarint(p, s->time);
+    
+    for(i = 0; i < HISTORY_VALUES; i++) {
+        p = putVarint(p, ZIGZAG((int32_t) s->value[i]));
+    }
+    
+    *p++ = s->state;
+    
+    return p - start;
+}
+/**
+ * 
+ * @param h
+ * @param p
+ * @param s
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR encodeDelta(HISTORY* h, uint8_t* p, const HISTORY_SAMPLE* s)
+{
+    uint8_t* start = p;
+    uint8_t  hdr   = HDR_SMALL;
+    uint32_t dt    = s->time - h->last.time;
+    int32_t  delta[HISTORY_VALUES];
+    int      i, n;
+    
+    for(i = 0; i < HISTORY_VALUES; i++) {
+        delta[i] = (int32_t) s->value[i] - h->last.value[i];
+        
+        if(delta[i] != 0) {
+            hdr |= 1 << i;
+            
+            if(delta[i] < -8 || delta[i] > 7) {
+                hdr &= ~HDR_SMALL;
+            }
+        }
+    }
+    
+    if(dt != h->interval) {
+        hdr |= HDR_DT;
+    }
+    if(s->state != h->last.state) {
+        hdr |= HDR_STATE;
+    }
+    
+    *p++ = hdr;
+    
+    if(hdr & HDR_DT) {
+        p = putVarint(p, dt);
+    }
+    if(hdr & HDR_STATE) {
+        *p++ = s->state;
+    }
+    
+    for(i = 0, n = 0; i < HISTORY_VALUES; i++) {
+        if(delta[i] == 0) {
+            continue;
+        }
+        
+        if(hdr & HDR_SMALL) {
+            if(n++ & 1) {
+                p[-1] |= (uint8_t) ((delta[i] & 0x0f) << 4);
+            }
+            else {
+                *p++ = (uint8_t) (delta[i] & 0x0f);
+            }
+        }
+        else {
+            p = putVarint(p, ZIGZAG(delta[i]));
+        }
+    }
+    
+    return p - start;
+}
+/**
+ * 
+ * @param h
+ * @param b
+ * @param clock     added to the times
+ * @param first
+ * @param s
+ * @param max
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR decode(HISTORY* h, HISTORY_BLOCK* b, uint32_t clock, uint32_t first, HISTORY_SAMPLE* s, int max)
+{
+    HISTORY_SAMPLE cur;
+    uint8_t*       p   = b->data;
+    uint8_t*       end = b->data + b->used;
+    uint32_t       index;
+    uint32_t       u;
+    uint8_t        hdr, nibble = 0;
+    int            i, n = 0, k;
+    
+    for(index = 0; index < b->count && p < end && n < max; index++) {
+        if(index == 0) {
+            p = getVarint(p, &cur.time);
+            
+            for(i = 0; i < HISTORY_VALUES; i++) {
+                p = getVarint(p, &u);
+                cur.value[i] = (int16_t) UNZIGZAG(u);
+            }
+            
+            cur.state = *p++;
+        }
+        else {
+            hdr = *p++;
+            
+            if(hdr & HDR_DT) {
+                p = getVarint(p, &u);
+                cur.time += u;
+            }
+            else {
+                cur.time += h->interval;
+            }
+            
+            if(hdr & HDR_STATE) {
+                cur.state = *p++;
+            }
+            
+            for(i = 0, k = 0; i < HISTORY_VALUES; i++) {
+                if(!(hdr & (1 << i))) {
+                    continue;
+                }
+                
+                if(hdr & HDR_SMALL) {
+                    if(k++ & 1) {
+                        nibble >>= 4;
+                    }
+                    else {
+                        nibble = *p++;
+                    }
+                    
+                    cur.value[i] += (int16_t) ((int8_t) (nibble << 4) >> 4);
+                }
+                else {
+                    p = getVarint(p, &u);
+                    cur.value[i] += (int16_t) UNZIGZAG(u);
+                }
+            }
+        }
+        
+        if(index >= first) {
+            s[n]       = cur;
+            s[n].time += clock;
+            n++;
+        }
+    }
+    
+    return n;
+}
+/**
+ * spill the current block to flash and start a new one
+ * 
+ * @param h
+ */
+static void ICACHE_FLASH_ATTR closeBlock(HISTORY* h)
+{
+    HISTORY_BLOCK* b = &h->block[h->seq % HISTORY_BLOCKS];
+    uint32_t       slot;
+    uint32_t       addr;
+    
+    if(h->flashSectors > 0) {
+        b->clock = h->clock;
+        
+        slot = h->seq % ((uint32_t) h->flashSectors * BLOCKS_PER_SECTOR);
+        addr = h->flashSector * SPI_FLASH_SEC_SIZE + slot * HISTORY_BLOCK_SIZE;
+        
+        if(slot % BLOCKS_PER_SECTOR == 0) {
+            if(spi_flash_erase_sector(h->flashSector + slot / BLOCKS_PER_SECTOR) != SPI_FLASH_RESULT_OK) {
+                h->flashErrors++;
+            }
+        }
+        
+        if(spi_flash_write(addr, (uint32_t*) b, sizeof(HISTORY_BLOCK)) != SPI_FLASH_RESULT_OK) {
+            h->flashErrors++;
+        }
+    }
+    
+    h->seq++;
+    
+    b = &h->block[h->seq % HISTORY_BLOCKS];
+    
+    b->seq   = h->seq;
+    b->clock = 0;
+    b->count = 0;
+    b->used  = 0;
+}
+/**
+ * 
+ * @param h
+ * @return oldest block that can be read
+ */
+static uint32_t ICACHE_FLASH_ATTR oldestSeq(HISTORY* h)
+{
+    uint32_t back  = HISTORY_BLOCKS - 1;
+    uint32_t first = (h->clock != 0) ? 0 : h->firstSeq;             // earlier boots only on a common time base
+    uint32_t flash;
+    
+    if(h->flashSectors > 0 && h->seq > 0) {
+        // erasing a sector drops the blocks it held; count full sectors plus the written part of the current one
+        flash = (h->flashSectors - 1) * BLOCKS_PER_SECTOR + (h->seq - 1) % BLOCKS_PER_SECTOR + 1;
+        
+        if(flash > back) {
+            back = flash;
+        }
+    }
+    
+    if(h->seq - first < back) {
+        return first;
+    }
+    
+    return h->seq - back;
+}
+/**
+ * 
+ * @param h
+ * @param seq
+ * @return block in RAM, or read from flash into scratch buffer
+ */
+static HISTORY_BLOCK* ICACHE_FLASH_ATTR getBlock(HISTORY* h, uint32_t seq)
+{
+    uint32_t slot;
+    
+    if(h->seq - seq < HISTORY_BLOCKS && seq >= h->firstSeq) {
+        return &h->block[seq % HISTORY_BLOCKS];
+    }
+    
+    if(h->flashSectors == 0) {
+        return 0;
+    }
+    
+    if(m_Scratch.seq == seq) {
+        return &m_Scratch;
+    }
+    
+    slot = seq % ((uint32_t) h->flashSectors * BLOCKS_PER_SECTOR);
+    
+    if(spi_flash_read(h->flashSector * SPI_FLASH_SEC_SIZE + slot * HISTORY_BLOCK_SIZE, (uint32_t*) &m_Scratch, sizeof(HISTORY_BLOCK)) != SPI_FLASH_RESULT_OK) {
+        h->flashErrors++;
+        m_Scratch.seq = ERASED;
+        return 0;
+    }
+    
+    if(m_Scratch.seq != seq || m_Scratch.used > sizeof(m_Scratch.data)) {
+        m_Scratch.seq = ERASED;
+        return 0;
+    }
+    
+    if(seq < h->firstSeq && m_Scratch.clock == 0) {
+        // an earlier boot that never learned the time; its uptime can't be placed
+        return 0;
+    }
+    
+    return &m_Scratch;
+}
@@ -0,0 +1,130 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * sensor history
+ *
+ * Samples are delta encoded into fixed size blocks. The first sample in a block is stored in full; the following
+ * ones as a header byte telling which fields changed, followed by the changes - packed in nibbles when they are
+ * small, as zigzag varints when not. A typical 60 s sample takes 2-3 bytes.
+ *
+ * The newest HISTORY_BLOCKS blocks are kept in RAM. With HISTORY_FLASH_SECTORS > 0 every completed block is also
+ * written to flash, which extends the history to HISTORY_FLASH_SECTORS * 16 blocks and keeps it across a reboot.
+ *
+ * Samples are stamped with uptime, which starts over at boot. Until History_SetClock() is told the wall clock only
+ * the blocks written since boot are served, in uptime. From then on the blocks of earlier boots that know their own
+ * clock are served as well, and all times are wall clock.
+ */
+#define HISTORY_BLOCK_SIZE          256                             // flash sector size must be a multiple
+#define HISTORY_BLOCKS              16                              // in RAM
+
+#define HISTORY_HEATERS             0x7f                            // HISTORY_SAMPLE.state; bit n: heater stage n+1
+#define HISTORY_FAN                 0x80
+
+#define HISTORY_VALUES              4
+
+typedef struct {
+    uint32_t                time;                                   // seconds
+    int16_t                 value[HISTORY_VALUES];                  // indoor temp/hum, outdoor temp/hum; 0.1 units
+    uint8_t                 state;
+} HISTORY_SAMPLE;
+
+typedef struct {
+    uint32_t                seq;                                    // 0xffffffff: erased flash
+    uint32_t                clock;                                  // wall clock at uptime 0; 0: not known
+    uint16_t                count;                                  // number of samples
+    uint16_t                used;                                   // bytes of 'data' used
+    uint8_t                 data[HISTORY_BLOCK_SIZE - 12];
+} HISTORY_BLOCK;
+
+typedef struct {
+    HISTORY_BLOCK           block[HISTORY_BLOCKS];
+    uint32_t                seq;                                    // current block
+    uint32_t                firstSeq;                               // first block since boot
+    uint32_t                interval;                               // nominal time between samples
+    uint32_t                clock;                                  // wall clock at uptime 0; 0: not known yet
+    HISTORY_SAMPLE          last;
+    uint16_t                flashSector;
+    uint16_t                flashSectors;
+    
+    // statistics
+    uint32_t                samples;                                // added since boot
+    uint32_t                bytes;                                  // encoded size of those samples
+    uint32_t                flashErrors;
+} HISTORY;
+
+/**
+ * 
+ * @param h
+ * @param interval      nominal seconds between samples
+ * @param flashSector   first flash sector to spill to
+ * @param flashSectors  0 to keep the history in RAM only
+ */
+void History_Initialize(HISTORY* h, uint32_t interval, uint16_t flashSector, uint16_t flashSectors);
+/**
+ * 
+ * @param h
+ * @param s
+ */
+void History_Add(HISTORY* h, const HISTORY_SAMPLE* s);
+/**
+ * the first call with a clock other than 0 sticks; later ones are ignored so the time base stays put
+ * 
+ * @param h
+ * @param clock     wall clock time at uptime 0, 0 if not known
+ */
+void History_SetClock(HISTORY* h, uint32_t clock);
+/**
+ * 
+ * @param h
+ * @return number of samples that can be read
+ */
+uint32_t History_Count(HISTORY* h);
+/**
+ * 
+ * @param h
+ * @param first     index of first sample; 0 is the oldest
+ * @param s
+ * @param max
+ * @return number of samples read; times are wall clock once the clock is set, uptime before
+ */
+int History_Read(HISTORY* h, uint32_t first, HISTORY_SAMPLE* s, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTORY_H */
@@ -0,0 +1,352 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include <ets_sys.h>
+#include "interlock.h"
+#include "flash_str.h"
+
+// FRC1_CTRL_ADDRESS bits; the SDK only has them in its hw_timer.c example
+#define FRC1_ENABLE_TIMER       BIT(7)
+#define FRC1_AUTO_LOAD          BIT(6)
+#define FRC1_DIVIDED_BY_16      4           // 80 MHz / 16
+#define FRC1_TICKS_PER_MS       5000
+#define FRC1_MAX_LOAD           0x7fffff    // 23 bits
+
+#define SATURATED               0x80000000  // ms; past any limit
+
+static const char* m_Names[INTERLOCK_CAUSES] = { "loop", "stale", "overtemp", "on-time", "fan" };
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void Interlock_Isr(void* arg);
+static void Interlock_Trip(INTERLOCK* il, uint32_t cause, uint32_t reaction);
+static void Interlock_Count(INTERLOCK* il, uint32_t n, uint32_t* seen, uint32_t* since);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param il
+ * @param heaterMask
+ * @param heaterOn
+ * @param fanMask
+ * @param fanOn
+ * @param temp
+ */
+void ICACHE_FLASH_ATTR Interlock_Initialize(INTERLOCK* il, uint32_t heaterMask, uint32_t heaterOn, uint32_t fanMask, uint32_t fanOn, int16_t temp)
+{
+    os_memset(il, 0, sizeof(INTERLOCK));
+    
+    il->heaterMask = heaterMask;
+    il->heaterOn   = heaterOn & heaterMask;
+    il->fanMask    = fanMask;
+    il->fanOn      = fanOn & fanMask;
+    il->tick       = 100;
+    il->maxTemp    = 0x7fff;
+    il->loop       = 0xffffffff;
+    il->stale      = 0xffffffff;
+    il->temp       = temp;
+    il->kicked     = system_get_time();
+    il->fed        = il->kicked;
+}
+/**
+ * 
+ * @param il
+ * @param loop
+ * @param stale
+ * @param maxTemp
+ * @param hysteresis
+ * @param maxOn
+ * @param rest
+ */
+void ICACHE_FLASH_ATTR Interlock_Limits(INTERLOCK* il, uint32_t loop, uint32_t stale, int16_t maxTemp, int16_t hysteresis, uint32_t maxOn, uint32_t rest)
+{
+    // system_get_time() wraps after 71 minutes; the ms counters cover longer silences
+    il->loop       = loop * 1000000;
+    il->stale      = stale * 1000000;
+    il->maxTemp    = maxTemp;
+    il->hysteresis = hysteresis;
+    il->maxOn      = maxOn * 1000;
+    il->rest       = rest * 1000;
+}
+/**
+ * 
+ * @param il
+ * @param tick
+ */
+void ICACHE_FLASH_ATTR Interlock_Start(INTERLOCK* il, uint32_t tick)
+{
+    uint32_t load = tick * FRC1_TICKS_PER_MS;
+    
+    if(load > FRC1_MAX_LOAD) {
+        load = FRC1_MAX_LOAD;
+        tick = FRC1_MAX_LOAD / FRC1_TICKS_PER_MS;
+    }
+    
+    ETS_FRC1_INTR_DISABLE();
+    TM1_EDGE_INT_DISABLE();
+    
+    il->tick = tick;
+    
+    RTC_REG_WRITE(FRC1_CTRL_ADDRESS, FRC1_AUTO_LOAD | FRC1_DIVIDED_BY_16 | FRC1_ENABLE_TIMER);
+    RTC_REG_WRITE(FRC1_LOAD_ADDRESS, load);
+    
+    ETS_FRC_TIMER1_INTR_ATTACH(Interlock_Isr, il);
+    TM1_EDGE_INT_ENABLE();
+    ETS_FRC1_INTR_ENABLE();
+}
+/**
+ * 
+ * @param il
+ */
+void ICACHE_FLASH_ATTR Interlock_Kick(INTERLOCK* il)
+{
+    il->kicked = system_get_time();
+    il->kicks++;
+}
+/**
+ * 
+ * @param il
+ * @param temp
+ */
+void ICACHE_FLASH_ATTR Interlock_Feed(INTERLOCK* il, int16_t temp)
+{
+    il->temp = temp;
+    il->fed  = system_get_time();
+    il->feeds++;
+}
+/**
+ * 
+ * @param il
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Interlock_Blocked(INTERLOCK* il)
+{
+    return il->active & INTERLOCK_CUT;
+}
+/**
+ * runs from the timer interrupt - no flash
+ * 
+ * @param il
+ * @param now
+ * @param out
+ * @return 
+ */
+uint32_t Interlock_Check(INTERLOCK* il, uint32_t now, uint32_t out)
+{
+    uint32_t heaters = ~(out ^ il->heaterOn) & il->heaterMask;
+    uint32_t fan     = ~(out ^ il->fanOn) & il->fanMask;
+    uint32_t kicked  = il->kicked;
+    uint32_t fed     = il->fed;
+    int16_t  temp    = il->temp;
+    uint32_t cause   = 0;
+    uint32_t age     = 0;                                   // us since the oldest deadline passed
+    uint32_t want    = out;
+    
+    il->ticks++;
+    
+    Interlock_Count(il, il->kicks, &il->kicksSeen, &il->sinceKick);
+    Interlock_Count(il, il->feeds, &il->feedsSeen, &il->sinceFeed);
+    
+    if(now - kicked > il->loop) {
+        cause |= INTERLOCK_LOOP;
+        age    = now - kicked - il->loop;
+    } else if(il->sinceKick > il->loop / 1000 + il->tick) {
+        cause |= INTERLOCK_LOOP;                            // the us clock has wrapped
+    }
+    
+    if(now - fed > il->stale) {
+        cause |= INTERLOCK_STALE;
+        
+        if(now - fed - il->stale > age) {
+            age = now - fed - il->stale;
+        }
+    } else if(il->sinceFeed > il->stale / 1000 + il->tick) {
+        cause |= INTERLOCK_STALE;
+    }
+    
+    // tripped by a reading, and held until it has cooled down
+    if(temp >= il->maxTemp || ((il->active & INTERLOCK_OVERTEMP) && temp > il->maxTemp - il->hysteresis)) {
+        cause |= INTERLOCK_OVERTEMP;
+        
+        if(now - fed > age) {
+            age = now - fed;
+        }
+    }
+    
+    // continuous heat, then a rest
+    if(heaters != 0) {
+        if(il->onMs == 0) {
+            il->heatSeen = now;
+        }
+        
+        il->onMs += il->tick;
+    } else {
+        il->onMs = 0;
+    }
+    
+    if(il->resting > 0) {
+        il->resting -= (il->resting < il->tick) ? il->resting : il->tick;
+    }
+    
+    if(il->maxOn != 0 && il->onMs > il->maxOn) {
+        if((il->onMs - il->maxOn) * 1000 > age) {
+            age = (il->onMs - il->maxOn) * 1000;
+        }
+        
+        il->onMs    = 0;
+        il->resting = il->rest;
+        cause      |= INTERLOCK_ONTIME;
+    }
+    
+    if(il->resting > 0) {
+        cause |= INTERLOCK_ONTIME;
+    }
+    
+    if(cause != 0 && heaters != 0) {
+        want    = (want & ~il->heaterMask) | (~il->heaterOn & il->heaterMask);
+        heaters = 0;
+        
+        Interlock_Trip(il, cause, age);
+    }
+    
+    if(heaters != 0 && fan == 0) {
+        want   = (want & ~il->fanMask) | il->fanOn;
+        cause |= INTERLOCK_FAN;
+        
+        Interlock_Trip(il, INTERLOCK_FAN, now - il->heatSeen);
+    }
+    
+    il->active = cause;
+    
+    return want;
+}
+/**
+ * 
+ * @param il
+ * @param buffer
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Interlock_Format(INTERLOCK* il, char* buffer)
+{
+    return FlashStr_Sprintf(buffer, FLASH_STR("interlock: loop=%lu stale=%lu overtemp=%lu on-time=%lu fan=%lu "
+                                              "reaction last=%lu max=%lu us bound=%lu ms"), 
+                        il->trips[0], il->trips[1], il->trips[2], il->trips[3], il->trips[4], 
+                        il->lastReaction, il->maxReaction, il->tick);
+}
+/**
+ * 
+ * @param cause
+ * @return 
+ */
+const char* ICACHE_FLASH_ATTR Interlock_Name(uint32_t cause)
+{
+    int i;
+    
+    for(i = 0; i < INTERLOCK_CAUSES; i++) {
+        if(cause & (1 << i)) {
+            return m_Names[i];
+        }
+    }
+    
+    return "none";
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param arg
+ */
+static void Interlock_Isr(void* arg)
+{
+    INTERLOCK*  il = (INTERLOCK*) arg;
+    uint32_t    out;
+    uint32_t    want;
+    
+    RTC_CLR_REG_MASK(FRC1_INT_ADDRESS, FRC1_INT_CLR_MASK);
+    
+    out  = GPIO_REG_READ(GPIO_OUT_ADDRESS);
+    want = Interlock_Check(il, system_get_time(), out);
+    
+    if(want != out) {
+        GPIO_REG_WRITE(GPIO_OUT_W1TS_ADDRESS, want & ~out);
+        GPIO_REG_WRITE(GPIO_OUT_W1TC_ADDRESS, out & ~want);
+    }
+}
+/**
+ * relays were driven
+ * 
+ * @param il
+ * @param cause
+ * @param reaction
+ */
+static void Interlock_Trip(INTERLOCK* il, uint32_t cause, uint32_t reaction)
+{
+    int i;
+    
+    for(i = 0; i < INTERLOCK_CAUSES; i++) {
+        if(cause & (1 << i)) {
+            il->trips[i]++;
+        }
+    }
+    
+    il->cuts++;
+    il->lastCause    = cause;
+    il->lastReaction = reaction;
+    
+    if(reaction > il->maxReaction) {
+        il->maxReaction = reaction;
+    }
+}
+/**
+ * ms since the counter last moved
+ * 
+ * @param il
+ * @param n
+ * @param seen
+ * @param since
+ */
+static void Interlock_Count(INTERLOCK* il, uint32_t n, uint32_t* seen, uint32_t* since)
+{
+    if(n != *seen) {
+        *seen  = n;
+        *since = 0;
+    } else if(*since < SATURATED) {
+        *since += il->tick;
+    }
+}
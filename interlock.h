@@ -0,0 +1,176 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#ifndef INTERLOCK_H
+#define INTERLOCK_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * safety interlocks
+ *
+ * A hardware timer (FRC1) checks the relays every tick, whatever the main loop is doing, and forces the heaters off
+ * when
+ *  - the main loop has not been through Interlock_Kick() for a while (stalled in a read, a connect or an upgrade),
+ *  - no indoor reading has come in through Interlock_Feed() for a while,
+ *  - the last reading is too hot, until it has dropped by the hysteresis,
+ *  - a heater has been on without a break for too long; they are then held off for a rest period.
+ * It also turns the fan on if a heater is found on without it.
+ *
+ * The relay state is read back from the GPIO output register, so the timer sees what is really driven. A condition
+ * is acted on at the first tick after it arises: the worst-case reaction time is one tick plus the interrupt
+ * latency. The measured reaction - from the deadline, or the reading that tripped it, to the relays being driven -
+ * is recorded with each trip.
+ *
+ * The interlock does not re-arm anything; the main loop must hold the heaters off while Interlock_Blocked().
+ */
+#define INTERLOCK_LOOP              0x01                            // main loop stalled
+#define INTERLOCK_STALE             0x02                            // no recent indoor reading
+#define INTERLOCK_OVERTEMP          0x04
+#define INTERLOCK_ONTIME            0x08                            // on for too long, or resting after that
+#define INTERLOCK_FAN               0x10                            // heating without the fan
+#define INTERLOCK_CAUSES            5
+
+#define INTERLOCK_CUT               (INTERLOCK_LOOP | INTERLOCK_STALE | INTERLOCK_OVERTEMP | INTERLOCK_ONTIME)
+
+typedef struct {
+    uint32_t                heaterMask;                             // GPIO output bits
+    uint32_t                heaterOn;                               // their level when on
+    uint32_t                fanMask;
+    uint32_t                fanOn;
+    
+    uint32_t                tick;                                   // ms
+    uint32_t                loop;                                   // us
+    uint32_t                stale;                                  // us
+    int16_t                 maxTemp;                                // 0.1 C
+    int16_t                 hysteresis;
+    uint32_t                maxOn;                                  // ms
+    uint32_t                rest;                                   // ms
+    
+    volatile uint32_t       kicked;                                 // system_get_time() of the last Interlock_Kick()
+    volatile uint32_t       kicks;
+    volatile uint32_t       fed;                                    // .. and Interlock_Feed()
+    volatile uint32_t       feeds;
+    volatile int16_t        temp;
+    
+    uint32_t                kicksSeen;                              // by the timer
+    uint32_t                sinceKick;                              // ms
+    uint32_t                feedsSeen;
+    uint32_t                sinceFeed;
+    uint32_t                onMs;                                   // heaters on without a break
+    uint32_t                resting;                                // ms left
+    uint32_t                heatSeen;                               // system_get_time() heat was first seen on
+    
+    volatile uint8_t        active;                                 // INTERLOCK_* conditions at the last tick
+    volatile uint32_t       trips[INTERLOCK_CAUSES];                // relays driven because of it
+    volatile uint32_t       cuts;                                   // ticks that drove relays
+    volatile uint8_t        lastCause;
+    volatile uint32_t       lastReaction;                           // us
+    volatile uint32_t       maxReaction;
+    volatile uint32_t       ticks;
+} INTERLOCK;
+
+/**
+ * 
+ * @param il
+ * @param heaterMask    GPIO output bits of the heater relays; GPIO16 is not supported
+ * @param heaterOn      level of those bits when on
+ * @param fanMask
+ * @param fanOn
+ * @param temp          the current indoor reading
+ */
+void Interlock_Initialize(INTERLOCK* il, uint32_t heaterMask, uint32_t heaterOn, uint32_t fanMask, uint32_t fanOn, int16_t temp);
+/**
+ * 
+ * @param il
+ * @param loop          seconds without Interlock_Kick()
+ * @param stale         seconds without Interlock_Feed()
+ * @param maxTemp       0.1 C
+ * @param hysteresis    0.1 C
+ * @param maxOn         seconds; 0: no limit
+ * @param rest          seconds
+ */
+void Interlock_Limits(INTERLOCK* il, uint32_t loop, uint32_t stale, int16_t maxTemp, int16_t hysteresis, uint32_t maxOn, uint32_t rest);
+/**
+ * start the timer; it is the only user of FRC1
+ * 
+ * @param il
+ * @param tick          ms, 1 .. 1600
+ */
+void Interlock_Start(INTERLOCK* il, uint32_t tick);
+/**
+ * main loop heartbeat
+ * 
+ * @param il
+ */
+void Interlock_Kick(INTERLOCK* il);
+/**
+ * 
+ * @param il
+ * @param temp          a fresh indoor reading, 0.1 C
+ */
+void Interlock_Feed(INTERLOCK* il, int16_t temp);
+/**
+ * 
+ * @param il
+ * @return INTERLOCK_CUT conditions holding the heaters off
+ */
+uint32_t Interlock_Blocked(INTERLOCK* il);
+/**
+ * one tick, called from the timer interrupt; kept apart from the registers so it can be driven on a host
+ * 
+ * @param il
+ * @param now           system_get_time()
+ * @param out           GPIO output register
+ * @return the output register as it should be
+ */
+uint32_t Interlock_Check(INTERLOCK* il, uint32_t now, uint32_t out);
+/**
+ * one line summary of trips and reaction times
+ * 
+ * @param il
+ * @param buffer
+ * @return length
+ */
+int Interlock_Format(INTERLOCK* il, char* buffer);
+/**
+ * 
+ * @param cause         INTERLOCK_* bit
+ * @return 
+ */
+const char* Interlock_Name(uint32_t cause);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INTERLOCK_H */
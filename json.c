@@ -0,0 +1,582 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "json.h"
+
+typedef struct {
+    JSON*                   j;
+    uint32_t                pos;
+    uint32_t                length;
+} PARSER;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static int  Json_Value(PARSER* p, int depth);
+static int  Json_Container(PARSER* p, int depth);
+static int  Json_String(PARSER* p);
+static int  Json_Primitive(PARSER* p, int bare);
+static int  Json_Token(PARSER* p, uint8_t type, uint32_t start);
+static void Json_Space(PARSER* p);
+static int  Json_Hex(char c);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param j
+ * @param text
+ * @param length
+ * @param tokens
+ * @param max
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Json_Parse(JSON* j, const char* text, uint32_t length, JSON_TOKEN* tokens, int max)
+{
+    PARSER  p;
+    int     rc;
+    char    c;
+    
+    j->text  = text;
+    j->token = tokens;
+    j->count = 0;
+    j->max   = max;
+    
+    if(length > JSON_MAX_LENGTH) {
+        return JSON_ERROR_LENGTH;
+    }
+    
+    p.j      = j;
+    p.pos    = 0;
+    p.length = length;
+    
+    Json_Space(&p);
+    
+    if(p.pos >= length) {
+        return JSON_ERROR_SYNTAX;
+    }
+    
+    c = text[p.pos];
+    
+    if(c == '{' || c == '[' || c == '"') {
+        rc = Json_Value(&p, 0);
+    } else {
+        rc = Json_Primitive(&p, 1);
+    }
+    
+    if(rc < 0) {
+        j->count = 0;
+        return rc;
+    }
+    
+    Json_Space(&p);
+    
+    if(p.pos != length) {
+        j->count = 0;
+        return JSON_ERROR_SYNTAX;
+    }
+    
+    return j->count;
+}
+/**
+ * 
+ * @param j
+ * @param object
+ * @param key
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Json_Find(const JSON* j, int object, const char* key)
+{
+    int i, n;
+    
+    if(object < 0 || object >= j->count || j->token[object].type != JSON_OBJECT) {
+        return -1;
+    }
+    
+    i = object + 1;
+    
+    for(n = 0; n < j->token[object].size; n++) {
+        if(Json_Equal(j, i, key)) {
+            return i + 1;
+        }
+        
+        i = j->token[i + 1].next;
+    }
+    
+    return -1;
+}
+/**
+ * 
+ * @param j
+ * @param t
+ * @param s
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Json_Equal(const JSON* j, int t, const char* s)
+{
+    const char* p;
+    uint32_t    i;
+    
+    if(t < 0 || t >= j->count) {
+        return 0;
+    }
+    
+    p = j->text + j->token[t].start;
+    
+    for(i = 0; i < j->token[t].length; i++) {
+        if(s[i] != p[i]) {                                  // also stops at the end of 's'
+            return 0;
+        }
+    }
+    
+    return s[i] == '\0';
+}
+/**
+ * 
+ * @param j
+ * @param t
+ * @param value
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Json_Int(const JSON* j, int t, int32_t* value)
+{
+    const char* p;
+    uint32_t    i = 0, n;
+    uint32_t    v = 0;
+    int         negative = 0;
+    
+    if(t < 0 || t >= j->count || j->token[t].type != JSON_PRIMITIVE) {
+        return 0;
+    }
+    
+    p = j->text + j->token[t].start;
+    n = j->token[t].length;
+    
+    if(p[0] == '-') {
+        negative = 1;
+        i++;
+    }
+    
+    if(i == n) {
+        return 0;
+    }
+    
+    for(; i < n; i++) {
+        if(p[i] < '0' || p[i] > '9' || v > (0x7fffffff - (p[i] - '0')) / 10) {
+            return 0;
+        }
+        
+        v = v * 10 + (p[i] - '0');
+    }
+    
+    *value = negative ? -(int32_t) v : (int32_t) v;
+    
+    return 1;
+}
+/**
+ * 
+ * @param j
+ * @param t
+ * @param value
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Json_Tenths(const JSON* j, int t, int32_t* value)
+{
+    const char* p;
+    uint32_t    i = 0, n, digits = 0;
+    uint32_t    v = 0;
+    int         negative = 0;
+    
+    if(t < 0 || t >= j->count || j->token[t].type != JSON_PRIMITIVE) {
+        return 0;
+    }
+    
+    p = j->text + j->token[t].start;
+    n = j->token[t].length;
+    
+    if(p[0] == '-') {
+        negative = 1;
+        i++;
+    }
+    
+    for(; i < n && p[i] >= '0' && p[i] <= '9'; i++, digits++) {
+        if(v > (0x7fffffff / 10 - 9 - (p[i] - '0')) / 10) {
+            return 0;
+        }
+        
+        v = v * 10 + (p[i] - '0');
+    }
+    
+    if(digits == 0) {
+        return 0;
+    }
+    
+    v *= 10;
+    
+    if(i < n && p[i] == '.') {
+        i++;
+        
+        if(i == n) {
+            return 0;
+        }
+        
+        for(digits = 0; i < n && p[i] >= '0' && p[i] <= '9'; i++, digits++) {
+            if(digits == 0) {
+                v += p[i] - '0';
+            }
+        }
+        
+        if(digits == 0) {
+            return 0;
+        }
+    }
+    
+    if(i != n) {
+        return 0;                                           // no exponents
+    }
+    
+    *value = negative ? -(int32_t) v : (int32_t) v;
+    
+    return 1;
+}
+/**
+ * 
+ * @param j
+ * @param t
+ * @param buffer
+ * @param size
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Json_Copy(const JSON* j, int t, char* buffer, int size)
+{
+    const char* p;
+    uint32_t    i, n;
+    int         len = 0;
+    char        c;
+    
+    if(t < 0 || t >= j->count || size < 1) {
+        return -1;
+    }
+    
+    p = j->text + j->token[t].start;
+    n = j->token[t].length;
+    
+    for(i = 0; i < n; i++) {
+        c = p[i];
+        
+        if(c == '\\' && j->token[t].type == JSON_STRING) {
+            c = p[++i];                                     // the parser has checked there is one
+            
+            switch(c) {
+                case 'b':   c = '\b';   break;
+                case 'f':   c = '\f';   break;
+                case 'n':   c = '\n';   break;
+                case 'r':   c = '\r';   break;
+                case 't':   c = '\t';   break;
+                case 'u': {
+                    int u = (Json_Hex(p[i + 1]) << 12) | (Json_Hex(p[i + 2]) << 8) | (Json_Hex(p[i + 3]) << 4) | Json_Hex(p[i + 4]);
+                    
+                    c  = (u > 0 && u < 0x80) ? (char) u : '?';
+                    i += 4;
+                    break;
+                }
+            }
+        }
+        
+        if(len + 1 >= size) {
+            buffer[0] = '\0';
+            return -1;
+        }
+        
+        buffer[len++] = c;
+    }
+    
+    buffer[len] = '\0';
+    
+    return len;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param p
+ * @param depth
+ * @return token, or JSON_ERROR_*
+ */
+static int ICACHE_FLASH_ATTR Json_Value(PARSER* p, int depth)
+{
+    char c;
+    
+    Json_Space(p);
+    
+    if(p->pos >= p->length) {
+        return JSON_ERROR_SYNTAX;
+    }
+    
+    c = p->j->text[p->pos];
+    
+    if(c == '{' || c == '[') {
+        return Json_Container(p, depth);
+    } else if(c == '"') {
+        return Json_String(p);
+    } else if(c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+        return Json_Primitive(p, 0);
+    }
+    
+    return JSON_ERROR_SYNTAX;
+}
+/**
+ * 
+ * @param p
+ * @param depth
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR Json_Container(PARSER* p, int depth)
+{
+    const char* text   = p->j->text;
+    int         object = (text[p->pos] == '{');
+    char        close  = object ? '}' : ']';
+    uint32_t    start  = p->pos;
+    int         t, rc;
+    char        c;
+    
+    if(depth >= JSON_MAX_DEPTH) {
+        return JSON_ERROR_DEPTH;
+    }
+    
+    if((t = Json_Token(p, object ? JSON_OBJECT : JSON_ARRAY, start)) < 0) {
+        return t;
+    }
+    
+    p->pos++;
+    
+    Json_Space(p);
+    
+    if(p->pos < p->length && text[p->pos] == close) {
+        p->pos++;
+    } else {
+        for(;;) {
+            if(p->j->token[t].size == 0xff) {
+                return JSON_ERROR_TOKENS;
+            }
+            
+            if(object) {
+                Json_Space(p);
+                
+                if(p->pos >= p->length || text[p->pos] != '"') {
+                    return JSON_ERROR_SYNTAX;
+                }
+                
+                if((rc = Json_String(p)) < 0) {
+                    return rc;
+                }
+                
+                Json_Space(p);
+                
+                if(p->pos >= p->length || text[p->pos] != ':') {
+                    return JSON_ERROR_SYNTAX;
+                }
+                
+                p->pos++;
+            }
+            
+            if((rc = Json_Value(p, depth + 1)) < 0) {
+                return rc;
+            }
+            
+            p->j->token[t].size++;
+            
+            Json_Space(p);
+            
+            if(p->pos >= p->length) {
+                return JSON_ERROR_SYNTAX;
+            }
+            
+            c = text[p->pos++];
+            
+            if(c == close) {
+                break;
+            } else if(c != ',') {
+                return JSON_ERROR_SYNTAX;
+            }
+        }
+    }
+    
+    p->j->token[t].length = p->pos - start;
+    p->j->token[t].next   = p->j->count;
+    
+    return t;
+}
+/**
+ * 
+ * @param p
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR Json_String(PARSER* p)
+{
+    const char* text  = p->j->text;
+    uint32_t    start = ++p->pos;                           // past the quote
+    int         t, i;
+    char        c;
+    
+    while(p->pos < p->length) {
+        c = text[p->pos];
+        
+        if(c == '"') {
+            if((t = Json_Token(p, JSON_STRING, start)) < 0) {
+                return t;
+            }
+            
+            p->j->token[t].length = p->pos - start;
+            p->pos++;
+            
+            return t;
+        } else if(c == '\\') {
+            if(++p->pos >= p->length) {
+                break;
+            }
+            
+            switch(text[p->pos]) {
+                case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                    break;
+                case 'u':
+                    for(i = 1; i <= 4; i++) {
+                        if(p->pos + i >= p->length || Json_Hex(text[p->pos + i]) < 0) {
+                            return JSON_ERROR_SYNTAX;
+                        }
+                    }
+                    
+                    p->pos += 4;
+                    break;
+                default:
+                    return JSON_ERROR_SYNTAX;
+            }
+        } else if((uint8_t) c < 0x20) {
+            break;
+        }
+        
+        p->pos++;
+    }
+    
+    return JSON_ERROR_SYNTAX;
+}
+/**
+ * 
+ * @param p
+ * @param bare          any word, not just numbers and literals
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR Json_Primitive(PARSER* p, int bare)
+{
+    const char* text  = p->j->text;
+    uint32_t    start = p->pos;
+    int         t;
+    char        c;
+    
+    for(; p->pos < p->length; p->pos++) {
+        c = text[p->pos];
+        
+        if(c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == ':' || c == ']' || c == '}') {
+            break;
+        } else if((uint8_t) c < 0x20 || c == '"' || c == '[' || c == '{') {
+            return JSON_ERROR_SYNTAX;
+        } else if(!bare && !((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E')) {
+            return JSON_ERROR_SYNTAX;
+        }
+    }
+    
+    if((t = Json_Token(p, JSON_PRIMITIVE, start)) < 0) {
+        return t;
+    }
+    
+    p->j->token[t].length = p->pos - start;
+    
+    return t;
+}
+/**
+ * 
+ * @param p
+ * @param type
+ * @param start
+ * @return 
+ */
+static int ICACHE_FLASH_ATTR Json_Token(PARSER* p, uint8_t type, uint32_t start)
+{
+    JSON_TOKEN* t;
+    
+    if(p->j->count >= p->j->max) {
+        return JSON_ERROR_TOKENS;
+    }
+    
+    t         = &p->j->token[p->j->count];
+    t->type   = type;
+    t->size   = 0;
+    t->start  = start;
+    t->length = 0;
+    t->next   = ++p->j->count;
+    
+    return p->j->count - 1;
+}
+/**
+ * 
+ * @param p
+ */
+static void ICACHE_FLASH_ATTR Json_Space(PARSER* p)
+{
+    const char* text = p->j->text;
+    
+    while(p->pos < p->length && (text[p->pos] == ' ' || text[p->pos] == '\t' || text[p->pos] == '\r' || text[p->pos] == '\n')) {
+        p->pos++;
+    }
+}
+/**
+ * 
+ * @param c
+ * @return 0 .. 15, -1 if not a hex digit
+ */
+static int ICACHE_FLASH_ATTR Json_Hex(char c)
+{
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    } else if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    
+    return -1;
+}
@@ -0,0 +1,134 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * in-place JSON parsing
+ *
+ * Json_Parse() splits a payload into tokens - type, offset and length into the text - in an array the caller
+ * provides. Nothing is allocated or copied, and the text is not modified, so it need not be NUL terminated. The
+ * cost is one pass over at most JSON_MAX_LENGTH bytes; nesting is limited to JSON_MAX_DEPTH, which bounds the stack.
+ *
+ * Keys must be strings. At the top level a bare word - stop, show - is taken as a primitive, like a number.
+ *
+ * Each token knows where its value ends ('next'), so an object is searched without looking inside its members.
+ */
+#define JSON_OBJECT                 1
+#define JSON_ARRAY                  2
+#define JSON_STRING                 3                               // start/length exclude the quotes
+#define JSON_PRIMITIVE              4                               // number, true, false, null or a bare word
+
+#define JSON_ERROR_SYNTAX           -1
+#define JSON_ERROR_TOKENS           -2                              // more than the caller made room for
+#define JSON_ERROR_DEPTH            -3
+#define JSON_ERROR_LENGTH           -4
+
+#define JSON_MAX_DEPTH              4
+#define JSON_MAX_LENGTH             1024
+
+typedef struct {
+    uint8_t                 type;
+    uint8_t                 size;                                   // members of an object or array, max. 255
+    uint16_t                start;                                  // offset into the text
+    uint16_t                length;
+    uint16_t                next;                                   // token after this value
+} JSON_TOKEN;
+
+typedef struct {
+    const char*             text;
+    JSON_TOKEN*             token;
+    int                     count;
+    int                     max;
+} JSON;
+
+/**
+ * 
+ * @param j
+ * @param text
+ * @param length
+ * @param tokens
+ * @param max           tokens
+ * @return number of tokens, or JSON_ERROR_*
+ */
+int Json_Parse(JSON* j, const char* text, uint32_t length, JSON_TOKEN* tokens, int max);
+/**
+ * 
+ * @param j
+ * @param object        token
+ * @param key
+ * @return token of the value, -1 if not there
+ */
+int Json_Find(const JSON* j, int object, const char* key);
+/**
+ * 
+ * @param j
+ * @param t
+ * @param s
+ * @return 1 if the token text is 's'; strings are compared as written, escapes and all
+ */
+int Json_Equal(const JSON* j, int t, const char* s);
+/**
+ * 
+ * @param j
+ * @param t
+ * @param value
+ * @return 1 if the token is an integer that fits
+ */
+int Json_Int(const JSON* j, int t, int32_t* value);
+/**
+ * 
+ * @param j
+ * @param t
+ * @param value         0.1 units, further decimals are dropped
+ * @return 1 if the token is a number that fits
+ */
+int Json_Tenths(const JSON* j, int t, int32_t* value);
+/**
+ * unescaped and NUL terminated; \u escapes outside ASCII become '?'
+ * 
+ * @param j
+ * @param t
+ * @param buffer
+ * @param size
+ * @return length, -1 if it does not fit
+ */
+int Json_Copy(const JSON* j, int t, char* buffer, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSON_H */
@@ -0,0 +1,126 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+
+#include "latency.h"
+#include "flash_str.h"
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param h
+ * @param name
+ */
+void ICACHE_FLASH_ATTR Latency_Initialize(LATENCY* h, const char* name)
+{
+    h->name = name;
+    
+    Latency_Reset(h);
+}
+/**
+ * 
+ * @param h
+ * @param cycles
+ */
+void ICACHE_FLASH_ATTR Latency_Add(LATENCY* h, uint32_t cycles)
+{
+    int n = (cycles == 0) ? 0 : 31 - __builtin_clz(cycles);
+    
+    if(n >= LATENCY_BUCKETS) {
+        n = LATENCY_BUCKETS - 1;
+    }
+    
+    h->bucket[n]++;
+    h->count++;
+    
+    if(cycles < h->min) {
+        h->min = cycles;
+    }
+    if(cycles > h->max) {
+        h->max = cycles;
+    }
+}
+/**
+ * 
+ * @param h
+ * @param percent
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Latency_Percentile(LATENCY* h, uint32_t percent)
+{
+    uint32_t limit = (uint32_t) (((uint64_t) h->count * percent + 99) / 100);
+    uint32_t sum   = 0;
+    int      n;
+    
+    if(limit == 0) {
+        limit = 1;                                                  // p0 is the shortest one seen, not bucket 0
+    }
+    
+    for(n = 0; n < LATENCY_BUCKETS - 1; n++) {
+        sum += h->bucket[n];
+        
+        if(sum >= limit) {
+            // never worse than what we have actually seen
+            return ((2UL << n) - 1 < h->max) ? (2UL << n) - 1 : h->max;
+        }
+    }
+    
+    return h->max;
+}
+/**
+ * 
+ * @param h
+ * @param buffer
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Latency_Format(LATENCY* h, char* buffer)
+{
+    uint32_t mhz = system_get_cpu_freq();
+    
+    if(h->count == 0) {
+        return FlashStr_Sprintf(buffer, FLASH_STR("%s: n=0"), h->name);
+    }
+    
+    return FlashStr_Sprintf(buffer, FLASH_STR("%s: n=%lu min=%lu max=%lu p50<=%lu p99<=%lu us"), h->name, h->count, 
+                        h->min / mhz, h->max / mhz, Latency_Percentile(h, 50) / mhz, Latency_Percentile(h, 99) / mhz);
+}
+/**
+ * 
+ * @param h
+ */
+void ICACHE_FLASH_ATTR Latency_Reset(LATENCY* h)
+{
+    os_memset(h->bucket, 0, sizeof(h->bucket));
+    
+    h->count = 0;
+    h->min   = 0xffffffff;
+    h->max   = 0;
+}
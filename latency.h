@@ -0,0 +1,125 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * latency histograms
+ *
+ * Durations are measured in CPU cycles (CCOUNT) and counted in log2 buckets: bucket n holds durations of
+ * 2^n .. 2^(n+1)-1 cycles, the last one everything longer. Percentiles are therefore upper bounds within a factor 2.
+ * Host builds use system_get_time() instead of CCOUNT.
+ */
+#define LATENCY_BUCKETS             24                              // 2^24 cycles = 210 ms at 80 MHz
+
+typedef struct {
+    const char*             name;
+    uint32_t                bucket[LATENCY_BUCKETS];
+    uint32_t                count;
+    uint32_t                min;                                    // cycles
+    uint32_t                max;
+} LATENCY;
+
+/**
+ * 
+ * @return CPU cycle counter
+ */
+static inline uint32_t Latency_Cycles(void)
+{
+#ifdef __xtensa__
+    uint32_t ccount;
+    __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+    return ccount;
+#else
+    return system_get_time() * 80;
+#endif
+}
+
+/*
+ * A stage that runs inside another one - a callback - is measured with LATENCY_MEASURE_INNER(), which adds its time
+ * to 'inner' as well; the outer stage is measured with LATENCY_MEASURE_OUTER() on the same 'inner' and leaves that
+ * time out, so no time is counted in two histograms.
+ */
+#ifdef LATENCY_ENABLE
+#define LATENCY_MEASURE(h, stmt)    do { uint32_t _t = Latency_Cycles(); stmt; Latency_Add((h), Latency_Cycles() - _t); } while(0)
+#define LATENCY_MEASURE_INNER(h, inner, stmt) \
+                                    do { uint32_t _t = Latency_Cycles(); stmt; _t = Latency_Cycles() - _t; Latency_Add((h), _t); (inner) += _t; } while(0)
+#define LATENCY_MEASURE_OUTER(h, inner, stmt) \
+                                    do { uint32_t _t = Latency_Cycles(); (inner) = 0; stmt; Latency_Add((h), Latency_Cycles() - _t - (inner)); } while(0)
+#else
+#define LATENCY_MEASURE(h, stmt)    do { stmt; } while(0)
+#define LATENCY_MEASURE_INNER(h, inner, stmt) \
+                                    do { stmt; } while(0)
+#define LATENCY_MEASURE_OUTER(h, inner, stmt) \
+                                    do { stmt; } while(0)
+#endif
+
+/**
+ * 
+ * @param h
+ * @param name
+ */
+void Latency_Initialize(LATENCY* h, const char* name);
+/**
+ * 
+ * @param h
+ * @param cycles
+ */
+void Latency_Add(LATENCY* h, uint32_t cycles);
+/**
+ * 
+ * @param h
+ * @param percent
+ * @return upper bound in cycles
+ */
+uint32_t Latency_Percentile(LATENCY* h, uint32_t percent);
+/**
+ * one line summary, times in us
+ * 
+ * @param h
+ * @param buffer
+ * @return length
+ */
+int Latency_Format(LATENCY* h, char* buffer);
+/**
+ * 
+ * @param h
+ */
+void Latency_Reset(LATENCY* h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_H */
@@ -0,0 +1,211 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <ets_sys.h>
+#include "log.h"
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+#define RING_MASK               (LOG_RING_SIZE - 1)
+
+// UART0 registers; uart_register.h is not in the SDK include path
+#ifndef UART0_BASE
+#define UART0_BASE              0x60000000
+#endif
+#define UART0_FIFO              (UART0_BASE + 0x00)
+#define UART0_INT_ST            (UART0_BASE + 0x08)
+#define UART0_INT_ENA           (UART0_BASE + 0x0c)
+#define UART0_INT_CLR           (UART0_BASE + 0x10)
+#define UART0_STATUS            (UART0_BASE + 0x1c)
+#define UART0_CONF1             (UART0_BASE + 0x24)
+
+#define TXFIFO_EMPTY_INT        BIT(1)
+#define TXFIFO_COUNT(status)    (((status) >> 16) & 0xff)
+#define TXFIFO_SIZE             128
+#define TXFIFO_THRESHOLD        16          // interrupt when fewer bytes are left; about 1.4 ms at 115200
+#define TXFIFO_THRESHOLD_S      8
+#define TXFIFO_THRESHOLD_M      0x7f
+
+static LOG m_Log;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static int      Log_Put(const char* s, uint32_t len);
+static void     Log_Kick(void);
+static uint32_t Log_Fill(void);
+static void     Log_Isr(void* arg);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ */
+void ICACHE_FLASH_ATTR Log_Initialize(void)
+{
+    ETS_UART_INTR_DISABLE();
+    
+    WRITE_PERI_REG(UART0_CONF1, (READ_PERI_REG(UART0_CONF1) & ~(TXFIFO_THRESHOLD_M << TXFIFO_THRESHOLD_S)) | 
+                                (TXFIFO_THRESHOLD << TXFIFO_THRESHOLD_S));
+    WRITE_PERI_REG(UART0_INT_ENA, 0);                       // the receive interrupts of uart_init() are not handled
+    WRITE_PERI_REG(UART0_INT_CLR, 0xffff);
+    
+    ETS_UART_INTR_ATTACH(Log_Isr, NULL);
+    ETS_UART_INTR_ENABLE();
+}
+/**
+ * 
+ * @param format
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Log_Write(const char* format, ...)
+{
+    char    buffer[LOG_LINE_MAX];
+    va_list args;
+    int     n;
+    
+    if(m_Log.dropped != m_Log.reported) {
+        n = FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("log: %lu messages dropped\n"), m_Log.dropped - m_Log.reported);
+        
+        if(Log_Put(buffer, n) == 0) {
+            m_Log.dropped++;
+            return 0;
+        }
+        
+        m_Log.reported = m_Log.dropped;
+    }
+    
+    va_start(args, format);
+    n = FlashStr_Vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    
+    if(Log_Put(buffer, n) == 0) {
+        m_Log.dropped++;
+        return 0;
+    }
+    
+    m_Log.messages++;
+    
+    return 1;
+}
+/**
+ * 
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Log_Dropped(void)
+{
+    return m_Log.dropped;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * all or nothing
+ * 
+ * @param s
+ * @param len
+ * @return 1 if queued, 0 if there was no room
+ */
+static int ICACHE_FLASH_ATTR Log_Put(const char* s, uint32_t len)
+{
+    uint32_t head = m_Log.head;
+    uint32_t i;
+    
+    if(len > LOG_RING_SIZE - (head - m_Log.tail)) {
+        return 0;
+    }
+    
+    for(i = 0; i < len; i++) {
+        m_Log.ring[(head + i) & RING_MASK] = s[i];
+    }
+    
+    __asm__ __volatile__("" ::: "memory");                  // the bytes before the index
+    m_Log.head = head + len;
+    
+    Log_Kick();
+    
+    return 1;
+}
+/**
+ * fill the FIFO now and let the interrupt do the rest
+ */
+static void ICACHE_FLASH_ATTR Log_Kick(void)
+{
+    ETS_UART_INTR_DISABLE();
+    
+    if(Log_Fill() > 0) {
+        SET_PERI_REG_MASK(UART0_INT_ENA, TXFIFO_EMPTY_INT);
+    }
+    
+    ETS_UART_INTR_ENABLE();
+}
+/**
+ * runs from IRAM
+ * 
+ * @return bytes left in the ring
+ */
+static uint32_t Log_Fill(void)
+{
+    uint32_t head = m_Log.head;
+    uint32_t tail = m_Log.tail;
+    uint32_t room = TXFIFO_SIZE - TXFIFO_COUNT(READ_PERI_REG(UART0_STATUS));
+    
+    while(room > 0 && tail != head) {
+        WRITE_PERI_REG(UART0_FIFO, m_Log.ring[tail & RING_MASK]);
+        tail++;
+        room--;
+    }
+    
+    m_Log.tail = tail;
+    
+    return head - tail;
+}
+/**
+ * runs from IRAM - keep it short
+ * 
+ * @param arg
+ */
+static void Log_Isr(void* arg)
+{
+    uint32_t status = READ_PERI_REG(UART0_INT_ST);
+    
+    if((status & TXFIFO_EMPTY_INT) && Log_Fill() == 0) {
+        CLEAR_PERI_REG_MASK(UART0_INT_ENA, TXFIFO_EMPTY_INT);
+    }
+    
+    WRITE_PERI_REG(UART0_INT_CLR, status);
+}
+
+#endif
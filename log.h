@@ -0,0 +1,130 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+#include "user_config.h"
+#include "flash_str.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * logging to the serial port
+ *
+ * LOG_ERROR() .. LOG_DEBUG() take a printf() format, kept in flash. Levels above LOG_LEVEL compile to nothing -
+ * no code, no string, and the arguments are not evaluated. LOG_LEVEL_NONE also leaves out the ring below.
+ *
+ * Enabled messages are formatted into a ring in RAM, which the UART TX interrupt drains into the hardware FIFO. A
+ * message that does not fit is dropped, and counted, instead of waiting for the UART; the next one that fits is
+ * preceded by a line with the count.
+ *
+ * Log_Initialize() takes over the UART0 interrupt from uart_init(), so nothing is received on the serial port.
+ * os_printf() still writes straight to the FIFO, and may interleave with the ring.
+ */
+#define LOG_LEVEL_NONE              0
+#define LOG_LEVEL_ERROR             1
+#define LOG_LEVEL_WARNING           2
+#define LOG_LEVEL_INFO              3
+#define LOG_LEVEL_DEBUG             4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL                   LOG_LEVEL_INFO
+#endif
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE               1024                            // power of 2
+#endif
+#ifndef LOG_LINE_MAX
+#define LOG_LINE_MAX                256                             // longer messages are cut
+#endif
+
+// disabled levels still see their arguments, so nothing is left unused, but never evaluate them
+static inline void Log_Discard(const char* format, ...) { }
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...)      Log_Write(FLASH_STR(format), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...)      do { if(0) Log_Discard(format, ##__VA_ARGS__); } while(0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARNING
+#define LOG_WARNING(format, ...)    Log_Write(FLASH_STR(format), ##__VA_ARGS__)
+#else
+#define LOG_WARNING(format, ...)    do { if(0) Log_Discard(format, ##__VA_ARGS__); } while(0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...)       Log_Write(FLASH_STR(format), ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...)       do { if(0) Log_Discard(format, ##__VA_ARGS__); } while(0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...)      Log_Write(FLASH_STR(format), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...)      do { if(0) Log_Discard(format, ##__VA_ARGS__); } while(0)
+#endif
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+typedef struct {
+    uint8_t                 ring[LOG_RING_SIZE];
+    volatile uint32_t       head;                                   // written up to here, by Log_Write()
+    volatile uint32_t       tail;                                   // sent up to here, by the interrupt
+    uint32_t                messages;
+    uint32_t                dropped;                                // messages
+    uint32_t                reported;                               // dropped messages already told about
+} LOG;
+
+/**
+ * call right after uart_init()
+ */
+void Log_Initialize(void);
+/**
+ * 
+ * @param format    in flash
+ * @return 1 if queued, 0 if dropped
+ */
+int Log_Write(const char* format, ...);
+/**
+ * 
+ * @return messages dropped since boot
+ */
+uint32_t Log_Dropped(void);
+
+#else
+
+#define Log_Initialize()            do { } while(0)
+#define Log_Dropped()               0
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_H */
@@ -25,6 +25,8 @@
  */
 
 #include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+#include <ets_sys.h>
+#include <spi_flash.h>
 #include <github.com/mikejac/misc.esp8266-nonos.cpp/uart.h>
 #include <github.com/mikejac/date_time.esp8266-nonos.cpp/system_time.h>
 #include <github.com/mikejac/timer.esp8266-nonos.cpp/timer.h>
@@ -35,14 +37,30 @@
 #include <github.com/mikejac/wifi.esp8266-nonos.cpp/wifi.h>
 #include <github.com/mikejac/upgrader.esp8266-nonos.cpp/upgrader.h>
 #include <github.com/mikejac/raburton.rboot.esp8266-nonos.cpp/appcode/rboot-api.h>
-#include <github.com/mikejac/dht.esp8266-nonos.cpp/dht22.hpp>
-#include <github.com/mikejac/br3ttb.pid.esp8266-nonos.cpp/Arduino-PID-Library/PID_v1.h>
 #include "user_config.h"
 #include "package.h"
+#include "scheduler.h"
+#include "dht_async.h"
+#include "pid_fixed.hpp"
+#include "stages.hpp"
+#include "deadband.h"
+#include "hampel.h"
+#include "arena.h"
+#include "history.h"
+#include "forward.h"
+#include "autotune.h"
+#include "schedule.h"
+#include "checkpoint.h"
+#include "latency.h"
+#include "health.h"
+#include "interlock.h"
+#include "command.h"
+#include "delta.h"
+#include "fetch.h"
+#include "flash_str.h"
+#include "log.h"
 #include "wifi.h"
 
-#define DTXT(...)   os_printf(__VA_ARGS__)
-
 // tasks
 #define TASK0_ID            0
 #define TASK1_ID            1
@@ -50,6 +68,71 @@
 
 #define QUEUE_SIZE          2
 
+// flash is mapped at this address; the linker script puts the end of the running image in _irom0_text_end
+#define IROM_FLASH_MAP      0x40200000
+
+extern "C" char _irom0_text_end;
+
+typedef PIDFixed<PID_FRAC>  HeaterPid;
+
+// heater stages; relay and seconds of continuous demand before it comes on
+typedef Stage<GPIO_HEATER1, 0,
+        Stage<GPIO_HEATER2, STAGE_2_TIME> >                 HeaterStages;
+typedef StageControl<HeaterStages, HEATER_ON, HEATER_OFF>   Heaters;
+
+// stages of the main loop with a latency histogram each
+enum {
+    STAGE_PID,
+    STAGE_DHT,
+    STAGE_CONNECTOR,
+    STAGE_EVENTS,
+    STAGE_BLINKER,
+    STAGE_UPGRADER,
+    STAGES
+};
+
+// what is forwarded after an outage
+enum {
+    EVENT_TEMP1,
+    EVENT_HUM1,
+    EVENT_TEMP2,
+    EVENT_HUM2,
+    EVENT_STATE                                         // HISTORY_HEATERS and HISTORY_FAN bits
+};
+
+// what survives a restart; change WARM_STATE_VERSION with the layout, or a checkpoint is read into the wrong fields
+#define WARM_STATE_VERSION  1
+
+typedef struct {
+    HeaterPid::value_t  integral;
+    HeaterPid::value_t  setpoint;
+    int16_t             temp1;
+    int16_t             hum1;
+    int16_t             temp2;
+    int16_t             hum2;
+    uint8_t             mode;
+    uint8_t             tuned;                          // gains below are from autotune
+    uint16_t            heatRate;                       // learned by the schedule, 0.1 C per hour
+    HeaterPid::value_t  kp;
+    HeaterPid::value_t  ki;
+    HeaterPid::value_t  kd;
+    uint32_t            demand;                         // s heat has been wanted; the stage delays go on from there
+} WARM_STATE;
+
+// fails to compile when WARM_STATE outgrows a checkpoint record
+typedef char WARM_STATE_FITS[(sizeof(WARM_STATE) <= CHECKPOINT_MAX_DATA) ? 1 : -1];
+
+// a delta firmware image on its way in
+typedef struct {
+    FETCH               fetch;
+    DELTA               delta;
+    uint8_t             rom;                            // slot being written
+    uint8_t             ended;                          // all of the patch is in; the result is being checked
+    uint8_t             failed;                         // waiting for the connection to go before freeing this
+    uint8_t             restart;                        // rBoot boots 'rom' next; kept until then, nothing starts
+    esp_time_t          progress;                       // last time anything moved
+} DELTA_UPDATE;
+
 /******************************************************************************************************************
  * global variables
  *
@@ -70,11 +153,34 @@ AccHumidity*        outdoorHumidity    = NULL;
 AccHumidity*        indoorHumidity     = NULL;
 AccThermostat*      thermostat         = NULL;
 AccText*            message            = NULL;
+AccText*            diagnostics        = NULL;
+
+// publishing of sensor values
+DEADBAND            m_PubTemp1;
+DEADBAND            m_PubHum1;
+DEADBAND            m_PubTemp2;
+DEADBAND            m_PubHum2;
 
 UPGRADER            m_Upgrader;
 BLINKER             m_BlueLED;
 
-Timer               m_DhtCountdown = Timer_initializer;
+// jobs
+SCHEDULER           m_Scheduler;
+SCHEDULER_JOB       m_SensorJob;
+SCHEDULER_JOB       m_DecodeJob;
+SCHEDULER_JOB       m_PidJob;
+SCHEDULER_JOB       m_FanJob;
+SCHEDULER_JOB       m_BlinkerJob;
+SCHEDULER_JOB       m_NetworkJob;
+SCHEDULER_JOB       m_LatencyJob;
+
+LATENCY             m_Latency[STAGES];
+uint32_t            m_LatencyInner;                     // cycles of callback stages within the connector stage
+
+// health
+SCHEDULER_JOB       m_HealthJob;
+HEALTH              m_Health;
+uint32_t            m_Connects;
 
 WIFI_AP             wifi_list[] = {
     { SSID1, PSW1 },
@@ -82,30 +188,143 @@ WIFI_AP             wifi_list[] = {
     { NULL,         NULL}
 };
 
+// same order as wifi_list
+const char*         m_WifiSsid[] = { SSID1, SSID2 };
+
+// boot timing, us since boot
+uint32_t            m_BootReading;
+uint32_t            m_BootConnect;
+uint32_t            m_BootPublish;
+
 // DHT sensors
-esp_nonos::dht::dht22_t         m_Dht1;
-esp_nonos::dht::dht22_t         m_Dht2;
+DHT_ASYNC           m_Dht1;
+DHT_ASYNC           m_Dht2;
 
 // PID controller
-PID                 m_Pid;
+HeaterPid           m_Pid;
 int                 m_PidEnable;
 int                 m_PidFan;
-int                 m_PidHeater1;
-int                 m_PidHeater2;
-Timer               m_PidFanCountdown = Timer_initializer;
-esp_time_t          m_PidStage2;
+uint32_t            m_PidStages;                        // bit n: heater stage n+1 on
+esp_time_t          m_PidDemand;                        // when heat was first wanted; stages are timed from here
+uint32_t            m_PidBase;                          // stages the outdoor temperature alone calls for
+int                 m_PidFresh;                         // new indoor reading not yet computed
+esp_time_t          m_PidWindow;                        // start of the current output window
+uint8_t             m_PidTuned;                         // gains are from autotune
+
+// relay feedback autotuning
+AUTOTUNE            m_Autotune;
+
+// weekly schedule
+SCHEDULE            m_Schedule;
+SCHEDULER_JOB       m_ScheduleJob;
+int16_t             m_ScheduleSetpoint;                 // last one applied; a manual change holds until it changes
+char                m_ScheduleText[256];                // a schedule sent as a JSON string, unescaped
+
+// MQTT commands, by feed id
+COMMANDS            m_Commands;
+
+// delta firmware images; from the heap while one is fetched
+DELTA_UPDATE*       m_Update;
+SCHEDULER_JOB       m_UpdateJob;
+uint8_t             m_BootRom;                          // the slot we run; rBoot's config has the next one
+
+// safety interlocks, checked from a hardware timer
+INTERLOCK           m_Interlock;
+uint32_t            m_InterlockCuts;                    // reported so far
+
+// when the sensors were last started, us
+uint32_t            m_SensorTime;
+uint32_t            m_SensorRetry;                      // ms, 0 after a good reading
 
-// DHT sensor results
-double              m_Temp1;
-double              m_Hum1;
-double              m_Temp2;
-double              m_Hum2;
+// outlier filters
+HAMPEL              m_FilterTemp1;
+HAMPEL              m_FilterHum1;
+HAMPEL              m_FilterTemp2;
+HAMPEL              m_FilterHum2;
+uint8_t             m_PidMode;
+
+// warm restart
+CHECKPOINT          m_Checkpoint;
+esp_time_t          m_CheckpointTime;
+
+// DHT sensor results, 0.1 degree Celsius and 0.1 %RH
+int16_t             m_Temp1;
+int16_t             m_Hum1;
+int16_t             m_Temp2;
+int16_t             m_Hum2;
+esp_time_t          m_Temp1Time;                        // when last read
+esp_time_t          m_Temp2Time;
+
+// sensor history
+HISTORY             m_History;
+char                m_HistoryReply[64 + HISTORY_PAGE_SIZE * 48];
+
+// store and forward while offline
+FORWARD             m_Forward;
+SCHEDULER_JOB       m_ForwardJob;
+esp_time_t          m_ForwardSince;                     // when we got connected
+char                m_ForwardBatch[48 + FORWARD_BATCH * 24];
 
 /******************************************************************************************************************
  * prototypes
  *
  */
 
+/**
+ * 
+ * @param arg
+ */
+static void sensorJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void decodeJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void pidJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void latencyJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void healthJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void forwardJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void scheduleJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void fanJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void blinkerJob(void* arg);
+/**
+ * 
+ * @param arg
+ */
+static void networkJob(void* arg);
+/**
+ * 
+ * @return 
+ */
+static int processDeviceEvents(void);
 /**
  * 
  */
@@ -136,7 +355,7 @@ static void setPidMode(uint8_t mode);
  * 
  * @param mode
  */
-static void setPidSetpoint(double value);
+static void setPidSetpoint(HeaterPid::value_t value);
 /**
  * 
  */
@@ -145,6 +364,132 @@ static void runPid(void);
  * 
  */
 static void updatePidStatus(void);
+/**
+ * 
+ * @param now
+ * @return 
+ */
+static uint32_t heatDemand(esp_time_t now);
+/**
+ * 
+ */
+static void feedForward(void);
+/**
+ * 
+ * @param payload
+ */
+static void startAutotune(const char* payload);
+/**
+ * 
+ */
+static void runAutotune(void);
+/**
+ * 
+ */
+static void reportInterlock(void);
+/**
+ * 
+ * @param payload
+ */
+static void setSchedule(const char* payload);
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void commandSetpoint(const JSON* json, int arg);
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void commandMode(const JSON* json, int arg);
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void commandAutotune(const JSON* json, int arg);
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void commandHistory(const JSON* json, int arg);
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void commandSchedule(const JSON* json, int arg);
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void commandDiagnostics(const JSON* json, int arg);
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void commandDelta(const JSON* json, int arg);
+/**
+ * 
+ * @param url
+ */
+static void startUpdate(const char* url);
+/**
+ * 
+ * @param arg
+ */
+static void updateJob(void* arg);
+/**
+ * 
+ * @param what
+ * @param rc
+ */
+static void failUpdate(const char* what, int rc);
+/**
+ * 
+ * @param p
+ * @param v
+ * @return 
+ */
+static int formatGain(char* p, HeaterPid::value_t v);
+/**
+ * 
+ * @param page
+ */
+static void sendHistory(uint32_t page);
+/**
+ * 
+ * @param flash
+ */
+static void saveState(int flash);
+/**
+ * 
+ */
+static void preferLastAp(void);
+/**
+ * 
+ */
+static void saveLastAp(void);
+/**
+ * 
+ */
+static void bootReport(void);
+/**
+ * 
+ * @param type
+ * @param value
+ */
+static void forward(uint8_t type, int16_t value);
+/**
+ * 
+ * @return 
+ */
+static esp_time_t wallClock(void);
 
 /******************************************************************************************************************
  * functions
@@ -157,358 +502,1469 @@ static void updatePidStatus(void);
  */
 void ICACHE_FLASH_ATTR task1(os_event_t* e)
 {
-    /******************************************************************************************************************
-     * run PID controller
-     * 
-     */
-    runPid();
+    // still alive; the interlock cuts the heaters if we get stuck in here
+    Interlock_Kick(&m_Interlock);
+    
+    // run whatever is due; the scheduler re-posts us when the next deadline is reached
+    Scheduler_Run(&m_Scheduler);
+}
+/**
+ * start reading DHT sensors - both convert at the same time
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR sensorJob(void* arg)
+{
+    Info(mqtt, "Read DHT sensors");
 
-    /******************************************************************************************************************
-     * read DHT sensors
-     * 
-     */
-    if(expired(&m_DhtCountdown)) {
-        Info(mqtt, "Read DHT sensors");
+    m_SensorTime = system_get_time();
+    
+    LATENCY_MEASURE(&m_Latency[STAGE_DHT], DhtAsync_Start(&m_Dht1); DhtAsync_Start(&m_Dht2));
+    
+    Scheduler_Start(&m_Scheduler, &m_DecodeJob, DHT_ASYNC_FRAME_MS);
+    
+    LOG_DEBUG("sensorJob(): passes = %lu, idle = %lu, jobs = %lu\n", m_Scheduler.passes, m_Scheduler.idlePasses, m_Scheduler.jobsRun);
+}
+/**
+ * pick up the DHT sensor readings
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR decodeJob(void* arg)
+{
+    int16_t         temp, hum;
+    int             rc;
+    int             failed = 0;
+    uint32_t        now    = esp_uptime(0);
+    esp_time_t      wall   = wallClock();
+    HISTORY_SAMPLE  sample;
+
+    LATENCY_MEASURE(&m_Latency[STAGE_DHT], rc = DhtAsync_Decode(&m_Dht1, &temp, &hum));
+    
+    if(rc == DHT_ASYNC_OK) {
+        m_Hum1      = Hampel_Filter(&m_FilterHum1,  hum);
+        m_Temp1     = Hampel_Filter(&m_FilterTemp1, temp);
+        m_Temp1Time = now;
+        
+        Interlock_Feed(&m_Interlock, m_Temp1);
+        
+        if(m_BootReading == 0) {
+            m_BootReading = system_get_time();
+        }
+
+        // tell the PID controller - it computes as soon as the reading is in
+        m_Pid.Input(HeaterPid::fromTenths(m_Temp1));
+        m_PidFresh = 1;
+
+        if(Deadband_Check(&m_PubTemp1, m_Temp1, now)) {
+            AccThermostatCurrentTemperatureSetValue(thermostat, m_Temp1 / 10.0);
+            forward(EVENT_TEMP1, m_Temp1);
+            
+            if(m_BootConnect != 0 && m_BootPublish == 0) {
+                m_BootPublish = system_get_time();
+                bootReport();
+            }
+        }
+        if(Deadband_Check(&m_PubHum1, m_Hum1, now)) {
+            AccHumidityCurrentRelativeHumiditySetValue(indoorHumidity, m_Hum1 / 10.0);
+            forward(EVENT_HUM1, m_Hum1);
+        }
+    } else {
+        LOG_WARNING("decodeJob(): DHT1 error %d\n", rc);
+        
+        if(m_SensorRetry == 0) {
+            Warning(mqtt, "Failed to read DHT1 sensor");
+        }
+        
+        failed = 1;
+    }
+
+    LATENCY_MEASURE(&m_Latency[STAGE_DHT], rc = DhtAsync_Decode(&m_Dht2, &temp, &hum));
+    
+    if(rc == DHT_ASYNC_OK) {
+        m_Temp2     = Hampel_Filter(&m_FilterTemp2, temp);
+        m_Hum2      = Hampel_Filter(&m_FilterHum2,  hum);
+        m_Temp2Time = now;
+
+        if(Deadband_Check(&m_PubTemp2, m_Temp2, now)) {
+            AccThermometerCurrentTemperatureSetValue(outdoorThermometer, m_Temp2 / 10.0);
+            forward(EVENT_TEMP2, m_Temp2);
+        }
+        if(Deadband_Check(&m_PubHum2, m_Hum2, now)) {
+            AccHumidityCurrentRelativeHumiditySetValue(outdoorHumidity, m_Hum2 / 10.0);
+            forward(EVENT_HUM2, m_Hum2);
+        }
+    } else {
+        LOG_WARNING("decodeJob(): DHT2 error %d\n", rc);
+        
+        if(m_SensorRetry == 0) {
+            Warning(mqtt, "Failed to read DHT2 sensor");
+        }
+        
+        failed = 1;
+    }
+    
+    // try again soon, backing off until we are back at the normal interval
+    if(failed) {
+        m_SensorRetry = (m_SensorRetry == 0) ? DHT_RETRY : m_SensorRetry * 2;
+        
+        if(m_SensorRetry < DHT_INTERVAL * 1000) {
+            Scheduler_Start(&m_Scheduler, &m_SensorJob, m_SensorRetry);
+        } else {
+            m_SensorRetry = DHT_INTERVAL * 1000;
+        }
+    } else {
+        m_SensorRetry = 0;
+    }
+    
+    // the PID computes as soon as a reading is in; without one it checks the age of the last
+    Scheduler_Start(&m_Scheduler, &m_PidJob, 0);
+    
+    // keep a record of it
+    sample.time     = now;
+    sample.value[0] = m_Temp1;
+    sample.value[1] = m_Hum1;
+    sample.value[2] = m_Temp2;
+    sample.value[3] = m_Hum2;
+    sample.state    = (m_PidStages & HISTORY_HEATERS) | (m_PidFan ? HISTORY_FAN : 0);
+    
+    History_SetClock(&m_History, (wall != 0) ? wall - now : 0);
+    History_Add(&m_History, &sample);
+    
+    // the PID state changes slowly; flash only now and then
+    saveState(now - m_CheckpointTime >= CHECKPOINT_INTERVAL);
+    
+    LOG_DEBUG("decodeJob(): published = %lu, suppressed = %lu\n", 
+            m_PubTemp1.published  + m_PubHum1.published  + m_PubTemp2.published  + m_PubHum2.published,
+            m_PubTemp1.suppressed + m_PubHum1.suppressed + m_PubTemp2.suppressed + m_PubHum2.suppressed);
+}
+/**
+ * run PID controller - on a fresh indoor reading, or to let the relays follow a thermostat change
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR pidJob(void* arg)
+{
+    LATENCY_MEASURE(&m_Latency[STAGE_PID], runPid());
+}
+/**
+ * report and restart the latency histograms
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR latencyJob(void* arg)
+{
+    char buffer[128];
+    int  i;
+    
+    for(i = 0; i < STAGES; i++) {
+        Latency_Format(&m_Latency[i], buffer);
+        
+        LOG_INFO("latencyJob(): %s\n", buffer);
+        Info(mqtt, buffer);
         
-        double temp, hum;
+        Latency_Reset(&m_Latency[i]);
+    }
+    
+    Interlock_Format(&m_Interlock, buffer);
+    
+    LOG_INFO("latencyJob(): %s\n", buffer);
+    Info(mqtt, buffer);
+}
+/**
+ * publish heap, stack and task queue health
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR healthJob(void* arg)
+{
+    char buffer[96];
+    
+    Health_Update(&m_Health);
+    
+    FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Heap %lu/%lu/%lu Stak %lu Kø %lu MQTT %lu Oppe %lu Log %lu"), 
+                        m_Health.heapFree, m_Health.heapLow, m_Health.heapLargest, m_Health.stackUsed,
+                        m_Scheduler.postErrors, (m_Connects > 0) ? m_Connects - 1 : 0, (uint32_t) esp_uptime(0), 
+                        (uint32_t) Log_Dropped());
+    
+    LOG_INFO("healthJob(): %s\n", buffer);
+    
+    AccTextSetValue(diagnostics, buffer);
+}
+/**
+ * follow the weekly schedule once the clock is synced
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR scheduleJob(void* arg)
+{
+    esp_time_t  wall = wallClock();
+    int16_t     temp;
+    int16_t     setpoint;
+    
+    if(wall == 0 || m_PidEnable == 0 || m_Autotune.state == AUTOTUNE_RUNNING) {
+        return;
+    }
+    
+    temp     = (m_Temp1 != INVALID_TENTHS && esp_uptime(0) - m_Temp1Time <= DHT_STALE) ? m_Temp1 : SCHEDULE_NONE;
+    setpoint = Schedule_Run(&m_Schedule, Schedule_MinuteOfWeek(wall, SCHEDULE_UTC_OFFSET, SCHEDULE_DST), temp, esp_uptime(0));
+    
+    if(setpoint == SCHEDULE_NONE || setpoint == m_ScheduleSetpoint) {
+        return;
+    }
+    
+    LOG_INFO("scheduleJob(): setpoint %d -> %d\n", HeaterPid::toTenths(m_Pid.Setpoint()), setpoint);
+    
+    m_ScheduleSetpoint = setpoint;
+    
+    setPidSetpoint(HeaterPid::fromTenths(setpoint));
+    saveState(0);
+    
+    // publish the change
+    AccThermostatTargetTemperatureSetValue(thermostat, setpoint / 10.0);
+    
+    Scheduler_Start(&m_Scheduler, &m_PidJob, 0);
+}
+/**
+ * send what was queued while offline, one batch per run so the control loop keeps going
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR forwardJob(void* arg)
+{
+    esp_time_t  wall = wallClock();
+    int         n;
+    
+    if(!WIFI_IsConnected() || !IsConnected(mqtt)) {
+        return;                                         // onConnect() starts us again
+    }
+    
+    if(wall == 0 && esp_uptime(0) - m_ForwardSince < FORWARD_CLOCK_WAIT) {
+        Scheduler_Start(&m_Scheduler, &m_ForwardJob, 1000);                 // give Chronos a chance
+        return;
+    }
+    
+    n = Forward_Format(&m_Forward, m_ForwardBatch, sizeof(m_ForwardBatch), FORWARD_BATCH, esp_uptime(0), wall);
+    
+    if(n == 0) {
+        return;
+    }
+    
+    if(!Info(mqtt, m_ForwardBatch)) {
+        Scheduler_Start(&m_Scheduler, &m_ForwardJob, FORWARD_RETRY);       // still queued; nothing is lost
+        return;
+    }
+    
+    Forward_Commit(&m_Forward, n);
+    
+    LOG_INFO("forwardJob(): sent %d, left %lu, dropped %lu\n", n, Forward_Count(&m_Forward), m_Forward.dropped);
+    
+    if(Forward_Count(&m_Forward) > 0) {
+        Scheduler_Start(&m_Scheduler, &m_ForwardJob, FORWARD_GAP);
+    }
+}
+/**
+ * turn fan off after some time
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR fanJob(void* arg)
+{
+    if(m_PidFan == 1) {
+        m_PidFan = 0;
 
-        if(m_Dht1.read(temp, hum) == 0) {
-            m_Hum1  = hum;
-            m_Temp1 = temp;
+        LOG_INFO("fanJob(): fan off\n");
 
-            // tell the PID controller
-            m_Pid.Input(m_Temp1);
+        gpio_write(GPIO_FAN, FAN_OFF);
 
-            AccThermostatCurrentTemperatureSetValue(thermostat, m_Temp1);
-            AccHumidityCurrentRelativeHumiditySetValue(indoorHumidity, m_Hum1);
+        // publish the change
+        updatePidStatus();
+    }
+}
+/**
+ * show we're alive
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR blinkerJob(void* arg)
+{
+    if(WIFI_IsConnected()) {
+        if(IsConnected(mqtt)) {
+            Blinker_Set(&m_BlueLED, 200, 3000);
+        } else {
+            Blinker_Set(&m_BlueLED, 1000, 1000);
+        }
+    } else {
+        Blinker_Set(&m_BlueLED, 200, 200);
+    }
+    
+    LATENCY_MEASURE(&m_Latency[STAGE_BLINKER], Blinker_Run(&m_BlueLED));
+}
+/**
+ * deal with MQTT, incoming value updates and the firmware upgrader
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR networkJob(void* arg)
+{
+    int event;
+    int count;
+    int newPkg;
+    
+    Health_Sample(&m_Health);
+    
+    LATENCY_MEASURE_OUTER(&m_Latency[STAGE_CONNECTOR], m_LatencyInner, event = ConnectorRun(mqtt));
+    if(event == RUN_CONNECTED) {
+        onConnect();
+    }
+    
+    /******************************************************************************************************************
+     * deal with incoming value updates
+     * 
+     */
+    LATENCY_MEASURE(&m_Latency[STAGE_EVENTS], count = processDeviceEvents());
+    
+    if(count == DEVICE_EVENT_BUDGET) {
+        Scheduler_Start(&m_Scheduler, &m_NetworkJob, 0);       // there may be more; come back on the next pass
+    }
+
+    /******************************************************************************************************************
+     * firmware upgrader
+     * 
+     */
+    LATENCY_MEASURE(&m_Latency[STAGE_UPGRADER], newPkg = Upgrader_NewPkg(&m_Upgrader));
+    
+    if(newPkg) {
+        if(Close(mqtt)) {
+            Upgrader_Run(&m_Upgrader);
+        }
+    }
+}
+/**
+ * drain up to DEVICE_EVENT_BUDGET incoming value updates - for the thermostat only the latest target mode and 
+ * target temperature in the batch are applied
+ * 
+ * @return number of events processed
+ */
+int ICACHE_FLASH_ATTR processDeviceEvents(void)
+{
+    Device_Message*     dm;
+    int                 count       = 0;
+    int                 mode        = -1;
+    int                 hasSetpoint = 0;
+    HeaterPid::value_t  setpoint    = 0;
+    
+    while(count < DEVICE_EVENT_BUDGET) {
+        CharacteristicFormat format = DeviceGetEventType(dm = DeviceGetEvent(device));
+        
+        if(format == FormatNone) {
+            DeviceDeleteEvent(dm);
+            break;
+        }
+        
+        count++;
+        
+        switch(format) {
+            case FormatString:  
+                break;
+            case FormatBool:
+                LOG_DEBUG("Bool; aid = %lld, iid = %lld, value = %s\n", Device_GetAid(dm), Device_GetIid(dm), (Device_GetValueBool(dm) == true) ? "True" : "False");
+                break;
+            case FormatUInt8:   
+                LOG_DEBUG("UInt8; aid = %lld, iid = %lld, value = %d\n", Device_GetAid(dm), Device_GetIid(dm), Device_GetValueUInt8(dm));
+                if(dm->acc == thermostat->Accessory) {
+                    LOG_DEBUG("thermostat\n");
+
+                    if(Device_GetIid(dm) == AccThermostatTargetHeatingCoolingStateIid) {
+                        mode = Device_GetValueUInt8(dm);                // supersedes any earlier one
+                    }
+                }
+                break;
+            case FormatInt8:    
+                break;
+            case FormatUInt16:  
+                break;
+            case FormatInt16:   
+                break;
+            case FormatUInt32:  
+                break;
+            case FormatInt32:   
+                break;
+            case FormatUInt64:  
+                break;
+            case FormatFloat:   
+                LOG_DEBUG("Float; aid = %lld, iid = %lld\n", Device_GetAid(dm), Device_GetIid(dm));
+                if(dm->acc == thermostat->Accessory) {
+                    if(Device_GetIid(dm) == AccThermostatTargetTemperatureIid) {
+                        setpoint    = HeaterPid::fromDouble(Device_GetValueFloat(dm));
+                        hasSetpoint = 1;                                // supersedes any earlier one
+                    }
+                }
+                break;
+            case FormatNone:
+                break;
+        }
+
+        DeviceDeleteEvent(dm);
+    }
+    
+    if(mode >= 0) {
+        setPidMode(mode);
+    }
+    
+    if(hasSetpoint) {
+        setPidSetpoint(setpoint);
+    }
+    
+    if(mode >= 0 || hasSetpoint) {
+        saveState(1);                                           // user settings must survive a power cut
+        
+        Scheduler_Start(&m_Scheduler, &m_PidJob, 0);            // a new setpoint is in the output already; let the relays follow
+    }
+    
+    return count;
+}
+/**
+ * 
+ */
+void ICACHE_FLASH_ATTR onConnect(void)
+{
+    LOG_INFO("onConnect():\n");
+
+    m_Connects++;
+    
+    if(m_BootConnect == 0) {
+        m_BootConnect = system_get_time();
+        saveLastAp();
+    }
+    
+    // publish fresh sensor values on the next reading - which is soon
+    Deadband_Reset(&m_PubTemp1);
+    Deadband_Reset(&m_PubHum1);
+    Deadband_Reset(&m_PubTemp2);
+    Deadband_Reset(&m_PubHum2);
+    
+    Scheduler_Start(&m_Scheduler, &m_SensorJob, DHT_WARMUP);
+    
+    // catch up on what happened while we were offline
+    m_ForwardSince = esp_uptime(0);
+    
+    if(Forward_Count(&m_Forward) > 0) {
+        Scheduler_Start(&m_Scheduler, &m_ForwardJob, FORWARD_GAP);
+    }
+
+    // firmware upgrade service
+    Upgrader_Subscribe_Package(&m_Upgrader);
+    Upgrader_Publish_Package(&m_Upgrader);
+}
+/**
+ * 
+ * @param mqtt
+ * @param ptr
+ * @param nodename
+ * @param actorId
+ * @param platformId
+ * @param feedId
+ * @param payload
+ */
+void ICACHE_FLASH_ATTR onCommandCallback(Mqtt*          mqtt, 
+                                         void*          ptr,
+                                         const char*    nodename,
+                                         const char*    actorId,
+                                         const char*    platformId,
+                                         const char*    feedId,
+                                         const char*    payload)
+{
+    int rc;
+    int upgrader;
+    
+    // our own commands first; a few hashes tell whether it is one, and addressed to us
+    if((rc = Command_Dispatch(&m_Commands, nodename, platformId, feedId, payload)) != 0) {
+        if(rc < 0) {
+            Warning(mqtt, "Command: payload rejected");
+        }
+        
+        return;
+    }
+    
+    LATENCY_MEASURE_INNER(&m_Latency[STAGE_UPGRADER], m_LatencyInner, upgrader = Upgrader_Check(&m_Upgrader, nodename, actorId, platformId, feedId, payload));
+    
+    if(upgrader) {
+        
+    } else {
+        LOG_DEBUG("onCommandCallback(): command message\n");
+        LOG_DEBUG("onCommandCallback(): nodename          = %s\n", nodename);
+        LOG_DEBUG("onCommandCallback(): actor_id          = %s\n", actorId);
+        LOG_DEBUG("onCommandCallback(): platform_id       = %s\n", platformId);
+        LOG_DEBUG("onCommandCallback(): feed_id           = %s\n", feedId);
+        LOG_DEBUG("onCommandCallback(): payload           = %s\n", payload);
+    }
+}
+/**
+ * 
+ * @param mode
+ */
+void ICACHE_FLASH_ATTR setPidMode(uint8_t mode)
+{
+    m_PidMode = mode;
+    
+    switch(mode) {
+        case TargetHeatingCoolingStateOff:
+        case TargetHeatingCoolingStateCool:             // nothing here cools; off as far as the heaters go
+            LOG_INFO("setPidMode(): thermostat off\n");
+            
+            Autotune_Stop(&m_Autotune);
+            
+            if(m_PidEnable == 1) {
+                LOG_INFO("setPidMode(): PID disabled\n");
+                m_Pid.SetMode(MANUAL);      // turn it off
+                m_PidEnable = 0;
+                
+                AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateOff);
+            }
+
+            if(m_PidStages != 0) {
+                LOG_INFO("setPidMode(): heaters off (disable)\n");
+                m_PidStages = Heaters::set(0, 0, 0, m_PidStages);
+
+                Scheduler_Start(&m_Scheduler, &m_FanJob, FANTIMEOUT * 1000);
+            }
+
+            // publish the change
+            updatePidStatus();
+            break;
+
+        case TargetHeatingCoolingStateHeat:
+        case TargetHeatingCoolingStateAuto:
+            LOG_INFO("setPidMode(): thermostat heat\n");
+            if(m_PidEnable == 0) {
+                m_Pid.SetMode(AUTOMATIC);      // turn it on
+                m_PidEnable = 1;
+                m_PidDemand = esp_uptime(0);
+            }
+            break;
+    }
+}
+/**
+ * 
+ * @param mode
+ */
+void ICACHE_FLASH_ATTR setPidSetpoint(HeaterPid::value_t value)
+{
+    m_Pid.Setpoint(value);
+    m_Pid.Refresh();                    // the output follows now, not at the next sample
+}
+/**
+ * 
+ */
+void ICACHE_FLASH_ATTR runPid(void)
+{
+    uint32_t blocked;
+    
+    reportInterlock();
+    
+    blocked = Interlock_Blocked(&m_Interlock);
+    
+    if(blocked != 0 || m_Temp1 == INVALID_TENTHS || esp_uptime(0) - m_Temp1Time > DHT_STALE) {
+        // no recent valid reading from DHT sensor - don't heat blind; nor fight the interlock
+        if(m_PidStages != 0) {
+            LOG_WARNING("runPid(): %s; heaters off\n", blocked ? Interlock_Name(blocked) : "stale reading");
+            m_PidStages = Heaters::set(0, 0, 0, m_PidStages);
+            
+            Scheduler_Start(&m_Scheduler, &m_FanJob, FANTIMEOUT * 1000);
+            
+            // publish the change
+            AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateOff);
+            
+            updatePidStatus();
+        }
+        
+        m_PidDemand = esp_uptime(0);
+        
+        return;
+    }
+    
+    if(m_PidFresh) {
+        m_PidFresh = 0;
+        
+        if(m_Autotune.state == AUTOTUNE_RUNNING) {
+            runAutotune();
+        } else {
+            feedForward();
+            m_Pid.Compute(m_SensorTime);        // timed by the sample, not by the loop
+            
+            if(Autotune_Observe(&m_Autotune, m_Temp1, esp_uptime(0), AUTOTUNE_WATCH)) {
+                char buffer[64];
+                
+                FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Autotune: overshoot %d.%d C, settling %lu s"), 
+                                    m_Autotune.overshoot / 10, m_Autotune.overshoot % 10, m_Autotune.settling);
+                
+                LOG_INFO("runPid(): %s\n", buffer);
+                Info(mqtt, buffer);
+            }
+        }
+    }
+    
+    if(m_PidEnable == 1) {
+        uint32_t    stages = m_PidStages;
+        esp_time_t  now    = esp_uptime(0);
+        bool        tuning = (m_Autotune.state == AUTOTUNE_RUNNING);
+        uint32_t    count;
+        
+        if(tuning || m_Pid.Output() <= 0) {
+            m_PidDemand = now;
+        }
+        
+        // the relay experiment runs on the first stage only
+        count = tuning ? m_Autotune.relay : heatDemand(now);
+        
+        if(count > 0) {
+            Scheduler_Start(&m_Scheduler, &m_FanJob, FANTIMEOUT * 1000);
+            
+            if(m_PidStages == 0) {
+                m_PidFan = 1;
+                
+                LOG_INFO("runPid(): fan on\n");
+                
+                gpio_write(GPIO_FAN, FAN_ON);
+                
+                // publish the change
+                AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateHeat);
+            }
+            
+            m_PidStages = Heaters::set(count, now - m_PidDemand, m_PidBase, m_PidStages);
+        } else {
+            m_PidStages = Heaters::set(0, 0, 0, m_PidStages);
+            
+            if(stages != 0 && m_PidStages == 0) {
+                // publish the change
+                AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateOff);
+            }
+        }
+        
+        if(m_PidStages != stages) {
+            LOG_INFO("runPid(): heater stages %lx -> %lx\n", stages, m_PidStages);
+            
+            // publish the change
+            updatePidStatus();
+        }
+    }
+}
+/**
+ * 
+ */
+void ICACHE_FLASH_ATTR updatePidStatus(void)
+{
+    char    buffer[16 + HeaterStages::count * 16];
+    char*   p = buffer;
+    int     i;
+    
+    for(i = 0; i < HeaterStages::count; i++) {
+        p += FlashStr_Sprintf(p, FLASH_STR("Varme %d: %s, "), i + 1, (m_PidStages & (1 << i)) ? "ON" : "OFF");
+    }
+    
+    FlashStr_Sprintf(p, FLASH_STR("Blæser: %s"), (m_PidFan == 1) ? "ON" : "OFF");
+    
+    AccTextSetValue(message, buffer);
+    
+    forward(EVENT_STATE, (m_PidStages & HISTORY_HEATERS) | (m_PidFan ? HISTORY_FAN : 0));
+}
+/**
+ * time-proportioned output - the output range covers all stages, used in order; each stage is on for its share of 
+ * every PID_WINDOW
+ * 
+ * @param now
+ * @return number of stages wanted now
+ */
+uint32_t ICACHE_FLASH_ATTR heatDemand(esp_time_t now)
+{
+    uint32_t total;
+    uint32_t onTime;
+    uint32_t pos;
+    uint32_t next;
+    uint32_t count = 0;
+    int      i;
+    
+    if(now - m_PidWindow >= PID_WINDOW) {
+        m_PidWindow = now;
+    }
+    
+    pos   = now - m_PidWindow;
+    next  = PID_WINDOW;
+    total = (uint32_t) (((int64_t) m_Pid.Output() * PID_WINDOW * HeaterStages::count) / HeaterPid::fromInt(PID_OUTPUT_MAX));
+    
+    for(i = 0; i < HeaterStages::count; i++) {
+        onTime = (total > PID_WINDOW) ? PID_WINDOW : total;
+        total -= onTime;
+        
+        if(onTime < PID_MIN_ON) {
+            onTime = 0;
+        } else if(onTime > PID_WINDOW - PID_MIN_ON) {
+            onTime = PID_WINDOW;
+        }
+        
+        if(pos < onTime) {
+            count++;
+            
+            if(onTime < next) {
+                next = onTime;
+            }
+        }
+    }
+    
+    // come back when the relays are due to change
+    Scheduler_Start(&m_Scheduler, &m_PidJob, (next - pos) * 1000);
+    
+    return count;
+}
+/**
+ * bias the output by what it takes to hold the setpoint against the outdoor temperature
+ */
+void ICACHE_FLASH_ATTR feedForward(void)
+{
+    HeaterPid::value_t bias = 0;
+    
+#if FEEDFORWARD_DELTA > 0
+    int32_t delta = HeaterPid::toTenths(m_Pid.Setpoint()) - m_Temp2;
+    
+    if(m_Temp2 != INVALID_TENTHS && esp_uptime(0) - m_Temp2Time <= DHT_STALE && delta > 0) {
+        // each stage holds FEEDFORWARD_DELTA and the output range covers all of them
+        bias = (HeaterPid::value_t) (((int64_t) HeaterPid::fromInt(PID_OUTPUT_MAX) * delta) / (FEEDFORWARD_DELTA * 10 * HeaterStages::count));
+    }
+#endif
+    
+    m_Pid.Bias(bias);
+    
+    // stages that are needed anyway come on without waiting for their delay
+    m_PidBase = (uint32_t) (((int64_t) bias * HeaterStages::count + HeaterPid::fromInt(PID_OUTPUT_MAX) - 1) / HeaterPid::fromInt(PID_OUTPUT_MAX));
+}
+/**
+ * autotune command - "stop" ends an experiment, "default" goes back to the gains in user_config.h and anything else 
+ * starts an experiment at the current setpoint
+ * 
+ * @param payload
+ */
+void ICACHE_FLASH_ATTR startAutotune(const char* payload)
+{
+    if(os_strcmp(payload, "stop") == 0) {
+        Autotune_Stop(&m_Autotune);
+        
+        Info(mqtt, "Autotune: stopped");
+    } else if(os_strcmp(payload, "default") == 0) {
+        Autotune_Stop(&m_Autotune);
+        
+        m_Pid.SetTunings(HeaterPid::fromInt(PID_Kp), HeaterPid::fromInt(PID_Ki), HeaterPid::fromInt(PID_Kd));
+        m_PidTuned = 0;
+        
+        saveState(1);
+        
+        Info(mqtt, "Autotune: default gains");
+    } else if(m_PidEnable == 0 || m_Temp1 == INVALID_TENTHS) {
+        Warning(mqtt, "Autotune: thermostat must be on");
+        return;
+    } else {
+        Autotune_Start(&m_Autotune, HeaterPid::toTenths(m_Pid.Setpoint()), AUTOTUNE_HYSTERESIS, AUTOTUNE_CYCLES, 
+                       AUTOTUNE_TIMEOUT, m_Temp1, esp_uptime(0));
+        
+        Info(mqtt, "Autotune: started");
+    }
+    
+    Scheduler_Start(&m_Scheduler, &m_PidJob, 0);
+}
+/**
+ * one step of the relay experiment; when it is done the new gains are put to use and saved
+ */
+void ICACHE_FLASH_ATTR runAutotune(void)
+{
+    char                buffer[128];
+    char*               p = buffer;
+    double              kp, ki, kd;
+    HeaterPid::value_t  gain[3];
+    
+    Autotune_Run(&m_Autotune, m_Temp1, esp_uptime(0));
+    
+    if(m_Autotune.state == AUTOTUNE_RUNNING) {
+        return;
+    }
+    
+    // the relay is stage 1, which is its share of the output range
+    if(!Autotune_Gains(&m_Autotune, PID_OUTPUT_MAX / HeaterStages::count, &kp, &ki, &kd)) {
+        Autotune_Stop(&m_Autotune);
+        
+        Warning(mqtt, "Autotune: failed; gains unchanged");
+        return;
+    }
+    
+    // a slow plant can ask for more than a value_t holds - Kd goes with the period; those are as large as it gets
+    gain[0] = HeaterPid::fromDouble(kp);
+    gain[1] = HeaterPid::fromDouble(ki);
+    gain[2] = HeaterPid::fromDouble(kd);
+    
+    m_Pid.SetTunings(gain[0], gain[1], gain[2]);
+    
+    if(m_Pid.GetKp() != gain[0] || m_Pid.GetKi() != gain[1] || m_Pid.GetKd() != gain[2]) {
+        Autotune_Stop(&m_Autotune);
+        
+        Warning(mqtt, "Autotune: gains refused; unchanged");
+        return;
+    }
+    
+    m_Pid.SetMode(MANUAL);
+    m_Pid.SetMode(AUTOMATIC);                           // start over from the current reading
+    m_PidTuned = 1;
+    
+    Autotune_Handover(&m_Autotune, esp_uptime(0));
+    
+    saveState(1);
+    
+    p += FlashStr_Sprintf(p, FLASH_STR("Autotune: Pu %lu s, a %lu.%02lu C, Kp "), 
+                    m_Autotune.period, m_Autotune.amplitude / 100, m_Autotune.amplitude % 100);
+    p += formatGain(p, m_Pid.GetKp());
+    p += FlashStr_Sprintf(p, FLASH_STR(" Ki "));
+    p += formatGain(p, m_Pid.GetKi());
+    p += FlashStr_Sprintf(p, FLASH_STR(" Kd "));
+    p += formatGain(p, m_Pid.GetKd());
+    
+    if(gain[0] == HeaterPid::MAX || gain[1] == HeaterPid::MAX || gain[2] == HeaterPid::MAX) {
+        p += FlashStr_Sprintf(p, FLASH_STR(", limited"));
+    }
+    
+    LOG_INFO("runAutotune(): %s\n", buffer);
+    Info(mqtt, buffer);
+}
+/**
+ * tell about relays the interlock had to drive
+ */
+void ICACHE_FLASH_ATTR reportInterlock(void)
+{
+    char        buffer[96];
+    uint32_t    cuts = m_Interlock.cuts;
+    uint32_t    stages;
+    
+    if(cuts == m_InterlockCuts) {
+        return;
+    }
+    
+    m_InterlockCuts = cuts;
+    
+    // Heaters::set() only writes the relays it thinks have changed
+    stages = Heaters::read(GPIO_REG_READ(GPIO_OUT_ADDRESS));
+    
+    if(stages != m_PidStages) {
+        m_PidStages = stages;
+        
+        if(stages == 0) {
+            Scheduler_Start(&m_Scheduler, &m_FanJob, FANTIMEOUT * 1000);
+            
+            // publish the change
+            AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateOff);
+        }
+    }
+    
+    if(m_PidFan == 0 && gpio_read(GPIO_FAN) == FAN_ON) {
+        // turned on behind our back; the fan timeout turns it off again
+        m_PidFan = 1;
+        
+        Scheduler_Start(&m_Scheduler, &m_FanJob, FANTIMEOUT * 1000);
+    }
+    
+    FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Interlock: %s; relays driven after %lu us, %lu trips"), 
+                        Interlock_Name(m_Interlock.lastCause), m_Interlock.lastReaction, cuts);
+    
+    LOG_WARNING("reportInterlock(): %s\n", buffer);
+    Warning(mqtt, buffer);
+    
+    updatePidStatus();
+}
+/**
+ * schedule command - "off" drops the schedule, "show" tells what it does now and anything else is a new schedule, 
+ * see schedule.h
+ * 
+ * @param payload
+ */
+void ICACHE_FLASH_ATTR setSchedule(const char* payload)
+{
+    char buffer[112];
+    int  n;
+    
+    if(os_strcmp(payload, "show") == 0) {
+        esp_time_t  wall = wallClock();
+        int         active, next;
+        
+        if(m_Schedule.count == 0) {
+            Info(mqtt, "Schedule: off");
+        } else if(wall == 0) {
+            Info(mqtt, "Schedule: waiting for the clock");
+        } else {
+            active = Schedule_Lookup(&m_Schedule, Schedule_MinuteOfWeek(wall, SCHEDULE_UTC_OFFSET, SCHEDULE_DST), &next);
+            
+            SCHEDULE_TRANSITION* now  = &m_Schedule.t[active];
+            SCHEDULE_TRANSITION* then = &m_Schedule.t[next];
+            
+            FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Schedule: %d transitions, %d.%d C now, %d.%d C from day %d %02d:%02d, heating %d.%d C/h"), 
+                                m_Schedule.count, now->setpoint / 10, now->setpoint % 10, then->setpoint / 10, then->setpoint % 10, 
+                                then->minute / (24 * 60) + 1, (then->minute / 60) % 24, then->minute % 60, 
+                                m_Schedule.heatRate / 10, m_Schedule.heatRate % 10);
+            
+            Info(mqtt, buffer);
+        }
+        
+        return;
+    }
+    
+    if(os_strcmp(payload, "off") == 0) {
+        Schedule_Clear(&m_Schedule);
+        
+        Info(mqtt, "Schedule: off");
+    } else if((n = Schedule_Compile(&m_Schedule, payload, PID_MIN_SETPOINT * 10, PID_MAX_SETPOINT * 10)) < 0) {
+        FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Schedule: error in entry %d"), -n);
+        
+        Warning(mqtt, buffer);
+        return;
+    } else {
+        FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Schedule: %d transitions"), n);
+        
+        Info(mqtt, buffer);
+    }
+    
+    if(Schedule_Save(&m_Schedule, SCHEDULE_FLASH_SECTOR) == 0) {
+        Warning(mqtt, "Schedule: not saved");
+    }
+    
+    m_ScheduleSetpoint = SCHEDULE_NONE;                 // apply it now
+    
+    Scheduler_Start(&m_Scheduler, &m_ScheduleJob, 0);
+}
+/**
+ * setpoint command - in C, e.g. 21.5 or {"value":21.5}
+ * 
+ * @param json
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR commandSetpoint(const JSON* json, int arg)
+{
+    int32_t setpoint;
+    
+    if(Json_Tenths(json, arg, &setpoint) == 0 || setpoint < PID_MIN_SETPOINT * 10 || setpoint > PID_MAX_SETPOINT * 10) {
+        Warning(mqtt, "Setpoint: out of range");
+        return;
+    }
+    
+    setPidSetpoint(HeaterPid::fromTenths(setpoint));
+    saveState(1);
+    
+    // publish the change
+    AccThermostatTargetTemperatureSetValue(thermostat, setpoint / 10.0);
+    
+    Scheduler_Start(&m_Scheduler, &m_PidJob, 0);
+}
+/**
+ * mode command - off, heat, cool, auto or their number
+ * 
+ * @param json
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR commandMode(const JSON* json, int arg)
+{
+    int32_t mode;
+    
+    if(Json_Equal(json, arg, "off")) {
+        mode = TargetHeatingCoolingStateOff;
+    } else if(Json_Equal(json, arg, "heat")) {
+        mode = TargetHeatingCoolingStateHeat;
+    } else if(Json_Equal(json, arg, "cool")) {
+        mode = TargetHeatingCoolingStateCool;
+    } else if(Json_Equal(json, arg, "auto")) {
+        mode = TargetHeatingCoolingStateAuto;
+    } else if(Json_Int(json, arg, &mode) == 0 || mode < TargetHeatingCoolingStateOff || mode > TargetHeatingCoolingStateAuto) {
+        Warning(mqtt, "Mode: unknown");
+        return;
+    }
+    
+    setPidMode(mode);
+    saveState(1);
+    
+    // publish the change
+    AccThermostatTargetHeatingCoolingStateSetValue(thermostat, mode);
+    
+    Scheduler_Start(&m_Scheduler, &m_PidJob, 0);
+}
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR commandAutotune(const JSON* json, int arg)
+{
+    char action[16];
+    
+    if(arg < 0 || Json_Copy(json, arg, action, sizeof(action)) < 0) {
+        action[0] = '\0';
+    }
+    
+    startAutotune(action);
+}
+/**
+ * history command - the page number; anything else is the first page
+ * 
+ * @param json
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR commandHistory(const JSON* json, int arg)
+{
+    int32_t page;
+    
+    if(Json_Int(json, arg, &page) == 0 || page < 0) {
+        page = 0;
+    }
+    
+    sendHistory(page);
+}
+/**
+ * schedule command - plain text as it is, or a JSON string
+ * 
+ * @param json
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR commandSchedule(const JSON* json, int arg)
+{
+    if(arg == 0 && json->token[0].type == JSON_PRIMITIVE) {
+        setSchedule(json->text);                        // the whole payload, NUL terminated
+    } else if(Json_Copy(json, arg, m_ScheduleText, sizeof(m_ScheduleText)) >= 0) {
+        setSchedule(m_ScheduleText);
+    } else {
+        Warning(mqtt, "Schedule: too long; send it as plain text");
+    }
+}
+/**
+ * diagnostics command - health, interlock and command counters now
+ * 
+ * @param json
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR commandDiagnostics(const JSON* json, int arg)
+{
+    char buffer[128];
+    
+    healthJob(NULL);
+    
+    Interlock_Format(&m_Interlock, buffer);
+    Info(mqtt, buffer);
+    
+    FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Commands %lu rejected %lu passed %lu"), 
+                        m_Commands.handled, m_Commands.rejected, m_Commands.passed);
+    Info(mqtt, buffer);
+}
+/**
+ * delta command - where the patches are, e.g. http://192.168.1.10:8000/; "stop" gives up
+ * 
+ * @param json
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR commandDelta(const JSON* json, int arg)
+{
+    char url[64];
+    
+    if(arg < 0 || Json_Copy(json, arg, url, sizeof(url)) < 0) {
+        Warning(mqtt, "Delta: no URL");
+    } else if(m_Update != NULL && m_Update->restart) {
+        Warning(mqtt, "Delta: restart pending");        // the other slot is already selected
+    } else if(os_strcmp(url, "stop") != 0) {
+        startUpdate(url);
+    } else if(m_Update != NULL && !m_Update->failed) {
+        failUpdate("stopped", 0);
+    }
+}
+/**
+ * fetch the patch from the image we run to the one for the other slot, rom<n>.dlt from deploy.sh
+ * 
+ * @param url
+ */
+void ICACHE_FLASH_ATTR startUpdate(const char* url)
+{
+    rboot_config    conf = rboot_get_config();
+    char            file[12];
+    int             rc;
+    
+    if(m_Update != NULL) {
+        Warning(mqtt, m_Update->restart ? "Delta: restart pending" : "Delta: already running");
+        return;
+    }
+    
+    if(conf.count < 2 || m_BootRom > 1) {
+        Warning(mqtt, "Delta: needs rBoot slots 0 and 1");
+        return;
+    }
+    
+    if((m_Update = (DELTA_UPDATE*) os_zalloc(sizeof(DELTA_UPDATE))) == NULL) {
+        Warning(mqtt, "Delta: out of memory");
+        return;
+    }
+    
+    m_Update->rom      = 1 - m_BootRom;
+    m_Update->progress = esp_uptime(0);
+    
+    Delta_Begin(&m_Update->delta, conf.roms[m_BootRom], conf.roms[m_Update->rom]);
+    
+    os_sprintf(file, "rom%d.dlt", m_Update->rom);
+    
+    if((rc = Fetch_Start(&m_Update->fetch, url, file)) < 0) {
+        failUpdate("no download", rc);
+        return;
+    }
+    
+    Info(mqtt, "Delta: fetching");
+    
+    Scheduler_Start(&m_Scheduler, &m_UpdateJob, DELTA_POLL);
+}
+/**
+ * move the patch from the download into the other slot; one step of flash work or one read per run, so the 
+ * control loop keeps going
+ * 
+ * @param arg
+ */
+void ICACHE_FLASH_ATTR updateJob(void* arg)
+{
+    DELTA_UPDATE*   u = m_Update;
+    const uint8_t*  data;
+    uint32_t        n;
+    int             rc;
+    char            buffer[64];
+    
+    if(u == NULL) {
+        return;
+    }
+    
+    if(u->restart) {
+        system_restart();                               // into the new image, see below
+        return;
+    }
+    
+    if(u->failed) {
+        if(Fetch_Status(&u->fetch) == FETCH_BUSY) {
+            Scheduler_Start(&m_Scheduler, &m_UpdateJob, DELTA_POLL);       // it may still call back into 'u'
         } else {
-            Warning(mqtt, "Failed to read DHT1 sensor");
+            os_free(u);
+            m_Update = NULL;
         }
         
-        if(m_Dht2.read(temp, hum) == 0) {
-            m_Temp2 = temp;
-            m_Hum2  = hum;
-            
-            AccThermometerCurrentTemperatureSetValue(outdoorThermometer, m_Temp2);
-            AccHumidityCurrentRelativeHumiditySetValue(outdoorHumidity, m_Hum2);
-        } else {
-            Warning(mqtt, "Failed to read DHT2 sensor");
-        }
-
-        countdown(&m_DhtCountdown, DHT_INTERVAL);
+        return;
     }
     
-    /******************************************************************************************************************
-     * deal with MQTT
-     * 
-     */
-    int event = ConnectorRun(mqtt);
-    if(event == RUN_CONNECTED) {
-        onConnect();
+    if((rc = Delta_Run(&u->delta)) == DELTA_BUSY) {
+        u->progress = esp_uptime(0);
+        
+        Scheduler_Start(&m_Scheduler, &m_UpdateJob, 0);
+        return;
+    } else if(rc != DELTA_OK) {
+        failUpdate("patch failed", rc);
+        return;
     }
     
-    /******************************************************************************************************************
-     * deal with incoming value updates
-     * 
-     */
-    Device_Message* dm;
+    if(u->ended) {
+        // the new image is in the other slot and checks out
+        if(!rboot_set_current_rom(u->rom)) {
+            failUpdate("slot not selected", 0);
+            return;
+        }
+        
+        FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Delta: rom%d verified, %lu bytes; restarting"), 
+                            u->rom, u->delta.written);
+        Info(mqtt, buffer);
+        
+        saveState(0);                                   // RTC memory survives the restart
+        
+        u->restart = 1;
+        
+        Scheduler_Start(&m_Scheduler, &m_UpdateJob, DELTA_RESTART);
+        return;
+    }
     
-    switch(DeviceGetEventType(dm = DeviceGetEvent(device))) {
-        case FormatString:  
-            break;
-        case FormatBool:
-            DTXT("Bool; aid = %lld, iid = %lld, value = %s\n", Device_GetAid(dm), Device_GetIid(dm), (Device_GetValueBool(dm) == true) ? "True" : "False");
-            break;
-        case FormatUInt8:   
-            DTXT("UInt8; aid = %lld, iid = %lld, value = %d\n", Device_GetAid(dm), Device_GetIid(dm), Device_GetValueUInt8(dm));
-            if(dm->acc == thermostat->Accessory) {
-                DTXT("thermostat\n");
-                
-                if(Device_GetIid(dm) == AccThermostatTargetHeatingCoolingStateIid) {
-                    setPidMode(Device_GetValueUInt8(dm));
-                }
-            }
-            break;
-        case FormatInt8:    
-            break;
-        case FormatUInt16:  
-            break;
-        case FormatInt16:   
-            break;
-        case FormatUInt32:  
-            break;
-        case FormatInt32:   
-            break;
-        case FormatUInt64:  
-            break;
-        case FormatFloat:   
-            DTXT("Float; aid = %lld, iid = %lld\n", Device_GetAid(dm), Device_GetIid(dm));
-            if(dm->acc == thermostat->Accessory) {
-                if(Device_GetIid(dm) == AccThermostatTargetTemperatureIid) {
-                    setPidSetpoint(Device_GetValueFloat(dm));
-                }
-            }
-            break;
-        case FormatNone:
-            break;
+    if((n = Fetch_Read(&u->fetch, &data)) > 0) {
+        if((rc = Delta_Write(&u->delta, data, n)) < 0) {
+            failUpdate("patch failed", rc);
+            return;
+        }
+        
+        Fetch_Release(&u->fetch, rc);
+        
+        u->progress = esp_uptime(0);
+        
+        Scheduler_Start(&m_Scheduler, &m_UpdateJob, 0);
+        return;
     }
     
-    DeviceDeleteEvent(dm);
-
-    /******************************************************************************************************************
-     * show we're alive
-     * 
-     */
-    if(WIFI_IsConnected()) {
-        if(IsConnected(mqtt)) {
-            Blinker_Set(&m_BlueLED, 200, 3000);
+    if((rc = Fetch_Status(&u->fetch)) == FETCH_BUSY) {
+        if(esp_uptime(0) - u->progress > DELTA_TIMEOUT) {
+            failUpdate("download stalled", 0);
         } else {
-            Blinker_Set(&m_BlueLED, 1000, 1000);
+            Scheduler_Start(&m_Scheduler, &m_UpdateJob, DELTA_POLL);
         }
-    } else {
-        Blinker_Set(&m_BlueLED, 200, 200);
+        
+        return;
+    } else if(rc != FETCH_OK) {
+        failUpdate("download failed", rc);
+        return;
     }
     
-    Blinker_Run(&m_BlueLED);
-
-    /******************************************************************************************************************
-     * firmware upgrader
-     * 
-     */
-    if(Upgrader_NewPkg(&m_Upgrader)) {
-        if(Close(mqtt)) {
-            Upgrader_Run(&m_Upgrader);
-        }
+    if((rc = Delta_End(&u->delta)) < 0) {
+        failUpdate("patch incomplete", rc);
+        return;
     }
     
-    system_os_post(TASK1_ID, 0, 0);
+    u->ended = 1;
+    
+    Scheduler_Start(&m_Scheduler, &m_UpdateJob, 0);
 }
 /**
+ * give up; the slot we run and the rBoot config are untouched
  * 
+ * @param what
+ * @param rc
  */
-void ICACHE_FLASH_ATTR onConnect(void)
+void ICACHE_FLASH_ATTR failUpdate(const char* what, int rc)
 {
-    DTXT("onConnect():\n");
-
-    // firmware upgrade service
-    Upgrader_Subscribe_Package(&m_Upgrader);
-    Upgrader_Publish_Package(&m_Upgrader);
+    char buffer[64];
+    
+    FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Delta: %s (%d)"), what, rc);
+    Warning(mqtt, buffer);
+    
+    Fetch_Stop(&m_Update->fetch);
+    
+    m_Update->failed = 1;
+    
+    Scheduler_Start(&m_Scheduler, &m_UpdateJob, 0);
 }
 /**
+ * os_sprintf() has no %f
  * 
- * @param mqtt
- * @param ptr
- * @param nodename
- * @param actorId
- * @param platformId
- * @param feedId
- * @param payload
+ * @param p
+ * @param v     not negative
+ * @return characters written
  */
-void ICACHE_FLASH_ATTR onCommandCallback(Mqtt*          mqtt, 
-                                         void*          ptr,
-                                         const char*    nodename,
-                                         const char*    actorId,
-                                         const char*    platformId,
-                                         const char*    feedId,
-                                         const char*    payload)
+int ICACHE_FLASH_ATTR formatGain(char* p, HeaterPid::value_t v)
 {
-    if(Upgrader_Check(&m_Upgrader, nodename, actorId, platformId, feedId, payload)) {
-        
-    } else {
-        DTXT("onCommandCallback(): command message\n");
-        DTXT("onCommandCallback(): nodename          = %s\n", nodename);
-        DTXT("onCommandCallback(): actor_id          = %s\n", actorId);
-        DTXT("onCommandCallback(): platform_id       = %s\n", platformId);
-        DTXT("onCommandCallback(): feed_id           = %s\n", feedId);
-        DTXT("onCommandCallback(): payload           = %s\n", payload);
-    }
+    uint32_t frac = (uint32_t) ((((int64_t) v & (HeaterPid::ONE - 1)) * 100000) >> PID_FRAC);
+    
+    return FlashStr_Sprintf(p, FLASH_STR("%ld.%05lu"), (int32_t) (v >> PID_FRAC), frac);
 }
 /**
+ * reply with one page of the sensor history, oldest first
  * 
- * @param mode
+ * @param page
  */
-void ICACHE_FLASH_ATTR setPidMode(uint8_t mode)
+void ICACHE_FLASH_ATTR sendHistory(uint32_t page)
 {
-    switch(mode) {
-        case TargetHeatingCoolingStateOff:
-            DTXT("setPidMode(): thermostat off\n");
-            
-            if(m_PidEnable == 1) {
-                DTXT("setPidMode(): PID disabled\n");
-                m_Pid.SetMode(MANUAL);      // turn it off
-                m_PidEnable = 0;
-                
-                AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateOff);
-            }
-
-            if(m_PidHeater1 == 1) {
-                DTXT("setPidMode(): heater 1 off (disable)\n");
-                gpio_write(GPIO_HEATER1, HEATER_OFF);
-                m_PidHeater1 = 0;
-
-                countdown(&m_PidFanCountdown, FANTIMEOUT);
-            }
-
-            if(m_PidHeater2 == 1) {
-                DTXT("setPidMode(): heater 2 off (disable)\n");
-                gpio_write(GPIO_HEATER2, HEATER_OFF);
-                m_PidHeater2 = 0;
-
-                countdown(&m_PidFanCountdown, FANTIMEOUT);
-            }
-
-            // publish the change
-            updatePidStatus();
-            break;
-
-        case TargetHeatingCoolingStateAuto:
-            DTXT("setPidMode(): thermostat heat\n");
-            if(m_PidEnable == 0) {
-                m_Pid.SetMode(AUTOMATIC);      // turn it on
-                m_PidEnable = 1;
-            }
-            break;
-
-        case TargetHeatingCoolingStateHeat:
-        case TargetHeatingCoolingStateCool:
-            DTXT("setPidMode(): thermostat heat/cool\n");
-            break;
+    HISTORY_SAMPLE  samples[HISTORY_PAGE_SIZE];
+    uint32_t        count = History_Count(&m_History);
+    char*           p     = m_HistoryReply;
+    int             i, n;
+    
+    n = History_Read(&m_History, page * HISTORY_PAGE_SIZE, samples, HISTORY_PAGE_SIZE);
+    
+    // the samples are in wall clock time once History_SetClock() has it, uptime before
+    p += FlashStr_Sprintf(p, FLASH_STR("{\"page\":%lu,\"pages\":%lu,\"clock\":\"%s\",\"now\":%lu,\"s\":["), 
+                    page, (count + HISTORY_PAGE_SIZE - 1) / HISTORY_PAGE_SIZE, (m_History.clock != 0) ? "utc" : "uptime",
+                    m_History.clock + esp_uptime(0));
+    
+    for(i = 0; i < n; i++) {
+        p += FlashStr_Sprintf(p, FLASH_STR("%s[%lu,%d,%d,%d,%d,%u]"), (i > 0) ? "," : "", samples[i].time,
+                        samples[i].value[0], samples[i].value[1], samples[i].value[2], samples[i].value[3], samples[i].state);
     }
+    
+    FlashStr_Sprintf(p, FLASH_STR("]}"));
+    
+    Info(mqtt, m_HistoryReply);
+    
+    LOG_DEBUG("sendHistory(): page %lu, %d samples, %lu bytes for %lu samples since boot\n", page, n, m_History.bytes, m_History.samples);
 }
 /**
+ * checkpoint what is needed to continue where we left off
  * 
- * @param mode
+ * @param flash
  */
-void ICACHE_FLASH_ATTR setPidSetpoint(double value)
+void ICACHE_FLASH_ATTR saveState(int flash)
 {
-    m_Pid.Setpoint(value);
+    WARM_STATE state;
+    
+    os_memset(&state, 0, sizeof(WARM_STATE));
+    
+    state.integral = m_Pid.Integral();
+    state.setpoint = m_Pid.Setpoint();
+    state.temp1    = m_Temp1;
+    state.hum1     = m_Hum1;
+    state.temp2    = m_Temp2;
+    state.hum2     = m_Hum2;
+    state.mode     = m_PidMode;
+    state.tuned    = m_PidTuned;
+    state.heatRate = m_Schedule.heatRate;
+    state.kp       = m_Pid.GetKp();
+    state.ki       = m_Pid.GetKi();
+    state.kd       = m_Pid.GetKd();
+    state.demand   = m_PidEnable ? esp_uptime(0) - m_PidDemand : 0;
+    
+    Checkpoint_Save(&m_Checkpoint, &state, flash);
+    
+    if(flash) {
+        m_CheckpointTime = esp_uptime(0);
+    }
 }
 /**
- * 
+ * move the access point we were last connected to to the front of wifi_list
  */
-void ICACHE_FLASH_ATTR runPid(void)
+void ICACHE_FLASH_ATTR preferLastAp(void)
 {
-    if(m_Temp1 == INVALID_TEMP) {
-        return;         // no valid reading from DHT sensor
+    uint32_t cache[2];
+    WIFI_AP  ap;
+    uint32_t i;
+    
+    if(!system_rtc_mem_read(FASTBOOT_RTC_BLOCK, cache, sizeof(cache)) || cache[1] != ~cache[0]) {
+        return;                                         // cold boot
     }
     
-    m_Pid.Compute();
+    if(cache[0] == 0 || cache[0] >= sizeof(m_WifiSsid) / sizeof(m_WifiSsid[0])) {
+        return;
+    }
     
-    if(m_PidEnable == 1) {
-        if(m_Pid.Output() > 1.0) {
-            countdown(&m_PidFanCountdown, FANTIMEOUT);
-            
-            if(m_PidHeater1 == 0) {
-                m_PidHeater1 = 1;
-                m_PidFan     = 1;
-                m_PidStage2  = esp_uptime(0);           // get ready for stage 2
-                
-                DTXT("runPid(): fan on\n");
-                DTXT("runPid(): heater 1 on\n");
-                
-                gpio_write(GPIO_FAN,     FAN_ON);
-                gpio_write(GPIO_HEATER1, HEATER_ON);
-                
-                // publish the change
-                AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateHeat);
-
-                updatePidStatus();
-            }
-
-            // is it time to turn on heater 2?
-            if(esp_uptime(0) - m_PidStage2 >= STAGE_2_TIME) {
-                if(m_PidHeater2 == 0) {
-                    m_PidHeater2 = 1;
-
-                    DTXT("runPid(): heater 2 on\n");
-
-                    gpio_write(GPIO_HEATER2, HEATER_ON);
-
-                    // publish the change
-                    updatePidStatus();
-                }
-            }
-        } else {
-            if(m_PidHeater1 == 1) {
-                m_PidHeater1 = 0;
-                
-                DTXT("runPid(): heater 1 off\n");
-
-                gpio_write(GPIO_HEATER1, HEATER_OFF);
-
-                // publish the change
-                AccThermostatCurrentHeatingCoolingStateSetValue(thermostat, CurrentHeatingCoolingStateOff);
-
-                updatePidStatus();
-            }
-            
-            if(m_PidHeater2 == 1) {
-                m_PidHeater2 = 0;
-                
-                DTXT("runPid(): heater 2 off\n");
-
-                gpio_write(GPIO_HEATER2, HEATER_OFF);
-
-                // publish the change
-                updatePidStatus();
-            }
-        }
+    ap = wifi_list[cache[0]];
+    
+    for(i = cache[0]; i > 0; i--) {
+        wifi_list[i] = wifi_list[i - 1];
     }
     
-    //
-    // turn fan off after some time
-    //
-    if(expired(&m_PidFanCountdown)) {
-        if(m_PidFan == 1) {
-            m_PidFan = 0;
-            
-            DTXT("runPid(): fan off\n");
-            
-            gpio_write(GPIO_FAN, FAN_OFF);
+    wifi_list[0] = ap;
+    
+    LOG_INFO("preferLastAp(): %s first\n", m_WifiSsid[cache[0]]);
+}
+/**
+ * remember which access point we got connected to
+ */
+void ICACHE_FLASH_ATTR saveLastAp(void)
+{
+    struct station_config   conf;
+    uint32_t                cache[2];
+    uint32_t                i;
+    
+    if(!wifi_station_get_config(&conf)) {
+        return;
+    }
+    
+    for(i = 0; i < sizeof(m_WifiSsid) / sizeof(m_WifiSsid[0]); i++) {
+        if(os_strncmp((const char*) conf.ssid, m_WifiSsid[i], sizeof(conf.ssid)) == 0) {
+            cache[0] = i;
+            cache[1] = ~i;
             
-            // publish the change
-            updatePidStatus();
+            system_rtc_mem_write(FASTBOOT_RTC_BLOCK, cache, sizeof(cache));
+            break;
         }
     }
 }
 /**
  * 
  */
-void ICACHE_FLASH_ATTR updatePidStatus(void)
+void ICACHE_FLASH_ATTR bootReport(void)
 {
-    char buffer[64];
+    char buffer[96];
     
-    os_sprintf(buffer, "Varme 1: %s, Varme 2: %s, Blæser: %s",  (m_PidHeater1 == 1) ? "ON" : "OFF",
-                                                                (m_PidHeater2 == 1) ? "ON" : "OFF",
-                                                                (m_PidFan == 1) ?     "ON" : "OFF");
+    FlashStr_Snprintf(buffer, sizeof(buffer), FLASH_STR("Boot: reading %lu ms, connect %lu ms, publish %lu ms"), 
+                        m_BootReading / 1000, m_BootConnect / 1000, m_BootPublish / 1000);
     
-    AccTextSetValue(message, buffer);
+    LOG_INFO("bootReport(): %s\n", buffer);
+    Info(mqtt, buffer);
+}
+/**
+ * queue an event if it cannot be published now
+ * 
+ * @param type
+ * @param value
+ */
+void ICACHE_FLASH_ATTR forward(uint8_t type, int16_t value)
+{
+    if(mqtt != NULL && WIFI_IsConnected() && IsConnected(mqtt)) {
+        return;
+    }
+    
+    Forward_Add(&m_Forward, type, value, esp_uptime(0));
+}
+/**
+ * 
+ * @return wall clock time as synced by Chronos, 0 if not synced yet
+ */
+esp_time_t ICACHE_FLASH_ATTR wallClock(void)
+{
+    esp_time_t now = esp_time(0);
+    
+    return (now < CLOCK_VALID) ? 0 : now;
 }
 /**
  * 
  */
 void ICACHE_FLASH_ATTR main_init_done(void)
 {
-    DTXT("main_init_done(): begin\n");
+    LOG_INFO("main_init_done(): begin\n");
 
-    os_sprintf(m_Pkg, "%s %lu", m_PkgId, m_Version);
+    FlashStr_Snprintf(m_Pkg, sizeof(m_Pkg), FLASH_STR("%s %lu"), m_PkgId, m_Version);
+    
+    // pick up where we left off - RTC memory after a reset or ROM swap, flash after a power cut
+    WARM_STATE  state;
+    int         warm;
+    
+    os_memset(&state, 0, sizeof(WARM_STATE));
+    
+    state.setpoint = HeaterPid::fromDouble(PID_DEFAULT_SETPOINT);
+    state.mode     = TargetHeatingCoolingStateAuto;
+    
+    if(!Checkpoint_Initialize(&m_Checkpoint, CHECKPOINT_RTC_BLOCK, CHECKPOINT_FLASH_SECTOR, sizeof(WARM_STATE),
+                              WARM_STATE_VERSION)) {
+        LOG_WARNING("main_init_done(): WARM_STATE does not fit a checkpoint\n");
+    }
+    
+    warm = Checkpoint_Load(&m_Checkpoint, &state);
+    
+    if(warm != CHECKPOINT_RTC) {
+        // no telling how old they are
+        state.temp1  = INVALID_TENTHS;
+        state.hum1   = INVALID_TENTHS;
+        state.temp2  = INVALID_TENTHS;
+        state.hum2   = INVALID_TENTHS;
+        state.demand = 0;
+    }
     
-    Container* cont    = NewContainer(WIFI_GetMAC(), "Vaerksted", "001", "github.com/mikejac", m_Pkg, 6 * 1024);
+    LOG_INFO("main_init_done(): checkpoint = %d, setpoint = %d, mode = %d\n", warm, HeaterPid::toTenths(state.setpoint), state.mode);
+    
+    uint32_t heap = system_get_free_heap_size();
+    
+    // these objects live forever; keep them out of the heap
+    Arena_Begin();
+    
+    Container* cont    = NewContainer(WIFI_GetMAC(), "Vaerksted", "001", "github.com/mikejac", m_Pkg, CONTAINER_BUFFER_SIZE);
 
     outdoorThermometer = NewAccThermometer("Udendørs Temperatur", "001-01", "github.com/mikejac", "ESP8266", 0, -10, 50, 0.1);
     outdoorHumidity    = NewAccHumidity("Udendørs Luftfugtighed", "001-02", "github.com/mikejac", "ESP8266", 0, 0, 100, 1);
     indoorHumidity     = NewAccHumidity("Værksted Luftfugtighed", "001-03", "github.com/mikejac", "ESP8266", 0, 0, 100, 1);
-    thermostat         = NewAccThermostat("Værksted Termostat", "001-04", "github.com/mikejac", "ESP8266", 0, -10, 50, 0.1, PID_DEFAULT_SETPOINT, PID_MIN_SETPOINT, PID_MAX_SETPOINT, 1);
+    thermostat         = NewAccThermostat("Værksted Termostat", "001-04", "github.com/mikejac", "ESP8266", 0, -10, 50, 0.1, HeaterPid::toDouble(state.setpoint), PID_MIN_SETPOINT, PID_MAX_SETPOINT, 1);
     message            = NewAccText("Værksted Besked", "001-05", "github.com/mikejac", "ESP8266", "Lige startet");
+    diagnostics        = NewAccText("Værksted Diagnose", "001-06", "github.com/mikejac", "ESP8266", "");
+    
+    // deadband (0.1 units), minimum interval and heartbeat for publishing the sensor values
+    Deadband_Initialize(&m_PubTemp2, 2,  PUBLISH_MIN_INTERVAL, PUBLISH_MAX_SILENCE);
+    Deadband_Initialize(&m_PubHum2,  10, PUBLISH_MIN_INTERVAL, PUBLISH_MAX_SILENCE);
+    Deadband_Initialize(&m_PubHum1,  10, PUBLISH_MIN_INTERVAL, PUBLISH_MAX_SILENCE);
+    Deadband_Initialize(&m_PubTemp1, 1,  PUBLISH_MIN_INTERVAL, PUBLISH_MAX_SILENCE);
     
     AddAccessory(cont, outdoorThermometer->Accessory);
     AddAccessory(cont, outdoorHumidity->Accessory);
     AddAccessory(cont, indoorHumidity->Accessory);
     AddAccessory(cont, thermostat->Accessory);
     AddAccessory(cont, message->Accessory);
+    AddAccessory(cont, diagnostics->Accessory);
 
+    Arena_End();
+    
     WIFI_Run();
     
+    Arena_Begin();
+    
     mqttOptions = NewMqttOptions();
     if(mqttOptions != 0) {
         MqttOptions_SetServer(mqttOptions,          MQTT_BROKER_IP);
@@ -519,7 +1975,7 @@ void ICACHE_FLASH_ATTR main_init_done(void)
         MqttOptions_SetNodename(mqttOptions,        WIFI_GetMAC());
         MqttOptions_SetActorPlatformId(mqttOptions, MY_PLATFORM_ID);
         MqttOptions_SetClassType(mqttOptions,       ClassTypeDeviceSvc);
-        MqttOptions_SetBufferSize(mqttOptions,      6 * 1024);
+        MqttOptions_SetBufferSize(mqttOptions,      MQTT_BUFFER_SIZE);
         
         mqtt = Connector(mqttOptions);
         if(mqtt != 0) {
@@ -537,56 +1993,148 @@ void ICACHE_FLASH_ATTR main_init_done(void)
             Upgrader_Initialize(&m_Upgrader, mqtt, NODENAME_UPGRADER, m_PkgId, &m_Version);
         }
     }
+    
+    Arena_End();
+    
+    const ARENA_STATS* arena = Arena_GetStats();
+    
+    LOG_INFO("main_init_done(): arena; size = %lu, used = %lu, high-water = %lu, holes = %lu, allocs = %lu, fallbacks = %lu\n",
+            arena->size, arena->used, arena->highWater, arena->holes, arena->allocs, arena->fallbacks);
+    LOG_INFO("main_init_done(): heap; before = %lu, after = %lu\n", heap, system_get_free_heap_size());
             
     Blinker_Initialize(&m_BlueLED, GPIO_BLUE);
     Blinker_Set(&m_BlueLED, 200, 200);
     Blinker_Enable_on(&m_BlueLED);
 
-    gpio_enable(GPIO_FAN,     GPIO_OUTPUT);
-    gpio_enable(GPIO_HEATER1, GPIO_OUTPUT);
-    gpio_enable(GPIO_HEATER2, GPIO_OUTPUT);
+    gpio_enable(GPIO_FAN, GPIO_OUTPUT);
+    gpio_write(GPIO_FAN, FAN_OFF);
 
-    gpio_write(GPIO_FAN,     FAN_OFF);
-    gpio_write(GPIO_HEATER1, HEATER_OFF);
-    gpio_write(GPIO_HEATER2, HEATER_OFF);
-    
-    m_Dht1.init(GPIO_DHT1);
-    m_Dht2.init(GPIO_DHT2);
+    Heaters::init();
     
-    double temp, hum;
-
-    // do DHT first readings - they will probably fail, so let's get it over with
-    m_Dht1.read(temp, hum);
-    m_Dht2.read(temp, hum);
+    gpio_enable(GPIO_DHT1, GPIO_INPUT);
+    gpio_enable(GPIO_DHT2, GPIO_INPUT);
 
+    // deploy.sh refuses images that reach the history sectors; this catches one built some other way
+    if(&_irom0_text_end - (char*) IROM_FLASH_MAP > HISTORY_FLASH_SECTOR * SPI_FLASH_SEC_SIZE) {
+        LOG_WARNING("main_init_done(): image reaches into the history sectors; keeping history in RAM\n");
+        History_Initialize(&m_History, DHT_INTERVAL, HISTORY_FLASH_SECTOR, 0);
+    } else {
+        History_Initialize(&m_History, DHT_INTERVAL, HISTORY_FLASH_SECTOR, HISTORY_FLASH_SECTORS);
+    }
+    Forward_Initialize(&m_Forward, FORWARD_POLICY);
+    
+    DhtAsync_Initialize(&m_Dht1, GPIO_DHT1);
+    DhtAsync_Initialize(&m_Dht2, GPIO_DHT2);
+    
+    m_Temp1      = state.temp1;
+    m_Hum1       = state.hum1;
+    m_Temp2      = state.temp2;
+    m_Hum2       = state.hum2;
+    m_Temp1Time  = esp_uptime(0);
+    m_Temp2Time  = esp_uptime(0);
+    
+    // from here on the relays are watched by a timer, whatever the loop is doing
+    Interlock_Initialize(&m_Interlock, BIT(GPIO_HEATER1) | BIT(GPIO_HEATER2), HEATER_ON ? 0xffffffff : 0, 
+                                       BIT(GPIO_FAN), FAN_ON ? 0xffffffff : 0, m_Temp1);
+    Interlock_Limits(&m_Interlock, INTERLOCK_LOOP_TIMEOUT, INTERLOCK_STALE_TIMEOUT, INTERLOCK_MAX_TEMP, 
+                                   INTERLOCK_HYSTERESIS, INTERLOCK_MAX_ON, INTERLOCK_REST);
+    Interlock_Start(&m_Interlock, INTERLOCK_TICK);
+    m_InterlockCuts = 0;
+    
+    Command_Initialize(&m_Commands, WIFI_GetMAC(), MY_PLATFORM_ID);
+    Command_Add(&m_Commands, "setpoint",    commandSetpoint);
+    Command_Add(&m_Commands, "mode",        commandMode);
+    Command_Add(&m_Commands, "autotune",    commandAutotune);
+    Command_Add(&m_Commands, "history",     commandHistory);
+    Command_Add(&m_Commands, "schedule",    commandSchedule);
+    Command_Add(&m_Commands, "diagnostics", commandDiagnostics);
+    Command_Add(&m_Commands, "delta",       commandDelta);
+    
+    Hampel_Initialize(&m_FilterTemp1, FILTER_TEMP_DEVIATION);
+    Hampel_Initialize(&m_FilterHum1,  FILTER_HUM_DEVIATION);
+    Hampel_Initialize(&m_FilterTemp2, FILTER_TEMP_DEVIATION);
+    Hampel_Initialize(&m_FilterHum2,  FILTER_HUM_DEVIATION);
+    
     // PID constroller
-    m_Pid.init(PID_Kp, PID_Ki, PID_Kd, DIRECT);
-    m_Pid.SetSampleTime(60 * 1000);
-    m_Pid.Setpoint(PID_DEFAULT_SETPOINT);
-    m_Pid.SetOutputLimits(0, 30);
+    m_Pid.init(HeaterPid::fromInt(PID_Kp), HeaterPid::fromInt(PID_Ki), HeaterPid::fromInt(PID_Kd), DIRECT);
+    m_Pid.SetSampleTime(DHT_INTERVAL * 1000);
+    m_Pid.Setpoint(state.setpoint);
+    m_Pid.SetOutputLimits(0, HeaterPid::fromInt(PID_OUTPUT_MAX));
+    
+    if(state.tuned) {
+        m_Pid.SetTunings(state.kp, state.ki, state.kd);     // from an earlier autotune
+        m_PidTuned = 1;
+    }
+    
+    if(m_Temp1 != INVALID_TENTHS) {
+        m_Pid.Input(HeaterPid::fromTenths(m_Temp1));
+    }
+    
     m_Pid.SetMode(AUTOMATIC);                           // start it
+    m_Pid.Integral(state.integral);                     // zero on a cold start
     
-    m_Temp1      = INVALID_TEMP;
-    m_Hum1       = INVALID_TEMP;
-    m_Temp2      = INVALID_TEMP;
-    m_Hum2       = INVALID_TEMP;
+    if(m_Temp1 != INVALID_TENTHS) {
+        m_Pid.Refresh();                                // the relays need not wait for the first reading
+    }
     
     m_PidEnable  = 0;
     m_PidFan     = 0;
-    m_PidHeater1 = 0;
-    m_PidHeater2 = 0;
+    m_PidStages  = 0;
+    m_PidWindow  = esp_uptime(0);
+    
+    Autotune_Initialize(&m_Autotune);
     
-    setPidMode(TargetHeatingCoolingStateAuto);
+    Schedule_Initialize(&m_Schedule, state.heatRate);
+    Schedule_Load(&m_Schedule, SCHEDULE_FLASH_SECTOR);
+    m_ScheduleSetpoint = SCHEDULE_NONE;
+    
+    setPidMode(state.mode);
     updatePidStatus();
+    
+    m_PidDemand = esp_uptime(0) - state.demand;         // a second stage that was due need not wait again
+    
+    if(warm != CHECKPOINT_NONE) {
+        AccThermostatTargetHeatingCoolingStateSetValue(thermostat, state.mode);
+    }
+    
+    m_CheckpointTime = esp_uptime(0);
 
-    countdown(&m_DhtCountdown, DHT_INTERVAL);
+    Latency_Initialize(&m_Latency[STAGE_PID],       "pid");
+    Latency_Initialize(&m_Latency[STAGE_DHT],       "dht");
+    Latency_Initialize(&m_Latency[STAGE_CONNECTOR], "connector");
+    Latency_Initialize(&m_Latency[STAGE_EVENTS],    "events");
+    Latency_Initialize(&m_Latency[STAGE_BLINKER],   "blinker");
+    Latency_Initialize(&m_Latency[STAGE_UPGRADER],  "upgrader");
     
     // create the so-called task
     system_os_task(task1, TASK1_ID, task0_queue, QUEUE_SIZE);
 
-    system_os_post(TASK1_ID, 0, 0);
+    // and the jobs it runs
+    Scheduler_Initialize(&m_Scheduler, TASK1_ID);
+    
+    Scheduler_Add(&m_Scheduler, &m_SensorJob,  sensorJob,  NULL, DHT_INTERVAL * 1000);
+    Scheduler_Add(&m_Scheduler, &m_DecodeJob,  decodeJob,  NULL, 0);
+    Scheduler_Add(&m_Scheduler, &m_PidJob,     pidJob,     NULL, 0);
+    Scheduler_Add(&m_Scheduler, &m_FanJob,     fanJob,     NULL, 0);
+    Scheduler_Add(&m_Scheduler, &m_BlinkerJob, blinkerJob, NULL, BLINKER_INTERVAL);
+    Scheduler_Add(&m_Scheduler, &m_NetworkJob, networkJob, NULL, NETWORK_INTERVAL);
+    Scheduler_Add(&m_Scheduler, &m_LatencyJob, latencyJob, NULL, LATENCY_INTERVAL * 1000);
+    Scheduler_Add(&m_Scheduler, &m_HealthJob,  healthJob,  NULL, HEALTH_INTERVAL * 1000);
+    Scheduler_Add(&m_Scheduler, &m_ForwardJob, forwardJob, NULL, 0);
+    Scheduler_Add(&m_Scheduler, &m_ScheduleJob, scheduleJob, NULL, SCHEDULE_INTERVAL * 1000);
+    Scheduler_Add(&m_Scheduler, &m_UpdateJob,  updateJob,  NULL, 0);
+    
+    Scheduler_Start(&m_Scheduler, &m_SensorJob,  DHT_WARMUP);           // sensors settle while WiFi comes up
+    Scheduler_Start(&m_Scheduler, &m_PidJob,     0);
+    Scheduler_Start(&m_Scheduler, &m_BlinkerJob, 0);
+    Scheduler_Start(&m_Scheduler, &m_NetworkJob, 0);
+    Scheduler_Start(&m_Scheduler, &m_HealthJob,  HEALTH_INTERVAL * 1000);
+    Scheduler_Start(&m_Scheduler, &m_ScheduleJob, SCHEDULE_INTERVAL * 1000);
+#ifdef LATENCY_ENABLE
+    Scheduler_Start(&m_Scheduler, &m_LatencyJob, LATENCY_INTERVAL * 1000);
+#endif
 
-    DTXT("main_init_done(): end\n");
+    LOG_INFO("main_init_done(): end\n");
 }
 /*
  * 
@@ -594,20 +2142,29 @@ void ICACHE_FLASH_ATTR main_init_done(void)
 extern "C" void ICACHE_FLASH_ATTR user_init(void)
 {
     uart_init(BIT_RATE_115200, BIT_RATE_115200);
-    os_delay_us(3000000);
+    Log_Initialize();
+    
+    Health_Initialize(&m_Health);                       // paint the stack while it is shallow
+    
+#ifndef FAST_BOOT
+    os_delay_us(3000000);                               // time to attach a terminal
+#endif
+    
+    LOG_INFO("\n\n");
+    LOG_INFO("user_init(): begin\n");
     
-    DTXT("\n\n");
-    DTXT("user_init(): begin\n");
+    m_BootRom = rboot_get_current_rom();
     
-    os_printf("Current ROM ....: %d\n",  rboot_get_current_rom());
-    os_printf("Package ID .....: %s\n",  m_PkgId);
-    os_printf("Package version : %lu\n", m_Version);
+    LOG_INFO("Current ROM ....: %d\n",  m_BootRom);
+    LOG_INFO("Package ID .....: %s\n",  m_PkgId);
+    LOG_INFO("Package version : %lu\n", m_Version);
     
     esp_start_system_time();                                                    // start our 1 second clock
     
+    preferLastAp();
     WIFI_InitializeEx(wifi_list);
     
     system_init_done_cb(main_init_done);
     
-    DTXT("user_init(): end\n");
+    LOG_INFO("user_init(): end\n");
 }
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# ESP8266 Non-OS Firmware
+# Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+#
+
+#
+# delta firmware images; see delta.h for the format
+#
+#   mkdelta.py diff  <old.bin> <new.bin> <patch>
+#   mkdelta.py apply <old.bin> <patch> <out.bin>
+#
+
+import struct
+import sys
+import zlib
+
+MAGIC    = b'DLT1'
+
+OP_END   = 0x00
+OP_COPY  = 0x01
+OP_ADD   = 0x02
+OP_PATCH = 0x03
+
+KEY      = 8        # bytes hashed to find matches
+MIN_RUN  = 16       # shorter matches are added as new bytes
+WINDOW   = 32       # a match ends when more than
+MISMATCH = 8        # this many of the last WINDOW bytes differ
+
+
+def varint(v):
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7f) | 0x80)
+        v >>= 7
+    out.append(v)
+    return bytes(out)
+
+
+def extend(old, new, i, j):
+    """length of the approximate match of new[i:] against old[j:], and the positions that differ"""
+    n = min(len(new) - i, len(old) - j)
+    diffs = []
+    good = 0
+    for k in range(n):
+        if new[i + k] == old[j + k]:
+            good = k + 1
+            continue
+        diffs.append(k)
+        if len(diffs) > MISMATCH and diffs[-MISMATCH - 1] > k - WINDOW:
+            break
+    # do not end on differences
+    return good, [d for d in diffs if d < good]
+
+
+def diff(old, new):
+    index = {}
+    for j in range(len(old) - KEY + 1):
+        index.setdefault(old[j:j + KEY], []).append(j)
+
+    out = bytearray(MAGIC)
+    out += struct.pack('<IIII', len(old), zlib.crc32(old) & 0xffffffff, len(new), zlib.crc32(new) & 0xffffffff)
+
+    pending = bytearray()
+    last = None         # source offset that would continue the previous match
+    i = 0
+
+    def add():
+        if pending:
+            out.append(OP_ADD)
+            out.extend(varint(len(pending)))
+            out.extend(pending)
+            pending.clear()
+
+    while i < len(new):
+        best = (0, [], 0)
+        candidates = []
+        if last is not None and last < len(old):
+            candidates.append(last)
+        candidates += index.get(new[i:i + KEY], [])[-4:]
+        for j in candidates:
+            length, diffs = extend(old, new, i, j)
+            # a replaced byte costs about two bytes in the patch
+            if length - 2 * len(diffs) > best[0] - 2 * len(best[1]):
+                best = (length, diffs, j)
+        length, diffs, j = best
+        if length - 2 * len(diffs) < MIN_RUN:
+            pending.append(new[i])
+            i += 1
+            if last is not None:
+                last += 1
+            continue
+        add()
+        if diffs:
+            out.append(OP_PATCH)
+            out.extend(varint(j) + varint(length) + varint(len(diffs)))
+            prev = 0
+            for d in diffs:
+                out.extend(varint(d - prev))
+                out.append(new[i + d])
+                prev = d + 1
+        else:
+            out.append(OP_COPY)
+            out.extend(varint(j) + varint(length))
+        i += length
+        last = j + length
+    add()
+    out.append(OP_END)
+    return bytes(out)
+
+
+def apply(old, patch):
+    def getvarint(p):
+        v = shift = 0
+        while True:
+            b = patch[p]
+            p += 1
+            v |= (b & 0x7f) << shift
+            shift += 7
+            if not b & 0x80:
+                return v, p
+
+    if patch[:4] != MAGIC:
+        raise ValueError('not a delta image')
+    src_size, src_crc, dst_size, dst_crc = struct.unpack('<IIII', patch[4:20])
+    if len(old) != src_size or zlib.crc32(old) & 0xffffffff != src_crc:
+        raise ValueError('patch is for another image')
+    out = bytearray()
+    p = 20
+    while True:
+        op = patch[p]
+        p += 1
+        if op == OP_END:
+            break
+        elif op == OP_COPY:
+            off, p = getvarint(p)
+            n, p = getvarint(p)
+            out += old[off:off + n]
+        elif op == OP_ADD:
+            n, p = getvarint(p)
+            out += patch[p:p + n]
+            p += n
+        elif op == OP_PATCH:
+            off, p = getvarint(p)
+            n, p = getvarint(p)
+            count, p = getvarint(p)
+            block = bytearray(old[off:off + n])
+            pos = 0
+            for _ in range(count):
+                gap, p = getvarint(p)
+                pos += gap
+                block[pos] = patch[p]
+                p += 1
+                pos += 1
+            out += block
+        else:
+            raise ValueError('bad opcode 0x%02x' % op)
+    if len(out) != dst_size or zlib.crc32(bytes(out)) & 0xffffffff != dst_crc:
+        raise ValueError('result does not match')
+    return bytes(out)
+
+
+def main(argv):
+    if len(argv) != 5 or argv[1] not in ('diff', 'apply'):
+        sys.stderr.write('usage: mkdelta.py diff <old.bin> <new.bin> <patch> | apply <old.bin> <patch> <out.bin>\n')
+        return 2
+    a = open(argv[2], 'rb').read()
+    b = open(argv[3], 'rb').read()
+    if argv[1] == 'diff':
+        patch = diff(a, b)
+        # never ship a patch that does not reproduce the image
+        apply(a, patch)
+        open(argv[4], 'wb').write(patch)
+        print('%s: %d bytes, %.1f%% of %d' % (argv[4], len(patch), 100.0 * len(patch) / len(b), len(b)))
+    else:
+        open(argv[4], 'wb').write(apply(a, b))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -80,7 +80,26 @@ OBJECTFILES= \
 	${OBJECTDIR}/_ext/7a785d1d/timer.o \
 	${OBJECTDIR}/_ext/3064526c/upgrader.o \
 	${OBJECTDIR}/_ext/ff9c556b/wifi.o \
-	${OBJECTDIR}/main.o
+	${OBJECTDIR}/arena.o \
+	${OBJECTDIR}/autotune.o \
+	${OBJECTDIR}/checkpoint.o \
+	${OBJECTDIR}/command.o \
+	${OBJECTDIR}/deadband.o \
+	${OBJECTDIR}/delta.o \
+	${OBJECTDIR}/dht_async.o \
+	${OBJECTDIR}/fetch.o \
+	${OBJECTDIR}/flash_str.o \
+	${OBJECTDIR}/forward.o \
+	${OBJECTDIR}/hampel.o \
+	${OBJECTDIR}/health.o \
+	${OBJECTDIR}/history.o \
+	${OBJECTDIR}/interlock.o \
+	${OBJECTDIR}/json.o \
+	${OBJECTDIR}/latency.o \
+	${OBJECTDIR}/log.o \
+	${OBJECTDIR}/main.o \
+	${OBJECTDIR}/schedule.o \
+	${OBJECTDIR}/scheduler.o
 
 
 # C Compiler Flags
@@ -334,11 +353,106 @@ ${OBJECTDIR}/_ext/ff9c556b/wifi.o: ../wifi.esp8266-nonos.cpp/wifi.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ff9c556b/wifi.o ../wifi.esp8266-nonos.cpp/wifi.c
 
+${OBJECTDIR}/arena.o: arena.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/arena.o arena.c
+
+${OBJECTDIR}/autotune.o: autotune.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/autotune.o autotune.c
+
+${OBJECTDIR}/checkpoint.o: checkpoint.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/checkpoint.o checkpoint.c
+
+${OBJECTDIR}/command.o: command.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/command.o command.c
+
+${OBJECTDIR}/deadband.o: deadband.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/deadband.o deadband.c
+
+${OBJECTDIR}/delta.o: delta.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/delta.o delta.c
+
+${OBJECTDIR}/dht_async.o: dht_async.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/dht_async.o dht_async.c
+
+${OBJECTDIR}/fetch.o: fetch.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/fetch.o fetch.c
+
+${OBJECTDIR}/flash_str.o: flash_str.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/flash_str.o flash_str.c
+
+${OBJECTDIR}/forward.o: forward.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/forward.o forward.c
+
+${OBJECTDIR}/hampel.o: hampel.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/hampel.o hampel.c
+
+${OBJECTDIR}/health.o: health.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/health.o health.c
+
+${OBJECTDIR}/history.o: history.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/history.o history.c
+
+${OBJECTDIR}/interlock.o: interlock.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/interlock.o interlock.c
+
+${OBJECTDIR}/json.o: json.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/json.o json.c
+
+${OBJECTDIR}/latency.o: latency.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/latency.o latency.c
+
+${OBJECTDIR}/log.o: log.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/log.o log.c
+
 ${OBJECTDIR}/main.o: main.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
 
+${OBJECTDIR}/schedule.o: schedule.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/schedule.o schedule.c
+
+${OBJECTDIR}/scheduler.o: scheduler.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/scheduler.o scheduler.c
+
 # Subprojects
 .build-subprojects:
 
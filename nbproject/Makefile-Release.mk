@@ -76,7 +76,26 @@ OBJECTFILES= \
 	${OBJECTDIR}/_ext/7a785d1d/timer.o \
 	${OBJECTDIR}/_ext/3064526c/upgrader.o \
 	${OBJECTDIR}/_ext/ff9c556b/wifi.o \
-	${OBJECTDIR}/main.o
+	${OBJECTDIR}/arena.o \
+	${OBJECTDIR}/autotune.o \
+	${OBJECTDIR}/checkpoint.o \
+	${OBJECTDIR}/command.o \
+	${OBJECTDIR}/deadband.o \
+	${OBJECTDIR}/delta.o \
+	${OBJECTDIR}/dht_async.o \
+	${OBJECTDIR}/fetch.o \
+	${OBJECTDIR}/flash_str.o \
+	${OBJECTDIR}/forward.o \
+	${OBJECTDIR}/hampel.o \
+	${OBJECTDIR}/health.o \
+	${OBJECTDIR}/history.o \
+	${OBJECTDIR}/interlock.o \
+	${OBJECTDIR}/json.o \
+	${OBJECTDIR}/latency.o \
+	${OBJECTDIR}/log.o \
+	${OBJECTDIR}/main.o \
+	${OBJECTDIR}/schedule.o \
+	${OBJECTDIR}/scheduler.o
 
 
 # C Compiler Flags
@@ -101,7 +120,7 @@ LDLIBSOPTIONS=
 
 ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/rom0.elf: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
-	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/rom0.elf ${OBJECTFILES} ${LDLIBSOPTIONS} -Wl,--no-check-sections -L${LIB_DIR} -nostdlib -fno-rtti -T${LD_SCRIPT1} -u ${ENTRY_SYMBOL} -Wl,-static -Wl,--start-group ${LIB_GROUP} -Wl,--end-group
+	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/rom0.elf ${OBJECTFILES} ${LDLIBSOPTIONS} -Wl,--no-check-sections -L${LIB_DIR} -nostdlib -fno-rtti -T${LD_SCRIPT1} -u ${ENTRY_SYMBOL} ${LD_WRAP} -Wl,-Map=${MAP_FILE} -Wl,-static -Wl,--start-group ${LIB_GROUP} -Wl,--end-group
 
 ${OBJECTDIR}/_ext/4be9d9a1/blinker.o: ../blinker.esp8266-nonos.cpp/blinker.c 
 	${MKDIR} -p ${OBJECTDIR}/_ext/4be9d9a1
@@ -308,11 +327,106 @@ ${OBJECTDIR}/_ext/ff9c556b/wifi.o: ../wifi.esp8266-nonos.cpp/wifi.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ff9c556b/wifi.o ../wifi.esp8266-nonos.cpp/wifi.c
 
+${OBJECTDIR}/arena.o: arena.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/arena.o arena.c
+
+${OBJECTDIR}/autotune.o: autotune.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/autotune.o autotune.c
+
+${OBJECTDIR}/checkpoint.o: checkpoint.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/checkpoint.o checkpoint.c
+
+${OBJECTDIR}/command.o: command.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/command.o command.c
+
+${OBJECTDIR}/deadband.o: deadband.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/deadband.o deadband.c
+
+${OBJECTDIR}/delta.o: delta.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/delta.o delta.c
+
+${OBJECTDIR}/dht_async.o: dht_async.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/dht_async.o dht_async.c
+
+${OBJECTDIR}/fetch.o: fetch.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/fetch.o fetch.c
+
+${OBJECTDIR}/flash_str.o: flash_str.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/flash_str.o flash_str.c
+
+${OBJECTDIR}/forward.o: forward.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/forward.o forward.c
+
+${OBJECTDIR}/hampel.o: hampel.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/hampel.o hampel.c
+
+${OBJECTDIR}/health.o: health.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/health.o health.c
+
+${OBJECTDIR}/history.o: history.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/history.o history.c
+
+${OBJECTDIR}/interlock.o: interlock.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/interlock.o interlock.c
+
+${OBJECTDIR}/json.o: json.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/json.o json.c
+
+${OBJECTDIR}/latency.o: latency.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/latency.o latency.c
+
+${OBJECTDIR}/log.o: log.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/log.o log.c
+
 ${OBJECTDIR}/main.o: main.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
 
+${OBJECTDIR}/schedule.o: schedule.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/schedule.o schedule.c
+
+${OBJECTDIR}/scheduler.o: scheduler.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -DICACHE_FLASH -I/Volumes/case-sensitive-espressif/esp-open-sdk/sdk/include -I../../.. -I../raburton.rboot.esp8266-nonos.cpp -I../raburton.rboot.esp8266-nonos.cpp/appcode -I. -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/scheduler.o scheduler.c
+
 # Subprojects
 .build-subprojects:
 
@@ -0,0 +1,323 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef PID_FIXED_HPP
+#define PID_FIXED_HPP
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+#include <github.com/mikejac/br3ttb.pid.esp8266-nonos.cpp/Arduino-PID-Library/PID_v1.h>
+
+/******************************************************************************************************************
+ * fixed-point PID controller
+ *
+ * Same algorithm and interface as PID (Arduino PID Library) but all values are signed Q(31 - FRAC).FRAC numbers,
+ * so Compute() only needs integer arithmetic - the ESP8266 has no FPU. Products are done in 64 bit.
+ *
+ * An optional feed-forward Bias() is added to the output. The integrator is limited together with it, so it can 
+ * also take back a bias that is too large.
+ *
+ * AUTOMATIC, MANUAL, DIRECT and REVERSE are taken from PID_v1.h.
+ */
+template<int FRAC>
+class PIDFixed
+{
+public:
+    typedef int32_t value_t;
+
+    static const value_t ONE = (value_t)1 << FRAC;
+    static const value_t MAX = 0x7fffffff;                          // the largest value; -MAX is the smallest
+
+    /**
+     * for constants and values from the outside world - not for the control loop; out of range saturates
+     * 
+     * @param v
+     * @return 
+     */
+    static inline value_t fromDouble(double v)          { return saturate(v * ONE + (v < 0 ? -0.5 : 0.5)); }
+    static inline double  toDouble(value_t v)           { return (double)v / ONE; }
+    static inline value_t fromInt(int32_t v)            { return v << FRAC; }
+    static inline value_t fromTenths(int32_t v)         { return (value_t)(((int64_t)v << FRAC) / 10); }
+    static inline int32_t toTenths(value_t v)           { return (int32_t)(((int64_t)v * 10 + (ONE / 2)) >> FRAC); }
+    static inline value_t mul(value_t a, value_t b)     { return (value_t)(((int64_t)a * b) >> FRAC); }
+    static inline value_t saturate(double v)            { return (v >= MAX) ? MAX : (v <= -MAX) ? -MAX : (value_t)v; }
+    static inline value_t saturate(int64_t v)           { return (v >= MAX) ? MAX : (v <= -MAX) ? -MAX : (value_t)v; }
+
+    /**
+     * 
+     * @param Kp
+     * @param Ki
+     * @param Kd
+     * @param ControllerDirection
+     */
+    void init(value_t Kp, value_t Ki, value_t Kd, int ControllerDirection)
+    {
+        m_Input      = 0;
+        m_Output     = 0;
+        m_Setpoint   = 0;
+        m_ITerm      = 0;
+        m_Bias       = 0;
+        m_LastInput  = 0;
+        m_DTerm      = 0;
+        m_InAuto     = false;
+        m_SampleTime = 100;                                         // ms, same default as PID
+        m_LastTime   = system_get_time() - m_SampleTime * 1000;
+        
+        SetOutputLimits(0, fromInt(255));
+        SetControllerDirection(ControllerDirection);
+        SetTunings(Kp, Ki, Kd);
+    }
+    /**
+     * 
+     * @return true when a new output was computed
+     */
+    bool Compute()
+    {
+        if(!m_InAuto) {
+            return false;
+        }
+        
+        uint32_t now = system_get_time();
+        
+        if(now - m_LastTime < m_SampleTime * 1000) {
+            return false;
+        }
+        
+        value_t error  = m_Setpoint - m_Input;
+        value_t dInput = m_Input - m_LastInput;
+        
+        m_DTerm  = ((int64_t)m_Kd * dInput) >> FRAC;
+        m_ITerm  = clamp((int64_t)m_ITerm + (((int64_t)m_Ki * error) >> FRAC) + m_Bias) - m_Bias;
+        m_Output = clamp((((int64_t)m_Kp * error) >> FRAC) + m_ITerm + m_Bias - m_DTerm);
+
+        m_LastInput = m_Input;
+        m_LastTime  = now;
+        
+        return true;
+    }
+    /**
+     * compute for a new sample, whenever it arrives - the I and D terms are scaled to the actual time since the
+     * previous sample (at most twice the sample time) instead of the nominal sample time; for D it is at least half
+     * the sample time, so a reading soon after the last one - a sensor retry - does not blow up the noise
+     * 
+     * @param timestamp     us, system_get_time() when the sample was taken
+     * @return true when a new output was computed
+     */
+    bool Compute(uint32_t timestamp)
+    {
+        if(!m_InAuto) {
+            return false;
+        }
+        
+        uint32_t dt = (timestamp - m_LastTime) / 1000;             // ms
+        
+        if(dt == 0) {
+            return false;
+        }
+        if(dt > 2 * m_SampleTime) {
+            dt = 2 * m_SampleTime;
+        }
+        
+        uint32_t dtD = (dt < m_SampleTime / 2) ? m_SampleTime / 2 : dt;
+        
+        value_t error  = m_Setpoint - m_Input;
+        value_t dInput = m_Input - m_LastInput;
+        
+        // m_Ki/m_Kd hold the gains per sample time
+        int64_t iTerm = ((((int64_t)m_Ki * error) >> FRAC) * dt) / m_SampleTime;
+        int64_t dTerm = ((((int64_t)m_Kd * dInput) >> FRAC) * m_SampleTime) / dtD;
+        
+        int64_t pTerm = ((int64_t)m_Kp * error) >> FRAC;
+        int64_t out   = pTerm + m_ITerm + m_Bias - dTerm;
+        
+        // no integration while the other terms hold the output at a limit - that is what winds it up
+        if(!(out >= m_OutMax && iTerm > 0) && !(out <= m_OutMin && iTerm < 0)) {
+            m_ITerm = clamp((int64_t)m_ITerm + iTerm + m_Bias) - m_Bias;
+        }
+        
+        m_Output = clamp(pTerm + m_ITerm + m_Bias - dTerm);
+
+        m_DTerm     = dTerm;
+        m_LastInput = m_Input;
+        m_LastTime  = timestamp;
+        
+        return true;
+    }
+    /**
+     * re-evaluate the output for a new setpoint without waiting for the next sample - only the P term follows; 
+     * the I and D terms stay as the last Compute() left them, and so does its timing
+     */
+    void Refresh()
+    {
+        if(!m_InAuto) {
+            return;
+        }
+        
+        m_Output = clamp((((int64_t)m_Kp * (m_Setpoint - m_Input)) >> FRAC) + m_ITerm + m_Bias - m_DTerm);
+    }
+    /**
+     * 
+     * @param Kp
+     * @param Ki
+     * @param Kd
+     */
+    void SetTunings(value_t Kp, value_t Ki, value_t Kd)
+    {
+        if(Kp < 0 || Ki < 0 || Kd < 0) {
+            return;
+        }
+        
+        m_DispKp = Kp;
+        m_DispKi = Ki;
+        m_DispKd = Kd;
+        
+        // scale to the sample time, same as PID::SetTunings(); a gain that will not scale is as large as it gets
+        m_Kp = Kp;
+        m_Ki = saturate(((int64_t)Ki * m_SampleTime) / 1000);
+        m_Kd = saturate(((int64_t)Kd * 1000) / m_SampleTime);
+        
+        if(m_Direction == REVERSE) {
+            m_Kp = -m_Kp;
+            m_Ki = -m_Ki;
+            m_Kd = -m_Kd;
+        }
+    }
+    /**
+     * 
+     * @param NewSampleTime     ms
+     */
+    void SetSampleTime(uint32_t NewSampleTime)
+    {
+        if(NewSampleTime > 0) {
+            m_SampleTime = NewSampleTime;
+            
+            // from the gains as given: a scaled one that saturated at the old sample time would stay wrong
+            SetTunings(m_DispKp, m_DispKi, m_DispKd);
+        }
+    }
+    /**
+     * 
+     * @param Min
+     * @param Max
+     */
+    void SetOutputLimits(value_t Min, value_t Max)
+    {
+        if(Min >= Max) {
+            return;
+        }
+        
+        m_OutMin = Min;
+        m_OutMax = Max;
+        
+        if(m_InAuto) {
+            m_Output = clamp(m_Output);
+            m_ITerm  = clamp((int64_t)m_ITerm + m_Bias) - m_Bias;
+        }
+    }
+    /**
+     * 
+     * @param Mode  AUTOMATIC or MANUAL
+     */
+    void SetMode(int Mode)
+    {
+        bool newAuto = (Mode == AUTOMATIC);
+        
+        if(newAuto && !m_InAuto) {
+            Initialize();                                           // bumpless transfer
+        }
+        
+        m_InAuto = newAuto;
+    }
+    /**
+     * 
+     * @param Direction DIRECT or REVERSE
+     */
+    void SetControllerDirection(int Direction)
+    {
+        if(m_InAuto && Direction != m_Direction) {
+            m_Kp = -m_Kp;
+            m_Ki = -m_Ki;
+            m_Kd = -m_Kd;
+        }
+        
+        m_Direction = Direction;
+    }
+    
+    void    Input(value_t v)        { m_Input = v; }
+    void    Setpoint(value_t v)     { m_Setpoint = v; }
+    value_t Input() const           { return m_Input; }
+    value_t Setpoint() const        { return m_Setpoint; }
+    value_t Output() const          { return m_Output; }
+    value_t Integral() const        { return m_ITerm; }
+    void    Integral(value_t v)     { m_ITerm = clamp(v); }             // warm restart
+    value_t Bias() const            { return m_Bias; }
+    void    Bias(value_t v)         { m_Bias = v; }                     // feed-forward; added to the output
+    value_t GetKp() const           { return m_DispKp; }
+    value_t GetKi() const           { return m_DispKi; }
+    value_t GetKd() const           { return m_DispKd; }
+    int     GetMode() const         { return m_InAuto ? AUTOMATIC : MANUAL; }
+    int     GetDirection() const    { return m_Direction; }
+    
+private:
+    void Initialize()
+    {
+        m_ITerm     = clamp(m_Output) - m_Bias;
+        m_LastInput = m_Input;
+        m_DTerm     = 0;
+    }
+    
+    value_t clamp(int64_t v) const
+    {
+        return (v > m_OutMax) ? m_OutMax : (v < m_OutMin) ? m_OutMin : (value_t)v;
+    }
+    
+    value_t     m_DispKp;                                           // as given by the user
+    value_t     m_DispKi;
+    value_t     m_DispKd;
+    
+    value_t     m_Kp;                                               // scaled to the sample time
+    value_t     m_Ki;
+    value_t     m_Kd;
+    
+    int         m_Direction;
+    
+    value_t     m_Input;
+    value_t     m_Output;
+    value_t     m_Setpoint;
+    
+    value_t     m_ITerm;                                            // the integrator is m_ITerm + m_Bias
+    value_t     m_Bias;
+    value_t     m_LastInput;
+    int64_t     m_DTerm;                                            // as of the last Compute(), for Refresh()
+    value_t     m_OutMin;
+    value_t     m_OutMax;
+    
+    uint32_t    m_LastTime;                                         // us
+    uint32_t    m_SampleTime;                                       // ms
+    bool        m_InAuto;
+};
+
+#endif /* PID_FIXED_HPP */
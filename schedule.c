@@ -0,0 +1,546 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "schedule.h"
+#include <spi_flash.h>
+
+#define MAGIC                   0x53434830                          // "SCH0"
+#define DAY                     (24 * 60)                           // minutes
+
+// what is kept in flash; also the scratch space for Schedule_Compile()
+typedef struct {
+    uint32_t                magic;
+    uint32_t                count;
+    SCHEDULE_TRANSITION     t[SCHEDULE_TRANSITIONS];
+    uint32_t                crc;
+} SCHEDULE_RECORD;
+
+static SCHEDULE_RECORD m_Record;
+
+static void         makeIndex(SCHEDULE* s);
+static int          insert(SCHEDULE_TRANSITION* t, int count, uint16_t minute, int16_t setpoint);
+static const char*  skipSpace(const char* p);
+static const char*  parseNumber(const char* p, uint32_t* v, int* digits);
+static const char*  parseDays(const char* p, uint8_t* days);
+static const char*  parseTime(const char* p, uint32_t* minute);
+static const char*  parseTenths(const char* p, int32_t* tenths);
+static uint32_t     daysFromCivil(uint32_t y, uint32_t m, uint32_t d);
+static uint32_t     lastSunday(uint32_t y, uint32_t m);
+static uint32_t     crc(const SCHEDULE_RECORD* r);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param s
+ * @param heatRate
+ */
+void ICACHE_FLASH_ATTR Schedule_Initialize(SCHEDULE* s, uint16_t heatRate)
+{
+    os_memset(s, 0, sizeof(SCHEDULE));
+    
+    s->setpoint = SCHEDULE_NONE;
+    s->warmTo   = SCHEDULE_NONE;
+    s->heatRate = (heatRate >= SCHEDULE_MIN_RATE && heatRate <= SCHEDULE_MAX_RATE) ? heatRate : SCHEDULE_HEAT_RATE;
+}
+/**
+ * 
+ * @param s
+ */
+void ICACHE_FLASH_ATTR Schedule_Clear(SCHEDULE* s)
+{
+    Schedule_Initialize(s, s->heatRate);
+}
+/**
+ * 
+ * @param s
+ * @param text
+ * @param min
+ * @param max
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Schedule_Compile(SCHEDULE* s, const char* text, int16_t min, int16_t max)
+{
+    const char* p     = text;
+    int         count = 0;
+    int         entry = 0;
+    
+    for(;;) {
+        uint8_t  days;
+        uint32_t minute;
+        int32_t  setpoint;
+        int      d;
+        
+        p = skipSpace(p);
+        
+        if(*p == '\0') {
+            break;
+        }
+        
+        entry++;
+        
+        if((p = parseDays(p, &days)) == NULL || (p = parseTime(skipSpace(p), &minute)) == NULL || 
+           (p = parseTenths(skipSpace(p), &setpoint)) == NULL || setpoint < min || setpoint > max) {
+            return -entry;
+        }
+        
+        p = skipSpace(p);
+        
+        if(*p == ';') {
+            p++;
+        } else if(*p != '\0') {
+            return -entry;
+        }
+        
+        for(d = 0; d < 7; d++) {
+            if(days & (1 << d)) {
+                if((count = insert(m_Record.t, count, d * DAY + minute, setpoint)) < 0) {
+                    return -entry;
+                }
+            }
+        }
+    }
+    
+    if(count == 0) {
+        return -1;
+    }
+    
+    Schedule_Clear(s);
+    
+    os_memcpy(s->t, m_Record.t, count * sizeof(SCHEDULE_TRANSITION));
+    s->count = count;
+    
+    makeIndex(s);
+    
+    return count;
+}
+/**
+ * 
+ * @param s
+ * @param minute
+ * @param next
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Schedule_Lookup(const SCHEDULE* s, uint32_t minute, int* next)
+{
+    int k;
+    
+    if(s->count == 0) {
+        return -1;
+    }
+    
+    minute %= SCHEDULE_WEEK;
+    
+    // at most the transitions within this hour
+    for(k = s->next[minute / 60]; k < s->count && s->t[k].minute <= minute; k++) {
+    }
+    
+    if(next != NULL) {
+        *next = (k == s->count) ? 0 : k;
+    }
+    
+    return (k == 0) ? s->count - 1 : k - 1;
+}
+/**
+ * 
+ * @param s
+ * @param minute
+ * @param temp
+ * @param now
+ * @return 
+ */
+int16_t ICACHE_FLASH_ATTR Schedule_Run(SCHEDULE* s, uint32_t minute, int16_t temp, uint32_t now)
+{
+    int     active;
+    int     next;
+    int16_t setpoint;
+    
+    if((active = Schedule_Lookup(s, minute, &next)) < 0) {
+        s->setpoint = SCHEDULE_NONE;
+        return SCHEDULE_NONE;
+    }
+    
+    if(s->preheat == active + 1) {
+        s->preheat = 0;                                         // on time
+    }
+    
+    setpoint = s->t[active].setpoint;
+    
+    if(s->preheat == 0 && s->t[next].setpoint > setpoint && temp != SCHEDULE_NONE) {
+        uint32_t until = (s->t[next].minute + SCHEDULE_WEEK - minute % SCHEDULE_WEEK) % SCHEDULE_WEEK;
+        int32_t  rise  = s->t[next].setpoint - temp;
+        uint32_t lead  = (rise > 0) ? (uint32_t) rise * 60 / s->heatRate : 0;
+        
+        if(lead > SCHEDULE_MAX_LEAD) {
+            lead = SCHEDULE_MAX_LEAD;
+        }
+        
+        if(until <= lead) {
+            s->preheat = next + 1;                              // and stay there, however the temperature goes
+        }
+    }
+    
+    if(s->preheat != 0) {
+        setpoint = s->t[s->preheat - 1].setpoint;
+    }
+    
+    if(setpoint != s->setpoint) {
+        // time it if it is a heat-up
+        s->warmTo = SCHEDULE_NONE;
+        
+        if(temp != SCHEDULE_NONE && setpoint - temp >= SCHEDULE_MIN_RISE) {
+            s->warmFrom  = temp;
+            s->warmTo    = setpoint;
+            s->warmStart = now;
+        }
+        
+        s->setpoint = setpoint;
+    } else if(s->warmTo != SCHEDULE_NONE && now - s->warmStart > 2 * SCHEDULE_MAX_LEAD * 60) {
+        s->warmTo = SCHEDULE_NONE;                              // heating was off, or overridden
+    } else if(s->warmTo != SCHEDULE_NONE && temp != SCHEDULE_NONE && temp >= s->warmTo && now > s->warmStart) {
+        uint32_t rate = (uint32_t) (s->warmTo - s->warmFrom) * 3600 / (now - s->warmStart);
+        
+        if(rate < SCHEDULE_MIN_RATE) {
+            rate = SCHEDULE_MIN_RATE;
+        } else if(rate > SCHEDULE_MAX_RATE) {
+            rate = SCHEDULE_MAX_RATE;
+        }
+        
+        s->heatRate = (3 * s->heatRate + rate + 2) / 4;
+        s->warmTo   = SCHEDULE_NONE;
+    }
+    
+    return setpoint;
+}
+/**
+ * 
+ * @param utc
+ * @param offset
+ * @param dst
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Schedule_MinuteOfWeek(uint32_t utc, int32_t offset, int dst)
+{
+    uint32_t local = utc + offset * 60;
+    
+    if(dst) {
+        // EU summer time, last Sunday of March to last Sunday of October, 01:00 UTC
+        uint32_t y = 1970 + utc / 31556952;
+        
+        if(daysFromCivil(y, 1, 1) * 86400 > utc) {
+            y--;
+        }
+        
+        if(utc >= lastSunday(y, 3) * 86400 + 3600 && utc < lastSunday(y, 10) * 86400 + 3600) {
+            local += 3600;
+        }
+    }
+    
+    // 1970-01-01 was a Thursday
+    return ((local / 86400 + 3) % 7) * DAY + (local % 86400) / 60;
+}
+/**
+ * 
+ * @param s
+ * @param sector
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Schedule_Load(SCHEDULE* s, uint16_t sector)
+{
+    uint32_t i;
+    
+    if(spi_flash_read(sector * SPI_FLASH_SEC_SIZE, (uint32_t*) &m_Record, sizeof(SCHEDULE_RECORD)) != SPI_FLASH_RESULT_OK ||
+       m_Record.magic != MAGIC || m_Record.count == 0 || m_Record.count > SCHEDULE_TRANSITIONS || m_Record.crc != crc(&m_Record)) {
+        return 0;
+    }
+    
+    for(i = 1; i < m_Record.count; i++) {
+        if(m_Record.t[i].minute <= m_Record.t[i - 1].minute || m_Record.t[i].minute >= SCHEDULE_WEEK) {
+            return 0;
+        }
+    }
+    
+    Schedule_Clear(s);
+    
+    os_memcpy(s->t, m_Record.t, m_Record.count * sizeof(SCHEDULE_TRANSITION));
+    s->count = m_Record.count;
+    
+    makeIndex(s);
+    
+    return 1;
+}
+/**
+ * 
+ * @param s
+ * @param sector
+ * @return 
+ */
+int ICACHE_FLASH_ATTR Schedule_Save(const SCHEDULE* s, uint16_t sector)
+{
+    os_memset(&m_Record, 0xff, sizeof(SCHEDULE_RECORD));
+    
+    m_Record.magic = MAGIC;
+    m_Record.count = s->count;
+    os_memcpy(m_Record.t, s->t, s->count * sizeof(SCHEDULE_TRANSITION));
+    m_Record.crc   = crc(&m_Record);
+    
+    if(spi_flash_erase_sector(sector) != SPI_FLASH_RESULT_OK) {
+        return 0;
+    }
+    
+    // an empty schedule is just the erased sector
+    if(s->count == 0) {
+        return 1;
+    }
+    
+    return spi_flash_write(sector * SPI_FLASH_SEC_SIZE, (uint32_t*) &m_Record, sizeof(SCHEDULE_RECORD)) == SPI_FLASH_RESULT_OK;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param s
+ */
+static void ICACHE_FLASH_ATTR makeIndex(SCHEDULE* s)
+{
+    uint32_t h;
+    int      k = 0;
+    
+    for(h = 0; h < SCHEDULE_HOURS; h++) {
+        while(k < s->count && s->t[k].minute <= h * 60) {
+            k++;
+        }
+        
+        s->next[h] = k;
+    }
+}
+/**
+ * keep them sorted; a later entry for the same minute replaces the earlier one
+ * 
+ * @param t
+ * @param count
+ * @param minute
+ * @param setpoint
+ * @return new count, -1 if full
+ */
+static int ICACHE_FLASH_ATTR insert(SCHEDULE_TRANSITION* t, int count, uint16_t minute, int16_t setpoint)
+{
+    int i, j;
+    
+    for(i = 0; i < count && t[i].minute < minute; i++) {
+    }
+    
+    if(i < count && t[i].minute == minute) {
+        t[i].setpoint = setpoint;
+        return count;
+    }
+    
+    if(count == SCHEDULE_TRANSITIONS) {
+        return -1;
+    }
+    
+    for(j = count; j > i; j--) {
+        t[j] = t[j - 1];
+    }
+    
+    t[i].minute   = minute;
+    t[i].setpoint = setpoint;
+    
+    return count + 1;
+}
+/**
+ * 
+ * @param p
+ * @return 
+ */
+static const char* ICACHE_FLASH_ATTR skipSpace(const char* p)
+{
+    while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    
+    return p;
+}
+/**
+ * 
+ * @param p
+ * @param v
+ * @param digits
+ * @return NULL if there is no number
+ */
+static const char* ICACHE_FLASH_ATTR parseNumber(const char* p, uint32_t* v, int* digits)
+{
+    *v      = 0;
+    *digits = 0;
+    
+    while(*p >= '0' && *p <= '9' && *digits < 6) {
+        *v = *v * 10 + (*p++ - '0');
+        (*digits)++;
+    }
+    
+    return (*digits > 0) ? p : NULL;
+}
+/**
+ * "*", "1-5", "67", "1-36" ...
+ * 
+ * @param p
+ * @param days      bit 0 is Monday
+ * @return 
+ */
+static const char* ICACHE_FLASH_ATTR parseDays(const char* p, uint8_t* days)
+{
+    *days = 0;
+    
+    if(*p == '*') {
+        *days = 0x7f;
+        p++;
+    } else {
+        while(*p >= '1' && *p <= '7') {
+            int first = *p++ - '1';
+            int last  = first;
+            
+            if(*p == '-') {
+                if(p[1] < '1' || p[1] > '7' || p[1] - '1' < first) {
+                    return NULL;
+                }
+                
+                last = p[1] - '1';
+                p   += 2;
+            }
+            
+            while(first <= last) {
+                *days |= 1 << first++;
+            }
+        }
+    }
+    
+    return (*days != 0 && (*p == ' ' || *p == '\t')) ? p : NULL;
+}
+/**
+ * hh:mm
+ * 
+ * @param p
+ * @param minute    of the day
+ * @return 
+ */
+static const char* ICACHE_FLASH_ATTR parseTime(const char* p, uint32_t* minute)
+{
+    uint32_t h, m;
+    int      digits;
+    
+    if((p = parseNumber(p, &h, &digits)) == NULL || digits > 2 || h > 23 || *p++ != ':' ||
+       (p = parseNumber(p, &m, &digits)) == NULL || digits != 2 || m > 59) {
+        return NULL;
+    }
+    
+    *minute = h * 60 + m;
+    
+    return p;
+}
+/**
+ * "18", "18.5"
+ * 
+ * @param p
+ * @param tenths
+ * @return 
+ */
+static const char* ICACHE_FLASH_ATTR parseTenths(const char* p, int32_t* tenths)
+{
+    uint32_t whole, frac = 0;
+    int      digits;
+    
+    if((p = parseNumber(p, &whole, &digits)) == NULL || digits > 3) {
+        return NULL;
+    }
+    
+    if(*p == '.') {
+        if((p = parseNumber(p + 1, &frac, &digits)) == NULL || digits != 1) {
+            return NULL;
+        }
+    }
+    
+    *tenths = whole * 10 + frac;
+    
+    return p;
+}
+/**
+ * days since 1970-01-01 of a date in the Gregorian calendar
+ * 
+ * @param y
+ * @param m
+ * @param d
+ * @return 
+ */
+static uint32_t ICACHE_FLASH_ATTR daysFromCivil(uint32_t y, uint32_t m, uint32_t d)
+{
+    uint32_t era, yoe, doy;
+    
+    y  -= (m <= 2);
+    era = y / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    
+    return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+/**
+ * 
+ * @param y
+ * @param m     a month with 31 days
+ * @return days since 1970-01-01
+ */
+static uint32_t ICACHE_FLASH_ATTR lastSunday(uint32_t y, uint32_t m)
+{
+    uint32_t last = daysFromCivil(y, m, 31);
+    
+    // Monday is 0
+    return last - ((last + 3) % 7 + 1) % 7;
+}
+/**
+ * FNV-1a over everything but the crc itself
+ * 
+ * @param r
+ * @return 
+ */
+static uint32_t ICACHE_FLASH_ATTR crc(const SCHEDULE_RECORD* r)
+{
+    const uint8_t* p    = (const uint8_t*) r;
+    uint32_t       hash = 2166136261UL;
+    uint32_t       i;
+    
+    for(i = 0; i < sizeof(SCHEDULE_RECORD) - sizeof(r->crc); i++) {
+        hash = (hash ^ p[i]) * 16777619UL;
+    }
+    
+    return hash;
+}
@@ -0,0 +1,148 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * weekly setpoint schedule
+ *
+ * A schedule is a list of entries "<days> <hh:mm> <setpoint>", separated by ';':
+ *
+ *      1-5 06:30 18; 1-5 16:00 9; 6 08:00 16.5; 6 13:00 9
+ *
+ * Days are 1 (Monday) to 7 (Sunday), as a list ("135"), a range ("1-5") or '*' for all; times are local. Each
+ * entry sets the setpoint from then until the next one, wrapping around the end of the week.
+ *
+ * Schedule_Compile() expands the entries into transitions sorted by minute of the week, and indexes them by hour, so
+ * a lookup only looks at the transitions within one hour.
+ *
+ * Schedule_Run() switches to the next, higher, setpoint early enough to reach it on time. The lead is the rise
+ * needed divided by the heating rate, which is learned from how long such heat-ups actually take.
+ */
+#define SCHEDULE_TRANSITIONS        64
+#define SCHEDULE_HOURS              (7 * 24)
+#define SCHEDULE_WEEK               (7 * 24 * 60)                   // minutes
+
+#define SCHEDULE_NONE               (-32768)                        // no schedule, or no reading
+
+#define SCHEDULE_HEAT_RATE          20                              // 0.1 C per hour until one is learned
+#define SCHEDULE_MIN_RATE           5
+#define SCHEDULE_MAX_RATE           200
+#define SCHEDULE_MIN_RISE           10                              // 0.1 C; smaller heat-ups teach nothing
+#define SCHEDULE_MAX_LEAD           (4 * 60)                        // minutes
+
+typedef struct {
+    uint16_t                minute;                                 // of the week, Monday 00:00 local time is 0
+    int16_t                 setpoint;                               // 0.1 C
+} SCHEDULE_TRANSITION;
+
+typedef struct {
+    SCHEDULE_TRANSITION     t[SCHEDULE_TRANSITIONS];
+    uint8_t                 next[SCHEDULE_HOURS];                   // first transition after the start of each hour
+    uint8_t                 count;
+    uint8_t                 preheat;                                // 1 + transition heated up to early, 0 if none
+    int16_t                 setpoint;                               // what Schedule_Run() returned last
+    uint16_t                heatRate;                               // 0.1 C per hour
+    
+    // heat-up being timed
+    int16_t                 warmFrom;
+    int16_t                 warmTo;                                 // SCHEDULE_NONE if none
+    uint32_t                warmStart;                              // uptime, seconds
+} SCHEDULE;
+
+/**
+ * 
+ * @param s
+ * @param heatRate  0.1 C per hour, 0 for the default
+ */
+void Schedule_Initialize(SCHEDULE* s, uint16_t heatRate);
+/**
+ * 
+ * @param s
+ */
+void Schedule_Clear(SCHEDULE* s);
+/**
+ * 
+ * @param s
+ * @param text
+ * @param min       lowest setpoint allowed, 0.1 C
+ * @param max       highest
+ * @return number of transitions, or -n for an error in entry n; 's' is unchanged then
+ */
+int Schedule_Compile(SCHEDULE* s, const char* text, int16_t min, int16_t max);
+/**
+ * 
+ * @param s
+ * @param minute    of the week
+ * @param next      if not NULL, gets the index of the next transition
+ * @return index of the transition in effect, -1 if there are none
+ */
+int Schedule_Lookup(const SCHEDULE* s, uint32_t minute, int* next);
+/**
+ * 
+ * @param s
+ * @param minute    of the week
+ * @param temp      0.1 C, SCHEDULE_NONE if not known
+ * @param now       uptime, seconds
+ * @return setpoint in 0.1 C, SCHEDULE_NONE if there is no schedule
+ */
+int16_t Schedule_Run(SCHEDULE* s, uint32_t minute, int16_t temp, uint32_t now);
+/**
+ * 
+ * @param utc       seconds since 1970
+ * @param offset    minutes east of UTC
+ * @param dst       1 to follow EU summer time
+ * @return local minute of the week
+ */
+uint32_t Schedule_MinuteOfWeek(uint32_t utc, int32_t offset, int dst);
+/**
+ * 
+ * @param s
+ * @param sector
+ * @return 1 if a schedule was found
+ */
+int Schedule_Load(SCHEDULE* s, uint16_t sector);
+/**
+ * 
+ * @param s
+ * @param sector
+ * @return 1 if written
+ */
+int Schedule_Save(const SCHEDULE* s, uint16_t sector);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCHEDULE_H */
@@ -0,0 +1,317 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "scheduler.h"
+
+#define DUE(job, now)       ((int32_t)((job)->deadline - (now)) <= 0)
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void Scheduler_Update(SCHEDULER* s);
+static void Scheduler_Insert(SCHEDULER* s, SCHEDULER_JOB* job);
+static void Scheduler_Unlink(SCHEDULER* s, SCHEDULER_JOB* job);
+static SCHEDULER_JOB* Scheduler_Take(SCHEDULER* s, uint32_t slot);
+static void Scheduler_Timeout(void* arg);
+static void Scheduler_Arm(SCHEDULER* s, uint32_t delay);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param s
+ * @param taskId
+ */
+void ICACHE_FLASH_ATTR Scheduler_Initialize(SCHEDULER* s, uint8_t taskId)
+{
+    os_memset(s, 0, sizeof(SCHEDULER));
+
+    s->taskId = taskId;
+    s->lastUs = system_get_time();
+
+    os_timer_disarm(&s->timer);
+    os_timer_setfn(&s->timer, Scheduler_Timeout, s);
+}
+/**
+ * 
+ * @param s
+ * @param job
+ * @param fn
+ * @param arg
+ * @param period
+ */
+void ICACHE_FLASH_ATTR Scheduler_Add(SCHEDULER* s, SCHEDULER_JOB* job, SchedulerJobFn fn, void* arg, uint32_t period)
+{
+    os_memset(job, 0, sizeof(SCHEDULER_JOB));
+
+    job->fn     = fn;
+    job->arg    = arg;
+    job->period = period;
+}
+/**
+ * 
+ * @param s
+ * @param job
+ * @param delay
+ */
+void ICACHE_FLASH_ATTR Scheduler_Start(SCHEDULER* s, SCHEDULER_JOB* job, uint32_t delay)
+{
+    if(job->active) {
+        Scheduler_Unlink(s, job);
+    }
+    
+    Scheduler_Update(s);
+
+    job->deadline = s->now + delay;
+    
+    Scheduler_Insert(s, job);
+    
+    if(delay == 0) {
+        Scheduler_Wakeup(s);
+    } else if(s->pending == 0 && (s->armed == 0 || DUE(job, s->wake))) {
+        Scheduler_Arm(s, delay);                                    // sooner than the timer would wake us
+    }
+}
+/**
+ * 
+ * @param s
+ * @param job
+ */
+void ICACHE_FLASH_ATTR Scheduler_Stop(SCHEDULER* s, SCHEDULER_JOB* job)
+{
+    if(job->active) {
+        Scheduler_Unlink(s, job);
+    }
+}
+/**
+ * 
+ * @param s
+ */
+void ICACHE_FLASH_ATTR Scheduler_Wakeup(SCHEDULER* s)
+{
+    if(s->pending == 0) {
+        s->pending = 1;
+        
+        if(!system_os_post(s->taskId, 0, 0)) {
+            s->pending = 0;                                         // try again on the next wakeup
+            s->postErrors++;
+        }
+    }
+}
+/**
+ * 
+ * @param s
+ */
+void ICACHE_FLASH_ATTR Scheduler_Run(SCHEDULER* s)
+{
+    SCHEDULER_JOB* job;
+    uint32_t       nowTick;
+    uint32_t       n;
+    int32_t        wait;
+    int            ran = 0;
+    
+    s->pending = 0;
+    s->passes++;
+    
+    os_timer_disarm(&s->timer);
+    s->armed = 0;
+    
+    Scheduler_Update(s);
+    
+    //
+    // run due jobs from the slots passed since last run (at most one full turn of the wheel)
+    //
+    nowTick = s->now >> SCHEDULER_TICK_SHIFT;
+    
+    if(nowTick - s->tick >= SCHEDULER_WHEEL_SLOTS) {
+        s->tick = nowTick - SCHEDULER_WHEEL_SLOTS + 1;
+    }
+    
+    for(;;) {
+        // a job may (re)start any job, including itself, so take them one at a time
+        while((job = Scheduler_Take(s, s->tick & SCHEDULER_WHEEL_MASK)) != NULL) {
+            if(job->period != 0) {
+                job->deadline += job->period;
+
+                if(DUE(job, s->now)) {
+                    job->deadline = s->now + job->period;       // we fell behind; don't try to catch up
+                }
+
+                Scheduler_Insert(s, job);
+            }
+
+            job->pass = s->passes;
+            job->fn(job->arg);
+
+            s->jobsRun++;
+            ran = 1;
+        }
+        
+        if(s->tick == nowTick) {
+            break;
+        }
+        
+        s->tick++;
+    }
+    
+    if(ran == 0) {
+        s->idlePasses++;
+    }
+    
+    //
+    // sleep until the nearest deadline
+    //
+    Scheduler_Update(s);
+    
+    wait = 0x7fffffff;
+    
+    for(n = 0; n < SCHEDULER_WHEEL_SLOTS; n++) {
+        for(job = s->slots[n]; job != NULL; job = job->next) {
+            if((int32_t)(job->deadline - s->now) < wait) {
+                wait = (int32_t)(job->deadline - s->now);
+            }
+        }
+    }
+    
+    if(wait <= 0) {
+        Scheduler_Wakeup(s);
+    } else if(wait != 0x7fffffff) {
+        Scheduler_Arm(s, wait);
+    }
+}
+/**
+ * 
+ * @param s
+ * @return 
+ */
+uint32_t ICACHE_FLASH_ATTR Scheduler_Now(SCHEDULER* s)
+{
+    Scheduler_Update(s);
+    
+    return s->now;
+}
+/**
+ * advance the millisecond clock - system_get_time() wraps every ~71 minutes
+ * 
+ * @param s
+ */
+static void ICACHE_FLASH_ATTR Scheduler_Update(SCHEDULER* s)
+{
+    uint32_t us = system_get_time();
+    
+    s->remUs  += us - s->lastUs;
+    s->lastUs  = us;
+    
+    s->now    += s->remUs / 1000;
+    s->remUs  %= 1000;
+}
+/**
+ * 
+ * @param s
+ * @param job
+ */
+static void ICACHE_FLASH_ATTR Scheduler_Insert(SCHEDULER* s, SCHEDULER_JOB* job)
+{
+    SCHEDULER_JOB** slot = &s->slots[(job->deadline >> SCHEDULER_TICK_SHIFT) & SCHEDULER_WHEEL_MASK];
+    
+    job->next   = *slot;
+    job->active = 1;
+    *slot       = job;
+}
+/**
+ * 
+ * @param s
+ * @param job
+ */
+static void ICACHE_FLASH_ATTR Scheduler_Unlink(SCHEDULER* s, SCHEDULER_JOB* job)
+{
+    SCHEDULER_JOB** pp = &s->slots[(job->deadline >> SCHEDULER_TICK_SHIFT) & SCHEDULER_WHEEL_MASK];
+    
+    while(*pp != NULL) {
+        if(*pp == job) {
+            *pp = job->next;
+            break;
+        }
+        
+        pp = &(*pp)->next;
+    }
+    
+    job->next   = NULL;
+    job->active = 0;
+}
+/**
+ * unlink the first job in 'slot' which is due and hasn't already run in this pass
+ * 
+ * @param s
+ * @param slot
+ * @return 
+ */
+static SCHEDULER_JOB* ICACHE_FLASH_ATTR Scheduler_Take(SCHEDULER* s, uint32_t slot)
+{
+    SCHEDULER_JOB** pp = &s->slots[slot];
+    SCHEDULER_JOB*  job;
+    
+    while((job = *pp) != NULL) {
+        if(DUE(job, s->now) && job->pass != s->passes) {
+            *pp         = job->next;
+            job->next   = NULL;
+            job->active = 0;
+            
+            return job;
+        }
+        
+        pp = &job->next;
+    }
+    
+    return NULL;
+}
+/**
+ * 
+ * @param arg
+ */
+static void ICACHE_FLASH_ATTR Scheduler_Timeout(void* arg)
+{
+    Scheduler_Wakeup((SCHEDULER*)arg);
+}
+/**
+ * 
+ * @param s
+ * @param delay     ms from s->now
+ */
+static void ICACHE_FLASH_ATTR Scheduler_Arm(SCHEDULER* s, uint32_t delay)
+{
+    os_timer_disarm(&s->timer);
+    os_timer_arm(&s->timer, delay, 0);
+    
+    s->armed = 1;
+    s->wake  = s->now + delay;
+}
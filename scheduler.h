@@ -0,0 +1,130 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * deadline driven job scheduler
+ *
+ * Jobs are kept in a hashed timer wheel. After each pass the scheduler arms a single os_timer for the nearest
+ * deadline, so the task only runs when there is something to do.
+ */
+#define SCHEDULER_TICK_SHIFT        4                               // 16 ms per wheel slot
+#define SCHEDULER_WHEEL_SLOTS       64                              // must be a power of 2
+#define SCHEDULER_WHEEL_MASK        (SCHEDULER_WHEEL_SLOTS - 1)
+
+typedef void (*SchedulerJobFn)(void* arg);
+
+typedef struct SCHEDULER_JOB {
+    struct SCHEDULER_JOB*   next;
+    SchedulerJobFn          fn;
+    void*                   arg;
+    uint32_t                deadline;                               // ms
+    uint32_t                period;                                 // ms, 0 = one-shot
+    uint32_t                pass;                                   // last pass the job ran in
+    uint8_t                 active;
+} SCHEDULER_JOB;
+
+typedef struct {
+    SCHEDULER_JOB*          slots[SCHEDULER_WHEEL_SLOTS];
+    uint32_t                now;                                    // ms
+    uint32_t                lastUs;
+    uint32_t                remUs;
+    uint32_t                tick;
+    os_timer_t              timer;
+    uint32_t                wake;                                   // ms; deadline the timer is armed for
+    uint8_t                 armed;
+    uint8_t                 taskId;
+    uint8_t                 pending;
+
+    // statistics
+    uint32_t                passes;                                 // number of task passes
+    uint32_t                idlePasses;                             // passes where no job was due
+    uint32_t                jobsRun;
+    uint32_t                postErrors;                             // task queue was full
+} SCHEDULER;
+
+/**
+ * 
+ * @param s
+ * @param taskId
+ */
+void Scheduler_Initialize(SCHEDULER* s, uint8_t taskId);
+/**
+ * 
+ * @param s
+ * @param job
+ * @param fn
+ * @param arg
+ * @param period    0 for one-shot jobs
+ */
+void Scheduler_Add(SCHEDULER* s, SCHEDULER_JOB* job, SchedulerJobFn fn, void* arg, uint32_t period);
+/**
+ * (re)arm a job to run 'delay' ms from now
+ * 
+ * @param s
+ * @param job
+ * @param delay
+ */
+void Scheduler_Start(SCHEDULER* s, SCHEDULER_JOB* job, uint32_t delay);
+/**
+ * 
+ * @param s
+ * @param job
+ */
+void Scheduler_Stop(SCHEDULER* s, SCHEDULER_JOB* job);
+/**
+ * run the task as soon as possible, e.g. when an external event is pending
+ * 
+ * @param s
+ */
+void Scheduler_Wakeup(SCHEDULER* s);
+/**
+ * run all due jobs and arm the timer for the next deadline - call from the task
+ * 
+ * @param s
+ */
+void Scheduler_Run(SCHEDULER* s);
+/**
+ * 
+ * @param s
+ * @return milliseconds since Scheduler_Initialize()
+ */
+uint32_t Scheduler_Now(SCHEDULER* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,120 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef STAGES_HPP
+#define STAGES_HPP
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+#include <github.com/mikejac/esp-open-rtos.gpio.esp8266-nonos.cpp/gpio/gpio.h>
+
+/******************************************************************************************************************
+ * heater stage table
+ *
+ * The stages are a compile-time list:
+ *
+ *      typedef Stage<GPIO_HEATER1, 0,
+ *              Stage<GPIO_HEATER2, STAGE_2_TIME> > HeaterStages;
+ *
+ * Each stage is a relay and the number of seconds heat must have been wanted before it may come on. Stages are used
+ * in order; StageControl<>::set() switches on the first 'count' of them. StageControl<> unrolls the list at compile
+ * time, so there is no table in RAM and no dispatch at run time; the only state is a bitmask with bit n set while
+ * stage n is on.
+ */
+struct StageEnd
+{
+    enum { count = 0 };
+};
+
+template<int GPIO, uint32_t DELAY, class NEXT = StageEnd>
+struct Stage
+{
+    enum { gpio = GPIO, count = NEXT::count + 1 };
+    
+    static const uint32_t delay = DELAY;                            // seconds
+    
+    typedef NEXT next;
+};
+
+template<class STAGE, bool ON, bool OFF>
+struct StageControl
+{
+    typedef StageControl<typename STAGE::next, ON, OFF> Next;
+    
+    /**
+     * all relays off
+     */
+    static void init()
+    {
+        gpio_enable(STAGE::gpio, GPIO_OUTPUT);
+        gpio_write(STAGE::gpio, OFF);
+        
+        Next::init();
+    }
+    /**
+     * 
+     * @param count     stages wanted
+     * @param onFor     seconds heat has been wanted
+     * @param base      stages that need not wait for their delay
+     * @param state     bitmask of stages that are on
+     * @param bit
+     * @return new bitmask
+     */
+    static uint32_t set(uint32_t count, uint32_t onFor, uint32_t base, uint32_t state, uint32_t bit = 1)
+    {
+        bool want = count > 0 && (base > 0 || onFor >= STAGE::delay);
+        
+        if(want != ((state & bit) != 0)) {
+            gpio_write(STAGE::gpio, want ? ON : OFF);
+            state ^= bit;
+        }
+        
+        return Next::set((count > 0) ? count - 1 : 0, onFor, (base > 0) ? base - 1 : 0, state, bit << 1);
+    }
+    /**
+     * the bitmask as the relays are really driven, e.g. after something else switched them
+     * 
+     * @param out       GPIO output register; GPIO16 is not in it
+     * @param bit
+     * @return bitmask
+     */
+    static uint32_t read(uint32_t out, uint32_t bit = 1)
+    {
+        bool on = (((out >> STAGE::gpio) & 1) != 0) == ON;
+        
+        return (on ? bit : 0) | Next::read(out, bit << 1);
+    }
+};
+
+template<bool ON, bool OFF>
+struct StageControl<StageEnd, ON, OFF>
+{
+    static void     init()                                              { }
+    static uint32_t set(uint32_t, uint32_t, uint32_t, uint32_t state, uint32_t)     { return state; }
+    static uint32_t read(uint32_t, uint32_t)                                        { return 0; }
+};
+
+#endif /* STAGES_HPP */
@@ -0,0 +1,312 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include "../user_config.h"
+#include "shim.h"
+#include "plant.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * autotune in closed loop
+ *
+ * The firmware holds the workshop model at a setpoint with the default gains, is told to tune itself and runs the
+ * relay experiment on the first stage only; then it is watched with the gains it found - through its own report and
+ * through a night setback and the morning heat-up after it.
+ *
+ * usage: autotune_sim [-v]
+ *
+ */
+#define OUTDOOR_MEAN            2.0                                 // C
+#define SETPOINT                16.0                                // C
+#define SETBACK                 10.0
+#define WARM_UP                 (6 * 3600)                          // s with the default gains before tuning
+#define NIGHT                   (8 * 3600)
+#define SETTLE                  (2 * 3600)                          // s after the heat-up not scored
+
+// bounds
+#define MIN_PERIOD              (5 * 60)                            // s; the relay cycle of this plant
+#define MAX_PERIOD              (3 * 3600)
+#define MAX_OVERSHOOT           1.5                                 // C
+#define MAX_MEAN_ERROR          0.3                                 // C, the day after the heat-up
+
+#define SLAB_OUTDOOR            9.0                                 // C
+#define SLAB_WARM_UP            (24 * 3600)                         // s; the slab catches up
+#define SLAB_TAU                (2 * 3600)                          // s the sensor in the slab lags the air
+#define SLAB_MIN_PERIOD         (2 * 3600)
+#define SLAB_MIN_KD             10000.0                             // Kd goes with the period
+
+typedef struct {
+    int                     tuned;                                  // the report came
+    int                     watched;                                // and the one on the new gains
+    uint32_t                warnings;
+    char                    report[128];
+} SLAB;
+
+static PLANT        m_Plant;
+static double       m_Tau;                                          // s; 0: the sensor is in the air
+static double       m_Slab;                                         // C; what it reads otherwise
+static uint32_t     m_Random = 12345;
+static int          m_Tuning;
+static uint32_t     m_Stage2;                                       // seconds stage 2 was on while tuning
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     slab(void* shared);
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static int      run(uint32_t seconds, const char* until);
+static void     setpoint(double value);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    unsigned long period = 0, settling = 0;
+    unsigned      whole = 0, hundredths = 0, over = 0, overTenths = 0;
+    double        error = 0, overshoot = 0, kd = 0;
+    uint32_t      s;
+    SLAB*         slow = (SLAB*) Shim_Shared(sizeof(SLAB));
+    
+    if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+        Shim_Verbose(1);
+    }
+    
+    // a long relay period first, in a child of its own: the gains it asks for must be the ones put to use
+    CHECK_EQUAL(Shim_Restart(true, slab, slow), 0);
+    CHECK(slow->tuned);
+    CHECK(sscanf(slow->report, "Autotune: Pu %lu s, a %u.%u C", &period, &whole, &hundredths) == 3);
+    CHECK(strstr(slow->report, " Kd ") != NULL && sscanf(strstr(slow->report, " Kd ") + 4, "%lf", &kd) == 1);
+    
+    printf("autotune_sim: slab: %s\n", slow->report);
+    
+    CHECK(period >= SLAB_MIN_PERIOD);
+    CHECK(kd >= SLAB_MIN_KD);
+    CHECK(slow->watched);
+    CHECK_EQUAL(slow->warnings, 0);
+    
+    period = whole = hundredths = 0;
+    
+    Plant_Initialize(&m_Plant, OUTDOOR_MEAN, SHIM_WALL_CLOCK);
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+    
+    run(5, NULL);
+    
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+    setpoint(SETPOINT);
+    
+    run(WARM_UP, NULL);
+    
+    // the experiment: stage 1 only, around the setpoint
+    Shim_Command("autotune", "start");
+    
+    CHECK(strcmp(Shim_Stats.lastInfo, "Autotune: started") == 0);
+    
+    m_Tuning = 1;
+    
+    CHECK(run(AUTOTUNE_TIMEOUT, "Autotune: Pu"));
+    CHECK_EQUAL(m_Stage2, 0);
+    
+    m_Tuning = 0;
+    CHECK(sscanf(Shim_Stats.lastInfo, "Autotune: Pu %lu s, a %u.%u C", &period, &whole, &hundredths) == 3);
+    
+    printf("autotune_sim: %s\n", Shim_Stats.lastInfo);
+    
+    CHECK(period >= MIN_PERIOD && period <= MAX_PERIOD);
+    CHECK(whole * 100 + hundredths >= AUTOTUNE_HYSTERESIS * 10);
+    
+    // its own report on the new gains
+    CHECK(run(AUTOTUNE_WATCH + 120, "Autotune: overshoot"));
+    CHECK(sscanf(Shim_Stats.lastInfo, "Autotune: overshoot %u.%u C, settling %lu s", 
+                 &over, &overTenths, &settling) == 3);
+    
+    printf("autotune_sim: %s\n", Shim_Stats.lastInfo);
+    
+    CHECK(over * 10 + overTenths <= MAX_OVERSHOOT * 10);
+    CHECK(settling < AUTOTUNE_WATCH);
+    
+    // a night setback and the morning after
+    setpoint(SETBACK);
+    run(NIGHT, NULL);
+    setpoint(SETPOINT);
+    
+    for(s = 0; s < 86400; s++) {
+        run(1, NULL);
+        
+        if(m_Plant.air - SETPOINT > overshoot) {
+            overshoot = m_Plant.air - SETPOINT;
+        }
+        
+        if(s >= SETTLE) {
+            error += fabs(m_Plant.air - SETPOINT);
+        }
+    }
+    
+    error /= 86400 - SETTLE;
+    
+    printf("autotune_sim: heat-up overshoot %.2f C, then mean error %.2f C\n", overshoot, error);
+    
+    CHECK(overshoot <= MAX_OVERSHOOT);
+    CHECK(error <= MAX_MEAN_ERROR);
+    CHECK_EQUAL(Shim_Stats.restarts, 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * the workshop with its sensor in the floor slab, SLAB_TAU behind the air: the relay experiment there runs for hours
+ * 
+ * @param shared    SLAB
+ */
+static void slab(void* shared)
+{
+    SLAB* result = (SLAB*) shared;
+    
+    m_Tau = SLAB_TAU;
+    
+    Plant_Initialize(&m_Plant, SLAB_OUTDOOR, SHIM_WALL_CLOCK);
+    m_Slab = m_Plant.air;
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+    
+    run(5, NULL);
+    
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+    setpoint(SETPOINT);
+    
+    run(SLAB_WARM_UP, NULL);
+    
+    Shim_Command("autotune", "start");
+    
+    result->tuned = run(AUTOTUNE_TIMEOUT, "Autotune: Pu");
+    
+    strncpy(result->report, Shim_Stats.lastInfo, sizeof(result->report) - 1);
+    
+    result->watched  = run(AUTOTUNE_WATCH + 120, "Autotune: overshoot");
+    result->warnings = Shim_Stats.warnings;
+}
+/**
+ * a reading of the plant with a tenth of noise; none in the slab
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    double t = (gpio == GPIO_DHT1) ? m_Plant.air      : m_Plant.outdoor;
+    double h = (gpio == GPIO_DHT1) ? m_Plant.humidity : Plant_OutdoorHumidity(&m_Plant);
+    int    noise = (int) (random32() % 3) - 1;
+    
+    if(gpio == GPIO_DHT1 && m_Tau > 0) {
+        t     = m_Slab;
+        noise = 0;
+    }
+    
+    *temperature = (int16_t) lround(t * 10) + noise;
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * the firmware and the plant, a second at a time
+ * 
+ * @param seconds
+ * @param until     stop at an info that starts with this
+ * @return 1 if it came
+ */
+static int run(uint32_t seconds, const char* until)
+{
+    uint32_t infos = Shim_Stats.infos;
+    uint32_t s;
+    int      heaters;
+    
+    for(s = 0; s < seconds; s++) {
+        Shim_Run(1000000);
+        
+        heaters = (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+        
+        if(m_Tuning && Shim_Output(GPIO_HEATER2) == HEATER_ON) {
+            m_Stage2++;
+        }
+        
+        if(m_Tau > 0) {
+            m_Slab += (m_Plant.air - m_Slab) / m_Tau;
+        }
+        
+        Plant_Step(&m_Plant, 1.0, heaters, Shim_Output(GPIO_FAN) == FAN_ON);
+        
+        if(until != NULL && Shim_Stats.infos != infos) {
+            infos = Shim_Stats.infos;
+            
+            if(strncmp(Shim_Stats.lastInfo, until, strlen(until)) == 0) {
+                return 1;
+            }
+        }
+    }
+    
+    return 0;
+}
+/**
+ * 
+ * @param value
+ */
+static void setpoint(double value)
+{
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, value);
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
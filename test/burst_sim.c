@@ -0,0 +1,212 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include "../user_config.h"
+#include "shim.h"
+#include "plant.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * a burst of value updates
+ *
+ * The app sends many target mode changes at once - a slider dragged, a scene replayed. They are drained
+ * DEVICE_EVENT_BUDGET a pass and only the last of each pass is applied, so every pass but the last ends on off
+ * and the heaters must stay off until it. Then they must go on within a few network polls of the last update,
+ * however long the burst.
+ *
+ * usage: burst_sim [-v]
+ *
+ */
+#define OUTDOOR_MEAN            2.0                                 // C
+#define SETPOINT                20.0                                // C; well above the air
+#define BURST                   (5 * DEVICE_EVENT_BUDGET + 3)       // updates; the last pass is not a full one
+#define PASSES                  ((BURST + DEVICE_EVENT_BUDGET - 1) / DEVICE_EVENT_BUDGET)
+#define STEP                    1000                                // us
+#define MAX_LATENCY             (3 * NETWORK_INTERVAL * 1000)       // us from the burst to the relay
+#define MODE_LOG                "setPidMode(): thermostat "
+
+static PLANT        m_Plant;
+static uint32_t     m_Random = 12345;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static int      heaters(void);
+static void     run(uint32_t seconds);
+static int      count(const char* text, const char* what);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    uint64_t latency = 0;
+    int      i, passes = 0, early = 0;
+    
+    if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+        Shim_Verbose(1);
+    }
+    
+    Plant_Initialize(&m_Plant, OUTDOOR_MEAN, SHIM_WALL_CLOCK);
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+    
+    run(5);
+    
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateOff);
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+    
+    run(60);
+    
+    CHECK_EQUAL(heaters(), 0);
+    
+    Shim_Serial();
+    
+    // heat and off in turn, off last in every full pass; heat at the very end
+    for(i = 0; i < BURST; i++) {
+        Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, 
+                         (i % 2 == 0) ? TargetHeatingCoolingStateAuto : TargetHeatingCoolingStateOff);
+    }
+    
+    // the air does not move in this short a time
+    while(latency < 1000000 && heaters() == 0) {
+        Shim_Run(STEP);
+        
+        latency += STEP;
+        passes  += count(Shim_Serial(), MODE_LOG);
+        
+        if(heaters() > 0 && passes < PASSES) {
+            early = 1;
+        }
+    }
+    
+    run(1);
+    
+    passes += count(Shim_Serial(), MODE_LOG);
+    
+    printf("burst_sim: %d updates, %d applied, heat after %.1f ms\n", BURST, passes, latency / 1000.0);
+    
+    CHECK(heaters() > 0);
+    CHECK(latency <= MAX_LATENCY);
+    CHECK_EQUAL(passes, PASSES);                                    // one mode a pass
+    CHECK_EQUAL(early, 0);
+    
+    CHECK_EQUAL(Shim_Stats.restarts, 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a reading of the plant with a tenth of noise
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    double t = (gpio == GPIO_DHT1) ? m_Plant.air      : m_Plant.outdoor;
+    double h = (gpio == GPIO_DHT1) ? m_Plant.humidity : Plant_OutdoorHumidity(&m_Plant);
+    
+    *temperature = (int16_t) lround(t * 10) + (int) (random32() % 3) - 1;
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * 
+ * @return stages on
+ */
+static int heaters(void)
+{
+    return (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+}
+/**
+ * the firmware and the plant, a second at a time
+ * 
+ * @param seconds
+ */
+static void run(uint32_t seconds)
+{
+    uint32_t s;
+    
+    for(s = 0; s < seconds; s++) {
+        Shim_Run(1000000);
+        
+        Plant_Step(&m_Plant, 1.0, heaters(), Shim_Output(GPIO_FAN) == FAN_ON);
+    }
+}
+/**
+ * 
+ * @param text
+ * @param what
+ * @return times 'what' is in 'text'
+ */
+static int count(const char* text, const char* what)
+{
+    int n = 0;
+    
+    while((text = strstr(text, what)) != NULL) {
+        text += strlen(what);
+        n++;
+    }
+    
+    return n;
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
@@ -0,0 +1,52 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+/******************************************************************************************************************
+ * the unit tests' assertions; each test is one program and its exit code says if all held
+ *
+ */
+
+static int m_Checks;
+static int m_Failed;
+
+#define CHECK(cond)             do { m_Checks++;                                                                \
+                                     if(!(cond)) { m_Failed++; printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); } \
+                                } while(0)
+
+#define CHECK_EQUAL(a, b)       do { long long _a = (a), _b = (b); m_Checks++;                                   \
+                                     if(_a != _b) { m_Failed++; printf("%s:%d: %s == %s; %lld != %lld\n",       \
+                                                                       __FILE__, __LINE__, #a, #b, _a, _b); }    \
+                                } while(0)
+
+#define CHECK_DONE()            (printf("%s: %d checks, %d failed\n", __FILE__, m_Checks, m_Failed), m_Failed != 0)
+
+#endif /* CHECK_H */
@@ -0,0 +1,198 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <spi_flash.h>
+#include "../checkpoint.h"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Checkpoint: many boots, each saving to RTC memory and the flash log; every third one loses power first, and
+ * must come back with the newest record in flash instead; then a firmware with another data layout, which must not
+ * load any of them
+ *
+ */
+#define RTC_BLOCK               96
+#define SECTOR                  0x20
+#define WORDS                   5
+#define BOOTS                   50
+#define SAVES                   37                                  // per boot; the log wraps many times
+#define VERSION                 3
+
+static CHECKPOINT m_Checkpoint;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void powerCut(void);
+static void torn(uint32_t next);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    uint32_t data[WORDS], saved[WORDS], flashed[WORDS];
+    uint32_t writes = 0, erases = 0, errors = 0;
+    int      boot, i, k, from;
+    
+    CHECK_EQUAL(Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, CHECKPOINT_MAX_DATA + 4, VERSION), 0);
+    
+    powerCut();
+    
+    CHECK(Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, sizeof(data), VERSION) != 0);
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_NONE);
+    
+    for(boot = 0; boot < BOOTS; boot++) {
+        Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, sizeof(data), VERSION);
+        
+        memset(data, 0, sizeof(data));
+        from = Checkpoint_Load(&m_Checkpoint, data);
+        
+        if(boot > 0) {
+            CHECK_EQUAL(from, (boot % 3 == 1) ? CHECKPOINT_FLASH : CHECKPOINT_RTC);
+            CHECK(memcmp(data, (boot % 3 == 1) ? flashed : saved, sizeof(data)) == 0);
+        }
+        
+        for(i = 0; i < SAVES; i++) {
+            for(k = 0; k < WORDS; k++) {
+                flashed[k] = boot * 1000 + i * 10 + k;
+            }
+            
+            Checkpoint_Save(&m_Checkpoint, flashed, 1);
+        }
+        
+        // a newer one in RTC memory only
+        for(k = 0; k < WORDS; k++) {
+            saved[k] = boot;
+        }
+        
+        Checkpoint_Save(&m_Checkpoint, saved, 0);
+        
+        if(boot % 3 == 0) {
+            powerCut();
+        }
+        
+        writes += m_Checkpoint.flashWrites;
+        erases += m_Checkpoint.flashErases;
+        errors += m_Checkpoint.errors;
+    }
+    
+    printf("%u flash writes, %u erases\n", writes, erases);
+    
+    CHECK_EQUAL(errors, 0);
+    CHECK(erases > 0);
+    CHECK(erases < writes / 50);                                    // a sector holds ~90 records
+    
+    // power lost while the newest record was written: the one before it, then the log goes on past the torn one
+    Checkpoint_Save(&m_Checkpoint, saved, 1);
+    Checkpoint_Save(&m_Checkpoint, flashed, 1);
+    torn(m_Checkpoint.slot);
+    powerCut();
+    
+    Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, sizeof(data), VERSION);
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_FLASH);
+    CHECK(memcmp(data, saved, sizeof(data)) == 0);
+    
+    Checkpoint_Save(&m_Checkpoint, flashed, 1);
+    powerCut();
+    
+    Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, sizeof(data), VERSION);
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_FLASH);
+    CHECK(memcmp(data, flashed, sizeof(data)) == 0);
+    
+    // a firmware with another layout loads nothing, neither from RTC memory nor from flash, and leaves 'data' alone
+    Checkpoint_Save(&m_Checkpoint, saved, 1);
+    
+    Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, sizeof(data), VERSION + 1);
+    memset(data, 0xaa, sizeof(data));
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_NONE);
+    powerCut();
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_NONE);
+    CHECK_EQUAL(data[0], 0xaaaaaaaa);
+    
+    // its own records go on at the end of the log and load as usual, from RTC memory and from flash
+    Checkpoint_Save(&m_Checkpoint, flashed, 1);
+    
+    Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, sizeof(data), VERSION + 1);
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_RTC);
+    CHECK(memcmp(data, flashed, sizeof(data)) == 0);
+    powerCut();
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_FLASH);
+    CHECK(memcmp(data, flashed, sizeof(data)) == 0);
+    
+    // back to the old firmware: not its older record either, the newest state is of the other layout
+    Checkpoint_Initialize(&m_Checkpoint, RTC_BLOCK, SECTOR, sizeof(data), VERSION);
+    memset(data, 0xaa, sizeof(data));
+    CHECK_EQUAL(Checkpoint_Load(&m_Checkpoint, data), CHECKPOINT_NONE);
+    CHECK_EQUAL(data[0], 0xaaaaaaaa);
+    CHECK_EQUAL(m_Checkpoint.errors, 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * RTC memory comes back with noise
+ */
+static void powerCut(void)
+{
+    uint32_t noise[(SHIM_RTC_SIZE - 256) / 4];
+    uint32_t i;
+    
+    for(i = 0; i < sizeof(noise) / 4; i++) {
+        noise[i] = 0x5a5a5a5a ^ (i * 2654435761u);
+    }
+    
+    system_rtc_mem_write(64, noise, sizeof(noise));
+}
+/**
+ * clear the last word - the CRC - of the record before 'next', as if its write never finished
+ * 
+ * @param next
+ */
+static void torn(uint32_t next)
+{
+    uint32_t perSector = SPI_FLASH_SEC_SIZE / sizeof(CHECKPOINT_RECORD);
+    uint32_t slot      = (next + 2 * perSector - 1) % (2 * perSector);
+    uint32_t end       = (SECTOR + slot / perSector) * SPI_FLASH_SEC_SIZE + (slot % perSector + 1) * sizeof(CHECKPOINT_RECORD);
+    uint32_t zero      = 0;
+    
+    spi_flash_write(end - 4, &zero, sizeof(zero));
+}
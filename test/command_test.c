@@ -0,0 +1,509 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../command.h"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Command and JSON: numbers and strings taken apart, messages routed to their handler with the right argument or
+ * passed on; then mutations of real payloads through both, with the token invariants checked on each, and the cost
+ * of a dispatch on this host
+ *
+ */
+#define NODENAME                "5a0c1f2e-9d7b-4c3e-8f61-2b7d9e4a1c05"
+#define PLATFORM                "heater"
+#define FUZZ_ROUNDS             200000
+#define FUZZ_SIZE               1100
+#define BENCH_ROUNDS            100000
+
+typedef struct {
+    const char*             feedId;
+    const char*             payload;
+} MESSAGE;
+
+static COMMANDS     m_Commands;
+static const JSON*  m_Json;                                         // what the last handler was given
+static int          m_Arg;
+static int          m_Calls;
+static uint32_t     m_Random = 1;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     numbers(void);
+static void     strings(void);
+static void     dispatch(void);
+static void     fuzz(void);
+static void     bench(void);
+static int      invariants(const char* text, uint32_t len);
+static int      tenths(const char* text, int32_t* value);
+static int      integer(const char* text, int32_t* value);
+static void     handler(const JSON* json, int arg);
+static uint32_t random32(void);
+static double   now(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    Command_Initialize(&m_Commands, NODENAME, PLATFORM);
+    
+    Command_Add(&m_Commands, "setpoint",    handler);
+    Command_Add(&m_Commands, "mode",        handler);
+    Command_Add(&m_Commands, "autotune",    handler);
+    Command_Add(&m_Commands, "history",     handler);
+    Command_Add(&m_Commands, "schedule",    handler);
+    Command_Add(&m_Commands, "diagnostics", handler);
+    
+    numbers();
+    strings();
+    dispatch();
+    fuzz();
+    bench();
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ */
+static void numbers(void)
+{
+    int32_t v;
+    
+    CHECK(tenths("21.5", &v) && v == 215);
+    CHECK(tenths("21.55", &v) && v == 215);                         // further decimals dropped
+    CHECK(tenths("-0.5", &v) && v == -5);
+    CHECK(tenths("21", &v) && v == 210);
+    CHECK(tenths("21474836", &v) && v == 214748360);
+    CHECK(!tenths("214748364", &v));                                // does not fit
+    CHECK(!tenths("1e3", &v));
+    CHECK(!tenths("21.", &v));
+    CHECK(!tenths(".5", &v));
+    CHECK(!tenths("-", &v));
+    CHECK(!tenths("abc", &v));
+    
+    CHECK(integer("2147483647", &v) && v == 2147483647);
+    CHECK(integer("-12", &v) && v == -12);
+    CHECK(integer("007", &v) && v == 7);
+    CHECK(!integer("2147483648", &v));
+    CHECK(!integer("3.0", &v));
+}
+/**
+ * 
+ */
+static void strings(void)
+{
+    const char* text = "{\"x\":[1,{\"value\":2}],\"value\":\"a\\u0041\\n\",\"long\":\"0123456789abcdef\"}";
+    JSON        json;
+    JSON_TOKEN  token[16];
+    char        buffer[16];
+    int         t;
+    
+    CHECK_EQUAL(Json_Parse(&json, text, strlen(text), token, 16), 11);
+    
+    // the member of the top object, not the one inside the array
+    t = Json_Find(&json, 0, "value");
+    
+    CHECK_EQUAL(t, 8);
+    CHECK(Json_Equal(&json, t, "a\\u0041\\n"));
+    CHECK_EQUAL(Json_Copy(&json, t, buffer, sizeof(buffer)), 3);
+    CHECK(strcmp(buffer, "aA\n") == 0);
+    
+    CHECK_EQUAL(Json_Copy(&json, Json_Find(&json, 0, "long"), buffer, sizeof(buffer)), -1);
+    CHECK_EQUAL(Json_Find(&json, 0, "missing"), -1);
+    
+    // errors
+    CHECK_EQUAL(Json_Parse(&json, text, strlen(text), token, 4), JSON_ERROR_TOKENS);
+    CHECK_EQUAL(Json_Parse(&json, "[[[[[1]]]]]", 11, token, 16), JSON_ERROR_DEPTH);
+    CHECK_EQUAL(Json_Parse(&json, "{\"value\":", 9, token, 16), JSON_ERROR_SYNTAX);
+    CHECK_EQUAL(Json_Parse(&json, "{1:2}", 5, token, 16), JSON_ERROR_SYNTAX);
+    CHECK_EQUAL(Json_Parse(&json, text, JSON_MAX_LENGTH + 1, token, 16), JSON_ERROR_LENGTH);
+    
+    // not NUL terminated: only 'length' is looked at
+    CHECK_EQUAL(Json_Parse(&json, "21.5garbage", 4, token, 16), 1);
+    CHECK(Json_Tenths(&json, 0, &t) && t == 215);
+}
+/**
+ * 
+ */
+static void dispatch(void)
+{
+    char     name[COMMAND_NAME_MAX + 2];
+    COMMANDS full;
+    int      i;
+    
+    // a single value is the argument
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, "setpoint", "21.5"), 1);
+    CHECK_EQUAL(m_Arg, 0);
+    
+    // an object's "value" member
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, "mode", "{\"format\":1,\"value\":\"off\"}"), 1);
+    CHECK(Json_Equal(m_Json, m_Arg, "off"));
+    
+    // one without
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, "history", "{\"page\":3}"), 1);
+    CHECK_EQUAL(m_Arg, -1);
+    
+    // not JSON: all of it as one primitive
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, "schedule", "1-5 06:30 18; 1-5 16:00 9"), 1);
+    CHECK_EQUAL(m_Json->token[m_Arg].type, JSON_PRIMITIVE);
+    CHECK_EQUAL(m_Json->token[m_Arg].length, 25);
+    
+    CHECK_EQUAL(m_Commands.handled, 4);
+    
+    // ours, but broken
+    m_Calls = 0;
+    
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, "setpoint", "[[[[[1]]]]]"), -1);
+    CHECK_EQUAL(m_Commands.rejected, 1);
+    
+    // not ours
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, "e03fe8f6-ad55-455f-9039-2a9fd7d9eec5", PLATFORM, "setpoint", "21"), 0);
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, "chronos", "setpoint", "21"), 0);
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NULL, PLATFORM, "setpoint", "21"), 0);
+    // the upgrader listens on "package"; passed on to it
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, "package", "{}"), 0);
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, "setpoints", "21"), 0);
+    
+    memset(name, 'a', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    
+    CHECK_EQUAL(Command_Dispatch(&m_Commands, NODENAME, PLATFORM, name, "21"), 0);
+    CHECK_EQUAL(m_Commands.passed, 6);
+    CHECK_EQUAL(m_Calls, 0);
+    
+    // the table: no twice, and no more than there is room for
+    CHECK_EQUAL(Command_Add(&m_Commands, "mode", handler), 0);
+    
+    Command_Initialize(&full, NODENAME, PLATFORM);
+    
+    for(i = 0; i < COMMAND_SLOTS + 2; i++) {
+        static char names[COMMAND_SLOTS + 2][8];
+        
+        sprintf(names[i], "c%d", i);
+        
+        CHECK_EQUAL(Command_Add(&full, names[i], handler), i < COMMAND_SLOTS);
+    }
+    
+    CHECK_EQUAL(Command_Dispatch(&full, NODENAME, PLATFORM, "c15", "1"), 1);
+    CHECK_EQUAL(Command_Dispatch(&full, NODENAME, PLATFORM, "c16", "1"), 0);
+}
+/**
+ * mutations of real payloads: insertions, deletions, flipped bytes, repeats, open brackets and cuts; every one must
+ * parse or fail cleanly, and never leave the text
+ */
+static void fuzz(void)
+{
+    const char* seeds[] = { "21.5", "{\"value\":19.0}", "auto", "{\"value\":\"off\"}", "[1,2,[3,{\"a\":null}]]", 
+                            "{\"value\":\"1-5 06:30 18\\u0041\\n\"}", "1-5 06:30 18; 6 08:00 16.5", "-0.05", 
+                            "  \"x\"  ", "{\"a\":{\"b\":{\"c\":[true,false]}}}", "" };
+    const char* feeds[] = { "setpoint", "mode", "autotune", "history", "schedule", "diagnostics", "package", "" };
+    const char* alphabet = "{}[]\",:\\u0123456789.-eE tfn";
+    char*       text;
+    char        buffer[FUZZ_SIZE + 1];
+    uint32_t    len, k, heap = Shim_HeapUsed();
+    int         i, m, bad = 0, parsed = 0;
+    
+    for(i = 0; i < FUZZ_ROUNDS; i++) {
+        strcpy(buffer, seeds[i % (sizeof(seeds) / sizeof(seeds[0]))]);
+        len = strlen(buffer);
+        
+        for(m = random32() % 8; m >= 0; m--) {
+            k = len ? random32() % (len + 1) : 0;
+            
+            switch(random32() % 6) {
+                case 0:
+                    if(len < FUZZ_SIZE) {
+                        memmove(buffer + k + 1, buffer + k, len - k);
+                        buffer[k] = alphabet[random32() % strlen(alphabet)];
+                        len++;
+                    }
+                    break;
+                case 1:
+                    if(k < len) {
+                        memmove(buffer + k, buffer + k + 1, len - k - 1);
+                        len--;
+                    }
+                    break;
+                case 2:
+                    if(k < len) {
+                        buffer[k] = (char) (1 + random32() % 255);
+                    }
+                    break;
+                case 3:
+                    if(len > 0 && 2 * len <= FUZZ_SIZE) {
+                        memcpy(buffer + len, buffer, len);
+                        len *= 2;
+                    }
+                    break;
+                case 4:
+                    if(len < FUZZ_SIZE) {
+                        memmove(buffer + k + 1, buffer + k, len - k);
+                        buffer[k] = (random32() & 1) ? '[' : '{';
+                        len++;
+                    }
+                    break;
+                case 5:
+                    len = k;
+                    break;
+            }
+        }
+        
+        // exactly 'len' bytes on the heap, so a read past them is caught under a checker
+        text = malloc(len ? len : 1);
+        memcpy(text, buffer, len);
+        
+        m = invariants(text, len);
+        
+        bad    += (m < 0);
+        parsed += (m > 0);
+        
+        free(text);
+        
+        buffer[len] = '\0';
+        
+        Command_Dispatch(&m_Commands, NODENAME, PLATFORM, feeds[random32() % 8], buffer);
+    }
+    
+    printf("command_test: %d mutations, %d parsed\n", FUZZ_ROUNDS, parsed);
+    
+    CHECK_EQUAL(bad, 0);
+    CHECK(parsed > FUZZ_ROUNDS / 10 && parsed < FUZZ_ROUNDS);
+    CHECK_EQUAL(Shim_HeapUsed(), heap);                             // nothing allocated along the way
+}
+/**
+ * a mix of what the broker sends; reported, not checked
+ */
+static void bench(void)
+{
+    static char big[JSON_MAX_LENGTH], wide[JSON_MAX_LENGTH];
+    MESSAGE     mix[] = {
+        { "setpoint",    "21.5" },
+        { "setpoint",    "{\"value\":19.0}" },
+        { "mode",        "auto" },
+        { "mode",        "{\"value\":\"off\"}" },
+        { "history",     "{\"value\":12,\"format\":\"compact\"}" },
+        { "autotune",    "stop" },
+        { "diagnostics", "" },
+        { "schedule",    "1-5 06:30 18; 1-5 16:00 9; 6 08:00 16.5; 6 13:00 9" },
+        { "temperature", "{\"value\":20.1}" },
+        { "setpoint",    "{\"value\":" },
+        { "history",     big },
+        { "mode",        wide },
+    };
+    int         n = sizeof(mix) / sizeof(mix[0]);
+    double      t, worst = 0, one;
+    int         i, k;
+    
+    memset(big, ' ', sizeof(big) - 1);
+    big[0] = '7';
+    
+    strcpy(wide, "[");
+    
+    for(i = 0; i < COMMAND_TOKENS; i++) {
+        strcat(wide, "\"aaaaaaaaaaaaaaaaaaaa\",");
+    }
+    
+    strcat(wide, "1]");
+    
+    t = now();
+    
+    for(k = 0; k < BENCH_ROUNDS; k++) {
+        for(i = 0; i < n; i++) {
+            Command_Dispatch(&m_Commands, NODENAME, PLATFORM, mix[i].feedId, mix[i].payload);
+        }
+    }
+    
+    t = now() - t;
+    
+    for(i = 0; i < n; i++) {
+        one = now();
+        
+        for(k = 0; k < 1000; k++) {
+            Command_Dispatch(&m_Commands, NODENAME, PLATFORM, mix[i].feedId, mix[i].payload);
+        }
+        
+        one = (now() - one) / 1000;
+        
+        if(one > worst) {
+            worst = one;
+        }
+    }
+    
+    printf("command_test: %.0f ns per message on average, %.0f ns for the slowest kind\n", 
+           t / (BENCH_ROUNDS * n), worst);
+}
+/**
+ * 
+ * @param text
+ * @param len
+ * @return 1 if it parsed, 0 if it was refused, -1 if the tokens are wrong
+ */
+static int invariants(const char* text, uint32_t len)
+{
+    JSON_TOKEN token[COMMAND_TOKENS];
+    JSON       json;
+    char       out[FUZZ_SIZE];
+    int32_t    x;
+    int        n = Json_Parse(&json, text, len, token, COMMAND_TOKENS);
+    int        i, k, v;
+    
+    if(n < 0) {
+        return (n >= JSON_ERROR_LENGTH && json.count == 0) ? 0 : -1;
+    }
+    
+    if(n != json.count || n < 1 || n > COMMAND_TOKENS || token[0].next != n) {
+        return -1;
+    }
+    
+    for(i = 0; i < n; i++) {
+        if(token[i].start + token[i].length > len || token[i].next <= i || token[i].next > n) {
+            return -1;
+        }
+        
+        if(token[i].type == JSON_OBJECT || token[i].type == JSON_ARRAY) {
+            // the members tile the tokens up to 'next'
+            for(k = i + 1, v = 0; v < token[i].size; v++) {
+                if(k >= token[i].next) {
+                    return -1;
+                }
+                
+                if(token[i].type == JSON_OBJECT) {
+                    if(token[k].type != JSON_STRING) {
+                        return -1;
+                    }
+                    
+                    k++;
+                }
+                
+                if(token[k].start < token[i].start) {
+                    return -1;
+                }
+                
+                k = token[k].next;
+            }
+            
+            if(k != token[i].next) {
+                return -1;
+            }
+        } else if(token[i].next != i + 1) {
+            return -1;
+        }
+        
+        if(Json_Copy(&json, i, out, sizeof(out)) > (int) token[i].length) {
+            return -1;
+        }
+        
+        Json_Int(&json, i, &x);
+        Json_Tenths(&json, i, &x);
+        Json_Equal(&json, i, "value");
+        
+        if(token[i].type == JSON_OBJECT) {
+            Json_Find(&json, i, "value");
+        }
+    }
+    
+    return 1;
+}
+/**
+ * 
+ * @param text
+ * @param value
+ * @return 
+ */
+static int tenths(const char* text, int32_t* value)
+{
+    JSON       json;
+    JSON_TOKEN token[4];
+    
+    return Json_Parse(&json, text, strlen(text), token, 4) == 1 && Json_Tenths(&json, 0, value);
+}
+/**
+ * 
+ * @param text
+ * @param value
+ * @return 
+ */
+static int integer(const char* text, int32_t* value)
+{
+    JSON       json;
+    JSON_TOKEN token[4];
+    
+    return Json_Parse(&json, text, strlen(text), token, 4) == 1 && Json_Int(&json, 0, value);
+}
+/**
+ * 
+ * @param json
+ * @param arg
+ */
+static void handler(const JSON* json, int arg)
+{
+    m_Json = json;
+    m_Arg  = arg;
+    m_Calls++;
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
+/**
+ * 
+ * @return ns
+ */
+static double now(void)
+{
+    struct timespec t;
+    
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
@@ -0,0 +1,323 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <spi_flash.h>
+#include "../delta.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Delta: an image and a rebuild of it - code moved, relocated addresses, new and dropped functions - diffed with
+ * mkdelta.py and applied in flash from the slot the firmware runs in to the other one, fed in chunks of any size
+ * like the fetcher does; then the ways a patch can be wrong
+ *
+ */
+#define MKDELTA                 "python3 ../mkdelta.py diff"
+#define OLD_FILE                "build/delta_old.bin"
+#define NEW_FILE                "build/delta_new.bin"
+#define PATCH_FILE              "build/delta.dlt"
+
+#define SRC_ADDR                0x002000                            // rBoot slot 0
+#define DST_ADDR                0x082000                            // and slot 1
+#define IMAGE_SIZE              (160 * 1024)
+#define MAX_SIZE                (IMAGE_SIZE + 8192)
+#define MAX_CHUNK               700
+
+static DELTA    m_Delta;
+static uint8_t  m_Old[MAX_SIZE];
+static uint8_t  m_New[MAX_SIZE];
+static uint8_t  m_Patch[MAX_SIZE];
+static uint8_t  m_Read[MAX_SIZE];
+static uint32_t m_Random = 1;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static uint32_t build(void);
+static uint32_t diff(uint32_t newSize);
+static void     program(uint32_t addr, const uint8_t* data, uint32_t len);
+static int      apply(const uint8_t* patch, uint32_t len, int* runs);
+static int      same(uint32_t addr, const uint8_t* data, uint32_t len);
+static void     save(const char* name, const uint8_t* data, uint32_t len);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    uint32_t newSize   = build();
+    uint32_t patchSize = diff(newSize);
+    uint32_t i;
+    int      runs;
+    
+    printf("delta_test: %u byte patch for a %u byte image\n", patchSize, newSize);
+    
+    CHECK(patchSize > 20 && patchSize < newSize / 10);
+    
+    program(SRC_ADDR, m_Old, IMAGE_SIZE);
+    program(DST_ADDR, m_Old + 4096, IMAGE_SIZE);                    // whatever was in the slot before
+    
+    // round trip
+    CHECK_EQUAL(apply(m_Patch, patchSize, &runs), DELTA_OK);
+    CHECK_EQUAL(m_Delta.written, newSize);
+    CHECK(same(DST_ADDR, m_New, newSize));
+    CHECK(runs > 0);
+    
+    // again - the slot is erased as it is written
+    CHECK_EQUAL(apply(m_Patch, patchSize, &runs), DELTA_OK);
+    CHECK(same(DST_ADDR, m_New, newSize));
+    
+    // a patch for another image: nothing is written
+    m_Old[IMAGE_SIZE / 2] ^= 0x01;
+    program(SRC_ADDR, m_Old, IMAGE_SIZE);
+    program(DST_ADDR, m_Old, IMAGE_SIZE);
+    
+    CHECK_EQUAL(apply(m_Patch, patchSize, &runs), DELTA_ERROR_SOURCE);
+    CHECK_EQUAL(m_Delta.written, 0);
+    CHECK(same(DST_ADDR, m_Old, IMAGE_SIZE));
+    
+    m_Old[IMAGE_SIZE / 2] ^= 0x01;
+    program(SRC_ADDR, m_Old, IMAGE_SIZE);
+    
+    // not a patch
+    m_Patch[0] ^= 0xff;
+    CHECK_EQUAL(apply(m_Patch, patchSize, &runs), DELTA_ERROR_MAGIC);
+    m_Patch[0] ^= 0xff;
+    
+    // cut short, anywhere after the header
+    for(i = 0; i < 8; i++) {
+        CHECK_EQUAL(apply(m_Patch, 20 + random32() % (patchSize - 21), &runs), DELTA_ERROR_FORMAT);
+    }
+    
+    // something after the end
+    m_Patch[patchSize] = 0x00;
+    CHECK_EQUAL(apply(m_Patch, patchSize + 1, &runs), DELTA_ERROR_FORMAT);
+    
+    // an unknown operation right after the header
+    m_Patch[20] ^= 0x80;
+    CHECK_EQUAL(apply(m_Patch, patchSize, &runs), DELTA_ERROR_FORMAT);
+    m_Patch[20] ^= 0x80;
+    
+    // a damaged byte in the tail, an added one: found by the CRC of the result
+    m_Patch[patchSize - 2] ^= 0x10;
+    CHECK_EQUAL(apply(m_Patch, patchSize, &runs), DELTA_ERROR_CRC);
+    m_Patch[patchSize - 2] ^= 0x10;
+    
+    // and still good
+    CHECK_EQUAL(apply(m_Patch, patchSize, &runs), DELTA_OK);
+    CHECK(same(DST_ADDR, m_New, newSize));
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * the old image is random - the top bits, the low ones of the generator repeat within the image; the new one keeps
+ * most of it with what a rebuild changes
+ * 
+ * @return size of the new image
+ */
+static uint32_t build(void)
+{
+    uint32_t n = 0;
+    uint32_t i, k;
+    
+    for(i = 0; i < IMAGE_SIZE; i++) {
+        m_Old[i] = random32() >> 16;
+    }
+    
+    // unchanged start, then a function grows
+    memcpy(m_New, m_Old, 30000);
+    n = 30000;
+    
+    for(i = 0; i < 1200; i++) {
+        m_New[n++] = random32() >> 16;
+    }
+    
+    // code moved by the above: every call and literal address in it differs in a byte or two
+    memcpy(m_New + n, m_Old + 30000, 50000);
+    
+    for(k = n + 100; k < n + 50000; k += 150 + random32() % 200) {
+        m_New[k] += 4;
+    }
+    
+    n += 50000;
+    
+    // a function dropped, the rest unchanged
+    memcpy(m_New + n, m_Old + 83000, IMAGE_SIZE - 83000 - 16);
+    n += IMAGE_SIZE - 83000 - 16;
+    
+    // and a new tail ending in a checksum
+    for(i = 0; i < 2000; i++) {
+        m_New[n++] = random32() >> 16;
+    }
+    
+    return n;
+}
+/**
+ * 
+ * @param newSize
+ * @return size of the patch
+ */
+static uint32_t diff(uint32_t newSize)
+{
+    FILE*    fp;
+    uint32_t n = 0;
+    
+    save(OLD_FILE, m_Old, IMAGE_SIZE);
+    save(NEW_FILE, m_New, newSize);
+    
+    if(system(MKDELTA " " OLD_FILE " " NEW_FILE " " PATCH_FILE " > /dev/null") != 0) {
+        printf("delta_test: mkdelta.py failed\n");
+        exit(1);
+    }
+    
+    if((fp = fopen(PATCH_FILE, "rb")) != NULL) {
+        n = fread(m_Patch, 1, sizeof(m_Patch) - 1, fp);
+        fclose(fp);
+    }
+    
+    return n;
+}
+/**
+ * 
+ * @param addr
+ * @param data
+ * @param len
+ */
+static void program(uint32_t addr, const uint8_t* data, uint32_t len)
+{
+    uint32_t i;
+    
+    for(i = 0; i < len; i += SPI_FLASH_SEC_SIZE) {
+        spi_flash_erase_sector((addr + i) / SPI_FLASH_SEC_SIZE);
+    }
+    
+    spi_flash_write(addr, (uint32_t*) data, (len + 3) & ~3);
+}
+/**
+ * feed the patch in random chunks, doing the queued flash work before the next one as fetch.c does
+ * 
+ * @param patch
+ * @param len
+ * @param runs      Delta_Run() calls that had more to do
+ * @return 
+ */
+static int apply(const uint8_t* patch, uint32_t len, int* runs)
+{
+    uint32_t done = 0;
+    uint32_t chunk;
+    int      rc   = DELTA_OK;
+    
+    *runs = 0;
+    
+    Delta_Begin(&m_Delta, SRC_ADDR, DST_ADDR);
+    
+    while(done < len) {
+        chunk = 1 + random32() % MAX_CHUNK;
+        
+        if(chunk > len - done) {
+            chunk = len - done;
+        }
+        
+        if((rc = Delta_Write(&m_Delta, patch + done, chunk)) < 0) {
+            return rc;
+        }
+        
+        done += rc;
+        
+        while((rc = Delta_Run(&m_Delta)) == DELTA_BUSY) {
+            (*runs)++;
+        }
+        
+        if(rc != DELTA_OK) {
+            return rc;
+        }
+    }
+    
+    rc = Delta_End(&m_Delta);
+    
+    while(rc == DELTA_BUSY) {
+        rc = Delta_Run(&m_Delta);
+    }
+    
+    return rc;
+}
+/**
+ * 
+ * @param addr
+ * @param data
+ * @param len
+ * @return 
+ */
+static int same(uint32_t addr, const uint8_t* data, uint32_t len)
+{
+    spi_flash_read(addr, (uint32_t*) m_Read, (len + 3) & ~3);
+    
+    return memcmp(m_Read, data, len) == 0;
+}
+/**
+ * 
+ * @param name
+ * @param data
+ * @param len
+ */
+static void save(const char* name, const uint8_t* data, uint32_t len)
+{
+    FILE* fp = fopen(name, "wb");
+    
+    if(fp == NULL || fwrite(data, 1, len, fp) != len) {
+        printf("delta_test: cannot write %s\n", name);
+        exit(1);
+    }
+    
+    fclose(fp);
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
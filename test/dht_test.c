@@ -0,0 +1,233 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include "../dht_async.h"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * DhtAsync_Decode() on edge traces with the spread of a real DHT22 - data bits of 22-30 us and 66-75 us, the
+ * response of 75-85 us - and damaged ones; then a full reading through the GPIO interrupt of the shim
+ *
+ */
+#define GPIO_TEST               5
+
+typedef enum {
+    TraceGood,
+    TraceTruncated,
+    TraceChecksum,
+    TraceLongBit,
+    TraceNoise
+} TRACE;
+
+static DHT_ASYNC    m_Dht;
+static uint16_t     m_Time;
+static uint32_t     m_Random = 1;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     edge(uint8_t level, uint16_t dt);
+static uint16_t jitter(uint16_t low, uint16_t high);
+static void     trace(uint16_t start, int16_t temperature, uint16_t humidity, TRACE kind);
+static int      reply(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    int16_t t, h;
+    
+    CHECK_EQUAL(DhtAsync_Initialize(&m_Dht, GPIO_TEST), 0);
+    
+    // not started
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_TIMEOUT);
+    
+    // plain frames, also across the wrap of the 16 bit timestamps
+    trace(1000, 235, 456, TraceGood);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_OK);
+    CHECK_EQUAL(t, 235);
+    CHECK_EQUAL(h, 456);
+    
+    trace(65000, -123, 999, TraceGood);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_OK);
+    CHECK_EQUAL(t, -123);
+    CHECK_EQUAL(h, 999);
+    
+    trace(40000, 0, 0, TraceGood);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_OK);
+    CHECK_EQUAL(t, 0);
+    CHECK_EQUAL(h, 0);
+    
+    // damaged ones
+    trace(1000, 235, 456, TraceTruncated);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_TIMEOUT);
+    
+    trace(1000, 235, 456, TraceChecksum);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_CHECKSUM);
+    
+    trace(1000, 235, 456, TraceLongBit);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_FRAME);
+    
+    // glitches before the frame overrun the ring; the frame itself is still whole
+    trace(1000, 235, 456, TraceNoise);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_OK);
+    CHECK_EQUAL(t, 235);
+    CHECK_EQUAL(m_Dht.overruns, 1);
+    
+    CHECK_EQUAL(m_Dht.frames, 4);
+    CHECK_EQUAL(m_Dht.checksumErrors, 1);
+    CHECK_EQUAL(m_Dht.frameErrors, 1);
+    CHECK_EQUAL(m_Dht.timeouts, 1);
+    
+    // the whole way: start signal, release, interrupts
+    Shim_SetDht(reply);
+    
+    DhtAsync_Start(&m_Dht);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_BUSY);
+    
+    Shim_Run(DHT_ASYNC_FRAME_MS * 1000);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_OK);
+    CHECK_EQUAL(t, -57);
+    CHECK_EQUAL(h, 823);
+    CHECK_EQUAL(Shim_Stats.dhtFrames, 1);
+    
+    // no sensor
+    Shim_SetDht(NULL);
+    
+    DhtAsync_Start(&m_Dht);
+    Shim_Run(DHT_ASYNC_FRAME_MS * 1000);
+    CHECK_EQUAL(DhtAsync_Decode(&m_Dht, &t, &h), DHT_ASYNC_TIMEOUT);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * what the ISR would store
+ * 
+ * @param level
+ * @param dt
+ */
+static void edge(uint8_t level, uint16_t dt)
+{
+    m_Time += dt;
+    
+    m_Dht.edges[m_Dht.head & (DHT_ASYNC_EDGES - 1)] = (m_Time & 0xfffe) | level;
+    m_Dht.head++;
+}
+/**
+ * 
+ * @param low
+ * @param high
+ * @return 
+ */
+static uint16_t jitter(uint16_t low, uint16_t high)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return low + (m_Random >> 16) % (high - low + 1);
+}
+/**
+ * 
+ * @param start
+ * @param temperature
+ * @param humidity
+ * @param kind
+ */
+static void trace(uint16_t start, int16_t temperature, uint16_t humidity, TRACE kind)
+{
+    uint16_t magnitude = (temperature < 0) ? -temperature : temperature;
+    uint8_t  data[5];
+    int      bits = (kind == TraceTruncated) ? 30 : 40;
+    int      i;
+    
+    data[0] = humidity >> 8;
+    data[1] = humidity;
+    data[2] = (magnitude >> 8) | ((temperature < 0) ? 0x80 : 0);
+    data[3] = magnitude;
+    data[4] = data[0] + data[1] + data[2] + data[3] + ((kind == TraceChecksum) ? 1 : 0);
+    
+    m_Dht.state = DhtAsyncCapture;
+    m_Dht.head  = 0;
+    m_Time      = start;
+    
+    if(kind == TraceNoise) {
+        for(i = 0; i < DHT_ASYNC_EDGES / 2; i++) {
+            edge(1, 3);
+            edge(0, 2);
+        }
+    }
+    
+    // our start signal let go, then the sensor's response
+    edge(1, 0);
+    edge(0, jitter(20, 40));
+    edge(1, jitter(75, 85));
+    edge(0, jitter(75, 85));
+    
+    for(i = 0; i < bits; i++) {
+        edge(1, jitter(48, 55));
+        
+        if(kind == TraceLongBit && i == 20) {
+            edge(0, 140);
+        } else {
+            edge(0, (data[i / 8] & (0x80 >> (i % 8))) ? jitter(66, 75) : jitter(22, 30));
+        }
+    }
+    
+    if(bits == 40) {
+        edge(1, jitter(48, 55));
+    }
+}
+/**
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 
+ */
+static int reply(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    *temperature = -57;
+    *humidity    = 823;
+    
+    return gpio == GPIO_TEST;
+}
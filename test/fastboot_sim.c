@@ -0,0 +1,239 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include <github.com/mikejac/wifi.esp8266-nonos.cpp/wifi.h>
+#include <wifi.h>
+#include "../user_config.h"
+#include "shim.h"
+#include "plant.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * fast boot
+ *
+ * Only the second access point in wifi_list is in range. The thermostat is set to heat and restarted: after a reset
+ * the RTC memory still says which access point it was, so that one is tried first; after a power cut it does not,
+ * and the first one has to time out. Either way the heaters must be on before the network is there - at once on
+ * the reading in the RTC checkpoint, or on the first one - without waiting for a terminal.
+ *
+ * usage: fastboot_sim [-v]
+ *
+ */
+#define OUTDOOR_MEAN            2.0                                 // C
+#define SETPOINT                18.0                                // C; far above the air
+#define SETTLE                  60                                  // s
+#define STEP                    10                                  // ms
+#define WATCH                   30000                               // ms after the boot
+#define FIRST_DECISION          (DHT_WARMUP + 500)                  // ms; the first reading and its PID run
+
+typedef struct {
+    PLANT                   plant;
+    int                     verbose;
+    uint32_t                relay;                                  // ms after the boot a heater went on; 0: not
+    uint32_t                wifi;                                   // ms after the boot it was connected; 0: not
+    int                     preferred;                              // the cached access point was put first
+} SHARED;
+
+static SHARED*      m_Shared;
+static uint32_t     m_Random = 12345;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     configure(void* shared);
+static void     first(void* shared);
+static void     boot(void* shared);
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static int      heaters(void);
+static void     run(uint32_t ms);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    SHARED* s = (SHARED*) Shim_Shared(sizeof(SHARED));
+    SHARED  reset;
+    
+    s->verbose = (argc > 1 && strcmp(argv[1], "-v") == 0);
+    
+    Plant_Initialize(&s->plant, OUTDOOR_MEAN, SHIM_WALL_CLOCK);
+    
+    CHECK_EQUAL(Shim_Restart(true, configure, s), 0);
+    CHECK(s->wifi > 0);
+    
+    // a reset: the RTC memory has the access point
+    CHECK_EQUAL(Shim_Restart(false, first, s), 0);
+    
+    reset = *s;
+    
+    // a power cut: it has not; the checkpoint in flash has the rest
+    CHECK_EQUAL(Shim_Restart(true, first, s), 0);
+    
+    printf("fastboot_sim: after a reset heat at %u ms, connected at %u ms; after a power cut %u ms and %u ms\n", 
+           reset.relay, reset.wifi, s->relay, s->wifi);
+    
+    CHECK(reset.preferred);
+    CHECK(!s->preferred);
+    
+    CHECK(reset.relay > 0 && reset.relay <= FIRST_DECISION);
+    CHECK(s->relay > 0 && s->relay <= FIRST_DECISION);
+    CHECK(reset.relay < reset.wifi);
+    CHECK(s->relay < s->wifi);
+    
+    CHECK(reset.wifi <= SHIM_WIFI_CONNECT + STEP);                  // straight to the one in range
+    CHECK(s->wifi >= SHIM_WIFI_SCAN + SHIM_WIFI_CONNECT);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a cold boot: connected the long way, then the thermostat is set from the app
+ * 
+ * @param shared
+ */
+static void configure(void* shared)
+{
+    boot(shared);
+    
+    run(WATCH);
+    
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+    
+    run(SETTLE * 1000);
+}
+/**
+ * the boot after it; when the heaters go on and when the network is there
+ * 
+ * @param shared
+ */
+static void first(void* shared)
+{
+    boot(shared);
+    
+    m_Shared->preferred = (strstr(Shim_Serial(), "preferLastAp()") != NULL);
+    
+    run(WATCH);
+}
+/**
+ * 
+ * @param shared
+ */
+static void boot(void* shared)
+{
+    m_Shared = (SHARED*) shared;
+    
+    m_Shared->relay = 0;
+    m_Shared->wifi  = 0;
+    
+    Shim_Verbose(m_Shared->verbose);
+    Shim_AccessPoint(SSID2);
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+}
+/**
+ * a reading of the plant with a tenth of noise
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    PLANT*  p = &m_Shared->plant;
+    double  t = (gpio == GPIO_DHT1) ? p->air      : p->outdoor;
+    double  h = (gpio == GPIO_DHT1) ? p->humidity : Plant_OutdoorHumidity(p);
+    
+    *temperature = (int16_t) lround(t * 10) + (int) (random32() % 3) - 1;
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * 
+ * @return stages on
+ */
+static int heaters(void)
+{
+    return (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+}
+/**
+ * the firmware and the plant, STEP at a time; the first heater and the connection are timed
+ * 
+ * @param ms
+ */
+static void run(uint32_t ms)
+{
+    uint32_t t;
+    
+    for(t = 0; t < ms; t += STEP) {
+        Shim_Run(STEP * 1000);
+        
+        if(m_Shared->relay == 0 && heaters() > 0) {
+            m_Shared->relay = (uint32_t) (Shim_Time() / 1000);
+        }
+        
+        if(m_Shared->wifi == 0 && WIFI_IsConnected()) {
+            m_Shared->wifi = (uint32_t) (Shim_Time() / 1000);
+        }
+        
+        Plant_Step(&m_Shared->plant, STEP / 1000.0, heaters(), Shim_Output(GPIO_FAN) == FAN_ON);
+    }
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
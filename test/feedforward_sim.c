@@ -0,0 +1,274 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include "../user_config.h"
+#include "shim.h"
+#include "plant.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * outdoor feed-forward in closed loop
+ *
+ * The firmware holds the workshop model at a setpoint through a cold front. Then, in a frost that takes more than
+ * one stage to hold the setpoint, it heats up after a night setback: with the outdoor reading both stages come on
+ * at once; without it - the sensor gone - the second stage waits for its delay and the heat-up takes longer.
+ *
+ * usage: feedforward_sim [-v]
+ *
+ */
+#define OUTDOOR_MEAN            6.0                                 // C before the front
+#define FRONT                   14.0                                // C it takes off the mean
+#define FRONT_TIME              (2 * 3600)                          // s it takes
+#define SETPOINT                16.0                                // C
+#define WARM_UP                 (12 * 3600)                         // s
+#define WATCH                   (12 * 3600)                         // s from the start of the front
+#define FROST                   -14.0                               // C outdoor mean
+#define SETBACK                 5.0                                 // C
+#define NIGHT                   (8 * 3600)                          // s
+#define MORNING                 (16 * 3600)                         // s watched after the setback; a day in all
+#define REACHED                 0.3                                 // C below the setpoint
+
+// bounds
+#define MAX_UNDERSHOOT          0.6                                 // C
+#define MAX_OVERSHOOT           1.0
+#define MAX_MEAN_ERROR          0.25
+
+typedef struct {
+    double                  error;                                  // sum of |error|
+    double                  over;
+    double                  under;
+} FRONT_STATS;
+
+typedef struct {
+    uint32_t                stage2;                                 // s from the setpoint to stage 2 on
+    uint32_t                reached;                                // s from the setpoint to near it
+    double                  over;
+} HEAT_UP;
+
+static PLANT        m_Plant;
+static uint32_t     m_Random = 12345;
+static int          m_Outdoor = 1;                                  // the outdoor sensor replies
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static void     front(FRONT_STATS* stats, double drop);
+static void     heatUp(HEAT_UP* h);
+static void     run(uint32_t seconds);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    FRONT_STATS stats;
+    HEAT_UP     with, without;
+    
+    if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+        Shim_Verbose(1);
+    }
+    
+    Plant_Initialize(&m_Plant, OUTDOOR_MEAN, SHIM_WALL_CLOCK);
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+    
+    run(5);
+    
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+    
+    run(WARM_UP);
+    
+    front(&stats, -FRONT);
+    
+    printf("feedforward_sim: cold front, mean error %.2f C, under %.2f C, over %.2f C\n", 
+           stats.error, stats.under, stats.over);
+    
+    CHECK(stats.error <= MAX_MEAN_ERROR);
+    CHECK(stats.under <= MAX_UNDERSHOOT);
+    CHECK(stats.over  <= MAX_OVERSHOOT);
+    
+    // frost
+    m_Plant.mean = FROST;
+    
+    run(WARM_UP);
+    
+    heatUp(&with);
+    
+    m_Outdoor = 0;
+    
+    heatUp(&without);
+    
+    printf("feedforward_sim: heat-up with the outdoor sensor:    stage 2 after %u s, near the setpoint after %u s\n", 
+           with.stage2, with.reached);
+    printf("feedforward_sim: heat-up without the outdoor sensor: stage 2 after %u s, near the setpoint after %u s\n", 
+           without.stage2, without.reached);
+    
+    CHECK(with.stage2 < STAGE_2_TIME / 4);
+    CHECK(without.stage2 >= STAGE_2_TIME);
+    CHECK(with.reached < without.reached);
+    CHECK(with.over <= MAX_OVERSHOOT);
+    CHECK_EQUAL(Shim_Stats.restarts, 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a reading of the plant with a tenth of noise
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 0: no reply
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    double t = (gpio == GPIO_DHT1) ? m_Plant.air      : m_Plant.outdoor;
+    double h = (gpio == GPIO_DHT1) ? m_Plant.humidity : Plant_OutdoorHumidity(&m_Plant);
+    
+    if(gpio != GPIO_DHT1 && !m_Outdoor) {
+        return 0;
+    }
+    
+    *temperature = (int16_t) lround(t * 10) + (int) (random32() % 3) - 1;
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * move the outdoor mean over FRONT_TIME and watch the air until WATCH
+ * 
+ * @param stats
+ * @param drop      C
+ */
+static void front(FRONT_STATS* stats, double drop)
+{
+    uint32_t s;
+    double   e;
+    
+    memset(stats, 0, sizeof(FRONT_STATS));
+    
+    for(s = 0; s < WATCH; s++) {
+        m_Plant.mean += (s < FRONT_TIME) ? drop / FRONT_TIME : 0;
+        run(1);
+        
+        e = m_Plant.air - SETPOINT;
+        
+        stats->error += fabs(e);
+        
+        if(e > stats->over) {
+            stats->over = e;
+        }
+        if(-e > stats->under) {
+            stats->under = -e;
+        }
+    }
+    
+    stats->error /= WATCH;
+}
+/**
+ * a night at the setback and the morning after; a day, so each starts at the same time of day
+ * 
+ * @param h
+ */
+static void heatUp(HEAT_UP* h)
+{
+    uint32_t s;
+    
+    memset(h, 0, sizeof(HEAT_UP));
+    
+    h->stage2  = UINT32_MAX;
+    h->reached = UINT32_MAX;
+    
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETBACK);
+    run(NIGHT);
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+    
+    for(s = 0; s < MORNING; s++) {
+        run(1);
+        
+        if(h->stage2 == UINT32_MAX && Shim_Output(GPIO_HEATER2) == HEATER_ON) {
+            h->stage2 = s + 1;
+        }
+        
+        if(h->reached == UINT32_MAX && m_Plant.air >= SETPOINT - REACHED) {
+            h->reached = s + 1;
+        }
+        
+        if(m_Plant.air - SETPOINT > h->over) {
+            h->over = m_Plant.air - SETPOINT;
+        }
+    }
+}
+/**
+ * the firmware and the plant, a second at a time
+ * 
+ * @param seconds
+ */
+static void run(uint32_t seconds)
+{
+    uint32_t s;
+    int      heaters;
+    
+    for(s = 0; s < seconds; s++) {
+        Shim_Run(1000000);
+        
+        heaters = (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+        
+        Plant_Step(&m_Plant, 1.0, heaters, Shim_Output(GPIO_FAN) == FAN_ON);
+    }
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
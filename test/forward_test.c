@@ -0,0 +1,253 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../forward.h"
+#include "../user_config.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Forward: six hours with two outages, the events queued meanwhile sent in batches to a broker stand-in that also
+ * turns down a publish now and then; every event arrives once, in order, with its time - or is counted as dropped
+ *
+ */
+#define WALL_CLOCK              1451865600
+#define DURATION                (6 * 3600)                          // s
+#define BATCH_SIZE              (48 + FORWARD_BATCH * 24)           // as main.cpp
+#define REFUSE                  5                                   // every n'th publish fails
+
+static FORWARD  m_Forward;
+static char     m_Batch[BATCH_SIZE];
+static int16_t  m_Sent[DURATION];                                   // by sequence number, which is the value
+static uint32_t m_SentTime[DURATION];
+static int      m_Produced;
+static int      m_Received;
+static int      m_Last;
+static int      m_Publishes;
+static int      m_Bad;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void run(int policy);
+static int  online(uint32_t t);
+static int  publish(const char* message);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    uint32_t i;
+    int      n;
+    
+    run(FORWARD_DROP_OLDEST);
+    run(FORWARD_DROP_NEWEST);
+    
+    // without a clock the times are uptime
+    Forward_Initialize(&m_Forward, FORWARD_DROP_OLDEST);
+    
+    for(i = 0; i < 3; i++) {
+        Forward_Add(&m_Forward, 1, i, 100 + i);
+    }
+    
+    n = Forward_Format(&m_Forward, m_Batch, sizeof(m_Batch), FORWARD_BATCH, 200, 0);
+    
+    CHECK_EQUAL(n, 3);
+    CHECK(strcmp(m_Batch, "{\"clock\":\"uptime\",\"forward\":[[100,1,0],[101,1,1],[102,1,2]],"
+                          "\"dropped\":0,\"left\":0}") == 0);
+    
+    // a batch not committed is sent again
+    n = Forward_Format(&m_Forward, m_Batch, sizeof(m_Batch), 2, 200, WALL_CLOCK);
+    
+    CHECK_EQUAL(n, 2);
+    CHECK(strcmp(m_Batch, "{\"clock\":\"utc\",\"forward\":[[1451865500,1,0],[1451865501,1,1]],"
+                          "\"dropped\":0,\"left\":1}") == 0);
+    
+    Forward_Commit(&m_Forward, n);
+    
+    n = Forward_Format(&m_Forward, m_Batch, sizeof(m_Batch), 2, 200, WALL_CLOCK);
+    
+    CHECK_EQUAL(n, 1);
+    CHECK(strcmp(m_Batch, "{\"clock\":\"utc\",\"forward\":[[1451865502,1,2]],\"dropped\":0,\"left\":0}") == 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * four sensors a minute and a relay change every seven while offline; one batch a second while online
+ * 
+ * @param policy
+ */
+static void run(int policy)
+{
+    uint32_t t;
+    int      k, n, seq;
+    int      lost  = 0;
+    int      first = -1;
+    
+    Forward_Initialize(&m_Forward, policy);
+    
+    m_Produced  = 0;
+    m_Received  = 0;
+    m_Last      = -1;
+    m_Publishes = 0;
+    m_Bad       = 0;
+    
+    memset(m_Sent, 0, sizeof(m_Sent));
+    
+    for(t = 0; t < DURATION; t++) {
+        if(!online(t)) {
+            for(k = 0; k < 4 && t % 60 == 0; k++) {
+                m_SentTime[m_Produced] = t;
+                Forward_Add(&m_Forward, k, m_Produced++, t);
+            }
+            
+            if(t % 420 == 0) {
+                m_SentTime[m_Produced] = t;
+                Forward_Add(&m_Forward, 4, m_Produced++, t);
+            }
+        } else if(Forward_Count(&m_Forward) > 0) {
+            n = Forward_Format(&m_Forward, m_Batch, sizeof(m_Batch), FORWARD_BATCH, t, WALL_CLOCK + t);
+            
+            CHECK(n > 0 && n <= FORWARD_BATCH);
+            CHECK(strlen(m_Batch) < sizeof(m_Batch));
+            
+            if(publish(m_Batch)) {
+                Forward_Commit(&m_Forward, n);
+            }
+        }
+    }
+    
+    // each event once, in order; what is missing was counted
+    for(seq = 0; seq < m_Produced; seq++) {
+        if(m_Sent[seq] == 0) {
+            lost++;
+        } else if(first < 0) {
+            first = seq;
+        }
+        
+        m_Bad += (m_Sent[seq] > 1);
+    }
+    
+    printf("forward_test: policy %d, %d events, %d received in %d publishes, %lu dropped\n", policy, m_Produced,
+        m_Received, m_Publishes, m_Forward.dropped);
+    
+    CHECK_EQUAL(m_Bad, 0);
+    CHECK_EQUAL(Forward_Count(&m_Forward), 0);
+    CHECK_EQUAL(m_Received, m_Forward.forwarded);
+    CHECK_EQUAL(m_Received + (int) m_Forward.dropped, m_Produced);
+    CHECK_EQUAL(lost, (int) m_Forward.dropped);
+    CHECK(m_Forward.dropped > 0);                                   // the long outage does not fit
+    
+    // the policy decides which end of the long outage survives
+    if(policy == FORWARD_DROP_OLDEST) {
+        CHECK(m_Sent[m_Produced - 1] == 1);
+    } else {
+        CHECK(m_Sent[m_Produced - 1] == 0);
+    }
+    
+    CHECK_EQUAL(first, 0);                                          // the short one does
+}
+/**
+ * 
+ * @param t
+ * @return 
+ */
+static int online(uint32_t t)
+{
+    if(t >= 3600 && t < 3600 + 25 * 60) {
+        return 0;
+    }
+    
+    if(t >= 3 * 3600 && t < DURATION - 1800) {
+        return 0;
+    }
+    
+    return 1;
+}
+/**
+ * broker stand-in: takes a message apart, checks each event against what was added
+ * 
+ * @param message
+ * @return 0 when refused
+ */
+static int publish(const char* message)
+{
+    const char*   p = strstr(message, "\"forward\":[");
+    unsigned long time;
+    unsigned      type;
+    int           value;
+    
+    if(++m_Publishes % REFUSE == 0) {
+        return 0;
+    }
+    
+    CHECK(strncmp(message, "{\"clock\":\"utc\"", 14) == 0);
+    CHECK(p != NULL);
+    
+    if(p == NULL) {
+        return 1;
+    }
+    
+    for(p += 11; *p == '[' || *p == ','; p = strchr(p, ']') + 1) {
+        if(*p == ',') {
+            p++;
+        }
+        
+        if(sscanf(p, "[%lu,%u,%d]", &time, &type, &value) != 3 || value < 0 || value >= m_Produced) {
+            m_Bad++;
+            break;
+        }
+        
+        if(value <= m_Last || time != WALL_CLOCK + m_SentTime[value]) {
+            m_Bad++;
+        }
+        
+        m_Sent[value]++;
+        m_Last = value;
+        m_Received++;
+    }
+    
+    CHECK(strncmp(p, "],\"dropped\":", 12) == 0);
+    
+    return 1;
+}
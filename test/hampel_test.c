@@ -0,0 +1,117 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "../hampel.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Hampel: single spikes either way are replaced by the median, noise and slow ramps pass untouched, and a real
+ * step is followed within half a window
+ *
+ */
+#define MIN_DEVIATION           10                                  // 0.1 C, as FILTER_TEMP_DEVIATION
+
+static HAMPEL m_Filter;
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    int16_t  noise[] = { 200, 201, 200, 199, 200, 201, 201, 200, 199, 199, 200 };
+    uint32_t i;
+    int16_t  out;
+    
+    Hampel_Initialize(&m_Filter, MIN_DEVIATION);
+    
+    // too few readings to judge: everything passes, even a spike
+    CHECK_EQUAL(Hampel_Filter(&m_Filter, 200), 200);
+    CHECK_EQUAL(Hampel_Filter(&m_Filter, 650), 650);
+    
+    Hampel_Reset(&m_Filter);
+    
+    // noise within the minimum deviation
+    for(i = 0; i < sizeof(noise) / sizeof(noise[0]); i++) {
+        CHECK_EQUAL(Hampel_Filter(&m_Filter, noise[i]), noise[i]);
+    }
+    
+    CHECK_EQUAL(m_Filter.rejected, 0);
+    
+    // spikes up and down, and two in a row - a window apart since the window keeps the raw readings
+    CHECK_EQUAL(Hampel_Filter(&m_Filter, 650), 200);
+    
+    for(i = 0; i < HAMPEL_WINDOW; i++) {
+        CHECK_EQUAL(Hampel_Filter(&m_Filter, 201), 201);
+    }
+    
+    CHECK_EQUAL(Hampel_Filter(&m_Filter, -400), 201);
+    
+    for(i = 0; i < HAMPEL_WINDOW; i++) {
+        CHECK_EQUAL(Hampel_Filter(&m_Filter, 200), 200);
+    }
+    
+    CHECK_EQUAL(Hampel_Filter(&m_Filter, 900), 200);
+    CHECK_EQUAL(Hampel_Filter(&m_Filter, 900), 200);
+    
+    for(i = 0; i < HAMPEL_WINDOW; i++) {
+        CHECK_EQUAL(Hampel_Filter(&m_Filter, 200), 200);
+    }
+    
+    CHECK_EQUAL(m_Filter.rejected, 4);
+    
+    // a ramp of a tenth per reading - a heater coming on - is not touched
+    for(i = 0; i < 50; i++) {
+        CHECK_EQUAL(Hampel_Filter(&m_Filter, 200 + i), 200 + i);
+    }
+    
+    // a real step: at most the first two readings are held back
+    for(i = 0; i < 10; i++) {
+        out = Hampel_Filter(&m_Filter, 300);
+        
+        if(i >= 2) {
+            CHECK_EQUAL(out, 300);
+        }
+    }
+    
+    // a spike in the noisier humidity
+    Hampel_Initialize(&m_Filter, 50);
+    
+    for(i = 0; i < 20; i++) {
+        CHECK_EQUAL(Hampel_Filter(&m_Filter, 600 + (i % 3) * 20), 600 + (i % 3) * 20);
+    }
+    
+    CHECK(Hampel_Filter(&m_Filter, 999) < 700);
+    CHECK_EQUAL(m_Filter.rejected, 1);
+    
+    return CHECK_DONE();
+}
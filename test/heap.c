@@ -0,0 +1,154 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <mem.h>
+#include "shim.h"
+
+/******************************************************************************************************************
+ * heap
+ *
+ * On its own, so that the calls from shim.c - the sibling libraries - go through the arena's wraps like on the chip.
+ *
+ */
+
+static uint32_t m_Used;
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+uint32_t Shim_HeapUsed(void)
+{
+    return m_Used;
+}
+/**
+ * 
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* pvPortMalloc(size_t sz, const char* file, unsigned line)
+{
+    size_t* p;
+    
+    if(m_Used + sz + sizeof(size_t) > SHIM_HEAP_SIZE || (p = (size_t*) malloc(sz + sizeof(size_t))) == NULL) {
+        return NULL;
+    }
+    
+    *p          = sz;
+    m_Used += sz + sizeof(size_t);
+    
+    (void) file;
+    (void) line;
+    
+    return p + 1;
+}
+/**
+ * 
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* pvPortZalloc(size_t sz, const char* file, unsigned line)
+{
+    void* p = pvPortMalloc(sz, file, line);
+    
+    if(p != NULL) {
+        os_memset(p, 0, sz);
+    }
+    
+    return p;
+}
+/**
+ * 
+ * @param count
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* pvPortCalloc(size_t count, size_t sz, const char* file, unsigned line)
+{
+    return pvPortZalloc(count * sz, file, line);
+}
+/**
+ * 
+ * @param p
+ * @param sz
+ * @param file
+ * @param line
+ * @return 
+ */
+void* pvPortRealloc(void* p, size_t sz, const char* file, unsigned line)
+{
+    void*  n;
+    size_t old;
+    
+    if(p == NULL) {
+        return pvPortMalloc(sz, file, line);
+    }
+    
+    if((n = pvPortMalloc(sz, file, line)) == NULL) {
+        return NULL;
+    }
+    
+    old = ((size_t*) p)[-1];
+    
+    os_memcpy(n, p, (old < sz) ? old : sz);
+    vPortFree(p, file, line);
+    
+    return n;
+}
+/**
+ * 
+ * @param p
+ * @param file
+ * @param line
+ */
+void vPortFree(void* p, const char* file, unsigned line)
+{
+    size_t* q = (size_t*) p - 1;
+    
+    if(p == NULL) {
+        return;
+    }
+    
+    m_Used -= *q + sizeof(size_t);
+    
+    free(q);
+    
+    (void) file;
+    (void) line;
+}
@@ -0,0 +1,282 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <spi_flash.h>
+#include "../history.h"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * History: random walks of samples with now and then a jump, read back in pages after one or more boots; the
+ * blocks of earlier boots served in wall clock once it is known
+ *
+ */
+#define INTERVAL                60                                  // s
+#define SECTOR                  0x10
+#define MAX_SAMPLES             20000
+#define PAGE                    17
+
+static HISTORY          m_History;
+static HISTORY_SAMPLE   m_Added[MAX_SAMPLES];
+static HISTORY_SAMPLE   m_Read[MAX_SAMPLES];
+static uint32_t         m_Random = 1;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     erase(uint16_t sectors);
+static void     walk(uint16_t sectors, int samples, int boots);
+static void     clock(void);
+static int      readAll(void);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    walk(0, 5000, 1);                                               // RAM only; the newest blocks
+    walk(2, 5000, 1);
+    walk(8, 5000, 3);                                               // served across boots once the clock is known
+    walk(8, 100, 2);                                                // less than a block
+    
+    clock();
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param sectors
+ */
+static void erase(uint16_t sectors)
+{
+    uint16_t i;
+    
+    for(i = 0; i < sectors; i++) {
+        spi_flash_erase_sector(SECTOR + i);
+    }
+}
+/**
+ * every boot adds 'samples' and reads all back; what is served must be what was added, in order, up to the newest -
+ * less the samples in the open block at each reboot
+ * 
+ * @param sectors
+ * @param samples
+ * @param boots
+ */
+static void walk(uint16_t sectors, int samples, int boots)
+{
+    HISTORY_SAMPLE s;
+    uint32_t       wall  = 1000000000;
+    int            total = 0;
+    int            b, i, j, k, n, bad;
+    
+    erase(sectors);
+    
+    memset(&s, 0, sizeof(s));
+    
+    s.value[0] = 200;
+    s.value[1] = 450;
+    s.value[2] = -30;
+    s.value[3] = 800;
+    
+    for(b = 0; b < boots; b++) {
+        History_Initialize(&m_History, INTERVAL, SECTOR, sectors);
+        History_SetClock(&m_History, wall);
+        
+        s.time = 5;
+        
+        for(i = 0; i < samples; i++) {
+            s.time += (random32() % 20 == 0) ? INTERVAL + 1 : INTERVAL;
+            
+            for(k = 0; k < HISTORY_VALUES; k++) {
+                uint32_t r = random32() % 10;
+                
+                s.value[k] += (r < 5) ? 0 : (r < 9) ? (int) (random32() % 3) - 1 : (int) (random32() % 400) - 200;
+            }
+            
+            if(random32() % 30 == 0) {
+                s.state ^= 1 << (random32() % 3);
+            }
+            
+            History_Add(&m_History, &s);
+            
+            m_Added[total]       = s;
+            m_Added[total].time += wall;
+            total++;
+        }
+        
+        wall += s.time + 1000;
+        
+        n   = readAll();
+        bad = 0;
+        
+        CHECK(n > 0 && n <= total);
+        
+        for(i = 0, j = 0; i < n; i++, j++) {
+            const HISTORY_SAMPLE* x = &m_Read[i];
+            
+            while(j < total && m_Added[j].time != x->time) {
+                j++;
+            }
+            
+            if(j == total || x->state != m_Added[j].state || memcmp(x->value, m_Added[j].value, sizeof(x->value)) != 0) {
+                bad++;
+            }
+        }
+        
+        CHECK_EQUAL(bad, 0);
+        CHECK_EQUAL(m_Read[n - 1].time, m_Added[total - 1].time);
+        
+        printf("sectors %u, boot %d: %d of %d served, %.2f bytes/sample\n", sectors, b, n, total, 
+               (double) m_History.bytes / m_History.samples);
+    }
+    
+    CHECK_EQUAL(m_History.flashErrors, 0);
+    
+    if(sectors == 0) {
+        CHECK(m_History.bytes < 3 * m_History.samples);
+    }
+}
+/**
+ * three boots: the first learns the clock late, the second never, the third again; the second's blocks cannot
+ * be placed in time and are left out
+ */
+static void clock(void)
+{
+    uint32_t wall  = 1000000000;
+    int      total = 0;
+    int      b, i, n, bad = 0;
+    
+    erase(8);
+    
+    for(b = 0; b < 3; b++) {
+        uint32_t up   = 5;
+        uint32_t base = wall - up;
+        int      samples = 300 + b * 100;
+        
+        History_Initialize(&m_History, INTERVAL, SECTOR, 8);
+        
+        for(i = 0; i < samples; i++) {
+            HISTORY_SAMPLE s;
+            
+            memset(&s, 0, sizeof(s));
+            
+            s.time     = up;
+            s.value[0] = i;
+            s.value[1] = 2 * i;
+            
+            if(i == 50 && b != 1) {
+                History_SetClock(&m_History, base);
+            }
+            
+            History_Add(&m_History, &s);
+            
+            m_Added[total]       = s;
+            m_Added[total].time += (b == 1) ? 0 : base;
+            total++;
+            
+            up   += INTERVAL;
+            wall += INTERVAL;
+        }
+        
+        wall += 1000;                                               // powered off for a while
+        
+        n = readAll();
+        
+        if(b == 1) {
+            // no clock: this boot only, in uptime
+            CHECK_EQUAL(m_Read[0].time, 5);
+            CHECK(n <= samples);
+        }
+        
+        if(b == 2) {
+            for(i = 0; i < samples; i++) {
+                if(m_Read[n - samples + i].time != m_Added[total - samples + i].time || 
+                   m_Read[n - samples + i].value[0] != m_Added[total - samples + i].value[0]) {
+                    bad++;
+                }
+            }
+            
+            // and before them, in wall clock, the first boot's
+            CHECK(n > samples);
+            CHECK(m_Read[0].time >= 1000000000 && m_Read[0].time < m_Added[total - samples].time);
+            CHECK(m_Read[n - samples - 1].time <= m_Added[299].time);
+            
+            for(i = 0; i < n - samples; i++) {
+                if(m_Read[i].time < 1000000000) {
+                    bad++;                                          // one of the second boot's
+                }
+            }
+        }
+    }
+    
+    CHECK_EQUAL(bad, 0);
+}
+/**
+ * 
+ * @return samples read, in pages
+ */
+static int readAll(void)
+{
+    uint32_t count = History_Count(&m_History);
+    int      n = 0;
+    int      k;
+    
+    while(n < (int) count && (k = History_Read(&m_History, n, m_Read + n, PAGE)) > 0) {
+        n += k;
+    }
+    
+    CHECK_EQUAL(n, count);
+    
+    return n;
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
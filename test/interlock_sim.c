@@ -0,0 +1,236 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include "../user_config.h"
+#include "shim.h"
+#include "plant.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * interlock in closed loop
+ *
+ * The firmware heats the workshop model, then its main loop is stuck - in a read, a connect - while only the
+ * interrupts run: the relays must be off within one tick of the loop timeout, a short stall must not cut them, and
+ * once the loop is back it reports the trip and heats again. Last the indoor sensor goes quiet with the loop running.
+ *
+ * usage: interlock_sim [-v]
+ *
+ */
+#define OUTDOOR_MEAN            2.0                                 // C
+#define SETPOINT                20.0                                // C; well above the air, so both stages are on
+#define STEP                    10000                               // us the stall is looked at
+#define SHORT_STALL             (INTERLOCK_LOOP_TIMEOUT * 1000000 / 2)
+#define LONG_STALL              (2 * INTERLOCK_LOOP_TIMEOUT * 1000000)
+#define DEADLINE                (INTERLOCK_LOOP_TIMEOUT * 1000000 + INTERLOCK_TICK * 1000 + STEP)   // us into the stall
+#define RECOVER                 (2 * PID_WINDOW)                    // s to heat again
+
+static PLANT        m_Plant;
+static uint32_t     m_Random = 12345;
+static int          m_Quiet;                                        // the indoor sensor does not reply
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static int      heaters(void);
+static uint32_t run(uint32_t seconds);
+static uint64_t stall(uint64_t us);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    unsigned long reaction = 0, trips = 0;
+    uint32_t      warnings;
+    uint64_t      off;
+    
+    if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+        Shim_Verbose(1);
+    }
+    
+    Plant_Initialize(&m_Plant, OUTDOOR_MEAN, SHIM_WALL_CLOCK);
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+    
+    run(5);
+    
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+    
+    CHECK(run(STAGE_2_TIME + 600) > 0);
+    CHECK_EQUAL(heaters(), 2);
+    
+    // a short stall is ridden out
+    warnings = Shim_Stats.warnings;
+    
+    CHECK_EQUAL(stall(SHORT_STALL), 0);
+    CHECK_EQUAL(heaters(), 2);
+    
+    run(60);
+    
+    CHECK_EQUAL(Shim_Stats.warnings, warnings);
+    
+    // a long one is not
+    off = stall(LONG_STALL);
+    
+    printf("interlock_sim: stalled with the heaters on; off after %.3f s\n", off / 1e6);
+    
+    CHECK(off > SHORT_STALL && off <= DEADLINE);
+    CHECK_EQUAL(heaters(), 0);
+    CHECK(Shim_Output(GPIO_FAN) == FAN_ON);                         // the fan clears the heat
+    
+    // back in the loop: told about, and heating again
+    CHECK(run(RECOVER) > 0);
+    CHECK(sscanf(Shim_Stats.lastWarning, "Interlock: loop; relays driven after %lu us, %lu trips", 
+                 &reaction, &trips) == 2);
+    
+    printf("interlock_sim: %s\n", Shim_Stats.lastWarning);
+    
+    CHECK(reaction <= INTERLOCK_TICK * 1000);
+    CHECK_EQUAL(trips, 1);
+    CHECK(heaters() > 0);
+    
+    // the sensor goes quiet: runPid() turns the heaters off, or else the interlock
+    m_Quiet = 1;
+    
+    off = run(INTERLOCK_STALE_TIMEOUT + 60);
+    
+    printf("interlock_sim: indoor sensor quiet; heaters off after %u s\n", off);
+    
+    CHECK(off > 0 && off <= INTERLOCK_STALE_TIMEOUT);
+    CHECK_EQUAL(heaters(), 0);
+    CHECK_EQUAL(Shim_Stats.restarts, 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a reading of the plant with a tenth of noise
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 0: no reply
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    double t = (gpio == GPIO_DHT1) ? m_Plant.air      : m_Plant.outdoor;
+    double h = (gpio == GPIO_DHT1) ? m_Plant.humidity : Plant_OutdoorHumidity(&m_Plant);
+    
+    if(gpio == GPIO_DHT1 && m_Quiet) {
+        return 0;
+    }
+    
+    *temperature = (int16_t) lround(t * 10) + (int) (random32() % 3) - 1;
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * 
+ * @return stages on
+ */
+static int heaters(void)
+{
+    return (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+}
+/**
+ * the firmware and the plant, a second at a time
+ * 
+ * @param seconds
+ * @return the last second the heaters went on or off in, 0 if they did not
+ */
+static uint32_t run(uint32_t seconds)
+{
+    uint32_t s, changed = 0;
+    int      was = heaters();
+    
+    for(s = 1; s <= seconds; s++) {
+        Shim_Run(1000000);
+        
+        if(heaters() != was) {
+            was     = heaters();
+            changed = s;
+        }
+        
+        Plant_Step(&m_Plant, 1.0, was, Shim_Output(GPIO_FAN) == FAN_ON);
+    }
+    
+    return changed;
+}
+/**
+ * the main loop is stuck; the plant goes on
+ * 
+ * @param us
+ * @return us into the stall the heaters went off, 0 if they did not
+ */
+static uint64_t stall(uint64_t us)
+{
+    uint64_t t, off = 0;
+    
+    for(t = STEP; t <= us; t += STEP) {
+        Shim_Stall(STEP);
+        
+        if(off == 0 && heaters() == 0) {
+            off = t;
+        }
+        
+        Plant_Step(&m_Plant, STEP / 1e6, heaters(), Shim_Output(GPIO_FAN) == FAN_ON);
+    }
+    
+    return off;
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
@@ -0,0 +1,173 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <string.h>
+#include "../user_config.h"
+#include "../latency.h"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Latency: known durations - simulated time, so exact - into the histograms, through the measuring macros as the
+ * firmware uses them; the percentiles are the upper bound of their bucket, never more than the longest seen, and the
+ * summary is in us. On the host the cycle counter is system_get_time() * 80, which wraps every 53.7 s.
+ *
+ */
+#define MHZ                     80
+#define WRAP                    (0x100000000ULL / MHZ)              // us the cycle counter wraps at
+
+static LATENCY  m_Outer;
+static LATENCY  m_Inner;
+static uint32_t m_InnerCycles;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     outer(uint32_t us, uint32_t innerUs);
+static void     wait(uint32_t us);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    LATENCY  h;
+    char     buffer[128];
+    uint32_t i;
+    
+    // empty
+    Latency_Initialize(&h, "events");
+    
+    Latency_Format(&h, buffer);
+    CHECK(strcmp(buffer, "events: n=0") == 0);
+    
+    // 98 short ones and 2 long ones, through the macro
+    for(i = 0; i < 100; i++) {
+        LATENCY_MEASURE(&h, wait((i < 98) ? 100 : 10000));
+    }
+    
+    CHECK_EQUAL(h.count, 100);
+    CHECK_EQUAL(h.min, 100 * MHZ);
+    CHECK_EQUAL(h.max, 10000 * MHZ);
+    CHECK_EQUAL(h.bucket[12], 98);                                  // 8000 cycles: 4096 .. 8191
+    CHECK_EQUAL(h.bucket[19], 2);                                   // 800000: 524288 .. 1048575
+    
+    CHECK_EQUAL(Latency_Percentile(&h, 50), 8191);                  // the top of the bucket
+    CHECK_EQUAL(Latency_Percentile(&h, 98), 8191);
+    CHECK_EQUAL(Latency_Percentile(&h, 99), 10000 * MHZ);           // not 1048575: none was that long
+    CHECK_EQUAL(Latency_Percentile(&h, 100), 10000 * MHZ);
+    CHECK_EQUAL(Latency_Percentile(&h, 0), 8191);
+    
+    Latency_Format(&h, buffer);
+    printf("latency_test: %s\n", buffer);
+    CHECK(strcmp(buffer, "events: n=100 min=100 max=10000 p50<=102 p99<=10000 us") == 0);
+    
+    // a short one above the rest in its bucket is its own bound
+    Latency_Reset(&h);
+    
+    Latency_Add(&h, 5000);
+    Latency_Add(&h, 6000);
+    
+    CHECK_EQUAL(Latency_Percentile(&h, 50), 6000);
+    
+    // zero and beyond the last bucket
+    Latency_Reset(&h);
+    
+    Latency_Add(&h, 0);
+    Latency_Add(&h, 0xffffffff);
+    
+    CHECK_EQUAL(h.bucket[0], 1);
+    CHECK_EQUAL(h.bucket[LATENCY_BUCKETS - 1], 1);
+    CHECK_EQUAL(Latency_Percentile(&h, 50), 1);
+    CHECK_EQUAL(Latency_Percentile(&h, 99), 0xffffffff);
+    
+    // a callback: its time goes to its own histogram, not to the one around it as well
+    Latency_Initialize(&m_Outer, "outer");
+    Latency_Initialize(&m_Inner, "inner");
+    
+    for(i = 0; i < 10; i++) {
+        LATENCY_MEASURE_OUTER(&m_Outer, m_InnerCycles, outer(300, (i % 2) ? 200 : 0));
+    }
+    
+    CHECK_EQUAL(m_Outer.count, 10);
+    CHECK_EQUAL(m_Outer.min, 300 * MHZ);
+    CHECK_EQUAL(m_Outer.max, 300 * MHZ);
+    CHECK_EQUAL(m_Inner.count, 10);
+    CHECK_EQUAL(m_Inner.min, 0);
+    CHECK_EQUAL(m_Inner.max, 200 * MHZ);
+    CHECK_EQUAL(Latency_Percentile(&m_Inner, 50), 1);               // half took no time
+    CHECK_EQUAL(Latency_Percentile(&m_Inner, 60), 200 * MHZ);
+    
+    // across the wrap of the cycle counter
+    Latency_Reset(&h);
+    
+    Shim_Run(WRAP - Shim_Time() - 500);
+    
+    LATENCY_MEASURE(&h, wait(1000));
+    
+    CHECK(Shim_Time() > WRAP);
+    CHECK_EQUAL(h.count, 1);
+    CHECK_EQUAL(h.max, 1000 * MHZ);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a stage that takes 'us' of its own and calls back into one that takes 'innerUs'
+ * 
+ * @param us
+ * @param innerUs
+ */
+static void outer(uint32_t us, uint32_t innerUs)
+{
+    wait(us / 2);
+    
+    LATENCY_MEASURE_INNER(&m_Inner, m_InnerCycles, wait(innerUs));
+    
+    wait(us - us / 2);
+}
+/**
+ * 
+ * @param us    of simulated time
+ */
+static void wait(uint32_t us)
+{
+    Shim_Run(us);
+}
@@ -0,0 +1,217 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <time.h>
+#include "../log.h"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Log: lines go out whole and in order; with the terminal held the ring takes what fits, drops the rest - never half a
+ * line - and says so once it drains; disabled levels cost nothing, not even their arguments. Last the cost of a
+ * call, flowing and dropping, on this host.
+ *
+ */
+#define LINES                   100
+#define BENCH_CALLS             200000
+#define PAYLOAD                 "{\"setpoint\":21.5}"
+
+static char     m_Expected[SHIM_SERIAL_SIZE];
+static int      m_Evaluated;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     bench(void);
+static int      evaluate(void);
+static double   now(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    char        line[64];
+    char        longLine[2 * LOG_LINE_MAX];
+    const char* serial;
+    uint32_t    accepted = 0, refused = 0;
+    int         i, n, len = 0;
+    
+    Log_Initialize();
+    
+    // in order and whole
+    for(i = 0; i < LINES; i++) {
+        CHECK_EQUAL(LOG_INFO("line %d of %d: %s\n", i, LINES, PAYLOAD), 1);
+        
+        len += sprintf(m_Expected + len, "line %d of %d: %s\n", i, LINES, PAYLOAD);
+        
+        if(i % 7 == 0) {
+            Shim_Run(1000);
+        }
+    }
+    
+    Shim_Run(1000);
+    
+    CHECK(strcmp(Shim_Serial(), m_Expected) == 0);
+    CHECK_EQUAL(Log_Dropped(), 0);
+    
+    // too long: cut
+    memset(longLine, 'x', sizeof(longLine) - 1);
+    longLine[sizeof(longLine) - 1] = '\0';
+    
+    CHECK_EQUAL(LOG_WARNING("%s\n", longLine), 1);
+    
+    Shim_Run(1000);
+    
+    serial = Shim_Serial();
+    
+    CHECK_EQUAL(strlen(serial), LOG_LINE_MAX - 1);
+    CHECK(strspn(serial, "x") == LOG_LINE_MAX - 1);
+    
+    // held: the ring fills with whole lines
+    Shim_SerialHold(true);
+    
+    len = 0;
+    
+    for(i = 0; i < LOG_RING_SIZE / 8; i++) {
+        n = sprintf(line, "held %03d\n", i);
+        
+        if(LOG_ERROR("held %03d\n", i)) {
+            len += sprintf(m_Expected + len, "%s", line);
+            accepted++;
+        } else {
+            refused++;
+        }
+    }
+    
+    CHECK_EQUAL(accepted, LOG_RING_SIZE / n);
+    CHECK_EQUAL(Log_Dropped(), refused);
+    CHECK_EQUAL(strlen(Shim_Serial()), 0);
+    
+    Shim_Run(1000);
+    Shim_SerialHold(false);
+    Shim_Run(1000);
+    
+    CHECK(strcmp(Shim_Serial(), m_Expected) == 0);
+    
+    // the next line tells about the loss
+    CHECK_EQUAL(LOG_INFO("after\n"), 1);
+    
+    Shim_Run(1000);
+    
+    sprintf(m_Expected, "log: %u messages dropped\nafter\n", refused);
+    
+    CHECK(strcmp(Shim_Serial(), m_Expected) == 0);
+    
+    // said once
+    CHECK_EQUAL(LOG_INFO("again\n"), 1);
+    
+    Shim_Run(1000);
+    
+    CHECK(strcmp(Shim_Serial(), "again\n") == 0);
+    
+    // above LOG_LEVEL: nothing at all
+    LOG_DEBUG("never %d\n", evaluate());
+    
+    Shim_Run(1000);
+    
+    CHECK_EQUAL(m_Evaluated, 0);
+    CHECK_EQUAL(strlen(Shim_Serial()), 0);
+    
+    bench();
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * the payload trace of onCommandCallback() over and over; reported, not checked
+ */
+static void bench(void)
+{
+    double t;
+    int    i, q = 0;
+    
+    t = now();
+    
+    for(i = 0; i < BENCH_CALLS; i++) {
+        q += LOG_INFO("onCommandCallback(): payload           = %s\n", PAYLOAD);
+        
+        if(i % 16 == 0) {
+            Shim_Run(100);
+            Shim_Serial();
+        }
+    }
+    
+    printf("log_test: flowing  %.0f ns per call, %d queued\n", (now() - t) / BENCH_CALLS, q);
+    
+    Shim_SerialHold(true);
+    
+    q = 0;
+    t = now();
+    
+    for(i = 0; i < BENCH_CALLS; i++) {
+        q += LOG_INFO("onCommandCallback(): payload           = %s\n", PAYLOAD);
+    }
+    
+    printf("log_test: held     %.0f ns per call, %d queued\n", (now() - t) / BENCH_CALLS, q);
+    
+    Shim_SerialHold(false);
+}
+/**
+ * 
+ * @return 
+ */
+static int evaluate(void)
+{
+    return ++m_Evaluated;
+}
+/**
+ * 
+ * @return ns
+ */
+static double now(void)
+{
+    struct timespec t;
+    
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
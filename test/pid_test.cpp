@@ -0,0 +1,363 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <math.h>
+#include <time.h>
+#include "../pid_fixed.hpp"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * PIDFixed against the double arithmetic of the Arduino PID library it replaces: both get the same readings of a
+ * room, for thousands of samples, and must agree to well below what a relay can resolve
+ *
+ */
+#define SAMPLE_TIME             60000                               // ms
+#define OUTPUT_MAX              30
+#define MAX_DIFFERENCE          0.05                                // output units; 1.5 s of the 10 minute window
+#define STEPS                   5000
+#define TRACE                   100000                              // samples the two are timed on
+#define ONE_TENTH               1                                   // output tenths they may differ by
+#define BENCH_KP                1.0                                 // mild enough to stay off the limits mostly
+#define BENCH_KI                0.001
+#define BENCH_KD                10.0
+
+typedef PIDFixed<16> Pid;
+
+//
+// the library's Compute(), with its SetSampleTime() scaling and clamping
+//
+class PidDouble
+{
+public:
+    PidDouble(double kp, double ki, double kd, double min, double max, int direction) :
+        m_Kp(kp), m_Ki(ki * SAMPLE_TIME / 1000), m_Kd(kd / (SAMPLE_TIME / 1000)), m_Min(min), m_Max(max),
+        m_ITerm(0), m_LastInput(0), m_Output(0)
+    {
+        if(direction == REVERSE) {
+            m_Kp = -m_Kp;
+            m_Ki = -m_Ki;
+            m_Kd = -m_Kd;
+        }
+    }
+    
+    void Start(double input)
+    {
+        m_LastInput = input;
+        m_ITerm     = clamp(m_Output);
+    }
+    
+    double Compute(double input, double setpoint)
+    {
+        double error = setpoint - input;
+        
+        m_ITerm     = clamp(m_ITerm + m_Ki * error);
+        m_Output    = clamp(m_Kp * error + m_ITerm - m_Kd * (input - m_LastInput));
+        m_LastInput = input;
+        
+        return m_Output;
+    }
+    
+private:
+    double clamp(double v) const    { return (v > m_Max) ? m_Max : (v < m_Min) ? m_Min : v; }
+    
+    double  m_Kp, m_Ki, m_Kd;
+    double  m_Min, m_Max;
+    double  m_ITerm;
+    double  m_LastInput;
+    double  m_Output;
+};
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static double run(double kp, double ki, double kd, int direction);
+static double step(double ki, double kd, uint32_t gap, int32_t dTenths);
+static bool   near(double a, double b);
+static void   bench(void);
+static double now(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    double worst;
+    
+    // conversions
+    CHECK_EQUAL(Pid::fromTenths(215), Pid::fromDouble(21.5));
+    CHECK_EQUAL(Pid::toTenths(Pid::fromTenths(-123)), -123);
+    CHECK_EQUAL(Pid::toTenths(Pid::fromDouble(9.0)), 90);
+    CHECK_EQUAL(Pid::mul(Pid::fromInt(3), Pid::fromDouble(0.5)), Pid::fromDouble(1.5));
+    CHECK(fabs(Pid::toDouble(Pid::fromDouble(-0.1)) + 0.1) < 1.0 / Pid::ONE);
+    
+    // a gain beyond Q15.16, as an autotune on a slow plant can ask for, is as large as it gets - not wrapped negative
+    // and refused; set before the sample time it still scales right
+    CHECK_EQUAL(Pid::fromDouble(40000.0), Pid::MAX);
+    CHECK_EQUAL(Pid::fromDouble(-40000.0), -Pid::MAX);
+    CHECK(near(step(0, 40000.0, SAMPLE_TIME, -1), -32768.0 / 60 * 0.1));
+    
+    // the gains in use and some rough ones
+    worst = run(2, 5, 1, DIRECT);
+    printf("max. difference %.5f\n", worst);
+    CHECK(worst < MAX_DIFFERENCE);
+    
+    CHECK(run(0.5, 0.02, 0, DIRECT) < MAX_DIFFERENCE);
+    CHECK(run(8, 0.5, 30, DIRECT)   < MAX_DIFFERENCE);
+    CHECK(run(2, 5, 1, REVERSE)     < MAX_DIFFERENCE);
+    
+    // Compute(timestamp): I scales with the time since the last sample, up to twice the sample time; D with its
+    // inverse, down to half the sample time - a sensor retry does not blow up the noise
+    CHECK(near(step(0.1, 0, SAMPLE_TIME,     10),   0.1 * 60));
+    CHECK(near(step(0.1, 0, SAMPLE_TIME / 2, 10),   0.1 * 30));
+    CHECK(near(step(0.1, 0, SAMPLE_TIME * 5, 10),   0.1 * 120));
+    CHECK(near(step(0, 60, SAMPLE_TIME,      -10), -1.0));
+    CHECK(near(step(0, 60, SAMPLE_TIME / 2,  -10), -2.0));
+    CHECK(near(step(0, 60, SAMPLE_TIME / 30, -10), -2.0));
+    
+    bench();
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param kp
+ * @param ki
+ * @param kd
+ * @param direction
+ * @return the largest difference in output
+ */
+static double run(double kp, double ki, double kd, int direction)
+{
+    PidDouble   d(kp, ki, kd, 0, OUTPUT_MAX, direction);
+    Pid         p = Pid();                                      // zeroed; init() leaves the gains alone on a negative one
+    double      room  = 5.0;
+    double      worst = 0;
+    int         i;
+    
+    p.init(Pid::fromDouble(kp), Pid::fromDouble(ki), Pid::fromDouble(kd), direction);
+    p.SetSampleTime(SAMPLE_TIME);
+    p.SetOutputLimits(0, Pid::fromInt(OUTPUT_MAX));
+    p.Setpoint(Pid::fromDouble(9.0));
+    p.Input(Pid::fromTenths(50));
+    p.SetMode(AUTOMATIC);
+    
+    d.Start(5.0);
+    
+    for(i = 0; i < STEPS; i++) {
+        double  setpoint = (i / 500) % 2 ? 12.0 : 9.0;              // a step now and then
+        int32_t tenths   = (int32_t) lround(room * 10);
+        double  diff;
+        
+        Shim_Run(SAMPLE_TIME * 1000ULL);
+        
+        p.Setpoint(Pid::fromDouble(setpoint));
+        p.Input(Pid::fromTenths(tenths));
+        
+        CHECK(p.Compute());
+        
+        diff = fabs(Pid::toDouble(p.Output()) - d.Compute(tenths / 10.0, setpoint));
+        
+        if(diff > worst) {
+            worst = diff;
+        }
+        
+        // the fixed-point one steers the room; both see the same readings
+        room += 0.02 * (Pid::toDouble(p.Output()) - 10) * ((direction == DIRECT) ? 1 : -1) + 0.05 * sin(i * 0.1);
+    }
+    
+    return worst;
+}
+/**
+ * one sample 'gap' ms after the first; with Ki the setpoint moves 'dTenths', with Kd the reading moves the other way
+ * 
+ * @param ki
+ * @param kd
+ * @param gap       ms
+ * @param dTenths
+ * @return the output
+ */
+static double step(double ki, double kd, uint32_t gap, int32_t dTenths)
+{
+    Pid      p = Pid();
+    uint32_t t = 1000000;
+    
+    p.init(0, Pid::fromDouble(ki), Pid::fromDouble(kd), DIRECT);
+    p.SetSampleTime(SAMPLE_TIME);
+    p.SetOutputLimits(-Pid::fromInt(1000), Pid::fromInt(1000));
+    p.Setpoint(Pid::fromTenths(200));
+    p.Input(Pid::fromTenths(200));
+    p.SetMode(AUTOMATIC);
+    
+    p.Compute(t);
+    
+    p.Setpoint(Pid::fromTenths(200 + dTenths));
+    p.Input(Pid::fromTenths(200 - ((kd != 0) ? dTenths : 0)));
+    
+    CHECK(p.Compute(t + gap * 1000));
+    
+    return Pid::toDouble(p.Output());
+}
+/**
+ * 
+ * @param a
+ * @param b
+ * @return true if within the 1% the gains' fixed-point rounding leaves
+ */
+static bool near(double a, double b)
+{
+    return fabs(a - b) <= 0.01 * fabs(b);
+}
+/**
+ * both Compute()s on one trace of readings - a slow swing, noise and setpoint steps - with the same rounded gains:
+ * they agree to a tenth of the output at every sample; what each costs is reported, not checked - this host has an
+ * FPU, the ESP8266 does not
+ */
+static void bench(void)
+{
+    static int32_t  trace[TRACE];
+    Pid             p = Pid();
+    Pid             q = Pid();
+    PidDouble       d(Pid::toDouble(Pid::fromDouble(BENCH_KP)), Pid::toDouble(Pid::fromDouble(BENCH_KI)), 
+                      Pid::toDouble(Pid::fromDouble(BENCH_KD)), 0, OUTPUT_MAX, DIRECT);    // the gains as rounded
+    uint32_t        random = 12345, stamp = 1000000;
+    double          sum = 0, t, tFixed, tStamped, tDouble, tClock;
+    int             i, worst = 0, diff, free = 0;
+    
+    for(i = 0; i < TRACE; i++) {
+        random   = random * 1103515245 + 12345;
+        trace[i] = (int32_t) lround(95 + 5 * sin(i * 0.01)) + (int32_t) ((random >> 8) % 3) - 1;
+    }
+    
+    p.init(Pid::fromDouble(BENCH_KP), Pid::fromDouble(BENCH_KI), Pid::fromDouble(BENCH_KD), DIRECT);
+    p.SetSampleTime(SAMPLE_TIME);
+    p.SetOutputLimits(0, Pid::fromInt(OUTPUT_MAX));
+    p.Input(Pid::fromTenths(trace[0]));
+    p.SetMode(AUTOMATIC);
+    
+    q = p;
+    
+    d.Start(trace[0] / 10.0);
+    
+    // the same results, one sample at a time
+    for(i = 0; i < TRACE; i++) {
+        double setpoint = (i / 2000) % 2 ? 10.0 : 9.0;
+        
+        Shim_Run(SAMPLE_TIME * 1000ULL);
+        
+        p.Setpoint(Pid::fromDouble(setpoint));
+        p.Input(Pid::fromTenths(trace[i]));
+        p.Compute();
+        
+        diff = abs(Pid::toTenths(p.Output()) - (int) lround(d.Compute(trace[i] / 10.0, setpoint) * 10));
+        
+        if(diff > worst) {
+            worst = diff;
+        }
+        
+        if(p.Output() > 0 && p.Output() < Pid::fromInt(OUTPUT_MAX)) {
+            free++;
+        }
+    }
+    
+    printf("pid_test: %d samples, %d off the limits, outputs at most %d tenth%s apart\n", TRACE, free, worst, 
+           (worst == 1) ? "" : "s");
+    
+    CHECK(worst <= ONE_TENTH);
+    CHECK(free >= TRACE / 2);                                       // not just both clamped
+    
+    // and what it takes; Compute() needs the clock moved, which is timed apart and taken off
+    t = now();
+    
+    for(i = 0; i < TRACE; i++) {
+        Shim_Run(SAMPLE_TIME * 1000ULL);
+    }
+    
+    tClock = now() - t;
+    t      = now();
+    
+    for(i = 0; i < TRACE; i++) {
+        Shim_Run(SAMPLE_TIME * 1000ULL);
+        
+        p.Input(Pid::fromTenths(trace[i]));
+        p.Compute();
+        
+        sum += p.Output();
+    }
+    
+    tFixed = now() - t - tClock;
+    t      = now();
+    
+    for(i = 0; i < TRACE; i++) {
+        stamp += SAMPLE_TIME * 1000;
+        
+        q.Input(Pid::fromTenths(trace[i]));
+        q.Compute(stamp);
+        
+        sum += q.Output();
+    }
+    
+    tStamped = now() - t;
+    t        = now();
+    
+    for(i = 0; i < TRACE; i++) {
+        sum += d.Compute(trace[i] / 10.0, 9.0);
+    }
+    
+    tDouble = now() - t;
+    
+    printf("pid_test: Compute() %.1f ns, Compute(timestamp) %.1f ns, double %.1f ns a sample\n", 
+           tFixed / TRACE, tStamped / TRACE, tDouble / TRACE);
+    
+    CHECK(sum > 0);                                                 // and the loops are not optimized away
+}
+/**
+ * 
+ * @return ns
+ */
+static double now(void)
+{
+    struct timespec t;
+    
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
@@ -0,0 +1,125 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <math.h>
+#include "plant.h"
+
+#define DAY                     86400.0
+#define PI                      3.14159265358979
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static double outdoor(const PLANT* p);
+static double saturation(double t);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param p
+ * @param mean
+ * @param wall
+ */
+void Plant_Initialize(PLANT* p, double mean, uint32_t wall)
+{
+    p->mean     = mean;
+    p->time     = wall;
+    p->energy   = 0;
+    p->outdoor  = outdoor(p);
+    p->air      = p->outdoor;
+    p->mass     = p->mean;
+    p->humidity = PLANT_OUTDOOR_RH;
+}
+/**
+ * 
+ * @param p
+ * @param dt
+ * @param stages
+ * @param fan
+ */
+void Plant_Step(PLANT* p, double dt, int stages, bool fan)
+{
+    double heat  = stages * PLANT_STAGE_POWER;
+    double share = fan ? PLANT_FAN_SHARE : PLANT_STILL_SHARE;
+    double toAir = PLANT_AIR_MASS * (p->mass - p->air);
+    
+    p->time   += dt;
+    p->energy += heat * dt;
+    p->outdoor = outdoor(p);
+    
+    p->air  += dt * (heat * share + toAir - PLANT_AIR_LOSS * (p->air - p->outdoor)) / PLANT_AIR_CAPACITY;
+    p->mass += dt * (heat * (1 - share) - toAir - PLANT_MASS_LOSS * (p->mass - p->outdoor)) / PLANT_MASS_CAPACITY;
+    
+    p->humidity = PLANT_OUTDOOR_RH * saturation(p->outdoor) / saturation(p->air);
+}
+/**
+ * 
+ * @param p
+ * @return 
+ */
+double Plant_OutdoorHumidity(const PLANT* p)
+{
+    (void) p;
+    
+    return PLANT_OUTDOOR_RH;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * day cycle plus two weather swings of a few days
+ * 
+ * @param p
+ * @return 
+ */
+static double outdoor(const PLANT* p)
+{
+    double day = fmod(p->time, DAY) / DAY;
+    
+    return p->mean - PLANT_DAY_SWING * cos(2 * PI * (day - 3.0 / 24)) 
+                   + 3.0 * sin(2 * PI * p->time / (4.3 * DAY)) 
+                   + 1.5 * sin(2 * PI * p->time / (1.7 * DAY) + 1);
+}
+/**
+ * Magnus formula
+ * 
+ * @param t
+ * @return hPa
+ */
+static double saturation(double t)
+{
+    return 6.112 * exp(17.62 * t / (243.12 + t));
+}
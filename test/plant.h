@@ -0,0 +1,95 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef PLANT_H
+#define PLANT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * workshop thermal model
+ *
+ * Two nodes: the air, which the heaters and the sensor see, and the building mass - walls, floor, benches - which
+ * the air exchanges heat with. Both lose heat to the outdoor air. With the fan off part of the heat goes into the
+ * floor instead of the air. The outdoor temperature follows a day cycle, coldest at 03:00, on top of slow weather
+ * swings; the indoor humidity is the outdoor moisture at the indoor temperature.
+ *
+ */
+#define PLANT_STAGE_POWER           2000.0                          // W per heater stage
+#define PLANT_AIR_CAPACITY          400e3                           // J/K; air and light contents
+#define PLANT_MASS_CAPACITY         8e6                             // J/K
+#define PLANT_AIR_LOSS              50.0                            // W/K air to outdoor
+#define PLANT_MASS_LOSS             33.0                            // W/K mass to outdoor
+#define PLANT_AIR_MASS              400.0                           // W/K air to mass
+#define PLANT_FAN_SHARE             1.0                             // share of the heat into the air, fan on
+#define PLANT_STILL_SHARE           0.7                             // fan off
+#define PLANT_DAY_SWING             4.0                             // C; half the day's range
+#define PLANT_OUTDOOR_RH            85.0                            // %RH
+
+typedef struct {
+    double                  air;                                    // C
+    double                  mass;                                   // C
+    double                  outdoor;                                // C
+    double                  humidity;                               // %RH indoor
+    double                  mean;                                   // C; outdoor average
+    double                  energy;                                 // J into the heaters
+    double                  time;                                   // s; wall clock
+} PLANT;
+
+/**
+ * start in equilibrium with the outdoor air
+ * 
+ * @param p
+ * @param mean      outdoor average
+ * @param wall      wall clock at the start
+ */
+void Plant_Initialize(PLANT* p, double mean, uint32_t wall);
+/**
+ * 
+ * @param p
+ * @param dt        seconds
+ * @param stages    heater stages on
+ * @param fan
+ */
+void Plant_Step(PLANT* p, double dt, int stages, bool fan);
+/**
+ * 
+ * @param p
+ * @return 
+ */
+double Plant_OutdoorHumidity(const PLANT* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLANT_H */
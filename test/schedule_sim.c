@@ -0,0 +1,230 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include "../user_config.h"
+#include "../schedule.h"
+#include "shim.h"
+#include "plant.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * weekly schedule in closed loop
+ *
+ * The firmware gets a working week schedule over MQTT and heats the workshop model by it for a week and a half. The
+ * first week it learns how fast the workshop heats up; in the second the nights must be set back, and the heat-ups
+ * must be there on time - but for a Monday or so: the rate is learned on the air, and after the long setback of a
+ * weekend the building takes it longer.
+ *
+ * usage: schedule_sim [-v]
+ *
+ */
+#define OUTDOOR_MEAN            2.0                                 // C
+#define WORK_WEEK               "1-5 06:30 18; 1-5 16:00 9; 6 08:00 16; 6 13:00 9"
+#define DAYS                    12                                  // from Monday
+#define SCORED                  7                                   // days learning first
+#define NEAR                    0.3                                 // C below the setpoint is there
+
+// bounds
+#define MAX_LATE                (75 * 60)                           // s; after a weekend the building is colder
+#define MIN_EARLY               3                                   // heat-ups there before their start
+#define MAX_NIGHT               12.0                                // C; the air at the end of a setback night
+
+static PLANT        m_Plant;
+static SCHEDULE     m_Schedule;                                     // the same, to know what is due when
+static uint32_t     m_Random = 12345;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static int16_t  scheduled(uint32_t s, int* next);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    uint32_t s, late, reached = 0, pending = 0, starts = 0, early = 0;
+    uint32_t lateMax = 0;
+    int16_t  want, target = 0, was;
+    double   low = 100, lowMax = 0;
+    int      heaters, next;
+    
+    if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+        Shim_Verbose(1);
+    }
+    
+    Schedule_Initialize(&m_Schedule, 0);
+    Schedule_Compile(&m_Schedule, WORK_WEEK, PID_MIN_SETPOINT * 10, PID_MAX_SETPOINT * 10);
+    
+    Plant_Initialize(&m_Plant, OUTDOOR_MEAN, SHIM_WALL_CLOCK);
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+    
+    Shim_Run(5000000);
+    
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+    
+    // a bad one is refused, the good one taken
+    Shim_Command("schedule", "1-5 06:30 18; 1-5 16:00");
+    
+    CHECK(strcmp(Shim_Stats.lastWarning, "Schedule: error in entry 2") == 0);
+    
+    Shim_Command("schedule", WORK_WEEK);
+    
+    CHECK(strcmp(Shim_Stats.lastInfo, "Schedule: 12 transitions") == 0);
+    
+    was = scheduled(0, NULL);
+    
+    for(s = 0; s < DAYS * 86400; s++) {
+        Shim_Run(1000000);
+        
+        heaters = (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+        
+        Plant_Step(&m_Plant, 1.0, heaters, Shim_Output(GPIO_FAN) == FAN_ON);
+        
+        want = scheduled(s, &next);
+        
+        if(want < was) {
+            // setback: how low it gets, and when the pre-start has it back at the next setpoint
+            target  = m_Schedule.t[next].setpoint;
+            low     = m_Plant.air;
+            reached = 0;
+        } else if(want > was) {
+            if(s >= SCORED * 86400) {
+                starts++;
+                
+                if(low > lowMax) {
+                    lowMax = low;
+                }
+                
+                if(reached != 0) {
+                    printf("schedule_sim: day %u, %.1f C from %.1f C, %u s early\n", s / 86400 + 1, want / 10.0, low, 
+                           s - reached);
+                    early++;
+                } else {
+                    pending = s;
+                }
+            }
+            
+            target = 0;
+        }
+        
+        if(target != 0) {
+            if(m_Plant.air < low) {
+                low = m_Plant.air;
+            }
+            
+            if(reached == 0 && low < target / 10.0 - 1 && m_Plant.air >= target / 10.0 - NEAR) {
+                reached = s;
+            }
+        }
+        
+        if(pending != 0 && m_Plant.air >= want / 10.0 - NEAR) {
+            late = s - pending;
+            
+            printf("schedule_sim: day %u, %.1f C from %.1f C, %u s late\n", s / 86400 + 1, want / 10.0, low, late);
+            
+            if(late > lateMax) {
+                lateMax = late;
+            }
+            
+            pending = 0;
+        }
+        
+        was = want;
+    }
+    
+    CHECK_EQUAL(starts, 5);                                         // Monday to Friday of the second week
+    CHECK_EQUAL(pending, 0);
+    CHECK(lateMax <= MAX_LATE);
+    CHECK(early >= MIN_EARLY);
+    CHECK(lowMax <= MAX_NIGHT);
+    CHECK_EQUAL(Shim_Stats.restarts, 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a reading of the plant with a tenth of noise
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    double t = (gpio == GPIO_DHT1) ? m_Plant.air      : m_Plant.outdoor;
+    double h = (gpio == GPIO_DHT1) ? m_Plant.humidity : Plant_OutdoorHumidity(&m_Plant);
+    
+    *temperature = (int16_t) lround(t * 10) + (int) (random32() % 3) - 1;
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * 
+ * @param s     simulated seconds
+ * @param next  if not NULL, gets the index of the next transition
+ * @return setpoint the schedule asks for, 0.1 C
+ */
+static int16_t scheduled(uint32_t s, int* next)
+{
+    uint32_t minute = Schedule_MinuteOfWeek(SHIM_WALL_CLOCK + s, SCHEDULE_UTC_OFFSET, SCHEDULE_DST);
+    
+    return m_Schedule.t[Schedule_Lookup(&m_Schedule, minute, next)].setpoint;
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
@@ -0,0 +1,260 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <time.h>
+#include "../schedule.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Schedule: the hour index against a plain search over every minute of the week, what the parser refuses, the
+ * pre-start lead and what it learns from a heat-up, a save and load through flash, and local time against the C
+ * library's idea of Europe/Copenhagen for a dozen years
+ *
+ */
+#define MIN_SETPOINT            50                                  // 0.1 C
+#define MAX_SETPOINT            250
+#define SECTOR                  0xFA
+#define WORKSHOP                "1-5 06:30 18; 1-5 16:00 9; 6 08:00 16.5; 6 13:00 9; 3 06:30 19"
+#define MINUTE(day, h, m)       (((day) - 1) * 1440 + (h) * 60 + (m))
+
+static SCHEDULE m_Schedule;
+static SCHEDULE m_Loaded;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void lookup(void);
+static void refuse(void);
+static void preStart(void);
+static void flash(void);
+static void localTime(void);
+static int  search(const SCHEDULE* s, uint32_t minute);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    lookup();
+    refuse();
+    preStart();
+    flash();
+    localTime();
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ */
+static void lookup(void)
+{
+    uint32_t minute;
+    int      active, next, bad = 0;
+    
+    Schedule_Initialize(&m_Schedule, 0);
+    
+    CHECK_EQUAL(Schedule_Lookup(&m_Schedule, 0, NULL), -1);
+    CHECK_EQUAL(Schedule_Run(&m_Schedule, 0, 150, 0), SCHEDULE_NONE);
+    
+    // Wednesday 06:30 is given twice; the later entry wins
+    CHECK_EQUAL(Schedule_Compile(&m_Schedule, WORKSHOP, MIN_SETPOINT, MAX_SETPOINT), 12);
+    
+    for(minute = 0; minute < SCHEDULE_WEEK; minute++) {
+        active = Schedule_Lookup(&m_Schedule, minute, &next);
+        
+        bad += (active != search(&m_Schedule, minute) || next != (active + 1) % m_Schedule.count);
+    }
+    
+    CHECK_EQUAL(bad, 0);
+    
+    CHECK_EQUAL(m_Schedule.t[Schedule_Lookup(&m_Schedule, MINUTE(3, 7, 0), NULL)].setpoint, 190);
+    CHECK_EQUAL(m_Schedule.t[Schedule_Lookup(&m_Schedule, MINUTE(6, 9, 0), NULL)].setpoint, 165);
+    CHECK_EQUAL(m_Schedule.t[Schedule_Lookup(&m_Schedule, MINUTE(1, 3, 0), NULL)].setpoint, 90);   // from Saturday
+    
+    CHECK_EQUAL(Schedule_Compile(&m_Schedule, "* 07:00 18;* 17:00 10", MIN_SETPOINT, MAX_SETPOINT), 14);
+}
+/**
+ * a bad schedule is refused as a whole and the one before stays
+ */
+static void refuse(void)
+{
+    const char* bad[] = { "", "8 06:00 18", "1-5 6:3 18", "1-5 06:30", "1-5 06:30 30", "5-1 06:00 18", "1-5 24:00 18", 
+                          "1-5 06:30 18.55", "1-5 06:30 18;x" };
+    char        big[512] = "";
+    uint32_t    i;
+    
+    CHECK_EQUAL(Schedule_Compile(&m_Schedule, WORKSHOP, MIN_SETPOINT, MAX_SETPOINT), 12);
+    
+    for(i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK_EQUAL(Schedule_Compile(&m_Schedule, bad[i], MIN_SETPOINT, MAX_SETPOINT), (i < 8) ? -1 : -2);
+    }
+    
+    // ten a day is more than there is room for
+    for(i = 0; i < 10; i++) {
+        sprintf(big + strlen(big), "* %02u:00 1%u;", i, i);
+    }
+    
+    CHECK(Schedule_Compile(&m_Schedule, big, MIN_SETPOINT, MAX_SETPOINT) < 0);
+    
+    CHECK_EQUAL(m_Schedule.count, 12);
+}
+/**
+ * 
+ */
+static void preStart(void)
+{
+    uint32_t minute;
+    uint32_t start = 0;
+    int16_t  setpoint;
+    
+    Schedule_Initialize(&m_Schedule, 0);
+    Schedule_Compile(&m_Schedule, "1-5 06:30 18; 1-5 16:00 9", MIN_SETPOINT, MAX_SETPOINT);
+    
+    // from 15 C at the default rate: 1.5 h early
+    for(minute = MINUTE(1, 3, 0); minute < MINUTE(1, 7, 0); minute++) {
+        setpoint = Schedule_Run(&m_Schedule, minute, 150, minute * 60);
+        
+        if(setpoint == 180 && start == 0) {
+            start = minute;
+        }
+    }
+    
+    CHECK_EQUAL(start, MINUTE(1, 6, 30) - 30 * 60 / SCHEDULE_HEAT_RATE);
+    
+    // it took an hour: that is what it learns from
+    CHECK_EQUAL(Schedule_Run(&m_Schedule, MINUTE(1, 7, 0), 180, (start + 60) * 60), 180);
+    CHECK_EQUAL(m_Schedule.heatRate, (3 * SCHEDULE_HEAT_RATE + 30 + 2) / 4);
+    
+    // far too cold: never earlier than the longest lead
+    start = 0;
+    
+    for(minute = MINUTE(1, 16, 0); minute < MINUTE(2, 7, 0); minute++) {
+        setpoint = Schedule_Run(&m_Schedule, minute, 60, minute * 60);
+        
+        if(setpoint == 180 && start == 0) {
+            start = minute;
+        }
+    }
+    
+    CHECK_EQUAL(start, MINUTE(2, 6, 30) - SCHEDULE_MAX_LEAD);
+    
+    // warm already: on time; and a fall in the setpoint is never early
+    Schedule_Initialize(&m_Schedule, 0);
+    Schedule_Compile(&m_Schedule, "1-5 06:30 18; 1-5 16:00 9", MIN_SETPOINT, MAX_SETPOINT);
+    
+    CHECK_EQUAL(Schedule_Run(&m_Schedule, MINUTE(1, 6, 29), 185, 0), 90);
+    CHECK_EQUAL(Schedule_Run(&m_Schedule, MINUTE(1, 6, 30), 185, 60), 180);
+    CHECK_EQUAL(Schedule_Run(&m_Schedule, MINUTE(1, 15, 59), 185, 60), 180);
+    CHECK_EQUAL(Schedule_Run(&m_Schedule, MINUTE(1, 16, 0), 185, 120), 90);
+}
+/**
+ * 
+ */
+static void flash(void)
+{
+    Schedule_Initialize(&m_Loaded, 0);
+    
+    CHECK_EQUAL(Schedule_Load(&m_Loaded, SECTOR), 0);               // erased
+    
+    Schedule_Compile(&m_Schedule, WORKSHOP, MIN_SETPOINT, MAX_SETPOINT);
+    
+    CHECK_EQUAL(Schedule_Save(&m_Schedule, SECTOR), 1);
+    CHECK_EQUAL(Schedule_Load(&m_Loaded, SECTOR), 1);
+    CHECK_EQUAL(m_Loaded.count, m_Schedule.count);
+    CHECK(memcmp(m_Loaded.t, m_Schedule.t, m_Schedule.count * sizeof(SCHEDULE_TRANSITION)) == 0);
+    CHECK(memcmp(m_Loaded.next, m_Schedule.next, sizeof(m_Schedule.next)) == 0);
+    
+    // an empty one is the erased sector, as at the first boot
+    Schedule_Clear(&m_Schedule);
+    
+    CHECK_EQUAL(Schedule_Save(&m_Schedule, SECTOR), 1);
+    
+    Schedule_Initialize(&m_Loaded, 0);
+    
+    CHECK_EQUAL(Schedule_Load(&m_Loaded, SECTOR), 0);
+    CHECK_EQUAL(m_Loaded.count, 0);
+}
+/**
+ * every 997 s from 2016 to 2027, which hits both changes each year from all sides
+ */
+static void localTime(void)
+{
+    struct tm* local;
+    time_t     t;
+    uint32_t   utc, want;
+    int        bad = 0;
+    
+    setenv("TZ", "Europe/Copenhagen", 1);
+    tzset();
+    
+    for(utc = 1451606400; utc < 1451606400 + 12U * 366 * 86400; utc += 997) {
+        t     = utc;
+        local = localtime(&t);
+        want  = ((local->tm_wday + 6) % 7) * 1440 + local->tm_hour * 60 + local->tm_min;
+        
+        bad += (Schedule_MinuteOfWeek(utc, 60, 1) != want);
+    }
+    
+    CHECK_EQUAL(bad, 0);
+    
+    CHECK_EQUAL(Schedule_MinuteOfWeek(1451865600, 60, 0), MINUTE(1, 1, 0));       // Monday 2016-01-04 00:00 UTC
+    CHECK_EQUAL(Schedule_MinuteOfWeek(1451865600, 0, 0), MINUTE(1, 0, 0));
+    CHECK_EQUAL(Schedule_MinuteOfWeek(1451865600, -60, 0), MINUTE(7, 23, 0));
+}
+/**
+ * 
+ * @param s
+ * @param minute
+ * @return the last transition at or before 'minute', else the last of the week
+ */
+static int search(const SCHEDULE* s, uint32_t minute)
+{
+    int i, active = s->count - 1;
+    
+    for(i = 0; i < s->count; i++) {
+        if(s->t[i].minute <= minute) {
+            active = i;
+        }
+    }
+    
+    return active;
+}
@@ -0,0 +1,248 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "../scheduler.h"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * Scheduler on the shim's timers and task queue: periods without drift, one-shots, restarts and stops, a job due
+ * before the armed timer, delays longer than the wheel, hours across the wrap of system_get_time(), and no passes
+ * without a job to run
+ *
+ */
+#define TASK_ID                 1
+#define QUEUE_SIZE              2
+#define SLACK                   (1 << SCHEDULER_TICK_SHIFT)         // ms a job may be late
+#define MAX_RUNS                1024
+
+typedef struct {
+    SCHEDULER_JOB           job;
+    uint32_t                runs;
+    uint64_t                at[MAX_RUNS];                           // ms
+} JOB;
+
+static SCHEDULER    m_Scheduler;
+static os_event_t   m_Queue[QUEUE_SIZE];
+static JOB          m_Fast, m_Slow, m_Once, m_Long, m_Stopped;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     task(os_event_t* e);
+static void     ran(void* arg);
+static void     slow(void* arg);
+static void     reset(JOB* j);
+static uint64_t now(void);
+static int      late(const JOB* j, uint64_t first, uint64_t period);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+int main(void)
+{
+    uint64_t start;
+    
+    system_os_task(task, TASK_ID, m_Queue, QUEUE_SIZE);
+    
+    Scheduler_Initialize(&m_Scheduler, TASK_ID);
+    
+    Scheduler_Add(&m_Scheduler, &m_Fast.job,    ran,  &m_Fast,    20);
+    Scheduler_Add(&m_Scheduler, &m_Slow.job,    slow, &m_Slow,    1000);
+    Scheduler_Add(&m_Scheduler, &m_Once.job,    ran,  &m_Once,    0);
+    Scheduler_Add(&m_Scheduler, &m_Long.job,    ran,  &m_Long,    0);
+    Scheduler_Add(&m_Scheduler, &m_Stopped.job, ran,  &m_Stopped, 100);
+    
+    // periods; the slow job starts the one-shot on its third run
+    start = now();
+    
+    Scheduler_Start(&m_Scheduler, &m_Fast.job, 0);
+    Scheduler_Start(&m_Scheduler, &m_Slow.job, 1000);
+    Scheduler_Start(&m_Scheduler, &m_Stopped.job, 0);
+    Scheduler_Stop(&m_Scheduler, &m_Stopped.job);
+    
+    Shim_Run(20000000ULL + 1000);
+    
+    CHECK_EQUAL(m_Fast.runs, 1001);
+    CHECK_EQUAL(m_Slow.runs, 20);
+    CHECK_EQUAL(m_Once.runs, 1);
+    CHECK_EQUAL(m_Stopped.runs, 0);
+    CHECK(late(&m_Fast, start, 20) <= SLACK);
+    CHECK(late(&m_Slow, start + 1000, 1000) <= SLACK);
+    CHECK(m_Once.at[0] >= start + 8000 && m_Once.at[0] - (start + 8000) <= SLACK);
+    
+    // one task pass per deadline, give or take; no polling
+    printf("%u passes, %u idle, %u jobs\n", m_Scheduler.passes, m_Scheduler.idlePasses, m_Scheduler.jobsRun);
+    CHECK(m_Scheduler.passes <= m_Scheduler.jobsRun + m_Scheduler.jobsRun / 10);
+    CHECK_EQUAL(m_Scheduler.postErrors, 0);
+    
+    // a restart moves the deadline instead of adding one
+    Scheduler_Stop(&m_Scheduler, &m_Fast.job);
+    Scheduler_Stop(&m_Scheduler, &m_Slow.job);
+    reset(&m_Once);
+    
+    start = now();
+    
+    Scheduler_Start(&m_Scheduler, &m_Once.job, 500);
+    Scheduler_Start(&m_Scheduler, &m_Once.job, 2000);
+    
+    Shim_Run(3000000);
+    
+    CHECK_EQUAL(m_Once.runs, 1);
+    CHECK(m_Once.at[0] >= start + 2000 && m_Once.at[0] - (start + 2000) <= SLACK);
+    
+    // due before the deadline the timer waits for
+    reset(&m_Once);
+    start = now();
+    
+    Scheduler_Start(&m_Scheduler, &m_Long.job, 10000);
+    Scheduler_Start(&m_Scheduler, &m_Once.job, 1000);
+    
+    Shim_Run(2000000);
+    
+    CHECK_EQUAL(m_Once.runs, 1);
+    CHECK(m_Once.at[0] >= start + 1000 && m_Once.at[0] - (start + 1000) <= SLACK);
+    CHECK_EQUAL(m_Long.runs, 0);
+    
+    Scheduler_Stop(&m_Scheduler, &m_Long.job);
+    
+    // longer than a turn of the wheel, and across the wrap of the us clock (71 minutes)
+    reset(&m_Slow);
+    start = now();
+    
+    Scheduler_Add(&m_Scheduler, &m_Slow.job, ran, &m_Slow, 30 * 60 * 1000);
+    Scheduler_Start(&m_Scheduler, &m_Slow.job, 30 * 60 * 1000);
+    Scheduler_Start(&m_Scheduler, &m_Long.job, 3 * 3600 * 1000);
+    
+    Shim_Run(5 * 3600 * 1000000ULL + 1000);
+    
+    CHECK_EQUAL(m_Slow.runs, 10);
+    CHECK(late(&m_Slow, start + 30 * 60 * 1000, 30 * 60 * 1000) <= SLACK);
+    CHECK_EQUAL(m_Long.runs, 1);
+    CHECK(m_Long.at[0] >= start + 3 * 3600 * 1000 && m_Long.at[0] - (start + 3 * 3600 * 1000) <= SLACK);
+    CHECK(m_Scheduler.passes < 1200);
+    
+    // a wakeup runs a pass right away
+    Scheduler_Stop(&m_Scheduler, &m_Slow.job);
+    
+    start = m_Scheduler.passes;
+    Scheduler_Wakeup(&m_Scheduler);
+    Scheduler_Wakeup(&m_Scheduler);
+    Shim_Run(0);
+    CHECK_EQUAL(m_Scheduler.passes, start + 1);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * 
+ * @param e
+ */
+static void task(os_event_t* e)
+{
+    Scheduler_Run(&m_Scheduler);
+}
+/**
+ * 
+ * @param arg
+ */
+static void ran(void* arg)
+{
+    JOB* j = (JOB*) arg;
+    
+    if(j->runs < MAX_RUNS) {
+        j->at[j->runs] = now();
+    }
+    
+    j->runs++;
+}
+/**
+ * 
+ * @param arg
+ */
+static void slow(void* arg)
+{
+    ran(arg);
+    
+    if(m_Slow.runs == 3) {
+        Scheduler_Start(&m_Scheduler, &m_Once.job, 5000);
+    }
+}
+/**
+ * 
+ * @param j
+ */
+static void reset(JOB* j)
+{
+    j->runs = 0;
+}
+/**
+ * 
+ * @return ms
+ */
+static uint64_t now(void)
+{
+    return Shim_Time() / 1000;
+}
+/**
+ * 
+ * @param j
+ * @param first
+ * @param period
+ * @return the most any run was late, in ms; very much if one was early
+ */
+static int late(const JOB* j, uint64_t first, uint64_t period)
+{
+    uint32_t i;
+    int      worst = 0;
+    
+    for(i = 0; i < j->runs && i < MAX_RUNS; i++) {
+        int64_t d = (int64_t) (j->at[i] - (first + i * period));
+        
+        if(d < 0) {
+            return 0x7fffffff;
+        }
+        if(d > worst) {
+            worst = (int) d;
+        }
+    }
+    
+    return worst;
+}
@@ -0,0 +1,1643 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <ets_sys.h>
+#include <gpio.h>
+#include <spi_flash.h>
+#include <espconn.h>
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/uart.h>
+#include <github.com/mikejac/date_time.esp8266-nonos.cpp/system_time.h>
+#include <github.com/mikejac/timer.esp8266-nonos.cpp/timer.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include <github.com/mikejac/blinker.esp8266-nonos.cpp/blinker.h>
+#include <github.com/mikejac/wifi.esp8266-nonos.cpp/wifi.h>
+#include <github.com/mikejac/upgrader.esp8266-nonos.cpp/upgrader.h>
+#include <github.com/mikejac/raburton.rboot.esp8266-nonos.cpp/appcode/rboot-api.h>
+#include "../flash_str.h"
+#include "shim.h"
+
+/******************************************************************************************************************
+ * registers
+ *
+ */
+#define REG_BASE                0x60000000
+#define REG_SIZE                0x1000
+#define GPIO_BASE               0x300
+#define FRC1_BASE               0x600
+
+#define UART0_FIFO              0x00
+#define UART0_INT_ST            0x08
+#define UART0_INT_ENA           0x0c
+#define UART0_INT_CLR           0x10
+#define UART0_STATUS            0x1c
+#define UART_TXFIFO_EMPTY_INT   BIT(1)
+#define UART_TXFIFO_SIZE        128
+
+#define FRC1_ENABLE_TIMER       BIT(7)
+#define FRC1_AUTO_LOAD          BIT(6)
+#define FRC1_DIVIDER(ctrl)      (((ctrl) & 0x0c) == 0x04 ? 16 : ((ctrl) & 0x0c) == 0x08 ? 256 : 1)
+
+#define PINS                    16
+#define EDGES                   256                                 // pending line changes
+#define PRIOS                   3
+#define EVENTS                  16
+#define DEVICE_EVENTS           64                                  // queued value updates; a larger burst is lost
+#define ISRS                    32
+
+typedef struct {
+    uint64_t                at;
+    uint8_t                 pin;
+    uint8_t                 level;
+} EDGE;
+
+typedef struct {
+    os_task_t               task;
+    os_event_t              event[EVENTS];
+    uint8_t                 len;
+    uint8_t                 head;
+    uint8_t                 count;
+} TASK;
+
+struct Accessory {
+    const char*             name;
+    double                  value;
+    int                     state;
+};
+
+// what a restart leaves, shared with the child processes
+typedef struct {
+    uint8_t                 rtc[SHIM_RTC_SIZE];
+    uint8_t                 flash[SHIM_FLASH_SIZE];
+    uint8_t                 rom;
+} KEPT;
+
+struct Container        { int unused; };
+struct MqttOptions      { const char* nodename; const char* platformId; int bufferSize; };
+struct Mqtt             { MqttOptions* options; OnCommand onCommand; void* ptr; int connected; };
+struct MqttDevice       { Mqtt* mqtt; };
+
+SHIM_STATS Shim_Stats;
+
+// time
+static uint64_t         m_Now;                                      // us since boot
+static uint32_t         m_Wall;                                     // wall clock time at boot
+static uint64_t         m_ChronosAt;                                // us; 0: not synced
+
+// registers and interrupts
+static uint32_t         m_Regs[REG_SIZE / 4];
+static uint32_t         m_EdgeIntEnable;
+static uint32_t         m_Line = 0xffff;                            // input levels; pulled up
+static uint8_t          m_IntrType[PINS];
+static bool             m_Gpio16Enable;
+static bool             m_Gpio16Value;
+static int_handler_t    m_Isr[ISRS];
+static void*            m_IsrArg[ISRS];
+static uint32_t         m_IsrMask;                                  // enabled ones
+static uint64_t         m_Frc1Next;                                 // us; 0: not running
+static bool             m_SerialHold;
+static char             m_Serial[SHIM_SERIAL_SIZE + 1];
+static uint32_t         m_SerialLen;
+static EDGE             m_Edges[EDGES];
+static int              m_EdgeCount;
+static SHIM_DHT         m_Dht;
+
+// OS
+static os_timer_t*      m_Timers;
+static TASK             m_Tasks[PRIOS];
+static init_done_cb_t   m_InitDone;
+static uint8_t          m_Flash[SHIM_FLASH_SIZE];
+static uint8_t          m_Rtc[SHIM_RTC_SIZE];
+static struct rst_info  m_RstInfo;
+static struct station_config m_Station;
+static uint8_t          m_CurrentRom;
+static int              m_Verbose;
+static KEPT*            m_Kept;                                     // by Shim_Restart()
+
+// network
+static bool             m_NetworkUp = true;
+static const char*      m_AccessPoint;                              // the one in range; NULL: associated at once
+static uint64_t         m_AssociatedAt;                             // us
+static Mqtt             m_Mqtt;
+static MqttOptions      m_Options;
+static MqttDevice       m_Device;
+static Device_Message   m_DeviceEvents[DEVICE_EVENTS];
+static uint32_t         m_DeviceHead;
+static uint32_t         m_DeviceTail;
+static Device_Message   m_NoEvent = { NULL, 0, FormatNone, 0 };
+static Accessory*       m_Thermostat;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+extern void user_init(void) __attribute__((weak));             // the unit tests have none
+
+static void     runTasks(void);
+static bool     runNext(uint64_t end, bool tasks);
+static void     serviceUart(void);
+static void     setEnable(uint32_t enable);
+static void     addEdge(uint64_t at, uint8_t pin, uint8_t level);
+static void     lineChange(uint8_t pin, uint8_t level);
+static void     dhtReply(uint8_t pin);
+static void     callIsr(int inum);
+static void     frc1Restart(void);
+static void     timerInsert(os_timer_t* t);
+static bool     timerRemove(os_timer_t* t);
+static int      vformat(char* s, size_t n, const char* format, va_list args);
+static void     say(const char* kind, const char* text);
+static void     powerOn(void) __attribute__((constructor));
+static bool     networkUp(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param wall
+ */
+void Shim_Boot(uint32_t wall)
+{
+    m_Now  = 0;
+    m_Wall = wall;
+    
+    m_RstInfo.reason = REASON_DEFAULT_RST;
+    
+    if(user_init != NULL) {
+        user_init();
+    }
+    
+    if(m_InitDone != NULL) {
+        m_InitDone();
+    }
+}
+/**
+ * 
+ * @param us
+ */
+void Shim_Run(uint64_t us)
+{
+    uint64_t end = m_Now + us;
+    
+    serviceUart();
+    runTasks();
+    
+    while(runNext(end, true)) {
+        runTasks();
+    }
+    
+    m_Now = end;
+}
+/**
+ * 
+ * @param us
+ */
+void Shim_Stall(uint64_t us)
+{
+    uint64_t end = m_Now + us;
+    
+    serviceUart();
+    
+    while(runNext(end, false)) {
+    }
+    
+    m_Now = end;
+}
+/**
+ * 
+ * @return 
+ */
+uint64_t Shim_Time(void)
+{
+    return m_Now;
+}
+/**
+ * 
+ * @param fn
+ */
+void Shim_SetDht(SHIM_DHT fn)
+{
+    m_Dht = fn;
+}
+/**
+ * 
+ * @param gpio
+ * @return 
+ */
+bool Shim_Output(uint8_t gpio)
+{
+    uint32_t enable = m_Regs[(GPIO_BASE + GPIO_ENABLE_ADDRESS) / 4];
+    uint32_t out    = m_Regs[(GPIO_BASE + GPIO_OUT_ADDRESS) / 4];
+    
+    if(gpio == 16) {
+        return m_Gpio16Enable ? m_Gpio16Value : true;
+    }
+    
+    return (enable & BIT(gpio)) ? (out & BIT(gpio)) != 0 : true;
+}
+/**
+ * 
+ * @param up
+ */
+void Shim_Network(bool up)
+{
+    m_NetworkUp = up;
+    
+    if(!up) {
+        m_Mqtt.connected = 0;
+    }
+}
+/**
+ * 
+ * @param ssid
+ */
+void Shim_AccessPoint(const char* ssid)
+{
+    m_AccessPoint = ssid;
+}
+/**
+ * 
+ * @param iid
+ * @param value
+ */
+void Shim_DeviceEvent(long long iid, double value)
+{
+    Device_Message* dm;
+    
+    if(m_DeviceTail - m_DeviceHead >= DEVICE_EVENTS) {
+        return;
+    }
+    
+    dm = &m_DeviceEvents[m_DeviceTail++ % DEVICE_EVENTS];
+    
+    dm->acc    = m_Thermostat;
+    dm->iid    = iid;
+    dm->format = (iid == AccThermostatTargetTemperatureIid) ? FormatFloat : FormatUInt8;
+    dm->value  = value;
+}
+/**
+ * 
+ * @param feedId
+ * @param payload
+ */
+void Shim_Command(const char* feedId, const char* payload)
+{
+    if(m_Mqtt.onCommand != NULL) {
+        m_Mqtt.onCommand(&m_Mqtt, m_Mqtt.ptr, m_Options.nodename, "sim", m_Options.platformId, feedId, payload);
+    }
+}
+/**
+ * 
+ * @param verbose
+ */
+void Shim_Verbose(int verbose)
+{
+    m_Verbose = verbose;
+}
+/**
+ * 
+ * @param hold
+ */
+void Shim_SerialHold(bool hold)
+{
+    m_SerialHold = hold;
+    
+    serviceUart();
+}
+/**
+ * 
+ * @return 
+ */
+const char* Shim_Serial(void)
+{
+    static char serial[SHIM_SERIAL_SIZE + 1];
+    
+    os_memcpy(serial, m_Serial, m_SerialLen);
+    serial[m_SerialLen] = '\0';
+    
+    m_SerialLen = 0;
+    
+    return serial;
+}
+
+/**
+ * 
+ * @param powerLost
+ * @param fn
+ * @param shared
+ * @return 
+ */
+int Shim_Restart(bool powerLost, void (*fn)(void* shared), void* shared)
+{
+    pid_t pid;
+    int   status;
+    
+    if(m_Kept == NULL) {
+        m_Kept = (KEPT*) Shim_Shared(sizeof(KEPT));
+        
+        os_memcpy(m_Kept->flash, m_Flash, SHIM_FLASH_SIZE);
+    }
+    
+    if(powerLost) {
+        os_memset(m_Kept->rtc, 0, SHIM_RTC_SIZE);
+    }
+    
+    fflush(stdout);
+    
+    if((pid = fork()) < 0) {
+        perror("shim: fork");
+        abort();
+    }
+    
+    if(pid == 0) {
+        os_memcpy(m_Rtc, m_Kept->rtc, SHIM_RTC_SIZE);
+        os_memcpy(m_Flash, m_Kept->flash, SHIM_FLASH_SIZE);
+        m_CurrentRom = m_Kept->rom;
+        
+        fn(shared);
+        
+        os_memcpy(m_Kept->rtc, m_Rtc, SHIM_RTC_SIZE);
+        os_memcpy(m_Kept->flash, m_Flash, SHIM_FLASH_SIZE);
+        m_Kept->rom = m_CurrentRom;
+        
+        fflush(stdout);
+        _exit(0);
+    }
+    
+    if(waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    
+    return 0;
+}
+/**
+ * 
+ * @param size
+ * @return 
+ */
+void* Shim_Shared(uint32_t size)
+{
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    
+    if(p == MAP_FAILED) {
+        perror("shim: mmap");
+        abort();
+    }
+    
+    return p;
+}
+
+/******************************************************************************************************************
+ * registers and interrupts
+ *
+ */
+
+/**
+ * 
+ * @param addr
+ * @return 
+ */
+uint32_t Shim_ReadReg(uint32_t addr)
+{
+    uint32_t off = addr - REG_BASE;
+    
+    if(addr == EDGE_INT_ENABLE_REG) {
+        return m_EdgeIntEnable;
+    }
+    
+    if(addr < REG_BASE || off >= REG_SIZE) {
+        fprintf(stderr, "shim: read of register 0x%08x\n", addr);
+        abort();
+    }
+    
+    switch(off) {
+        case UART0_INT_ST:
+            return m_SerialHold ? 0 : m_Regs[UART0_INT_ENA / 4] & UART_TXFIFO_EMPTY_INT;  // drained at once
+        case UART0_STATUS:
+            return m_SerialHold ? UART_TXFIFO_SIZE << UART_TXFIFO_CNT_S : 0;
+        case GPIO_BASE + GPIO_IN_ADDRESS: {
+            uint32_t enable = m_Regs[(GPIO_BASE + GPIO_ENABLE_ADDRESS) / 4];
+            
+            return (m_Regs[(GPIO_BASE + GPIO_OUT_ADDRESS) / 4] & enable) | (m_Line & ~enable);
+        }
+    }
+    
+    return m_Regs[off / 4];
+}
+/**
+ * 
+ * @param addr
+ * @param val
+ */
+void Shim_WriteReg(uint32_t addr, uint32_t val)
+{
+    uint32_t  off = addr - REG_BASE;
+    uint32_t* reg = &m_Regs[off / 4];
+    
+    if(addr == EDGE_INT_ENABLE_REG) {
+        m_EdgeIntEnable = val;
+        return;
+    }
+    
+    if(addr < REG_BASE || off >= REG_SIZE) {
+        fprintf(stderr, "shim: write of register 0x%08x\n", addr);
+        abort();
+    }
+    
+    switch(off) {
+        case UART0_FIFO:
+            if(m_SerialLen < SHIM_SERIAL_SIZE) {
+                m_Serial[m_SerialLen++] = (char) val;
+            }
+            if(m_Verbose) {
+                putchar((int) (val & 0xff));
+            }
+            break;
+        case UART0_INT_CLR:
+            break;
+        case GPIO_BASE + GPIO_OUT_W1TS_ADDRESS:
+            m_Regs[(GPIO_BASE + GPIO_OUT_ADDRESS) / 4] |= val;
+            break;
+        case GPIO_BASE + GPIO_OUT_W1TC_ADDRESS:
+            m_Regs[(GPIO_BASE + GPIO_OUT_ADDRESS) / 4] &= ~val;
+            break;
+        case GPIO_BASE + GPIO_ENABLE_ADDRESS:
+            setEnable(val);
+            break;
+        case GPIO_BASE + GPIO_ENABLE_W1TS_ADDRESS:
+            setEnable(m_Regs[(GPIO_BASE + GPIO_ENABLE_ADDRESS) / 4] | val);
+            break;
+        case GPIO_BASE + GPIO_ENABLE_W1TC_ADDRESS:
+            setEnable(m_Regs[(GPIO_BASE + GPIO_ENABLE_ADDRESS) / 4] & ~val);
+            break;
+        case GPIO_BASE + GPIO_STATUS_W1TS_ADDRESS:
+            m_Regs[(GPIO_BASE + GPIO_STATUS_ADDRESS) / 4] |= val;
+            break;
+        case GPIO_BASE + GPIO_STATUS_W1TC_ADDRESS:
+            m_Regs[(GPIO_BASE + GPIO_STATUS_ADDRESS) / 4] &= ~val;
+            break;
+        case FRC1_BASE + FRC1_LOAD_ADDRESS:
+        case FRC1_BASE + FRC1_CTRL_ADDRESS:
+            *reg = val;
+            frc1Restart();
+            break;
+        default:
+            *reg = val;
+            break;
+    }
+}
+/**
+ * 
+ * @param enable
+ * @param value
+ */
+void Shim_Gpio16(bool enable, bool value)
+{
+    m_Gpio16Enable = enable;
+    m_Gpio16Value  = value;
+}
+/**
+ * 
+ * @return 
+ */
+bool Shim_Gpio16Read(void)
+{
+    return m_Gpio16Enable ? m_Gpio16Value : true;
+}
+/**
+ * 
+ * @param i
+ * @param func
+ * @param arg
+ */
+void ets_isr_attach(int i, int_handler_t func, void* arg)
+{
+    m_Isr[i]    = func;
+    m_IsrArg[i] = arg;
+}
+/**
+ * 
+ * @param intr
+ */
+void ets_isr_mask(unsigned intr)
+{
+    m_IsrMask &= ~intr;
+}
+/**
+ * 
+ * @param intr
+ */
+void ets_isr_unmask(unsigned intr)
+{
+    m_IsrMask |= intr;
+    
+    // an edge that came in while masked
+    if((intr & BIT(ETS_GPIO_INUM)) && m_Regs[(GPIO_BASE + GPIO_STATUS_ADDRESS) / 4] != 0) {
+        callIsr(ETS_GPIO_INUM);
+    }
+}
+void ets_intr_lock(void)    {}
+void ets_intr_unlock(void)  {}
+/**
+ * 
+ * @param i
+ * @param intr_state
+ */
+void gpio_pin_intr_state_set(uint32 i, GPIO_INT_TYPE intr_state)
+{
+    if(i < PINS) {
+        m_IntrType[i] = (uint8_t) intr_state;
+    }
+}
+/**
+ * 
+ * @param set_mask
+ * @param clear_mask
+ * @param enable_mask
+ * @param disable_mask
+ */
+void gpio_output_set(uint32 set_mask, uint32 clear_mask, uint32 enable_mask, uint32 disable_mask)
+{
+    uint32_t* out = &m_Regs[(GPIO_BASE + GPIO_OUT_ADDRESS) / 4];
+    
+    *out = (*out | set_mask) & ~clear_mask;
+    
+    setEnable((m_Regs[(GPIO_BASE + GPIO_ENABLE_ADDRESS) / 4] | enable_mask) & ~disable_mask);
+}
+/**
+ * 
+ * @return 
+ */
+uint32 gpio_input_get(void)
+{
+    return Shim_ReadReg(PERIPHS_GPIO_BASEADDR + GPIO_IN_ADDRESS);
+}
+
+/******************************************************************************************************************
+ * OS
+ *
+ */
+
+/**
+ * 
+ * @return 
+ */
+uint32 system_get_time(void)
+{
+    return (uint32) m_Now;
+}
+uint8  system_get_cpu_freq(void)        { return 80; }
+void   system_soft_wdt_feed(void)       {}
+/**
+ * 
+ * @return 
+ */
+uint32 system_get_free_heap_size(void)
+{
+    return SHIM_HEAP_SIZE - Shim_HeapUsed();
+}
+/**
+ * 
+ * @param task
+ * @param prio
+ * @param queue
+ * @param qlen
+ * @return 
+ */
+bool system_os_task(os_task_t task, uint8 prio, os_event_t* queue, uint8 qlen)
+{
+    if(prio >= PRIOS || qlen == 0) {
+        return false;
+    }
+    
+    m_Tasks[prio].task  = task;
+    m_Tasks[prio].len   = (qlen < EVENTS) ? qlen : EVENTS;
+    m_Tasks[prio].head  = 0;
+    m_Tasks[prio].count = 0;
+    
+    (void) queue;
+    
+    return true;
+}
+/**
+ * 
+ * @param prio
+ * @param sig
+ * @param par
+ * @return 
+ */
+bool system_os_post(uint8 prio, os_signal_t sig, os_param_t par)
+{
+    TASK*       t = &m_Tasks[prio];
+    os_event_t* e;
+    
+    if(prio >= PRIOS || t->task == NULL || t->count >= t->len) {
+        Shim_Stats.postErrors++;
+        return false;
+    }
+    
+    e = &t->event[(t->head + t->count++) % EVENTS];
+    
+    e->sig = sig;
+    e->par = par;
+    
+    return true;
+}
+/**
+ * 
+ * @param cb
+ */
+void system_init_done_cb(init_done_cb_t cb)
+{
+    m_InitDone = cb;
+}
+/**
+ * 
+ * @param src_addr
+ * @param des_addr
+ * @param load_size
+ * @return 
+ */
+bool system_rtc_mem_read(uint8 src_addr, void* des_addr, uint16 load_size)
+{
+    if(src_addr < 64 || src_addr * 4 + load_size > SHIM_RTC_SIZE) {
+        return false;
+    }
+    
+    os_memcpy(des_addr, m_Rtc + src_addr * 4, load_size);
+    
+    return true;
+}
+/**
+ * 
+ * @param des_addr
+ * @param src_addr
+ * @param save_size
+ * @return 
+ */
+bool system_rtc_mem_write(uint8 des_addr, const void* src_addr, uint16 save_size)
+{
+    if(des_addr < 64 || des_addr * 4 + save_size > SHIM_RTC_SIZE) {
+        return false;
+    }
+    
+    os_memcpy(m_Rtc + des_addr * 4, src_addr, save_size);
+    
+    return true;
+}
+/**
+ * 
+ * @return 
+ */
+struct rst_info* system_get_rst_info(void)
+{
+    return &m_RstInfo;
+}
+/**
+ * 
+ */
+void system_restart(void)
+{
+    Shim_Stats.restarts++;
+}
+/**
+ * 
+ * @param t
+ * @param time
+ * @param repeat
+ * @param isMs
+ */
+void ets_timer_arm_new(os_timer_t* t, uint32 time, bool repeat, int isMs)
+{
+    uint32_t us = isMs ? time * 1000 : time;
+    
+    timerRemove(t);
+    
+    t->timer_expire = m_Now + us;
+    t->timer_period = repeat ? us : 0;
+    
+    timerInsert(t);
+}
+/**
+ * 
+ * @param t
+ */
+void ets_timer_disarm(os_timer_t* t)
+{
+    timerRemove(t);
+}
+/**
+ * 
+ * @param t
+ * @param func
+ * @param arg
+ */
+void ets_timer_setfn(os_timer_t* t, os_timer_func_t* func, void* arg)
+{
+    timerRemove(t);
+    
+    t->timer_func = func;
+    t->timer_arg  = arg;
+}
+/**
+ * busy wait; nothing else runs
+ * 
+ * @param us
+ */
+void ets_delay_us(uint32 us)
+{
+    m_Now += us;
+}
+void os_install_putc1(void (*p)(char c))   { (void) p; }
+/**
+ * 
+ * @param format
+ * @return 
+ */
+int os_printf_plus(const char* format, ...)
+{
+    char    buffer[512];
+    va_list args;
+    int     n;
+    
+    va_start(args, format);
+    n = vformat(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    
+    if(m_Verbose) {
+        fputs(buffer, stdout);
+    }
+    
+    return n;
+}
+/**
+ * 
+ * @param str
+ * @param format
+ * @return 
+ */
+int ets_sprintf(char* str, const char* format, ...)
+{
+    va_list args;
+    int     n;
+    
+    va_start(args, format);
+    n = vformat(str, 0x7fffffff, format, args);
+    va_end(args);
+    
+    return n;
+}
+/**
+ * 
+ * @param str
+ * @param size
+ * @param format
+ * @return 
+ */
+int ets_snprintf(char* str, size_t size, const char* format, ...)
+{
+    va_list args;
+    int     n;
+    
+    va_start(args, format);
+    n = vformat(str, size, format, args);
+    va_end(args);
+    
+    return n;
+}
+/**
+ * 
+ * @param s
+ * @param n
+ * @param format
+ * @param arg
+ * @return 
+ */
+int ets_vsnprintf(char* s, size_t n, const char* format, va_list arg)
+{
+    return vformat(s, n, format, arg);
+}
+/******************************************************************************************************************
+ * flash
+ *
+ */
+
+/**
+ * 
+ * @param sec
+ * @return 
+ */
+SpiFlashOpResult spi_flash_erase_sector(uint16 sec)
+{
+    if((uint32_t) (sec + 1) * SPI_FLASH_SEC_SIZE > SHIM_FLASH_SIZE) {
+        return SPI_FLASH_RESULT_ERR;
+    }
+    
+    os_memset(m_Flash + sec * SPI_FLASH_SEC_SIZE, 0xff, SPI_FLASH_SEC_SIZE);
+    
+    return SPI_FLASH_RESULT_OK;
+}
+/**
+ * like the chip, writing can only clear bits
+ * 
+ * @param des_addr
+ * @param src_addr
+ * @param size
+ * @return 
+ */
+SpiFlashOpResult spi_flash_write(uint32 des_addr, uint32* src_addr, uint32 size)
+{
+    const uint8_t* src = (const uint8_t*) src_addr;
+    uint32_t       i;
+    
+    if((des_addr & 3) || (size & 3) || des_addr + size > SHIM_FLASH_SIZE) {
+        return SPI_FLASH_RESULT_ERR;
+    }
+    
+    for(i = 0; i < size; i++) {
+        m_Flash[des_addr + i] &= src[i];
+    }
+    
+    return SPI_FLASH_RESULT_OK;
+}
+/**
+ * 
+ * @param src_addr
+ * @param des_addr
+ * @param size
+ * @return 
+ */
+SpiFlashOpResult spi_flash_read(uint32 src_addr, uint32* des_addr, uint32 size)
+{
+    if((src_addr & 3) || src_addr + size > SHIM_FLASH_SIZE) {
+        return SPI_FLASH_RESULT_ERR;
+    }
+    
+    os_memcpy(des_addr, m_Flash + src_addr, size);
+    
+    return SPI_FLASH_RESULT_OK;
+}
+
+/******************************************************************************************************************
+ * station
+ *
+ */
+
+bool wifi_station_get_config(struct station_config* config)         { *config = m_Station; return true; }
+bool wifi_station_set_config(struct station_config* config)         { m_Station = *config; return true; }
+bool wifi_station_set_config_current(struct station_config* config) { m_Station = *config; return true; }
+uint8 wifi_get_channel(void)                                        { return 6; }
+bool wifi_set_channel(uint8 channel)                                { (void) channel; return true; }
+/**
+ * 
+ * @return 
+ */
+uint8 wifi_station_get_connect_status(void)
+{
+    return networkUp() ? STATION_GOT_IP : STATION_CONNECTING;
+}
+/**
+ * 
+ * @param if_index
+ * @param info
+ * @return 
+ */
+bool wifi_get_ip_info(uint8 if_index, struct ip_info* info)
+{
+    os_memset(info, 0, sizeof(struct ip_info));
+    
+    info->ip.addr = 0x3201a8c0;                                     // 192.168.1.50
+    
+    (void) if_index;
+    
+    return true;
+}
+/**
+ * the list is tried in order: a scan for each access point that is not there, then the one that is
+ * 
+ * @param list
+ */
+void WIFI_InitializeEx(WIFI_AP* list)
+{
+    uint64_t at = m_Now;
+    
+    if(m_AccessPoint == NULL) {
+        m_AssociatedAt = 0;
+        return;
+    }
+    
+    m_AssociatedAt = UINT64_MAX;                                    // none in range
+    
+    for(; list->ssid != NULL; list++) {
+        if(strcmp(list->ssid, m_AccessPoint) != 0) {
+            at += SHIM_WIFI_SCAN * 1000ULL;
+            continue;
+        }
+        
+        m_AssociatedAt = at + SHIM_WIFI_CONNECT * 1000ULL;
+        
+        os_strncpy((char*) m_Station.ssid, list->ssid, sizeof(m_Station.ssid));
+        break;
+    }
+}
+void        WIFI_Run(void)                      {}
+const char* WIFI_GetMAC(void)                   { return SHIM_MAC; }
+bool        WIFI_IsConnected(void)              { return networkUp(); }
+
+sint8  espconn_connect(struct espconn* espconn)                                         { (void) espconn; return ESPCONN_RTE; }
+sint8  espconn_disconnect(struct espconn* espconn)                                      { (void) espconn; return ESPCONN_OK; }
+sint8  espconn_send(struct espconn* espconn, uint8* psent, uint16 length)               { (void) espconn; (void) psent; (void) length; return ESPCONN_RTE; }
+sint8  espconn_regist_connectcb(struct espconn* espconn, espconn_connect_callback cb)   { espconn->proto.tcp->connect_callback = cb; return ESPCONN_OK; }
+sint8  espconn_regist_reconcb(struct espconn* espconn, espconn_reconnect_callback cb)   { espconn->proto.tcp->reconnect_callback = cb; return ESPCONN_OK; }
+sint8  espconn_regist_disconcb(struct espconn* espconn, espconn_connect_callback cb)    { espconn->proto.tcp->disconnect_callback = cb; return ESPCONN_OK; }
+sint8  espconn_regist_recvcb(struct espconn* espconn, espconn_recv_callback cb)         { espconn->recv_callback = cb; return ESPCONN_OK; }
+sint8  espconn_recv_hold(struct espconn* pespconn)                                      { (void) pespconn; return ESPCONN_OK; }
+sint8  espconn_recv_unhold(struct espconn* pespconn)                                    { (void) pespconn; return ESPCONN_OK; }
+uint32 espconn_port(void)                                                               { return 49152; }
+
+/******************************************************************************************************************
+ * sibling libraries
+ *
+ */
+
+void uart_init(UartBautRate uart0_br, UartBautRate uart1_br)        { (void) uart0_br; (void) uart1_br; }
+
+void Blinker_Initialize(BLINKER* b, int gpio)                       { os_memset(b, 0, sizeof(BLINKER)); b->gpio = gpio; }
+void Blinker_Set(BLINKER* b, int on, int off)                       { b->on = on; b->off = off; }
+void Blinker_Enable_on(BLINKER* b)                                  { b->enabled = 1; }
+void Blinker_Run(BLINKER* b)                                        { (void) b; }
+
+/**
+ * 
+ * @param t
+ * @return 
+ */
+esp_time_t esp_uptime(esp_time_t* t)
+{
+    esp_time_t now = (esp_time_t) (m_Now / 1000000);
+    
+    if(t != NULL) {
+        *t = now;
+    }
+    
+    return now;
+}
+/**
+ * 
+ * @param t
+ * @return 
+ */
+esp_time_t esp_time(esp_time_t* t)
+{
+    esp_time_t now = esp_uptime(0);
+    
+    if(m_ChronosAt != 0 && m_Now >= m_ChronosAt) {
+        now += m_Wall;
+    }
+    
+    if(t != NULL) {
+        *t = now;
+    }
+    
+    return now;
+}
+void esp_start_system_time(void)                                    {}
+
+void countdown_ms(Timer* timer, unsigned int timeout)               { timer->end_time = (uint32_t) (m_Now / 1000) + timeout; }
+void countdown(Timer* timer, unsigned int timeout)                  { countdown_ms(timer, timeout * 1000); }
+char expired(Timer* timer)                                          { return left_ms(timer) <= 0; }
+int  left_ms(Timer* timer)                                          { return (int) (timer->end_time - (uint32_t) (m_Now / 1000)); }
+
+rboot_config rboot_get_config(void)
+{
+    rboot_config conf;
+    
+    os_memset(&conf, 0, sizeof(conf));
+    
+    conf.magic       = 0xe1;
+    conf.version     = 0x01;
+    conf.count       = 2;
+    conf.current_rom = m_CurrentRom;
+    conf.roms[0]     = 0x02000;
+    conf.roms[1]     = 0x82000;
+    
+    return conf;
+}
+bool  rboot_set_current_rom(uint8 rom)                              { m_CurrentRom = rom; return rom < 2; }
+uint8 rboot_get_current_rom(void)                                   { return m_CurrentRom; }
+
+void Upgrader_Initialize(UPGRADER* u, Mqtt* mqtt, const char* nodename, const char* pkgId, const uint32_t* version)
+{
+    u->mqtt = mqtt;
+    
+    (void) nodename;
+    (void) pkgId;
+    (void) version;
+}
+bool Upgrader_NewPkg(UPGRADER* u)                                   { (void) u; return false; }
+void Upgrader_Run(UPGRADER* u)                                      { (void) u; }
+void Upgrader_Subscribe_Package(UPGRADER* u)                        { (void) u; }
+void Upgrader_Publish_Package(UPGRADER* u)                          { (void) u; }
+bool Upgrader_Check(UPGRADER* u, const char* nodename, const char* actorId, const char* platformId, const char* feedId, 
+                    const char* payload)
+{
+    (void) u; (void) nodename; (void) actorId; (void) platformId; (void) feedId; (void) payload;
+    
+    return false;
+}
+
+/******************************************************************************************************************
+ * MQTT connector and accessories
+ *
+ */
+
+/**
+ * the containers keep their buffer in the heap - or the arena - like the real one
+ * 
+ * @return 
+ */
+Container* NewContainer(const char* nodename, const char* name, const char* serial, const char* manufacturer, 
+                        const char* model, int bufferSize)
+{
+    (void) nodename; (void) name; (void) serial; (void) manufacturer; (void) model;
+    
+    return (Container*) os_zalloc(bufferSize);
+}
+/**
+ * 
+ * @param name
+ * @return 
+ */
+static Accessory* newAccessory(const char* name)
+{
+    Accessory* a = (Accessory*) os_zalloc(sizeof(Accessory));
+    
+    if(a != NULL) {
+        a->name = name;
+    }
+    
+    return a;
+}
+AccThermometer* NewAccThermometer(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                                  int value, double min, double max, double step)
+{
+    AccThermometer* a = (AccThermometer*) os_zalloc(sizeof(AccThermometer));
+    
+    (void) serial; (void) manufacturer; (void) model; (void) value; (void) min; (void) max; (void) step;
+    
+    a->Accessory = newAccessory(name);
+    
+    return a;
+}
+AccHumidity* NewAccHumidity(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                            int value, double min, double max, double step)
+{
+    AccHumidity* a = (AccHumidity*) os_zalloc(sizeof(AccHumidity));
+    
+    (void) serial; (void) manufacturer; (void) model; (void) value; (void) min; (void) max; (void) step;
+    
+    a->Accessory = newAccessory(name);
+    
+    return a;
+}
+AccThermostat* NewAccThermostat(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                                int value, double min, double max, double step, double target, double targetMin, 
+                                double targetMax, double targetStep)
+{
+    AccThermostat* a = (AccThermostat*) os_zalloc(sizeof(AccThermostat));
+    
+    (void) serial; (void) manufacturer; (void) model; (void) value; (void) min; (void) max; (void) step;
+    (void) targetMin; (void) targetMax; (void) targetStep;
+    
+    a->Accessory        = newAccessory(name);
+    a->Accessory->value = target;
+    
+    m_Thermostat = a->Accessory;
+    
+    return a;
+}
+AccText* NewAccText(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                    const char* value)
+{
+    AccText* a = (AccText*) os_zalloc(sizeof(AccText));
+    
+    (void) serial; (void) manufacturer; (void) model; (void) value;
+    
+    a->Accessory = newAccessory(name);
+    
+    return a;
+}
+void AddAccessory(Container* c, Accessory* a)                       { (void) c; (void) a; }
+
+MqttOptions* NewMqttOptions(void)                                   { os_memset(&m_Options, 0, sizeof(m_Options)); return &m_Options; }
+void MqttOptions_SetServer(MqttOptions* o, const char* server)      { (void) o; (void) server; }
+void MqttOptions_SetPort(MqttOptions* o, int port)                  { (void) o; (void) port; }
+void MqttOptions_SetClientId(MqttOptions* o, const char* clientId)  { (void) o; (void) clientId; }
+void MqttOptions_SetKeepalive(MqttOptions* o, int keepalive)        { (void) o; (void) keepalive; }
+void MqttOptions_SetRootTopic(MqttOptions* o, const char* topic)    { (void) o; (void) topic; }
+void MqttOptions_SetNodename(MqttOptions* o, const char* nodename)  { o->nodename = nodename; }
+void MqttOptions_SetActorPlatformId(MqttOptions* o, const char* id) { o->platformId = id; }
+void MqttOptions_SetClassType(MqttOptions* o, int classType)        { (void) o; (void) classType; }
+void MqttOptions_SetBufferSize(MqttOptions* o, int size)            { o->bufferSize = size; }
+
+/**
+ * 
+ * @param o
+ * @return 
+ */
+Mqtt* Connector(MqttOptions* o)
+{
+    os_memset(&m_Mqtt, 0, sizeof(m_Mqtt));
+    
+    m_Mqtt.options = o;
+    
+    // the connector's buffer
+    if(os_zalloc(o->bufferSize) == NULL) {
+        return NULL;
+    }
+    
+    return &m_Mqtt;
+}
+void InstallCallbacks(Mqtt* mqtt, void* ptr, OnCommand onCommand)  { mqtt->ptr = ptr; mqtt->onCommand = onCommand; }
+void EnableChronos(Mqtt* mqtt, const char* nodename)                { (void) mqtt; (void) nodename; }
+/**
+ * 
+ * @param mqtt
+ * @return 
+ */
+int ConnectorRun(Mqtt* mqtt)
+{
+    if(networkUp() && !mqtt->connected) {
+        mqtt->connected = 1;
+        
+        if(m_ChronosAt == 0) {
+            m_ChronosAt = m_Now + SHIM_CHRONOS_DELAY * 1000000ULL;
+        }
+        
+        return RUN_CONNECTED;
+    }
+    
+    return RUN_NONE;
+}
+bool IsConnected(Mqtt* mqtt)                                        { return mqtt->connected != 0; }
+bool Close(Mqtt* mqtt)                                              { mqtt->connected = 0; return true; }
+/**
+ * 
+ * @param mqtt
+ * @param text
+ * @return 
+ */
+bool Info(Mqtt* mqtt, const char* text)
+{
+    if(mqtt == NULL || !mqtt->connected) {
+        return false;
+    }
+    
+    Shim_Stats.infos++;
+    
+    FlashStr_Copy(Shim_Stats.lastInfo, text, sizeof(Shim_Stats.lastInfo));
+    
+    say("info", Shim_Stats.lastInfo);
+    
+    return true;
+}
+/**
+ * 
+ * @param mqtt
+ * @param text
+ */
+void Warning(Mqtt* mqtt, const char* text)
+{
+    Shim_Stats.warnings++;
+    
+    FlashStr_Copy(Shim_Stats.lastWarning, text, sizeof(Shim_Stats.lastWarning));
+    
+    say("warning", Shim_Stats.lastWarning);
+    
+    (void) mqtt;
+}
+
+MqttDevice* NewDevice(Mqtt* mqtt)                                   { m_Device.mqtt = mqtt; return &m_Device; }
+void SetAccessories(MqttDevice* device, Container* c)               { (void) device; (void) c; }
+/**
+ * 
+ * @param device
+ * @return 
+ */
+Device_Message* DeviceGetEvent(MqttDevice* device)
+{
+    (void) device;
+    
+    if(m_DeviceHead == m_DeviceTail || !m_Mqtt.connected) {
+        return &m_NoEvent;
+    }
+    
+    return &m_DeviceEvents[m_DeviceHead % DEVICE_EVENTS];
+}
+CharacteristicFormat DeviceGetEventType(Device_Message* dm)         { return dm->format; }
+/**
+ * 
+ * @param dm
+ */
+void DeviceDeleteEvent(Device_Message* dm)
+{
+    if(dm != &m_NoEvent && m_DeviceHead != m_DeviceTail) {
+        m_DeviceHead++;
+    }
+}
+long long Device_GetAid(Device_Message* dm)                         { (void) dm; return 1; }
+long long Device_GetIid(Device_Message* dm)                         { return dm->iid; }
+bool      Device_GetValueBool(Device_Message* dm)                   { return dm->value != 0; }
+uint8_t   Device_GetValueUInt8(Device_Message* dm)                  { return (uint8_t) dm->value; }
+double    Device_GetValueFloat(Device_Message* dm)                  { return dm->value; }
+
+void AccThermostatCurrentTemperatureSetValue(AccThermostat* a, double value)        { a->Accessory->value = value; }
+void AccThermostatCurrentHeatingCoolingStateSetValue(AccThermostat* a, int value)   { a->Accessory->state = value; }
+void AccThermostatTargetTemperatureSetValue(AccThermostat* a, double value)         { (void) a; (void) value; }
+void AccThermostatTargetHeatingCoolingStateSetValue(AccThermostat* a, int value)    { (void) a; (void) value; }
+void AccHumidityCurrentRelativeHumiditySetValue(AccHumidity* a, double value)       { a->Accessory->value = value; }
+void AccThermometerCurrentTemperatureSetValue(AccThermometer* a, double value)      { a->Accessory->value = value; }
+void AccTextSetValue(AccText* a, const char* value)                                 { (void) a; (void) value; }
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * the flash comes erased
+ */
+static void powerOn(void)
+{
+    os_memset(m_Flash, 0xff, sizeof(m_Flash));
+}
+
+/**
+ * 
+ */
+static void runTasks(void)
+{
+    int prio;
+    
+    for(;;) {
+        for(prio = PRIOS - 1; prio >= 0 && m_Tasks[prio].count == 0; prio--) {
+        }
+        
+        if(prio < 0) {
+            return;
+        }
+        
+        TASK*      t = &m_Tasks[prio];
+        os_event_t e = t->event[t->head];
+        
+        t->head = (t->head + 1) % EVENTS;
+        t->count--;
+        
+        Shim_Stats.tasks++;
+        
+        t->task(&e);
+        
+        serviceUart();
+    }
+}
+/**
+ * fire whatever is due first, if that is before 'end'
+ * 
+ * @param end
+ * @param tasks     false: the task is stuck; software timers wait
+ * @return false if nothing was due
+ */
+static bool runNext(uint64_t end, bool tasks)
+{
+    uint64_t    next = end + 1;
+    int         what = 0;
+    os_timer_t* t;
+    
+    if(tasks && m_Timers != NULL && m_Timers->timer_expire < next) {
+        next = m_Timers->timer_expire;
+        what = 1;
+    }
+    if(m_EdgeCount > 0 && m_Edges[0].at < next) {
+        next = m_Edges[0].at;
+        what = 2;
+    }
+    if(m_Frc1Next != 0 && m_Frc1Next < next) {
+        next = m_Frc1Next;
+        what = 3;
+    }
+    
+    if(what == 0) {
+        return false;
+    }
+    
+    if(next > m_Now) {
+        m_Now = next;
+    }
+    
+    switch(what) {
+        case 1:
+            t        = m_Timers;
+            m_Timers = t->timer_next;
+            
+            if(t->timer_period > 0) {
+                t->timer_expire += t->timer_period;
+                timerInsert(t);
+            }
+            
+            Shim_Stats.timers++;
+            
+            t->timer_func(t->timer_arg);
+            break;
+            
+        case 2: {
+            EDGE e = m_Edges[0];
+            
+            m_EdgeCount--;
+            os_memmove(&m_Edges[0], &m_Edges[1], m_EdgeCount * sizeof(EDGE));
+            
+            lineChange(e.pin, e.level);
+            break;
+        }
+        
+        case 3: {
+            uint32_t ctrl = m_Regs[(FRC1_BASE + FRC1_CTRL_ADDRESS) / 4];
+            
+            if(ctrl & FRC1_AUTO_LOAD) {
+                frc1Restart();
+            } else {
+                m_Frc1Next = 0;
+            }
+            
+            m_Regs[(FRC1_BASE + FRC1_INT_ADDRESS) / 4] |= 1;
+            
+            if(m_EdgeIntEnable & BIT(1)) {
+                callIsr(ETS_FRC_TIMER1_INUM);
+            }
+            break;
+        }
+    }
+    
+    serviceUart();
+    
+    return true;
+}
+/**
+ * the UART interrupt asks for more as long as it is enabled and not held - the FIFO drains at once
+ */
+static void serviceUart(void)
+{
+    int n;
+    
+    for(n = 0; n < 64 && !m_SerialHold && (m_Regs[UART0_INT_ENA / 4] & UART_TXFIFO_EMPTY_INT); n++) {
+        if(m_Isr[ETS_UART_INUM] == NULL || !(m_IsrMask & BIT(ETS_UART_INUM))) {
+            return;
+        }
+        
+        callIsr(ETS_UART_INUM);
+    }
+}
+/**
+ * a DHT pin that was pulling the line low lets go - the start signal is over and the sensor replies
+ * 
+ * @param enable
+ */
+static void setEnable(uint32_t enable)
+{
+    uint32_t* reg      = &m_Regs[(GPIO_BASE + GPIO_ENABLE_ADDRESS) / 4];
+    uint32_t  released = *reg & ~enable & ~m_Regs[(GPIO_BASE + GPIO_OUT_ADDRESS) / 4];
+    uint8_t   pin;
+    
+    *reg = enable;
+    
+    for(pin = 0; pin < PINS; pin++) {
+        if(released & BIT(pin)) {
+            dhtReply(pin);
+        }
+    }
+}
+/**
+ * 
+ * @param at
+ * @param pin
+ * @param level
+ */
+static void addEdge(uint64_t at, uint8_t pin, uint8_t level)
+{
+    int i;
+    
+    if(m_EdgeCount == EDGES) {
+        return;
+    }
+    
+    for(i = m_EdgeCount; i > 0 && m_Edges[i - 1].at > at; i--) {
+        m_Edges[i] = m_Edges[i - 1];
+    }
+    
+    m_Edges[i].at    = at;
+    m_Edges[i].pin   = pin;
+    m_Edges[i].level = level;
+    
+    m_EdgeCount++;
+}
+/**
+ * 
+ * @param pin
+ * @param level
+ */
+static void lineChange(uint8_t pin, uint8_t level)
+{
+    uint8_t  type = m_IntrType[pin];
+    uint32_t old  = (m_Line >> pin) & 1;
+    
+    if(old == level) {
+        return;
+    }
+    
+    m_Line = (m_Line & ~BIT(pin)) | ((uint32_t) level << pin);
+    
+    if(type == GPIO_PIN_INTR_ANYEDGE || (type == GPIO_PIN_INTR_POSEDGE && level) || (type == GPIO_PIN_INTR_NEGEDGE && !level)) {
+        m_Regs[(GPIO_BASE + GPIO_STATUS_ADDRESS) / 4] |= BIT(pin);
+        
+        callIsr(ETS_GPIO_INUM);
+    }
+}
+/**
+ * DHT22 reply: 20-40 us, 80 us low, 80 us high, then 40 bits of 50 us low and 26 or 70 us high, then 50 us low
+ * 
+ * @param pin
+ */
+static void dhtReply(uint8_t pin)
+{
+    uint64_t at = m_Now;
+    uint8_t  data[5];
+    int16_t  temp, hum;
+    int      i;
+    
+    if(m_Dht == NULL || !m_Dht(pin, &temp, &hum)) {
+        return;
+    }
+    
+    data[0] = (uint8_t) (hum >> 8);
+    data[1] = (uint8_t) hum;
+    data[2] = (uint8_t) (((temp < 0) ? -temp : temp) >> 8) | ((temp < 0) ? 0x80 : 0);
+    data[3] = (uint8_t) ((temp < 0) ? -temp : temp);
+    data[4] = (uint8_t) (data[0] + data[1] + data[2] + data[3]);
+    
+    addEdge(at += 30, pin, 0);
+    addEdge(at += 80, pin, 1);
+    addEdge(at += 80, pin, 0);
+    
+    for(i = 0; i < 40; i++) {
+        addEdge(at += 50, pin, 1);
+        addEdge(at += (data[i / 8] & (0x80 >> (i % 8))) ? 70 : 26, pin, 0);
+    }
+    
+    addEdge(at += 50, pin, 1);
+    
+    Shim_Stats.dhtFrames++;
+}
+/**
+ * 
+ * @param inum
+ */
+static void callIsr(int inum)
+{
+    if(m_Isr[inum] == NULL || !(m_IsrMask & BIT(inum))) {
+        return;
+    }
+    
+    Shim_Stats.isrs++;
+    
+    m_Isr[inum](m_IsrArg[inum]);
+}
+/**
+ * 
+ */
+static void frc1Restart(void)
+{
+    uint32_t ctrl = m_Regs[(FRC1_BASE + FRC1_CTRL_ADDRESS) / 4];
+    uint32_t load = m_Regs[(FRC1_BASE + FRC1_LOAD_ADDRESS) / 4];
+    uint64_t us   = (uint64_t) load * FRC1_DIVIDER(ctrl) / 80;
+    
+    m_Frc1Next = ((ctrl & FRC1_ENABLE_TIMER) && us > 0) ? m_Now + us : 0;
+}
+/**
+ * 
+ * @param t
+ */
+static void timerInsert(os_timer_t* t)
+{
+    os_timer_t** p = &m_Timers;
+    
+    while(*p != NULL && (*p)->timer_expire <= t->timer_expire) {
+        p = &(*p)->timer_next;
+    }
+    
+    t->timer_next = *p;
+    *p            = t;
+}
+/**
+ * 
+ * @param t
+ * @return true if it was armed
+ */
+static bool timerRemove(os_timer_t* t)
+{
+    os_timer_t** p = &m_Timers;
+    
+    while(*p != NULL) {
+        if(*p == t) {
+            *p = t->timer_next;
+            return true;
+        }
+        
+        p = &(*p)->timer_next;
+    }
+    
+    return false;
+}
+/**
+ * vsnprintf() with the chip's long: a single 'l' is dropped, so %lu takes a uint32_t as it does there
+ * 
+ * @param s
+ * @param n
+ * @param format
+ * @param args
+ * @return 
+ */
+static int vformat(char* s, size_t n, const char* format, va_list args)
+{
+    char        fmt[512];
+    char*       d = fmt;
+    const char* p = format;
+    
+    while(*p != '\0' && d < fmt + sizeof(fmt) - 2) {
+        if((*d++ = *p++) != '%') {
+            continue;
+        }
+        
+        while(*p != '\0' && strchr("-+ #0123456789.*", *p) != NULL && d < fmt + sizeof(fmt) - 2) {
+            *d++ = *p++;
+        }
+        
+        if(p[0] == 'l' && p[1] != 'l') {
+            p++;
+        }
+    }
+    
+    *d = '\0';
+    
+    return vsnprintf(s, n, fmt, args);
+}
+/**
+ * 
+ * @param kind
+ * @param text
+ */
+static void say(const char* kind, const char* text)
+{
+    uint32_t s = (uint32_t) (m_Now / 1000000);
+    
+    if(m_Verbose) {
+        printf("[%u.%02u:%02u:%02u] %s: %s\n", s / 86400, (s / 3600) % 24, (s / 60) % 60, s % 60, kind, text);
+    }
+}
+/**
+ * 
+ * @return associated, and the broker reachable
+ */
+static bool networkUp(void)
+{
+    return m_NetworkUp && m_Now >= m_AssociatedAt;
+}
@@ -0,0 +1,185 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef SHIM_H
+#define SHIM_H
+
+#include <github.com/mikejac/misc.esp8266-nonos.cpp/espmissingincludes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************************************************
+ * host shim
+ *
+ * Runs the firmware on a PC against simulated time. The SDK, the sibling libraries and the few peripherals the
+ * firmware touches - GPIO, the FRC1 timer, UART0, flash and RTC memory - are modelled in shim.c. Software timers,
+ * tasks and interrupts fire in the order they would on the chip, but the code between them takes no time, so a
+ * simulated week runs in seconds.
+ *
+ * Only one firmware instance per process: its globals are not reset, so Shim_Boot() is called once. A restart is a
+ * fresh child process, see Shim_Restart().
+ */
+#define SHIM_MAC                    "5ccf7f0a0b0c"                  // our nodename
+#define SHIM_WALL_CLOCK             1451865600                      // Monday 2016-01-04 00:00 UTC
+#define SHIM_CHRONOS_DELAY          2                               // seconds from connect to a synced clock
+#define SHIM_WIFI_SCAN              2500                            // ms to give up on an access point not in range
+#define SHIM_WIFI_CONNECT           3000                            // ms to associate and get an address
+#define SHIM_HEAP_SIZE              (40 * 1024)
+#define SHIM_RTC_SIZE               768                             // bytes of RTC memory, 4 byte blocks
+#define SHIM_SERIAL_SIZE            (64 * 1024)                     // UART0 output kept for Shim_Serial()
+
+/**
+ * DHT22 on a pin
+ * 
+ * @param gpio
+ * @param temperature   0.1 C
+ * @param humidity      0.1 %RH
+ * @return 0 if the sensor does not answer
+ */
+typedef int (*SHIM_DHT)(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+
+typedef struct {
+    uint32_t                infos;                                  // Info() calls
+    uint32_t                warnings;
+    uint32_t                restarts;                               // system_restart() calls
+    uint32_t                dhtFrames;                              // replies sent
+    uint32_t                isrs;                                   // interrupt handler calls
+    uint32_t                timers;                                 // software timer callbacks
+    uint32_t                tasks;                                  // task events run
+    uint32_t                postErrors;                             // task queue full
+    char                    lastInfo[1024];
+    char                    lastWarning[256];
+} SHIM_STATS;
+
+extern SHIM_STATS Shim_Stats;
+
+/**
+ * start the firmware - user_init() and the init done callback; wall clock time starts at 'wall'
+ * 
+ * @param wall
+ */
+void Shim_Boot(uint32_t wall);
+/**
+ * run timers, tasks and interrupts until 'us' more of simulated time has passed
+ * 
+ * @param us
+ */
+void Shim_Run(uint64_t us);
+/**
+ * the task is stuck for 'us' - only interrupts are served
+ * 
+ * @param us
+ */
+void Shim_Stall(uint64_t us);
+/**
+ * 
+ * @return us since boot
+ */
+uint64_t Shim_Time(void);
+/**
+ * 
+ * @param fn
+ */
+void Shim_SetDht(SHIM_DHT fn);
+/**
+ * 
+ * @param gpio
+ * @return level driven on the pin; true if it is not an output
+ */
+bool Shim_Output(uint8_t gpio);
+/**
+ * 
+ * @param up    false: the broker is gone, Info() fails
+ */
+void Shim_Network(bool up);
+/**
+ * only 'ssid' is in range: WIFI_InitializeEx() gets there after SHIM_WIFI_SCAN for each access point before it in
+ * the list, and SHIM_WIFI_CONNECT; by default the network is there at once
+ * 
+ * @param ssid  NULL: the default
+ */
+void Shim_AccessPoint(const char* ssid);
+/**
+ * incoming value update for the thermostat, as from the app
+ * 
+ * @param iid       AccThermostatTargetTemperatureIid or AccThermostatTargetHeatingCoolingStateIid
+ * @param value
+ */
+void Shim_DeviceEvent(long long iid, double value);
+/**
+ * command message addressed to us
+ * 
+ * @param feedId
+ * @param payload
+ */
+void Shim_Command(const char* feedId, const char* payload);
+/**
+ * 
+ * @param verbose   print the UART, Info() and Warning() with a time stamp
+ */
+void Shim_Verbose(int verbose);
+/**
+ * a held UART0 has a full FIFO and no interrupt - a slow or stuck terminal; let go, it drains at once
+ * 
+ * @param hold
+ */
+void Shim_SerialHold(bool hold);
+/**
+ * what went out of UART0 since the last call; output beyond SHIM_SERIAL_SIZE is lost
+ * 
+ * @return NUL terminated
+ */
+const char* Shim_Serial(void);
+/**
+ * 
+ * @return bytes taken from the simulated heap, headers included
+ */
+uint32_t Shim_HeapUsed(void);
+/**
+ * a reset or a power cycle: 'fn' runs in a child process that starts out as this one is - so Shim_Boot() must not
+ * have been called here - with the RTC memory, flash and rBoot slot as the previous Shim_Restart() left them
+ * 
+ * @param powerLost     the RTC memory is gone too
+ * @param fn            boots the firmware and runs it; tells the caller how it went through 'shared'
+ * @param shared        from Shim_Shared()
+ * @return 0 if 'fn' returned, -1 if the child died
+ */
+int Shim_Restart(bool powerLost, void (*fn)(void* shared), void* shared);
+/**
+ * 
+ * @param size
+ * @return zeroed memory the caller and the children of Shim_Restart() all see
+ */
+void* Shim_Shared(uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHIM_H */
@@ -0,0 +1,64 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef C_TYPES_H
+#define C_TYPES_H
+
+/******************************************************************************************************************
+ * host shim: SDK base types
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint8_t                 uint8;
+typedef int8_t                  sint8;
+typedef int8_t                  int8;
+typedef uint16_t                uint16;
+typedef int16_t                 sint16;
+typedef int16_t                 int16;
+typedef uint32_t                uint32;
+typedef int32_t                 sint32;
+typedef int32_t                 int32;
+typedef uint64_t                uint64;
+typedef int64_t                 sint64;
+
+#define ICACHE_FLASH_ATTR
+#define ICACHE_RODATA_ATTR
+#define STORE_ATTR              __attribute__((aligned(4)))
+#define LOCAL                   static
+
+#ifndef __cplusplus
+#define TRUE                    1
+#define FALSE                   0
+#endif
+
+#define BIT(n)                  (1UL << (n))
+#define BIT0                    BIT(0)
+
+#endif /* C_TYPES_H */
@@ -0,0 +1,91 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef EAGLE_SOC_H
+#define EAGLE_SOC_H
+
+#include "c_types.h"
+
+/******************************************************************************************************************
+ * host shim: peripheral registers
+ *
+ * Every register access goes through Shim_ReadReg()/Shim_WriteReg(), which model the GPIO, FRC1 timer and UART0
+ * registers the firmware uses. Any other address stops the simulation.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t Shim_ReadReg(uint32_t addr);
+void     Shim_WriteReg(uint32_t addr, uint32_t val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define READ_PERI_REG(addr)             Shim_ReadReg((uint32_t) (addr))
+#define WRITE_PERI_REG(addr, val)       Shim_WriteReg((uint32_t) (addr), (uint32_t) (val))
+#define CLEAR_PERI_REG_MASK(reg, mask)  WRITE_PERI_REG((reg), (READ_PERI_REG(reg) & (~(mask))))
+#define SET_PERI_REG_MASK(reg, mask)    WRITE_PERI_REG((reg), (READ_PERI_REG(reg) | (mask)))
+
+#define PERIPHS_GPIO_BASEADDR           0x60000300
+#define GPIO_REG_READ(reg)              READ_PERI_REG(PERIPHS_GPIO_BASEADDR + (reg))
+#define GPIO_REG_WRITE(reg, val)        WRITE_PERI_REG(PERIPHS_GPIO_BASEADDR + (reg), val)
+#define GPIO_OUT_ADDRESS                0x00
+#define GPIO_OUT_W1TS_ADDRESS           0x04
+#define GPIO_OUT_W1TC_ADDRESS           0x08
+#define GPIO_ENABLE_ADDRESS             0x0c
+#define GPIO_ENABLE_W1TS_ADDRESS        0x10
+#define GPIO_ENABLE_W1TC_ADDRESS        0x14
+#define GPIO_IN_ADDRESS                 0x18
+#define GPIO_STATUS_ADDRESS             0x1c
+#define GPIO_STATUS_W1TS_ADDRESS        0x20
+#define GPIO_STATUS_W1TC_ADDRESS        0x24
+#define GPIO_ID_PIN0                    0
+#define GPIO_ID_PIN(n)                  (GPIO_ID_PIN0 + (n))
+#define GPIO_PIN_ADDR(i)                (0x28 + (i) * 4)
+
+#define PERIPHS_TIMER_BASEDDR           0x60000600
+#define FRC1_LOAD_ADDRESS               0x00
+#define FRC1_COUNT_ADDRESS              0x04
+#define FRC1_CTRL_ADDRESS               0x08
+#define FRC1_INT_ADDRESS                0x0c
+#define FRC1_INT_CLR_MASK               BIT(0)
+#define RTC_REG_WRITE(addr, val)        WRITE_PERI_REG(PERIPHS_TIMER_BASEDDR + (addr), val)
+#define RTC_REG_READ(addr)              READ_PERI_REG(PERIPHS_TIMER_BASEDDR + (addr))
+#define RTC_CLR_REG_MASK(reg, mask)     CLEAR_PERI_REG_MASK(PERIPHS_TIMER_BASEDDR + (reg), mask)
+
+#define EDGE_INT_ENABLE_REG             0x3ff00004
+#define TM1_EDGE_INT_ENABLE()           SET_PERI_REG_MASK(EDGE_INT_ENABLE_REG, BIT(1))
+#define TM1_EDGE_INT_DISABLE()          CLEAR_PERI_REG_MASK(EDGE_INT_ENABLE_REG, BIT(1))
+
+#define UART_FIFO(i)                    (0x60000000 + (i) * 0xf00)
+#define UART_STATUS(i)                  (0x6000001C + (i) * 0xf00)
+#define UART_TXFIFO_CNT                 0x000000FF
+#define UART_TXFIFO_CNT_S               16
+
+#endif /* EAGLE_SOC_H */
@@ -0,0 +1,113 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef ESPCONN_H
+#define ESPCONN_H
+
+#include "c_types.h"
+
+/******************************************************************************************************************
+ * host shim: TCP connections - there is no network; every connect fails
+ *
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef sint8 err_t;
+typedef void* espconn_handle;
+typedef void (*espconn_connect_callback)(void* arg);
+typedef void (*espconn_reconnect_callback)(void* arg, sint8 err);
+typedef void (*espconn_recv_callback)(void* arg, char* pdata, unsigned short len);
+typedef void (*espconn_sent_callback)(void* arg);
+
+enum espconn_type {
+    ESPCONN_INVALID = 0,
+    ESPCONN_TCP     = 0x10,
+    ESPCONN_UDP     = 0x20
+};
+
+enum espconn_state {
+    ESPCONN_NONE,
+    ESPCONN_WAIT,
+    ESPCONN_LISTEN,
+    ESPCONN_CONNECT,
+    ESPCONN_WRITE,
+    ESPCONN_READ,
+    ESPCONN_CLOSE
+};
+
+typedef struct _esp_tcp {
+    int                         remote_port;
+    int                         local_port;
+    uint8                       local_ip[4];
+    uint8                       remote_ip[4];
+    espconn_connect_callback    connect_callback;
+    espconn_reconnect_callback  reconnect_callback;
+    espconn_connect_callback    disconnect_callback;
+    espconn_connect_callback    write_finish_fn;
+} esp_tcp;
+
+typedef struct _esp_udp {
+    int                         remote_port;
+    int                         local_port;
+    uint8                       local_ip[4];
+    uint8                       remote_ip[4];
+} esp_udp;
+
+struct espconn {
+    enum espconn_type           type;
+    enum espconn_state          state;
+    union {
+        esp_tcp*                tcp;
+        esp_udp*                udp;
+    } proto;
+    espconn_recv_callback       recv_callback;
+    espconn_sent_callback       sent_callback;
+    uint8                       link_cnt;
+    void*                       reverse;
+};
+
+#define ESPCONN_OK                      0
+#define ESPCONN_RTE                     -4
+
+sint8  espconn_connect(struct espconn* espconn);
+sint8  espconn_disconnect(struct espconn* espconn);
+sint8  espconn_send(struct espconn* espconn, uint8* psent, uint16 length);
+sint8  espconn_regist_connectcb(struct espconn* espconn, espconn_connect_callback connect_cb);
+sint8  espconn_regist_reconcb(struct espconn* espconn, espconn_reconnect_callback recon_cb);
+sint8  espconn_regist_disconcb(struct espconn* espconn, espconn_connect_callback discon_cb);
+sint8  espconn_regist_recvcb(struct espconn* espconn, espconn_recv_callback recv_cb);
+sint8  espconn_recv_hold(struct espconn* pespconn);
+sint8  espconn_recv_unhold(struct espconn* pespconn);
+uint32 espconn_port(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESPCONN_H */
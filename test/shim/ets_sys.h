@@ -0,0 +1,70 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef ETS_SYS_H
+#define ETS_SYS_H
+
+#include "c_types.h"
+#include "eagle_soc.h"
+
+/******************************************************************************************************************
+ * host shim: interrupts
+ *
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*int_handler_t)(void*);
+
+void ets_isr_attach(int i, int_handler_t func, void* arg);
+void ets_isr_mask(unsigned intr);
+void ets_isr_unmask(unsigned intr);
+void ets_intr_lock(void);
+void ets_intr_unlock(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ETS_GPIO_INUM                           4
+#define ETS_UART_INUM                           5
+#define ETS_FRC_TIMER1_INUM                     9
+
+#define ETS_GPIO_INTR_ATTACH(func, arg)         ets_isr_attach(ETS_GPIO_INUM, (int_handler_t) (func), (void*) (arg))
+#define ETS_GPIO_INTR_ENABLE()                  ets_isr_unmask(1 << ETS_GPIO_INUM)
+#define ETS_GPIO_INTR_DISABLE()                 ets_isr_mask(1 << ETS_GPIO_INUM)
+#define ETS_FRC_TIMER1_INTR_ATTACH(func, arg)   ets_isr_attach(ETS_FRC_TIMER1_INUM, (int_handler_t) (func), (void*) (arg))
+#define ETS_FRC1_INTR_ENABLE()                  ets_isr_unmask(1 << ETS_FRC_TIMER1_INUM)
+#define ETS_FRC1_INTR_DISABLE()                 ets_isr_mask(1 << ETS_FRC_TIMER1_INUM)
+#define ETS_UART_INTR_ATTACH(func, arg)         ets_isr_attach(ETS_UART_INUM, (int_handler_t) (func), (void*) (arg))
+#define ETS_UART_INTR_ENABLE()                  ets_isr_unmask(1 << ETS_UART_INUM)
+#define ETS_UART_INTR_DISABLE()                 ets_isr_mask(1 << ETS_UART_INUM)
+#define ETS_INTR_LOCK()                         ets_intr_lock()
+#define ETS_INTR_UNLOCK()                       ets_intr_unlock()
+
+#endif /* ETS_SYS_H */
@@ -0,0 +1,84 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef ESP_OPEN_RTOS_GPIO_H
+#define ESP_OPEN_RTOS_GPIO_H
+
+#include <c_types.h>
+#include <eagle_soc.h>
+
+/******************************************************************************************************************
+ * host shim: GPIO 0-15 through the GPIO registers, GPIO 16 is kept aside as on the chip
+ *
+ */
+typedef enum {
+    GPIO_INPUT,
+    GPIO_OUTPUT,
+    GPIO_OUT_OPEN_DRAIN
+} gpio_direction_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void Shim_Gpio16(bool enable, bool value);
+bool Shim_Gpio16Read(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline void gpio_enable(const uint8_t gpio_num, const gpio_direction_t direction)
+{
+    if(gpio_num == 16) {
+        Shim_Gpio16(direction != GPIO_INPUT, Shim_Gpio16Read());
+    } else if(direction == GPIO_INPUT) {
+        GPIO_REG_WRITE(GPIO_ENABLE_W1TC_ADDRESS, BIT(gpio_num));
+    } else {
+        GPIO_REG_WRITE(GPIO_ENABLE_W1TS_ADDRESS, BIT(gpio_num));
+    }
+}
+
+static inline void gpio_write(const uint8_t gpio_num, const bool set)
+{
+    if(gpio_num == 16) {
+        Shim_Gpio16(true, set);
+    } else {
+        GPIO_REG_WRITE(set ? GPIO_OUT_W1TS_ADDRESS : GPIO_OUT_W1TC_ADDRESS, BIT(gpio_num));
+    }
+}
+
+static inline bool gpio_read(const uint8_t gpio_num)
+{
+    if(gpio_num == 16) {
+        return Shim_Gpio16Read();
+    }
+    
+    return (GPIO_REG_READ(GPIO_IN_ADDRESS) & BIT(gpio_num)) != 0;
+}
+
+#endif /* ESP_OPEN_RTOS_GPIO_H */
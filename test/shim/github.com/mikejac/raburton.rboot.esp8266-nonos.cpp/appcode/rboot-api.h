@@ -0,0 +1,58 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef RBOOT_API_H
+#define RBOOT_API_H
+
+#include <c_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAX_ROMS                        4
+
+typedef struct {
+    uint8                       magic;
+    uint8                       version;
+    uint8                       mode;
+    uint8                       current_rom;
+    uint8                       gpio_rom;
+    uint8                       count;
+    uint8                       unused[2];
+    uint32                      roms[MAX_ROMS];
+} rboot_config;
+
+rboot_config rboot_get_config(void);
+bool         rboot_set_current_rom(uint8 rom);
+uint8        rboot_get_current_rom(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBOOT_API_H */
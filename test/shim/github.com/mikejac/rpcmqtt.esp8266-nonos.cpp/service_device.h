@@ -0,0 +1,159 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef SERVICE_DEVICE_H
+#define SERVICE_DEVICE_H
+
+#include <c_types.h>
+
+/******************************************************************************************************************
+ * host shim: MQTT connector and accessories
+ *
+ * The broker is always there. Outgoing values end up in the accessories; incoming value updates are queued by
+ * the simulation with Shim_DeviceEvent().
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MqttOptions      MqttOptions;
+typedef struct Mqtt             Mqtt;
+typedef struct MqttDevice       MqttDevice;
+typedef struct Container        Container;
+typedef struct Accessory        Accessory;
+
+typedef struct { Accessory* Accessory; } AccThermometer;
+typedef struct { Accessory* Accessory; } AccHumidity;
+typedef struct { Accessory* Accessory; } AccThermostat;
+typedef struct { Accessory* Accessory; } AccText;
+
+typedef enum {
+    FormatString,
+    FormatBool,
+    FormatUInt8,
+    FormatInt8,
+    FormatUInt16,
+    FormatInt16,
+    FormatUInt32,
+    FormatInt32,
+    FormatUInt64,
+    FormatFloat,
+    FormatNone
+} CharacteristicFormat;
+
+typedef struct {
+    Accessory*                  acc;
+    long long                   iid;
+    CharacteristicFormat        format;
+    double                      value;
+} Device_Message;
+
+enum {
+    TargetHeatingCoolingStateOff,
+    TargetHeatingCoolingStateHeat,
+    TargetHeatingCoolingStateCool,
+    TargetHeatingCoolingStateAuto
+};
+
+enum {
+    CurrentHeatingCoolingStateOff,
+    CurrentHeatingCoolingStateHeat,
+    CurrentHeatingCoolingStateCool
+};
+
+#define AccThermostatTargetHeatingCoolingStateIid   10
+#define AccThermostatTargetTemperatureIid           11
+
+enum {
+    RUN_NONE,
+    RUN_CONNECTED
+};
+
+enum {
+    ClassTypeDeviceSvc
+};
+
+typedef void (*OnCommand)(Mqtt* mqtt, void* ptr, const char* nodename, const char* actorId, const char* platformId, 
+                          const char* feedId, const char* payload);
+
+Container*      NewContainer(const char* nodename, const char* name, const char* serial, const char* manufacturer, 
+                             const char* model, int bufferSize);
+AccThermometer* NewAccThermometer(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                                  int value, double min, double max, double step);
+AccHumidity*    NewAccHumidity(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                               int value, double min, double max, double step);
+AccThermostat*  NewAccThermostat(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                                 int value, double min, double max, double step, double target, double targetMin, 
+                                 double targetMax, double targetStep);
+AccText*        NewAccText(const char* name, const char* serial, const char* manufacturer, const char* model, 
+                           const char* value);
+void            AddAccessory(Container* c, Accessory* a);
+
+MqttOptions*    NewMqttOptions(void);
+void            MqttOptions_SetServer(MqttOptions* o, const char* server);
+void            MqttOptions_SetPort(MqttOptions* o, int port);
+void            MqttOptions_SetClientId(MqttOptions* o, const char* clientId);
+void            MqttOptions_SetKeepalive(MqttOptions* o, int keepalive);
+void            MqttOptions_SetRootTopic(MqttOptions* o, const char* topic);
+void            MqttOptions_SetNodename(MqttOptions* o, const char* nodename);
+void            MqttOptions_SetActorPlatformId(MqttOptions* o, const char* platformId);
+void            MqttOptions_SetClassType(MqttOptions* o, int classType);
+void            MqttOptions_SetBufferSize(MqttOptions* o, int size);
+
+Mqtt*           Connector(MqttOptions* o);
+void            InstallCallbacks(Mqtt* mqtt, void* ptr, OnCommand onCommand);
+void            EnableChronos(Mqtt* mqtt, const char* nodename);
+int             ConnectorRun(Mqtt* mqtt);
+bool            IsConnected(Mqtt* mqtt);
+bool            Close(Mqtt* mqtt);
+bool            Info(Mqtt* mqtt, const char* text);
+void            Warning(Mqtt* mqtt, const char* text);
+
+MqttDevice*     NewDevice(Mqtt* mqtt);
+void            SetAccessories(MqttDevice* device, Container* c);
+Device_Message* DeviceGetEvent(MqttDevice* device);
+CharacteristicFormat DeviceGetEventType(Device_Message* dm);
+void            DeviceDeleteEvent(Device_Message* dm);
+long long       Device_GetAid(Device_Message* dm);
+long long       Device_GetIid(Device_Message* dm);
+bool            Device_GetValueBool(Device_Message* dm);
+uint8_t         Device_GetValueUInt8(Device_Message* dm);
+double          Device_GetValueFloat(Device_Message* dm);
+
+void            AccThermostatCurrentTemperatureSetValue(AccThermostat* a, double value);
+void            AccThermostatCurrentHeatingCoolingStateSetValue(AccThermostat* a, int value);
+void            AccThermostatTargetTemperatureSetValue(AccThermostat* a, double value);
+void            AccThermostatTargetHeatingCoolingStateSetValue(AccThermostat* a, int value);
+void            AccHumidityCurrentRelativeHumiditySetValue(AccHumidity* a, double value);
+void            AccThermometerCurrentTemperatureSetValue(AccThermometer* a, double value);
+void            AccTextSetValue(AccText* a, const char* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVICE_DEVICE_H */
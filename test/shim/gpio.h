@@ -0,0 +1,64 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef GPIO_H
+#define GPIO_H
+
+#include "c_types.h"
+#include "eagle_soc.h"
+
+/******************************************************************************************************************
+ * host shim: SDK GPIO functions
+ *
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GPIO_PIN_INTR_DISABLE = 0,
+    GPIO_PIN_INTR_POSEDGE,
+    GPIO_PIN_INTR_NEGEDGE,
+    GPIO_PIN_INTR_ANYEDGE,
+    GPIO_PIN_INTR_LOLEVEL,
+    GPIO_PIN_INTR_HILEVEL
+} GPIO_INT_TYPE;
+
+void   gpio_pin_intr_state_set(uint32 i, GPIO_INT_TYPE intr_state);
+void   gpio_output_set(uint32 set_mask, uint32 clear_mask, uint32 enable_mask, uint32 disable_mask);
+uint32 gpio_input_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define GPIO_OUTPUT_SET(gpio_no, bit_value) \
+            gpio_output_set((bit_value) << (gpio_no), ((~(bit_value)) & 0x01) << (gpio_no), 1 << (gpio_no), 0)
+#define GPIO_DIS_OUTPUT(gpio_no)        gpio_output_set(0, 0, 0, 1 << (gpio_no))
+#define GPIO_INPUT_GET(gpio_no)         ((gpio_input_get() >> (gpio_no)) & BIT0)
+
+#endif /* GPIO_H */
@@ -0,0 +1,57 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef MEM_H
+#define MEM_H
+
+#include "c_types.h"
+
+/******************************************************************************************************************
+ * host shim: heap
+ *
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* pvPortMalloc(size_t sz, const char* file, unsigned line);
+void* pvPortZalloc(size_t sz, const char* file, unsigned line);
+void* pvPortCalloc(size_t count, size_t sz, const char* file, unsigned line);
+void* pvPortRealloc(void* p, size_t sz, const char* file, unsigned line);
+void  vPortFree(void* p, const char* file, unsigned line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define os_malloc(s)                    pvPortMalloc(s, __FILE__, __LINE__)
+#define os_zalloc(s)                    pvPortZalloc(s, __FILE__, __LINE__)
+#define os_calloc(n, s)                 pvPortCalloc(n, s, __FILE__, __LINE__)
+#define os_realloc(p, s)                pvPortRealloc(p, s, __FILE__, __LINE__)
+#define os_free(p)                      vPortFree(p, __FILE__, __LINE__)
+
+#endif /* MEM_H */
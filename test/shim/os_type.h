@@ -0,0 +1,56 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef OS_TYPE_H
+#define OS_TYPE_H
+
+#include "c_types.h"
+
+/******************************************************************************************************************
+ * host shim: tasks and software timers
+ *
+ */
+typedef uint8                   os_signal_t;
+typedef uint32                  os_param_t;
+
+typedef struct {
+    os_signal_t                 sig;
+    os_param_t                  par;
+} os_event_t;
+
+typedef void (*os_task_t)(os_event_t* e);
+typedef void os_timer_func_t(void* arg);
+
+typedef struct _os_timer_t {
+    struct _os_timer_t*         timer_next;                         // armed timers, soonest first
+    uint64_t                    timer_expire;                       // us of simulated time
+    uint32_t                    timer_period;                       // us; 0: one-shot
+    os_timer_func_t*            timer_func;
+    void*                       timer_arg;
+} os_timer_t;
+
+#endif /* OS_TYPE_H */
@@ -0,0 +1,78 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef OSAPI_H
+#define OSAPI_H
+
+#include <string.h>
+#include <stdio.h>
+#include "c_types.h"
+#include "os_type.h"
+
+/******************************************************************************************************************
+ * host shim: SDK OS API
+ *
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// formats are taken as on the chip, where long is 32 bits: %lu prints a uint32_t
+int  os_printf_plus(const char* format, ...);
+int  ets_sprintf(char* str, const char* format, ...);
+int  ets_snprintf(char* str, size_t size, const char* format, ...);
+void ets_delay_us(uint32 us);
+void ets_timer_arm_new(os_timer_t* t, uint32 time, bool repeat, int isMs);
+void ets_timer_disarm(os_timer_t* t);
+void ets_timer_setfn(os_timer_t* t, os_timer_func_t* func, void* arg);
+void os_install_putc1(void (*p)(char c));
+
+#ifdef __cplusplus
+}
+#endif
+
+#define os_printf                       os_printf_plus
+#define os_sprintf                      ets_sprintf
+#define os_snprintf                     ets_snprintf
+#define os_memcpy                       memcpy
+#define os_memmove                      memmove
+#define os_memset                       memset
+#define os_memcmp                       memcmp
+#define os_strlen                       strlen
+#define os_strcmp                       strcmp
+#define os_strncmp                      strncmp
+#define os_strcpy                       strcpy
+#define os_strncpy                      strncpy
+#define os_strstr                       strstr
+#define os_delay_us                     ets_delay_us
+
+#define os_timer_arm(t, ms, repeat)     ets_timer_arm_new(t, ms, repeat, 1)
+#define os_timer_arm_us(t, us, repeat)  ets_timer_arm_new(t, us, repeat, 0)
+#define os_timer_disarm                 ets_timer_disarm
+#define os_timer_setfn                  ets_timer_setfn
+
+#endif /* OSAPI_H */
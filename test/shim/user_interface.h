@@ -0,0 +1,113 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef USER_INTERFACE_H
+#define USER_INTERFACE_H
+
+#include "c_types.h"
+#include "os_type.h"
+#include "ip_addr.h"
+
+/******************************************************************************************************************
+ * host shim: system and station functions
+ *
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rst_reason {
+    REASON_DEFAULT_RST = 0,
+    REASON_WDT_RST,
+    REASON_EXCEPTION_RST,
+    REASON_SOFT_WDT_RST,
+    REASON_SOFT_RESTART,
+    REASON_DEEP_SLEEP_AWAKE,
+    REASON_EXT_SYS_RST
+};
+
+struct rst_info {
+    uint32                      reason;
+    uint32                      exccause;
+    uint32                      epc1;
+    uint32                      epc2;
+    uint32                      epc3;
+    uint32                      excvaddr;
+    uint32                      depc;
+};
+
+struct station_config {
+    uint8                       ssid[32];
+    uint8                       password[64];
+    uint8                       bssid_set;
+    uint8                       bssid[6];
+};
+
+struct ip_info {
+    struct ip_addr              ip;
+    struct ip_addr              netmask;
+    struct ip_addr              gw;
+};
+
+enum {
+    STATION_IDLE = 0,
+    STATION_CONNECTING,
+    STATION_WRONG_PASSWORD,
+    STATION_NO_AP_FOUND,
+    STATION_CONNECT_FAIL,
+    STATION_GOT_IP
+};
+
+#define STATION_IF                      0
+
+typedef void (*init_done_cb_t)(void);
+
+uint32           system_get_time(void);
+uint8            system_get_cpu_freq(void);
+uint32           system_get_free_heap_size(void);
+bool             system_os_task(os_task_t task, uint8 prio, os_event_t* queue, uint8 qlen);
+bool             system_os_post(uint8 prio, os_signal_t sig, os_param_t par);
+void             system_init_done_cb(init_done_cb_t cb);
+bool             system_rtc_mem_read(uint8 src_addr, void* des_addr, uint16 load_size);
+bool             system_rtc_mem_write(uint8 des_addr, const void* src_addr, uint16 save_size);
+struct rst_info* system_get_rst_info(void);
+void             system_soft_wdt_feed(void);
+void             system_restart(void);
+
+bool             wifi_station_get_config(struct station_config* config);
+bool             wifi_station_set_config(struct station_config* config);
+bool             wifi_station_set_config_current(struct station_config* config);
+uint8            wifi_get_channel(void);
+bool             wifi_set_channel(uint8 channel);
+uint8            wifi_station_get_connect_status(void);
+bool             wifi_get_ip_info(uint8 if_index, struct ip_info* info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_INTERFACE_H */
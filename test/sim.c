@@ -0,0 +1,264 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include "../user_config.h"
+#include "shim.h"
+#include "plant.h"
+
+/******************************************************************************************************************
+ * closed loop simulation
+ *
+ * The firmware, booted on the shim, heats the workshop model for a number of days: the DHT replies come from the
+ * plant, the relays drive it. The setpoint follows a day/night program sent as HomeKit device events. Each day is
+ * summed up in one line; the exit code tells if the control stayed within bounds.
+ *
+ * usage: sim [-v] [days]
+ *
+ */
+#define OUTDOOR_MEAN            2.0                                 // C
+#define SETPOINT_DAY            16.0                                // C, 07:00 to 17:00 local
+#define SETPOINT_NIGHT          10.0
+#define DAY_START               (6 * 3600)                          // s of the UTC day
+#define DAY_END                 (16 * 3600)
+#define SETTLE                  (2 * 3600)                          // s after a higher setpoint not scored
+#define SPIKE_RATE              300                                 // one reading in ... is a spike
+#define MISS_RATE               100                                 // one reading in ... gets no reply
+
+// bounds for the exit code; the first day is spent heating up and not checked
+#define MAX_MEAN_ERROR          0.5                                 // C
+#define MAX_OVERSHOOT           1.5                                 // C
+#define MAX_SWITCHES            (2 * 2 * 86400 / PID_WINDOW)        // relay changes per day; two per window and stage
+
+typedef struct {
+    double                  error;                                  // sum of |error|
+    uint32_t                samples;
+    double                  over;                                   // largest error above the setpoint
+    double                  under;                                  // below
+    uint32_t                switches;
+    double                  energy;                                 // J at the start of the day
+    uint32_t                warnings;                               // at the start of the day
+} DAY_STATS;
+
+static PLANT        m_Plant;
+static uint32_t     m_Random = 12345;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static uint32_t random32(void);
+static double   noise(void);
+static int      report(uint32_t day, DAY_STATS* s);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    DAY_STATS   stats;
+    uint32_t    days = 7;
+    uint32_t    s, end, settled = 0;
+    double      setpoint = SETPOINT_NIGHT;
+    int         heaters = 0, fan = 0;
+    int         failed = 0;
+    int         i;
+    
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-v") == 0) {
+            Shim_Verbose(1);
+        } else {
+            days = (uint32_t) atoi(argv[i]);
+        }
+    }
+    
+    Plant_Initialize(&m_Plant, OUTDOOR_MEAN, SHIM_WALL_CLOCK);
+    Shim_SetDht(dht);
+    Shim_Boot(SHIM_WALL_CLOCK);
+    
+    memset(&stats, 0, sizeof(stats));
+    
+    printf("day  mean-err  over  under  switches  kWh  warnings\n");
+    
+    end = days * 86400;
+    
+    for(s = 0; s < end; s++) {
+        uint32_t tod = (SHIM_WALL_CLOCK + s) % 86400;
+        double   want;
+        int      h;
+        
+        if(s == 5) {
+            Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+        }
+        
+        want = (tod >= DAY_START && tod < DAY_END) ? SETPOINT_DAY : SETPOINT_NIGHT;
+        
+        if(want != setpoint || s == 5) {
+            // a lower setpoint is scored from when the air has cooled down to it; there is nothing to cool with
+            settled  = (want < setpoint) ? UINT32_MAX : s + SETTLE;
+            setpoint = want;
+            
+            Shim_DeviceEvent(AccThermostatTargetTemperatureIid, setpoint);
+        }
+        
+        Shim_Run(1000000);
+        
+        h = (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+        
+        if(h != heaters) {
+            stats.switches++;
+            heaters = h;
+        }
+        
+        fan = (Shim_Output(GPIO_FAN) == FAN_ON);
+        
+        Plant_Step(&m_Plant, 1.0, heaters, fan);
+        
+        if(settled == UINT32_MAX && m_Plant.air <= setpoint) {
+            settled = s;
+        }
+        
+        if(s >= settled) {
+            double e = m_Plant.air - setpoint;
+            
+            stats.error += fabs(e);
+            stats.samples++;
+            
+            if(e > stats.over) {
+                stats.over = e;
+            }
+            if(-e > stats.under) {
+                stats.under = -e;
+            }
+        }
+        
+        if((s + 1) % 86400 == 0) {
+            uint32_t day = (s + 1) / 86400;
+            
+            if(report(day, &stats) && day > 1) {
+                failed = 1;
+            }
+        }
+    }
+    
+    if(Shim_Stats.restarts != 0 || Shim_Stats.dhtFrames == 0) {
+        printf("restarts %u, DHT frames %u\n", Shim_Stats.restarts, Shim_Stats.dhtFrames);
+        failed = 1;
+    }
+    
+    printf("%s\n", failed ? "FAIL" : "PASS");
+    
+    return failed;
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a DHT22 reading of the plant: a tenth of noise, now and then a spike or no reply at all
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 0: no reply
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    double t = (gpio == GPIO_DHT1) ? m_Plant.air      : m_Plant.outdoor;
+    double h = (gpio == GPIO_DHT1) ? m_Plant.humidity : Plant_OutdoorHumidity(&m_Plant);
+    
+    if(random32() % MISS_RATE == 0) {
+        return 0;
+    }
+    
+    if(random32() % SPIKE_RATE == 0) {
+        t += (random32() & 1) ? 25 : -25;
+    }
+    
+    *temperature = (int16_t) lround((t + noise()) * 10);
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
+/**
+ * 
+ * @return -0.1 .. 0.1
+ */
+static double noise(void)
+{
+    return ((int) (random32() % 3) - 1) * 0.1;
+}
+/**
+ * print the day and start the next
+ * 
+ * @param day
+ * @param s
+ * @return 1 if out of bounds
+ */
+static int report(uint32_t day, DAY_STATS* s)
+{
+    double   mean = s->samples ? s->error / s->samples : 0;
+    uint32_t warnings = Shim_Stats.warnings - s->warnings;
+    int      bad = mean > MAX_MEAN_ERROR || s->over > MAX_OVERSHOOT || s->switches > MAX_SWITCHES;
+    
+    printf("%3u  %8.2f  %4.1f  %5.1f  %8u  %5.1f  %8u%s\n", day, mean, s->over, s->under, s->switches, 
+           (m_Plant.energy - s->energy) / 3.6e6, warnings, bad ? "  *" : "");
+    
+    s->error    = 0;
+    s->samples  = 0;
+    s->over     = 0;
+    s->under    = 0;
+    s->switches = 0;
+    s->energy   = m_Plant.energy;
+    s->warnings = Shim_Stats.warnings;
+    
+    return bad;
+}
@@ -0,0 +1,291 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../user_config.h"
+#include "../stages.hpp"
+#include "shim.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * the heater stage table in the configurations it is built in: one, two and three stages, each with and without the
+ * fan on a relay of its own - which stages come on when, the bitmask against the relays, and what it costs in code
+ *
+ * The sizes are those of this host build, read from the program itself with nm; they are printed, and each stage
+ * must add the same - the list is unrolled, no loop over a table - no more than MAX_STAGE_TEXT and no data.
+ *
+ */
+#define GPIO_HEATER3            2                                   // a spare pin; GPIO16 is not in the out register
+#define STAGE_3_TIME            (2 * STAGE_2_TIME)
+#define MAX_STAGE_TEXT          128                                 // bytes
+#define MAX_STAGE_SPREAD        32                                  // bytes one stage may cost more; registers vary
+#define NM                      "nm -S -C --defined-only "
+
+typedef Stage<GPIO_HEATER1, 0>                                                      One;
+typedef Stage<GPIO_HEATER1, 0, Stage<GPIO_HEATER2, STAGE_2_TIME> >                  Two;
+typedef Stage<GPIO_HEATER1, 0, Stage<GPIO_HEATER2, STAGE_2_TIME, 
+        Stage<GPIO_HEATER3, STAGE_3_TIME> > >                                       Three;
+
+typedef StageControl<Three, HEATER_ON, HEATER_OFF>                                  Relays;     // all the pins
+typedef StageControl<Stage<GPIO_FAN, 0>, FAN_ON, FAN_OFF>                          Fan;
+
+// one function a configuration, so each has a size of its own
+#define VARIANT(name, STAGES)                                                                                   \
+    extern "C" __attribute__((noinline)) uint32_t name(uint32_t count, uint32_t onFor, uint32_t base,           \
+                                                       uint32_t state)                                          \
+    {                                                                                                           \
+        return StageControl<STAGES, HEATER_ON, HEATER_OFF>::set(count, onFor, base, state);                     \
+    }                                                                                                           \
+    extern "C" __attribute__((noinline)) uint32_t name##_fan(uint32_t count, uint32_t onFor, uint32_t base,     \
+                                                             uint32_t state)                                    \
+    {                                                                                                           \
+        uint32_t heaters = StageControl<STAGES, HEATER_ON, HEATER_OFF>::set(count, onFor, base, state & 0x7f);   \
+                                                                                                                \
+        return heaters | (Fan::set(heaters != 0, 0, 0, state >> 7) << 7);       /* bit 7 as in the history */ \
+    }
+
+VARIANT(stages_one,   One)
+VARIANT(stages_two,   Two)
+VARIANT(stages_three, Three)
+
+typedef uint32_t (*SET)(uint32_t count, uint32_t onFor, uint32_t base, uint32_t state);
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     variant(int stages, SET set, bool fan);
+static uint32_t relays(int stages, bool fan);
+static long     size(const char* program, const char* symbol);
+static int      data(const char* program);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    static const char*  names[] = { "stages_one", "stages_two", "stages_three" };
+    long                text[3][2];
+    int                 i, fan;
+    
+    (void) argc;
+    
+    Relays::init();
+    Fan::init();
+    
+    variant(1, stages_one,   false);
+    variant(2, stages_two,   false);
+    variant(3, stages_three, false);
+    variant(1, stages_one_fan,   true);
+    variant(2, stages_two_fan,   true);
+    variant(3, stages_three_fan, true);
+    
+    // what it costs
+    for(i = 0; i < 3; i++) {
+        for(fan = 0; fan < 2; fan++) {
+            char symbol[32];
+            
+            snprintf(symbol, sizeof(symbol), fan ? "%s_fan" : "%s", names[i]);
+            
+            text[i][fan] = size(argv[0], symbol);
+        }
+        
+        printf("stages_test: %d stage%s: set() %ld bytes, %ld with the fan\n", i + 1, i ? "s" : "", 
+               text[i][0], text[i][1]);
+        
+        CHECK(text[i][0] > 0 && text[i][1] > text[i][0]);
+    }
+    
+    for(fan = 0; fan < 2; fan++) {
+        long first  = text[1][fan] - text[0][fan];
+        long second = text[2][fan] - text[1][fan];
+        
+        printf("stages_test: %s: +%ld and +%ld bytes a stage\n", fan ? "with the fan" : "heaters only", first, second);
+        
+        CHECK(first > 0 && first <= MAX_STAGE_TEXT);
+        CHECK(second > 0 && second <= MAX_STAGE_TEXT);
+        CHECK(labs(second - first) <= MAX_STAGE_SPREAD);
+    }
+    
+    CHECK_EQUAL(data(argv[0]), 0);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * one configuration through the delays, the base and off again
+ * 
+ * @param stages
+ * @param set
+ * @param fan       bit 7 is the fan
+ */
+static void variant(int stages, SET set, bool fan)
+{
+    uint32_t all   = (1 << stages) - 1;
+    uint32_t state = set(0, 0, 0, 0);
+    uint32_t want;
+    
+    CHECK_EQUAL(state, 0);
+    CHECK_EQUAL(relays(stages, fan), 0);
+    
+    // wanted, but the later ones wait for their delay
+    state = set(stages, 0, 0, state);
+    want  = 1 | (fan ? 0x80 : 0);
+    
+    CHECK_EQUAL(state, want);
+    CHECK_EQUAL(relays(stages, fan), want);
+    
+    state = set(stages, STAGE_2_TIME, 0, state);
+    want  = (all & 3) | (fan ? 0x80 : 0);
+    
+    CHECK_EQUAL(state, want);
+    CHECK_EQUAL(relays(stages, fan), want);
+    
+    state = set(stages, STAGE_3_TIME, 0, state);
+    want  = all | (fan ? 0x80 : 0);
+    
+    CHECK_EQUAL(state, want);
+    CHECK_EQUAL(relays(stages, fan), want);
+    
+    // fewer wanted: from the top down
+    state = set(1, STAGE_3_TIME, 0, state);
+    want  = 1 | (fan ? 0x80 : 0);
+    
+    CHECK_EQUAL(state, want);
+    CHECK_EQUAL(relays(stages, fan), want);
+    
+    // the base need not wait
+    state = set(stages, 0, stages, state);
+    want  = all | (fan ? 0x80 : 0);
+    
+    CHECK_EQUAL(state, want);
+    CHECK_EQUAL(relays(stages, fan), want);
+    
+    // more than there are is all of them
+    CHECK_EQUAL(set(stages + 2, STAGE_3_TIME, 0, state), state);
+    
+    state = set(0, 0, 0, state);
+    
+    CHECK_EQUAL(state, 0);
+    CHECK_EQUAL(relays(stages, fan), 0);
+}
+/**
+ * 
+ * @param stages
+ * @param fan
+ * @return the relays as driven, as a state bitmask
+ */
+static uint32_t relays(int stages, bool fan)
+{
+    uint32_t out   = GPIO_REG_READ(GPIO_OUT_ADDRESS);
+    uint32_t state = Relays::read(out);
+    
+    CHECK_EQUAL(state >> stages, 0);                                // the pins of the stages not built stay off
+    
+    if(fan) {
+        state |= Fan::read(out) << 7;
+    } else {
+        CHECK_EQUAL(Fan::read(out), 0);
+    }
+    
+    return state;
+}
+/**
+ * 
+ * @param program
+ * @param symbol
+ * @return bytes of code, -1 if it is not there
+ */
+static long size(const char* program, const char* symbol)
+{
+    char          command[256], line[512], name[256], type;
+    unsigned long addr, bytes;
+    long          found = -1;
+    FILE*         fp;
+    
+    snprintf(command, sizeof(command), NM "%s", program);
+    
+    if((fp = popen(command, "r")) == NULL) {
+        return -1;
+    }
+    
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        if(sscanf(line, "%lx %lx %c %255s", &addr, &bytes, &type, name) == 4 && 
+           (type == 'T' || type == 't') && strcmp(name, symbol) == 0) {
+            found = (long) bytes;
+        }
+    }
+    
+    pclose(fp);
+    
+    return found;
+}
+/**
+ * 
+ * @param program
+ * @return symbols of the stage table in data or bss
+ */
+static int data(const char* program)
+{
+    char    command[256], line[512];
+    int     n = 0;
+    FILE*   fp;
+    
+    snprintf(command, sizeof(command), NM "%s", program);
+    
+    if((fp = popen(command, "r")) == NULL) {
+        return -1;
+    }
+    
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        if(strstr(line, "Stage") != NULL && (strstr(line, " d ") || strstr(line, " D ") || 
+                                             strstr(line, " b ") || strstr(line, " B "))) {
+            printf("stages_test: %s", line);
+            n++;
+        }
+    }
+    
+    pclose(fp);
+    
+    return n;
+}
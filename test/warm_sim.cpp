@@ -0,0 +1,369 @@
+/* 
+ * The MIT License (MIT)
+ * 
+ * ESP8266 Non-OS Firmware
+ * Copyright (c) 2015 Michael Jacobsen (github.com/mikejac)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <github.com/mikejac/rpcmqtt.esp8266-nonos.cpp/service_device.h>
+#include <spi_flash.h>
+#include "../user_config.h"
+#include "shim.h"
+#include "plant.h"
+#include "check.h"
+
+/******************************************************************************************************************
+ * warm restart in closed loop
+ *
+ * Every boot is a child process of this one, see Shim_Restart(), and finds the RTC memory and flash the previous
+ * one left. The thermostat is put in each mode and restarted, by a reset - the RTC checkpoint - and by a power cut -
+ * the flash copy; it must come back in that mode with the PID and the relays as they were. Heat and auto heat, off
+ * and cool - there is nothing to cool with - do not.
+ *
+ * Then the workshop is heated from cold and reset, once on the way up and once long after it got there, and the
+ * time until the air is back in the band is compared with a start without the checkpoint - where the app sends the
+ * setpoint again, which is the best that did before.
+ *
+ * usage: warm_sim [-v]
+ *
+ */
+#define OUTDOOR_MEAN            2.0                                 // C
+#define SETPOINT                18.0                                // C; far above the air
+#define SETTLE                  120                                 // s after a boot or a change
+#define HEATING                 (2 * 3600)                           // s into the heat-up the restart comes
+#define HOLDING                 (24 * 3600)                         // s; long since at the setpoint
+#define WATCH                   (12 * 3600)                         // s after the restart
+#define BAND                    0.5                                 // C around the setpoint
+
+typedef struct {
+    PLANT                   plant;
+    uint32_t                wall;                                   // wall clock now
+    int                     verbose;
+    int                     mode;                                   // to set
+    int                     pidEnable;                              // when the boot or the change has settled
+    int                     pidMode;
+    int                     heaters;
+    int                     cold;                                   // the checkpoint is gone
+    uint32_t                time;                                   // s to run
+    uint32_t                back;                                   // s after the restart the air was in the band
+    uint32_t                out;                                    // s out of it after that
+    double                  low;                                    // C; lowest air after it was back
+} SHARED;
+
+// the firmware's
+extern int              m_PidEnable;
+extern uint8_t          m_PidMode;
+
+static SHARED*      m_Shared;
+static uint32_t     m_Random = 12345;
+
+/******************************************************************************************************************
+ * prototypes
+ *
+ */
+
+static void     configure(void* shared);
+static void     restore(void* shared);
+static void     heat(void* shared);
+static void     resume(void* shared);
+static void     recover(SHARED* s, uint32_t time, const char* what, SHARED* warm);
+static void     boot(void* shared);
+static int      dht(uint8_t gpio, int16_t* temperature, int16_t* humidity);
+static int      heaters(void);
+static void     run(uint32_t seconds);
+static uint32_t random32(void);
+
+/******************************************************************************************************************
+ * functions
+ *
+ */
+
+/**
+ * 
+ * @param argc
+ * @param argv
+ * @return 
+ */
+int main(int argc, char** argv)
+{
+    static const int    modes[] = { TargetHeatingCoolingStateOff,  TargetHeatingCoolingStateHeat, 
+                                    TargetHeatingCoolingStateCool, TargetHeatingCoolingStateAuto };
+    static const char*  names[] = { "off", "heat", "cool", "auto" };
+    SHARED*             s       = (SHARED*) Shim_Shared(sizeof(SHARED));
+    SHARED              warm;
+    int                 i, powerLost, heat, enable, stages;
+    
+    s->verbose = (argc > 1 && strcmp(argv[1], "-v") == 0);
+    s->wall    = SHIM_WALL_CLOCK;
+    
+    Plant_Initialize(&s->plant, OUTDOOR_MEAN, s->wall);
+    
+    // each mode, back after a reset and after a power cut
+    for(i = 0; i < 4; i++) {
+        for(powerLost = 0; powerLost <= 1; powerLost++) {
+            s->mode = modes[i];
+            
+            CHECK_EQUAL(Shim_Restart(true, configure, s), 0);
+            
+            heat   = (modes[i] == TargetHeatingCoolingStateHeat || modes[i] == TargetHeatingCoolingStateAuto);
+            enable = s->pidEnable;
+            stages = s->heaters;
+            
+            CHECK_EQUAL(s->pidMode,   modes[i]);
+            CHECK_EQUAL(enable,       heat);
+            CHECK_EQUAL(stages > 0,   heat);
+            
+            CHECK_EQUAL(Shim_Restart(powerLost != 0, restore, s), 0);
+            
+            printf("warm_sim: %-4s after a %-9s PID %-3s %d stages on\n", names[i], powerLost ? "power cut" : "reset", 
+                   s->pidEnable ? "on" : "off", s->heaters);
+            
+            CHECK_EQUAL(s->pidMode,   modes[i]);
+            CHECK_EQUAL(s->pidEnable, enable);
+            CHECK_EQUAL(s->heaters,   stages);
+        }
+    }
+    
+    // back to the setpoint after a restart with the checkpoint and without
+    recover(s, HEATING, "heating up", &warm);
+    
+    CHECK(warm.back > 0 && s->back > 0);
+    CHECK(warm.back + STAGE_2_TIME / 4 <= s->back);                 // the second stage did not wait again
+    
+    recover(s, HOLDING, "holding", &warm);
+    
+    CHECK(warm.back > 0 && warm.back <= SETTLE);
+    CHECK(warm.out <= s->out);
+    
+    return CHECK_DONE();
+}
+
+/******************************************************************************************************************
+ * internal functions
+ *
+ */
+
+/**
+ * a cold boot, then the thermostat is set from the app
+ * 
+ * @param shared
+ */
+static void configure(void* shared)
+{
+    boot(shared);
+    
+    run(5);
+    
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, m_Shared->mode);
+    
+    run(SETTLE);
+    
+    m_Shared->pidEnable = m_PidEnable;
+    m_Shared->pidMode   = m_PidMode;
+    m_Shared->heaters   = heaters();
+}
+/**
+ * the boot after it; nothing is sent
+ * 
+ * @param shared
+ */
+static void restore(void* shared)
+{
+    boot(shared);
+    
+    run(SETTLE);
+    
+    m_Shared->pidEnable = m_PidEnable;
+    m_Shared->pidMode   = m_PidMode;
+    m_Shared->heaters   = heaters();
+}
+/**
+ * from cold, heat up to the setpoint for a while
+ * 
+ * @param shared
+ */
+static void heat(void* shared)
+{
+    boot(shared);
+    
+    run(5);
+    
+    Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+    Shim_DeviceEvent(AccThermostatTargetHeatingCoolingStateIid, TargetHeatingCoolingStateAuto);
+    
+    run(m_Shared->time);
+}
+/**
+ * the boot after it; without a checkpoint the setpoint is sent again - as it was before the warm restart, when the 
+ * PID started over from an empty integral
+ * 
+ * @param shared
+ */
+static void resume(void* shared)
+{
+    uint32_t    t;
+    double      error;
+    
+    m_Shared = (SHARED*) shared;
+    
+    if(m_Shared->cold) {
+        spi_flash_erase_sector(CHECKPOINT_FLASH_SECTOR);
+        spi_flash_erase_sector(CHECKPOINT_FLASH_SECTOR + 1);
+    }
+    
+    boot(shared);
+    
+    m_Shared->back = 0;
+    m_Shared->out  = 0;
+    m_Shared->low  = SETPOINT;
+    
+    for(t = 1; t <= WATCH; t++) {
+        run(1);
+        
+        if(m_Shared->cold && t == 5) {
+            Shim_DeviceEvent(AccThermostatTargetTemperatureIid, SETPOINT);
+        }
+        
+        error = m_Shared->plant.air - SETPOINT;
+        
+        if(m_Shared->back == 0) {
+            if(fabs(error) <= BAND) {
+                m_Shared->back = t;
+            }
+            
+            continue;
+        }
+        
+        m_Shared->out += (fabs(error) > BAND);
+        
+        if(m_Shared->plant.air < m_Shared->low) {
+            m_Shared->low = m_Shared->plant.air;
+        }
+    }
+}
+/**
+ * heat from cold for 'time', then restart once with the checkpoint and once without
+ * 
+ * @param s         how it went without
+ * @param time
+ * @param what
+ * @param warm      how it went with
+ */
+static void recover(SHARED* s, uint32_t time, const char* what, SHARED* warm)
+{
+    SHARED restart;
+    
+    Plant_Initialize(&s->plant, OUTDOOR_MEAN, s->wall);
+    
+    s->time = time;
+    
+    CHECK_EQUAL(Shim_Restart(true, heat, s), 0);
+    
+    restart = *s;
+    
+    // a reset: the RTC checkpoint
+    s->cold = 0;
+    
+    CHECK_EQUAL(Shim_Restart(false, resume, s), 0);
+    
+    *warm = *s;
+    
+    // the same moment without one
+    *s      = restart;
+    s->cold = 1;
+    
+    CHECK_EQUAL(Shim_Restart(true, resume, s), 0);
+    
+    printf("warm_sim: restart %s at %.1f C; warm in the band after %u s, %u s out, low %.2f C; "
+           "cold after %u s, %u s out, low %.2f C\n", what, restart.plant.air, warm->back, warm->out, warm->low, 
+           s->back, s->out, s->low);
+}
+/**
+ * 
+ * @param shared
+ */
+static void boot(void* shared)
+{
+    m_Shared = (SHARED*) shared;
+    
+    Shim_Verbose(m_Shared->verbose);
+    Shim_SetDht(dht);
+    Shim_Boot(m_Shared->wall);
+}
+/**
+ * a reading of the plant with a tenth of noise
+ * 
+ * @param gpio
+ * @param temperature
+ * @param humidity
+ * @return 
+ */
+static int dht(uint8_t gpio, int16_t* temperature, int16_t* humidity)
+{
+    PLANT*  p = &m_Shared->plant;
+    double  t = (gpio == GPIO_DHT1) ? p->air      : p->outdoor;
+    double  h = (gpio == GPIO_DHT1) ? p->humidity : Plant_OutdoorHumidity(p);
+    
+    *temperature = (int16_t) lround(t * 10) + (int) (random32() % 3) - 1;
+    *humidity    = (int16_t) lround((h > 99.9 ? 99.9 : h) * 10);
+    
+    return 1;
+}
+/**
+ * 
+ * @return stages on
+ */
+static int heaters(void)
+{
+    return (Shim_Output(GPIO_HEATER1) == HEATER_ON) + (Shim_Output(GPIO_HEATER2) == HEATER_ON);
+}
+/**
+ * the firmware and the plant, a second at a time
+ * 
+ * @param seconds
+ */
+static void run(uint32_t seconds)
+{
+    uint32_t s;
+    
+    for(s = 0; s < seconds; s++) {
+        Shim_Run(1000000);
+        
+        Plant_Step(&m_Shared->plant, 1.0, heaters(), Shim_Output(GPIO_FAN) == FAN_ON);
+        
+        m_Shared->wall++;
+    }
+}
+/**
+ * 
+ * @return 
+ */
+static uint32_t random32(void)
+{
+    m_Random = m_Random * 1103515245 + 12345;
+    
+    return m_Random >> 8;
+}
@@ -30,6 +30,94 @@
 #define CLIENT_SSL_ENABLE
 
 #define DHT_INTERVAL            60
+#define DHT_WARMUP              2000        // ms - first reading after boot or (re)connect
+#define DHT_RETRY               2000        // ms - first retry after a failed reading; doubles up to DHT_INTERVAL
+#define DHT_STALE               (5 * 60)    // seconds - older indoor readings do not drive the heaters
+
+#define FILTER_TEMP_DEVIATION   10          // 0.1 C - smaller deviations from the median are never outliers
+#define FILTER_HUM_DEVIATION    50          // 0.1 %RH
+
+/******************************************************************************************************************
+ * boot
+ *
+ */
+#define FAST_BOOT                           // comment out to wait 3 s for a terminal at boot
+#define FASTBOOT_RTC_BLOCK      112         // RTC user memory; last good access point
+
+/******************************************************************************************************************
+ * scheduler
+ *
+ */
+#define NETWORK_INTERVAL        20          // ms - poll MQTT connector and device events
+#define BLINKER_INTERVAL        50          // ms
+
+#define DEVICE_EVENT_BUDGET     8           // max. incoming value updates handled per pass
+
+/******************************************************************************************************************
+ * memory
+ *
+ */
+#define CONTAINER_BUFFER_SIZE   (6 * 1024)
+#define MQTT_BUFFER_SIZE        (6 * 1024)
+
+// objects created in main_init_done(): both buffers above and the rest; check the high-water mark and fallbacks 
+// printed at boot
+#define ARENA_OBJECTS           (3 * 1024)  // container, accessories, options and connector
+#define ARENA_SIZE              (CONTAINER_BUFFER_SIZE + MQTT_BUFFER_SIZE + ARENA_OBJECTS)
+
+/******************************************************************************************************************
+ * publishing of sensor values
+ *
+ */
+#define PUBLISH_MIN_INTERVAL    30          // seconds
+#define PUBLISH_MAX_SILENCE     (15 * 60)   // seconds
+
+/******************************************************************************************************************
+ * sensor history
+ *
+ */
+// flash sectors 0xF0-0xF7 are reserved for the history; rom1 must end below 0xF0000
+#define HISTORY_FLASH_SECTOR    0xF0
+#define HISTORY_FLASH_SECTORS   8           // 0: keep history in RAM only
+#define HISTORY_PAGE_SIZE       16          // samples per reply
+
+/******************************************************************************************************************
+ * warm restart
+ *
+ */
+#define CHECKPOINT_RTC_BLOCK    96          // RTC user memory; rBoot has the blocks from 64
+#define CHECKPOINT_FLASH_SECTOR 0xF8        // and 0xF9
+#define CHECKPOINT_INTERVAL     (30 * 60)   // seconds between flash copies of the PID state
+
+/******************************************************************************************************************
+ * store and forward
+ *
+ */
+#define FORWARD_POLICY          FORWARD_DROP_OLDEST
+#define FORWARD_BATCH           16          // max. events per message
+#define FORWARD_GAP             250         // ms between messages while catching up
+#define FORWARD_RETRY           2000        // ms before a batch that was not published is tried again
+#define FORWARD_CLOCK_WAIT      30          // seconds after connect to wait for Chronos before sending uptime
+#define CLOCK_VALID             1451606400  // earlier wall clock times mean not synced yet (2016-01-01)
+
+/******************************************************************************************************************
+ * delta firmware images
+ *
+ */
+#define DELTA_POLL              20          // ms between looks at the download while it is quiet
+#define DELTA_TIMEOUT           30          // seconds without progress before the download is given up
+#define DELTA_RESTART           2000        // ms from a verified image to the restart; time to tell
+
+/******************************************************************************************************************
+ * diagnostics
+ *
+ */
+#define LATENCY_ENABLE                      // per-stage latency histograms
+#define LATENCY_INTERVAL        (5 * 60)    // seconds between reports
+#define HEALTH_INTERVAL         60          // seconds between heap/stack reports
+
+#define LOG_LEVEL               LOG_LEVEL_INFO  // LOG_LEVEL_DEBUG adds the command and device value traces
+#define LOG_RING_SIZE           1024        // bytes waiting for the UART; must be a power of 2
 
 /******************************************************************************************************************
  * MQTT
@@ -66,6 +154,38 @@
 #define PID_Ki                  5
 #define PID_Kd                  1
 
+#define PID_FRAC                16          // fixed-point fraction bits; Q15.16
+
+#define PID_OUTPUT_MAX          30
+#define PID_WINDOW              (10 * 60)   // seconds; the output range is spread over the stages in it
+#define PID_MIN_ON              30          // seconds; shorter on or off times are not worth a relay click
+
+#define AUTOTUNE_HYSTERESIS     2           // 0.1 C around the setpoint
+#define AUTOTUNE_CYCLES         3           // relay cycles measured
+#define AUTOTUNE_TIMEOUT        (12 * 3600) // seconds
+#define AUTOTUNE_WATCH          (4 * 3600)  // seconds the tuned controller is watched before reporting
+
+/******************************************************************************************************************
+ * weekly schedule
+ *
+ */
+#define SCHEDULE_FLASH_SECTOR   0xFA        // 0xFC and up hold the SDK parameters
+#define SCHEDULE_INTERVAL       60          // seconds
+#define SCHEDULE_UTC_OFFSET     60          // minutes; the schedule is in local time
+#define SCHEDULE_DST            1           // EU summer time
+
+/******************************************************************************************************************
+ * safety interlocks
+ *
+ */
+#define INTERLOCK_TICK          100         // ms between relay checks; the worst-case reaction time
+#define INTERLOCK_LOOP_TIMEOUT  5           // seconds the main loop may stall with the heaters on
+#define INTERLOCK_STALE_TIMEOUT (DHT_STALE + 60)  // seconds without an indoor reading; runPid() acts first
+#define INTERLOCK_MAX_TEMP      350         // 0.1 C
+#define INTERLOCK_HYSTERESIS    20          // 0.1 C below the max. before heating again
+#define INTERLOCK_MAX_ON        (6 * 3600)  // seconds of heat without a break; 0: no limit
+#define INTERLOCK_REST          (10 * 60)   // seconds off after that
+
 /******************************************************************************************************************
  * GPIO
  *
@@ -97,9 +217,11 @@
 #define HEATER_OFF              true
 
 #define FANTIMEOUT              (3 * 60)    // seconds
-#define STAGE_2_TIME            (30 * 60)   // seconds
+#define STAGE_2_TIME            (30 * 60)   // seconds heat must be wanted before stage 2 may join
+#define FEEDFORWARD_DELTA       24          // C above outdoor one stage holds on its own; 0: no feed-forward
 
 #define INVALID_TEMP            -100
+#define INVALID_TENTHS          (INVALID_TEMP * 10)
 #define INVALID_HUM             0
 
 #endif